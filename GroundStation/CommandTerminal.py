@@ -16,9 +16,23 @@ Simplified syntax (no leading / or -a):
 Run a newline-delimited program file:
   run_file TestProgram.cake
 
+Send a program file as program packets, many CNC instructions per InfluxDB row:
+  run_program TestProgram.cake
+
+Upload a program file to the device's flash once, then run it from there:
+  store_program TestProgram.cake
+  run_stored TestProgram.cake
+
+Compile a program file to a binary packet stream for the host simulation (no InfluxDB needed):
+  python CommandTerminal.py compile TestProgram.cake program.bin [--packed]
+
 Env vars: INFLUXDB_URL, INFLUXDB_TOKEN, INFLUXDB_ORG, INFLUXDB_CMD_BUCKET
+Optional: PANCAKE_PUSH_PORT starts the push channel server (PushServer.py); while the device is
+connected to it, commands go down that socket instead of through InfluxDB.
 
 Commands are encoded as binary [opcode][length][payload] and base64-encoded before being written.
+Program packets wrap a run of CNC instructions behind a sequence number and CRC-32 (see
+Pancake_esp/main/ProgramPacket.h); the firmware queues all of a program or none of it.
 """
 
 from __future__ import annotations
@@ -33,6 +47,7 @@ import struct
 
 import re
 import glob
+import zlib
 
 # ANSI colors
 RESET = "\033[0m"
@@ -48,6 +63,9 @@ INFLUXDB_TOKEN = os.environ.get("INFLUXDB_TOKEN")
 INFLUXDB_ORG = os.environ.get("INFLUXDB_ORG")
 INFLUXDB_CMD_BUCKET = os.environ.get("INFLUXDB_CMD_BUCKET")
 _last_write_timestamp_ms = 0
+# Push channel server, when PANCAKE_PUSH_PORT is set (see PushServer.py).
+_push_server = None
+_next_program_sequence = 0
 
 GCODE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "GCode")
 GCODE_FILE_EXTENSION = ".cake"
@@ -80,12 +98,32 @@ CNC_OPCODES: Dict[str, int] = {
     "local_origin": 0x1F,
 }
 
+# Program packet container (matches CNC_PROGRAM_OPCODE and ProgramPacket.h)
+CNC_PROGRAM_OPCODE = 0x20
+PROGRAM_HEADER_FORMAT = "<HHHI"  # sequence, instruction count, body length, CRC-32 of body
+PROGRAM_MAX_LEN = 1024  # CMD_PROGRAM_MAX_LEN in DataModel.h
+
+# Program store commands (match ProgramStore.h and CNCOpCodes.h)
+PROGRAM_STORE_BEGIN_OPCODE = 0x05
+PROGRAM_STORE_DATA_OPCODE = 0x06
+PROGRAM_STORE_COMMIT_OPCODE = 0x07
+PROGRAM_RUN_STORED_OPCODE = 0x08
+PROGRAM_STORE_CHUNK_LEN = 250  # plus the u32 offset, within the 254-byte instruction payload
+PROGRAM_STORE_MAX_LEN = 16384 - 16  # PROGRAM_SLOT_BYTES less the slot header
+
+# Control loop capture (match ControlCapture.h and CNCOpCodes.h)
+CAPTURE_ARM_OPCODE = 0x09
+CAPTURE_TRIGGER_STOP = 1 << 1
+CAPTURE_TRIGGER_LIMIT_SWITCH = 1 << 2
+CAPTURE_DEFAULT_POST_TRIGGER = 256  # half of CONTROL_CAPTURE_SAMPLES
+
 # Immediate control opcodes
 IMMEDIATE_OPCODES: Dict[str, int] = {
     "pause": 0x01,
     "resume": 0x02,
     "stop": 0x03,
     "crash_diagnostic": 0x04,
+    "capture_trigger": 0x0A,
 }
 
 # Defaults for command arguments
@@ -134,14 +172,19 @@ def print_help() -> None:
     print("  local_origin OriginX_m=<m> OriginY_m=<m>")
     print("  pump_purge pumpSpeed_degps=<signed deg/s> duration_ms=<ms>")
     print("  wait timeout_ms=<int>")
-    print("  set_motor_limits motor=<S0|S1|Pump|All> accel=<degps2> speed=<degps>")
+    print("  set_motor_limits motor=<S0|S1|Pump|All> accel=<degps2> speed=<degps> [jerk=<degps3>]")
     print("  set_pump_constant pumpConstant_degpm=<val>")
     print("  set_accel_scale accelScale=<ratio>")
     print("  pause | resume | stop")
     print("  crash_diagnostic")
+    print("  capture_arm [PostTrigger_cycles=<n>] [OnStop=<0|1>] [OnLimitSwitch=<0|1>]")
+    print("  capture_trigger")
     print("  ask_to_continue [message]")
     print("  terminal_wait duration_ms=<int>")
     print("  run_file <filename.cake> [delay_ms]")
+    print("  run_program <filename.cake> [delay_ms]")
+    print("  store_program <filename.cake> [delay_ms]")
+    print("  run_stored <filename.cake>")
     print("")
     print(f"{DIM}Tip: '<Cmd> help' shows command-specific options.{RESET}")
 
@@ -209,7 +252,8 @@ COMMAND_HELP: Dict[str, str] = {
         "set_motor_limits keys:\n"
         "  motor: S0 | S1 | Pump | All\n"
         "  accel: float\n"
-        "  speed: float"
+        "  speed: float\n"
+        "  jerk: float (optional) — S-curve jerk limit, 0 for trapezoidal ramps; omit to keep"
     ),
     "set_pump_constant": (
         "set_pump_constant keys:\n"
@@ -230,6 +274,14 @@ COMMAND_HELP: Dict[str, str] = {
     "crash_diagnostic": (
         "crash_diagnostic — print reset/coredump facts to EVR logs, then erase the saved coredump."
     ),
+    "capture_arm": (
+        "capture_arm keys:\n"
+        "  PostTrigger_cycles: int — 100 Hz cycles kept after the trigger, of 512 (default 256)\n"
+        "  OnStop:             0|1 — a stop or limit stop triggers (default 1)\n"
+        "  OnLimitSwitch:      0|1 — a limit switch closing triggers (default 1)\n"
+        "The finished capture is uploaded to the telemetry bucket as measurement \"cap\"."
+    ),
+    "capture_trigger": "capture_trigger — trigger an armed capture now.",
     "ask_to_continue": (
         "ask_to_continue [message]\n"
         "  Prompts the user to continue (y/n). Not sent to device."
@@ -238,6 +290,20 @@ COMMAND_HELP: Dict[str, str] = {
         "terminal_wait keys:\n"
         "  duration_ms: int — local delay before next command."
     ),
+    "run_program": (
+        "run_program <filename.cake> [delay_ms]\n"
+        "  Sends the file's CNC instructions packed into program packets, each queued whole or\n"
+        "  not at all. Terminal-only lines (ask_to_continue, terminal_wait) are skipped."
+    ),
+    "store_program": (
+        "store_program <filename.cake> [delay_ms]\n"
+        "  Uploads the file's CNC instructions to the device's program flash. The device skips\n"
+        "  the upload if it already holds the same program."
+    ),
+    "run_stored": (
+        "run_stored <filename.cake>\n"
+        "  Runs a program uploaded with store_program from the device's flash."
+    ),
 }
 
 # Legacy command names mapped to canonical snake_case names
@@ -292,6 +358,23 @@ def _build_echo_packet(message: str) -> bytes:
     return bytes([opcode, len(data)]) + data
 
 
+def _build_capture_arm_packet(args: Dict[str, Any]) -> bytes:
+    allowed = {"PostTrigger_cycles", "OnStop", "OnLimitSwitch"}
+    unknown = set(args.keys()) - allowed
+    if unknown:
+        raise ValueError(f"Unknown keys for capture_arm: {', '.join(sorted(unknown))}")
+    post_trigger = int(args.get("PostTrigger_cycles", CAPTURE_DEFAULT_POST_TRIGGER))
+    if not 0 <= post_trigger <= 0xFFFF:
+        raise ValueError("PostTrigger_cycles must fit in 16 bits")
+    mask = 0
+    if int(args.get("OnStop", 1)):
+        mask |= CAPTURE_TRIGGER_STOP
+    if int(args.get("OnLimitSwitch", 1)):
+        mask |= CAPTURE_TRIGGER_LIMIT_SWITCH
+    payload = struct.pack("<HB", post_trigger, mask)
+    return bytes([CAPTURE_ARM_OPCODE, len(payload)]) + payload
+
+
 def _build_pump_purge_payload(args: Dict[str, Any]) -> bytes:
     allowed = {"pumpSpeed_degps", "duration_ms"}
     unknown = set(args.keys()) - allowed
@@ -354,17 +437,21 @@ def _build_cnc_payload(cmd: str, args: Dict[str, Any]) -> Tuple[int, bytes]:
         payload = struct.pack("<i", int(merged.get("timeout_ms")))
         return op, payload
     elif cmd == "set_motor_limits":
-        # Expect: motor=S0|S1|Pump|All accel=... speed=...
+        # Expect: motor=S0|S1|Pump|All accel=... speed=... [jerk=...]
         motor_map = {"S0": 0, "S1": 1, "Pump": 2, "All": 255}
         mkey = str(args.get("motor", "All"))
         motor_id = motor_map.get(mkey, 255)
         accel = float(args.get("accel", 0.0))
         speed = float(args.get("speed", 0.0))
-        allowed = {"motor", "accel", "speed"}
+        allowed = {"motor", "accel", "speed", "jerk"}
         unknown = set(args.keys()) - allowed
         if unknown:
             raise ValueError(f"Unknown keys for set_motor_limits: {', '.join(sorted(unknown))}")
-        payload = struct.pack("<Bff", motor_id, accel, speed)
+        if "jerk" in args:
+            # The firmware only changes the jerk limit when the longer payload is sent.
+            payload = struct.pack("<Bfff", motor_id, accel, speed, float(args.get("jerk")))
+        else:
+            payload = struct.pack("<Bff", motor_id, accel, speed)
         return op, payload
     elif cmd == "set_pump_constant":
         allowed = {"pumpConstant_degpm"}
@@ -477,7 +564,7 @@ def _build_command_packet(line: str) -> Optional[bytes]:
     if len(parts) >= 2 and parts[1].lower() in {"help", "-h", "?"}:
         # handled by caller
         return None
-    if cmd == "run_file":
+    if cmd in {"run_file", "run_program", "store_program", "run_stored"}:
         return None
     # Normalize command names to snake_case
     cmd = _canonical_cmd_name(cmd_raw)
@@ -490,12 +577,94 @@ def _build_command_packet(line: str) -> Optional[bytes]:
 
     arg_map = _parse_kv_tokens(parts[1:])
 
+    if cmd == "capture_arm":
+        return _build_capture_arm_packet(arg_map)
+
     opcode, payload = _build_cnc_payload(cmd, arg_map)
     if len(payload) > 255:
         raise ValueError("payload too long")
     return bytes([opcode, len(payload)]) + payload
 
 
+def _build_program_packet(instructions: List[bytes], sequence: int) -> bytes:
+    body = b"".join(instructions)
+    if not instructions:
+        raise ValueError("program needs at least one instruction")
+    if 2 + struct.calcsize(PROGRAM_HEADER_FORMAT) + len(body) > PROGRAM_MAX_LEN:
+        raise ValueError("program too long for one packet")
+    header = struct.pack(PROGRAM_HEADER_FORMAT, sequence & 0xFFFF, len(instructions), len(body),
+                         zlib.crc32(body))
+    return bytes([CNC_PROGRAM_OPCODE, len(header)]) + header + body
+
+
+def pack_program_packets(packets: List[bytes]) -> List[bytes]:
+    """Pack runs of consecutive CNC packets into as few program packets as fit.
+
+    Other packets (echo, pause/resume/stop, ...) stay single and keep their place in the order;
+    a run of one CNC packet is sent as is.
+    """
+    header_len = 2 + struct.calcsize(PROGRAM_HEADER_FORMAT)
+    out: List[bytes] = []
+    run: List[bytes] = []
+
+    def flush() -> None:
+        global _next_program_sequence
+        if len(run) == 1:
+            out.append(run[0])
+        elif run:
+            out.append(_build_program_packet(run, _next_program_sequence))
+            _next_program_sequence = (_next_program_sequence + 1) & 0xFFFF
+        run.clear()
+
+    cnc_opcodes = set(CNC_OPCODES.values())
+    for pkt in packets:
+        if pkt[0] not in cnc_opcodes:
+            flush()
+            out.append(pkt)
+            continue
+        if header_len + sum(len(p) for p in run) + len(pkt) > PROGRAM_MAX_LEN:
+            flush()
+        run.append(pkt)
+    flush()
+    return out
+
+
+def program_hash(program: bytes) -> int:
+    """FNV-1a hash that names a stored program (ProgramHash in ProgramStore.cpp)."""
+    h = 2166136261
+    for b in program:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def compile_stored_program(file_name: str) -> bytes:
+    """The CNC instruction stream of a .cake file, as kept in the device's program store."""
+    cnc_opcodes = set(CNC_OPCODES.values())
+    program = b"".join(pkt for pkt in compile_run_file(file_name) if pkt[0] in cnc_opcodes)
+    if not program:
+        raise ValueError("program has no CNC instructions")
+    if len(program) > PROGRAM_STORE_MAX_LEN:
+        raise ValueError(f"program is {len(program)} bytes; the device stores at most {PROGRAM_STORE_MAX_LEN}")
+    return program
+
+
+def build_store_program_packets(program: bytes) -> List[bytes]:
+    """Begin, data chunks and commit packets that upload `program` to the program store."""
+    h = program_hash(program)
+    begin = struct.pack("<II", h, len(program))
+    packets = [bytes([PROGRAM_STORE_BEGIN_OPCODE, len(begin)]) + begin]
+    for offset in range(0, len(program), PROGRAM_STORE_CHUNK_LEN):
+        chunk = struct.pack("<I", offset) + program[offset:offset + PROGRAM_STORE_CHUNK_LEN]
+        packets.append(bytes([PROGRAM_STORE_DATA_OPCODE, len(chunk)]) + chunk)
+    packets.append(bytes([PROGRAM_STORE_COMMIT_OPCODE, 4]) + struct.pack("<I", h))
+    return packets
+
+
+def build_run_stored_packet(program: bytes) -> bytes:
+    payload = struct.pack("<II", program_hash(program), len(program))
+    return bytes([PROGRAM_RUN_STORED_OPCODE, len(payload)]) + payload
+
+
 def _run_file_path_candidates(text: str) -> List[str]:
     """Return filename completions for .cake programs in the GCode directory."""
     if _has_path_separator(text):
@@ -523,7 +692,22 @@ def _resolve_run_file_path(file_name: str) -> str:
     return os.path.abspath(os.path.join(GCODE_DIR, file_name))
 
 
+def _start_push_server(port_text: str) -> None:
+    global _push_server
+    try:
+        from GroundStation.PushServer import PushServer
+    except ModuleNotFoundError:  # pragma: no cover - direct script execution fallback
+        from PushServer import PushServer
+
+    _push_server = PushServer(port=int(port_text)).start()
+    print(f"{DIM}Push channel listening on port {_push_server.port}; InfluxDB until the device connects{RESET}")
+
+
 def _write_packet(packet: bytes) -> None:
+    # The push channel, when the device is on it, skips the InfluxDB round trip and poll.
+    if _push_server is not None and _push_server.send(packet):
+        return
+
     import requests
     global _last_write_timestamp_ms
 
@@ -602,6 +786,67 @@ def _run_file(path: str, delay_ms: int, run_file_stack: Optional[List[str]] = No
         stack.pop()
 
 
+def compile_run_file(file_name: str, run_file_stack: Optional[List[str]] = None) -> List[bytes]:
+    """Return the packets a run_file of `file_name` would write, without writing or waiting.
+
+    Nested run_file calls are expanded in place; terminal-only lines (ask_to_continue,
+    terminal_wait) and help requests produce no packets.
+    """
+    stack = run_file_stack if run_file_stack is not None else []
+    abs_path = _resolve_run_file_path(file_name)
+    if abs_path in stack:
+        chain = " -> ".join([*stack, abs_path])
+        raise ValueError(f"Recursive run_file call disallowed: {chain}")
+
+    packets: List[bytes] = []
+    stack.append(abs_path)
+    try:
+        with open(abs_path, 'r', encoding='utf-8') as f:
+            for raw in f:
+                s = raw.strip()
+                if not s or s.startswith('#'):
+                    continue
+                parts = shlex.split(s)
+                if parts[0] in {'ask_to_continue', 'terminal_wait'}:
+                    continue
+                if parts[0] == 'run_file':
+                    if len(parts) < 2:
+                        raise ValueError("usage: run_file <filename.cake> [delay_ms]")
+                    packets.extend(compile_run_file(parts[1], stack))
+                    continue
+                pkt = _build_command_packet(s)
+                if pkt is not None:
+                    packets.append(pkt)
+    finally:
+        stack.pop()
+    return packets
+
+
+def _run_program(file_name: str, delay_ms: int) -> None:
+    for pkt in pack_program_packets(compile_run_file(file_name)):
+        if pkt[0] == CNC_PROGRAM_OPCODE:
+            count = struct.unpack_from("<H", pkt, 4)[0]
+            print(f"{DIM}↳ program of {count} instructions ({len(pkt)} bytes){RESET}")
+        _write_packet(pkt)
+        time.sleep(delay_ms / 1000.0)
+
+
+def _compile_main(argv: List[str]) -> int:
+    packed = "--packed" in argv
+    argv = [arg for arg in argv if arg != "--packed"]
+    if len(argv) != 2:
+        print("usage: CommandTerminal.py compile <filename.cake> <output.bin> [--packed]", file=sys.stderr)
+        return 2
+    packets = compile_run_file(argv[0])
+    if packed:
+        packets = pack_program_packets(packets)
+    with open(argv[1], 'wb') as f:
+        for pkt in packets:
+            f.write(pkt)
+    print(f"Wrote {len(packets)} packets to {argv[1]}")
+    return 0
+
+
 def _send_command(line: str, run_file_stack: Optional[List[str]] = None) -> bool:
     parts = shlex.split(line)
     if not parts:
@@ -620,6 +865,38 @@ def _send_command(line: str, run_file_stack: Optional[List[str]] = None) -> bool
             delay_ms = int(os.environ.get('CT_RUNFILE_DELAY_MS', '800'))
         _run_file(path, delay_ms, run_file_stack)
         return True
+    if parts[0] == "store_program":
+        if len(parts) < 2:
+            raise ValueError("usage: store_program <filename.cake> [delay_ms]")
+        delay_ms = int(parts[2]) if len(parts) >= 3 else 0
+        if delay_ms <= 0:
+            delay_ms = int(os.environ.get('CT_RUNFILE_DELAY_MS', '800'))
+        program = compile_stored_program(parts[1])
+        packets = build_store_program_packets(program)
+        print(f"{DIM}↳ uploading {len(program)} bytes as program {program_hash(program):08x} "
+              f"({len(packets)} packets){RESET}")
+        for pkt in packets:
+            _write_packet(pkt)
+            time.sleep(delay_ms / 1000.0)
+        return True
+    if parts[0] == "run_stored":
+        if len(parts) < 2:
+            raise ValueError("usage: run_stored <filename.cake>")
+        _write_packet(build_run_stored_packet(compile_stored_program(parts[1])))
+        return True
+    if parts[0] == "run_program":
+        if len(parts) < 2:
+            raise ValueError("usage: run_program <filename.cake> [delay_ms]")
+        delay_ms = 0
+        if len(parts) >= 3:
+            try:
+                delay_ms = int(parts[2])
+            except ValueError:
+                raise ValueError("delay_ms must be integer milliseconds")
+        if delay_ms <= 0:
+            delay_ms = int(os.environ.get('CT_RUNFILE_DELAY_MS', '800'))
+        _run_program(parts[1], delay_ms)
+        return True
 
     # Command-specific help
     if len(parts) >= 2 and parts[1].lower() in {"help", "-h", "?"}:
@@ -656,11 +933,18 @@ def _send_command(line: str, run_file_stack: Optional[List[str]] = None) -> bool
 
 
 def main() -> None:
+    if len(sys.argv) >= 2 and sys.argv[1] == "compile":
+        sys.exit(_compile_main(sys.argv[2:]))
+
     _require(INFLUXDB_URL, "INFLUXDB_URL")
     _require(INFLUXDB_TOKEN, "INFLUXDB_TOKEN")
     _require(INFLUXDB_ORG, "INFLUXDB_ORG")
     _require(INFLUXDB_CMD_BUCKET, "INFLUXDB_CMD_BUCKET")
 
+    push_port = os.environ.get("PANCAKE_PUSH_PORT")
+    if push_port:
+        _start_push_server(push_port)
+
     # Optional: readline for history + tab completion
     completer_installed = False
     try:
@@ -689,7 +973,12 @@ def main() -> None:
             "resume",
             "stop",
             "crash_diagnostic",
+            "capture_arm",
+            "capture_trigger",
             "run_file",
+            "run_program",
+            "store_program",
+            "run_stored",
             "help",
             "?",
             "quit",
@@ -707,7 +996,7 @@ def main() -> None:
             "cnc_sine": ["Amplitude_deg", "Frequency_hz"],
             "cnc_constant_speed": ["S0Speed_degps", "S1Speed_degps"],
             "wait": ["timeout_ms"],
-            "set_motor_limits": ["motor", "accel", "speed"],
+            "set_motor_limits": ["motor", "accel", "speed", "jerk"],
             "set_pump_constant": ["pumpConstant_degpm"],
             "set_accel_scale": ["accelScale"],
             "cnc_jog": ["TargetX_m", "TargetY_m", "LinearSpeed_mps", "PumpOn"],
@@ -732,7 +1021,7 @@ def main() -> None:
                 candidates = [c for c in COMMANDS if c.startswith(text)]
             else:
                 cmd = tokens[0]
-                if cmd == 'run_file':
+                if cmd in {'run_file', 'run_program', 'store_program', 'run_stored'}:
                     candidates = _run_file_path_candidates(text)
                 else:
                     # After a command, offer keys= completions
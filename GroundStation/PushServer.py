@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Push command channel server: the ground station end of Pancake_esp/main/PushCommandChannel.h.
+
+The device connects out to this server and keeps the connection open; every command written to
+it goes straight down the socket as a bare [opcode][len][payload] frame, with no base64 and no
+InfluxDB round trip. CommandTerminal starts one when PANCAKE_PUSH_PORT is set and falls back to
+InfluxDB whenever no device is connected.
+
+Run on its own as a stand-in for trying the channel, sending hex-encoded packets typed on stdin:
+  python PushServer.py --port 8095
+  > 0300          (stop)
+"""
+
+from __future__ import annotations
+
+import argparse
+import socket
+import sys
+import threading
+from typing import Optional
+
+DEFAULT_PUSH_PORT = 8095
+
+
+class PushServer:
+    """Accept the device's connection and write command packets to it.
+
+    Only the most recent connection is kept: a device that reboots reconnects, and the stale
+    socket is dropped. send() never blocks on a missing device; it reports False so the caller can
+    take the InfluxDB path instead.
+    """
+
+    def __init__(self, host: str = "0.0.0.0", port: int = DEFAULT_PUSH_PORT) -> None:
+        self._listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self._listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self._listener.bind((host, port))
+        self._listener.listen(1)
+        self._lock = threading.Lock()
+        self._device: Optional[socket.socket] = None
+        self._device_address: Optional[tuple] = None
+        self._closed = False
+        self._thread = threading.Thread(target=self._accept_loop, name="PushServer", daemon=True)
+
+    @property
+    def port(self) -> int:
+        return self._listener.getsockname()[1]
+
+    @property
+    def device_address(self) -> Optional[tuple]:
+        with self._lock:
+            return self._device_address
+
+    def start(self) -> "PushServer":
+        self._thread.start()
+        return self
+
+    def is_connected(self) -> bool:
+        with self._lock:
+            return self._device is not None
+
+    def send(self, packet: bytes) -> bool:
+        """Write one packet to the device. False if no device is connected or the write failed."""
+        with self._lock:
+            if self._device is None:
+                return False
+            try:
+                self._device.sendall(packet)
+                return True
+            except OSError:
+                self._drop_device_locked()
+                return False
+
+    def close(self) -> None:
+        self._closed = True
+        with self._lock:
+            self._drop_device_locked()
+        try:
+            self._listener.close()
+        except OSError:
+            pass
+
+    def _drop_device_locked(self) -> None:
+        if self._device is not None:
+            # shutdown() first: close() alone neither sends the FIN while the watcher thread is
+            # blocked reading the socket nor wakes that thread.
+            try:
+                self._device.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            self._device.close()
+        self._device = None
+        self._device_address = None
+
+    def _accept_loop(self) -> None:
+        while not self._closed:
+            try:
+                conn, address = self._listener.accept()
+            except OSError:
+                return
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            with self._lock:
+                self._drop_device_locked()
+                self._device = conn
+                self._device_address = address
+            threading.Thread(target=self._watch_device, args=(conn,), daemon=True).start()
+
+    def _watch_device(self, conn: socket.socket) -> None:
+        # The device never writes; a read returning means it closed or the link dropped.
+        try:
+            while conn.recv(64):
+                pass
+        except OSError:
+            pass
+        with self._lock:
+            if self._device is conn:
+                self._drop_device_locked()
+
+
+def main(argv: Optional[list] = None) -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=DEFAULT_PUSH_PORT)
+    args = parser.parse_args(argv)
+
+    server = PushServer(args.host, args.port).start()
+    print(f"Listening on {args.host}:{server.port}; enter packets as hex")
+    try:
+        for line in sys.stdin:
+            text = line.strip()
+            if not text:
+                continue
+            try:
+                packet = bytes.fromhex(text)
+            except ValueError:
+                print("Not hex")
+                continue
+            print("sent" if server.send(packet) else "no device connected")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -4,6 +4,7 @@ import sys
 import tempfile
 import types
 import unittest
+import zlib
 from unittest import mock
 
 # CommandTerminal only needs requests when writing packets, but requests is not
@@ -11,7 +12,16 @@ from unittest import mock
 # serialization tests can import the module without exercising network writes.
 sys.modules.setdefault("requests", types.SimpleNamespace())
 
-from GroundStation.CommandTerminal import _build_command_packet, _build_pump_purge_payload, _send_command
+from GroundStation.CommandTerminal import (
+    _build_command_packet,
+    _build_pump_purge_payload,
+    _send_command,
+    build_run_stored_packet,
+    build_store_program_packets,
+    compile_run_file,
+    pack_program_packets,
+    program_hash,
+)
 
 
 class CommandTerminalPacketTests(unittest.TestCase):
@@ -47,6 +57,46 @@ class CommandTerminalPacketTests(unittest.TestCase):
         self.assertAlmostEqual(origin_x, 0.12)
         self.assertAlmostEqual(origin_y, 0.34)
 
+    def test_set_motor_limits_packet_keeps_legacy_layout_without_jerk(self):
+        packet = _build_command_packet("set_motor_limits motor=S1 accel=200 speed=5000")
+
+        self.assertIsNotNone(packet)
+        opcode, payload_len = packet[:2]
+        motor_id, accel, speed = struct.unpack("<Bff", packet[2:])
+
+        self.assertEqual(opcode, 0x16)
+        self.assertEqual(payload_len, struct.calcsize("<Bff"))
+        self.assertEqual(motor_id, 1)
+        self.assertEqual(accel, 200.0)
+        self.assertEqual(speed, 5000.0)
+
+    def test_set_motor_limits_packet_appends_jerk(self):
+        packet = _build_command_packet("set_motor_limits motor=S0 accel=100 speed=5000 jerk=2000")
+
+        self.assertIsNotNone(packet)
+        opcode, payload_len = packet[:2]
+        motor_id, accel, speed, jerk = struct.unpack("<Bfff", packet[2:])
+
+        self.assertEqual(opcode, 0x16)
+        self.assertEqual(payload_len, struct.calcsize("<Bfff"))
+        self.assertEqual(motor_id, 0)
+        self.assertEqual(accel, 100.0)
+        self.assertEqual(speed, 5000.0)
+        self.assertEqual(jerk, 2000.0)
+
+    def test_capture_arm_packet(self):
+        packet = _build_command_packet("capture_arm PostTrigger_cycles=100 OnLimitSwitch=0")
+
+        self.assertIsNotNone(packet)
+        opcode, payload_len = packet[:2]
+        post_trigger, mask = struct.unpack("<HB", packet[2:])
+
+        self.assertEqual(opcode, 0x09)
+        self.assertEqual(payload_len, struct.calcsize("<HB"))
+        self.assertEqual(post_trigger, 100)
+        self.assertEqual(mask, 1 << 1)
+        self.assertEqual(_build_command_packet("capture_trigger"), bytes([0x0A, 0]))
+
     def test_run_file_can_call_run_file(self):
         with tempfile.TemporaryDirectory() as tmp:
             child = os.path.join(tmp, "child.cake")
@@ -81,6 +131,127 @@ class CommandTerminalPacketTests(unittest.TestCase):
         with self.assertRaisesRegex(ValueError, r"\.cake"):
             _send_command("run_file TestProgram.txt 1")
 
+    def test_compile_run_file_expands_nested_files_and_skips_terminal_lines(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            child = os.path.join(tmp, "child.cake")
+            parent = os.path.join(tmp, "parent.cake")
+            with open(child, "w", encoding="utf-8") as f:
+                f.write("local_origin OriginX_m=0.1 OriginY_m=0.2\n")
+            with open(parent, "w", encoding="utf-8") as f:
+                f.write("# comment\n")
+                f.write("terminal_wait duration_ms=5000\n")
+                f.write("ask_to_continue Ready?\n")
+                f.write("run_file child.cake 1\n")
+                f.write("cnc_go_home\n")
+
+            with mock.patch("GroundStation.CommandTerminal.GCODE_DIR", tmp):
+                with mock.patch("GroundStation.CommandTerminal._write_packet") as write_packet:
+                    packets = compile_run_file("parent.cake")
+
+        write_packet.assert_not_called()
+        self.assertEqual([pkt[0] for pkt in packets], [0x1F, 0x1E])
+        self.assertEqual(packets[1], bytes([0x1E, 0]))
+
+
+class ProgramPacketTests(unittest.TestCase):
+    def test_consecutive_cnc_packets_share_one_program(self):
+        jog = _build_command_packet("cnc_jog TargetX_m=0.1 TargetY_m=0.2 LinearSpeed_mps=0.03 PumpOn=1")
+        home = _build_command_packet("cnc_go_home")
+
+        programs = pack_program_packets([jog, jog, home])
+
+        self.assertEqual(len(programs), 1)
+        program = programs[0]
+        self.assertEqual(program[:2], bytes([0x20, 10]))
+        _, count, body_len, crc = struct.unpack_from("<HHHI", program, 2)
+        body = program[12:]
+        self.assertEqual(count, 3)
+        self.assertEqual(body_len, len(body))
+        self.assertEqual(body, jog + jog + home)
+        self.assertEqual(crc, zlib.crc32(body))
+
+    def test_immediate_commands_keep_their_place(self):
+        jog = _build_command_packet("cnc_jog TargetX_m=0.1 TargetY_m=0.2 LinearSpeed_mps=0.03 PumpOn=0")
+        pause = _build_command_packet("pause")
+
+        packets = pack_program_packets([jog, jog, pause, jog])
+
+        self.assertEqual([pkt[0] for pkt in packets], [0x20, 0x01, 0x12])
+        self.assertEqual(packets[2], jog)
+
+    def test_long_runs_split_and_number_programs(self):
+        jog = _build_command_packet("cnc_jog TargetX_m=0.1 TargetY_m=0.2 LinearSpeed_mps=0.03 PumpOn=0")
+
+        programs = pack_program_packets([jog] * 200)
+
+        self.assertTrue(all(pkt[0] == 0x20 and len(pkt) <= 1024 for pkt in programs))
+        self.assertEqual(len(programs), 4)
+        self.assertEqual(sum(struct.unpack_from("<H", pkt, 4)[0] for pkt in programs), 200)
+        sequences = [struct.unpack_from("<H", pkt, 2)[0] for pkt in programs]
+        self.assertEqual(len(set(sequences)), len(sequences))
+
+    def test_run_program_writes_packed_file(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "logo.cake")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write("terminal_wait duration_ms=5000\n")
+                for _ in range(10):
+                    f.write("cnc_jog TargetX_m=0.1 TargetY_m=0.2 LinearSpeed_mps=0.03 PumpOn=1\n")
+
+            with mock.patch("GroundStation.CommandTerminal.GCODE_DIR", tmp):
+                with mock.patch("GroundStation.CommandTerminal._write_packet") as write_packet:
+                    with mock.patch("GroundStation.CommandTerminal.time.sleep"):
+                        self.assertTrue(_send_command("run_program logo.cake 1"))
+
+        write_packet.assert_called_once()
+        program = write_packet.call_args.args[0]
+        self.assertEqual(program[0], 0x20)
+        self.assertEqual(struct.unpack_from("<H", program, 4)[0], 10)
+
+
+class ProgramStoreTests(unittest.TestCase):
+    def test_program_hash_is_fnv1a(self):
+        self.assertEqual(program_hash(b"foobar"), 0xBF9CF968)
+
+    def test_upload_chunks_reassemble_the_program(self):
+        program = bytes(range(256)) * 3
+        packets = build_store_program_packets(program)
+
+        self.assertEqual(packets[0][:2], bytes([0x05, 8]))
+        self.assertEqual(struct.unpack("<II", packets[0][2:]), (program_hash(program), len(program)))
+        self.assertEqual(packets[-1], bytes([0x07, 4]) + struct.pack("<I", program_hash(program)))
+
+        rebuilt = b""
+        for pkt in packets[1:-1]:
+            self.assertEqual(pkt[0], 0x06)
+            self.assertEqual(pkt[1], len(pkt) - 2)
+            self.assertLessEqual(pkt[1], 254)
+            (offset,) = struct.unpack_from("<I", pkt, 2)
+            self.assertEqual(offset, len(rebuilt))
+            rebuilt += pkt[6:]
+        self.assertEqual(rebuilt, program)
+
+    def test_store_then_run_names_the_same_program(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "logo.cake")
+            with open(path, "w", encoding="utf-8") as f:
+                f.write("e Hello\n")
+                f.write("cnc_go_home\n")
+                f.write("cnc_jog TargetX_m=0.1 TargetY_m=0.2 LinearSpeed_mps=0.03 PumpOn=1\n")
+
+            with mock.patch("GroundStation.CommandTerminal.GCODE_DIR", tmp):
+                with mock.patch("GroundStation.CommandTerminal._write_packet") as write_packet:
+                    with mock.patch("GroundStation.CommandTerminal.time.sleep"):
+                        self.assertTrue(_send_command("store_program logo.cake 1"))
+                        self.assertTrue(_send_command("run_stored logo.cake"))
+
+        written = [call.args[0] for call in write_packet.call_args_list]
+        self.assertEqual([pkt[0] for pkt in written], [0x05, 0x06, 0x07, 0x08])
+        # The echo line is not part of the stored program.
+        self.assertEqual(written[1][6:8], bytes([0x1E, 0]))
+        self.assertEqual(written[3][2:], written[0][2:])
+        self.assertEqual(build_run_stored_packet(written[1][6:]), written[3])
+
 
 if __name__ == "__main__":
     unittest.main()
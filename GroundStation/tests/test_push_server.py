@@ -0,0 +1,109 @@
+import socket
+import sys
+import time
+import types
+import unittest
+from unittest import mock
+
+sys.modules.setdefault("requests", types.SimpleNamespace())
+
+import GroundStation.CommandTerminal as terminal
+from GroundStation.PushServer import PushServer
+
+
+def _wait_for(condition, timeout_s=2.0):
+    deadline = time.monotonic() + timeout_s
+    while time.monotonic() < deadline:
+        if condition():
+            return True
+        time.sleep(0.005)
+    return False
+
+
+def _connect_device(server):
+    device = socket.create_connection(("127.0.0.1", server.port), timeout=2.0)
+    assert _wait_for(server.is_connected)
+    return device
+
+
+def _read_exactly(sock, length):
+    data = b""
+    while len(data) < length:
+        chunk = sock.recv(length - len(data))
+        if not chunk:
+            break
+        data += chunk
+    return data
+
+
+class PushServerTests(unittest.TestCase):
+    def setUp(self):
+        self.server = PushServer("127.0.0.1", 0).start()
+
+    def tearDown(self):
+        self.server.close()
+
+    def test_send_without_device_reports_false(self):
+        self.assertFalse(self.server.is_connected())
+        self.assertFalse(self.server.send(b"\x03\x00"))
+
+    def test_packets_arrive_as_bare_frames_in_order(self):
+        device = _connect_device(self.server)
+        try:
+            stop = b"\x03\x00"
+            origin = terminal._build_command_packet("local_origin OriginX_m=0.1 OriginY_m=0.2")
+            self.assertIsNotNone(origin)
+
+            start = time.monotonic()
+            self.assertTrue(self.server.send(stop))
+            self.assertEqual(_read_exactly(device, len(stop)), stop)
+            latency_s = time.monotonic() - start
+            self.assertLess(latency_s, 0.05)
+
+            self.assertTrue(self.server.send(origin))
+            self.assertTrue(self.server.send(stop))
+            self.assertEqual(_read_exactly(device, len(origin) + len(stop)), origin + stop)
+        finally:
+            device.close()
+
+    def test_newest_connection_replaces_the_old_one(self):
+        old = _connect_device(self.server)
+        old_address = self.server.device_address
+        new = socket.create_connection(("127.0.0.1", self.server.port), timeout=2.0)
+        try:
+            self.assertTrue(_wait_for(lambda: self.server.device_address not in (None, old_address)))
+            self.assertTrue(self.server.send(b"\x04\x00"))
+            self.assertEqual(_read_exactly(new, 2), b"\x04\x00")
+            self.assertEqual(old.recv(16), b"")
+        finally:
+            old.close()
+            new.close()
+
+    def test_device_disconnect_is_noticed(self):
+        device = _connect_device(self.server)
+        device.close()
+        self.assertTrue(_wait_for(lambda: not self.server.is_connected()))
+        self.assertFalse(self.server.send(b"\x03\x00"))
+
+
+class PushFallbackTests(unittest.TestCase):
+    def test_write_packet_prefers_push_then_falls_back_to_influx(self):
+        push = mock.Mock()
+        post = mock.Mock()
+        requests_stub = types.SimpleNamespace(post=post)
+        with mock.patch.object(terminal, "_push_server", push), mock.patch.dict(
+            sys.modules, {"requests": requests_stub}
+        ):
+            push.send.return_value = True
+            terminal._write_packet(b"\x03\x00")
+            push.send.assert_called_once_with(b"\x03\x00")
+            post.assert_not_called()
+
+            push.send.return_value = False
+            terminal._write_packet(b"\x03\x00")
+            post.assert_called_once()
+            self.assertIn('cmd data="AwA="', post.call_args.kwargs["data"])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,120 @@
+// Command line front end for HostSimulation.
+//
+//   python GroundStation/CommandTerminal.py compile SmileyFace.cake smiley.bin
+//   scripts/run_host_sim.sh smiley.bin --repeat 10
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "HostSimulation.h"
+
+namespace
+{
+void PrintUsage(const char *program)
+{
+    std::fprintf(stderr,
+                 "usage: %s <program.bin> [--repeat N] [--start S0_deg S1_deg] [--feedforward G]\n"
+                 "          [--step-timer shared|per-motor] [--verbose]\n"
+                 "  program.bin  packet stream from `CommandTerminal.py compile`\n"
+                 "  --repeat N   run the program N times and report the mean wall time\n"
+                 "  --start      initial joint angles (default: go-home pose)\n"
+                 "  --feedforward G  joint velocity feedforward gain (default 1, 0 disables)\n"
+                 "  --step-timer     one Bresenham ISR for all motors, or a gptimer per motor\n"
+                 "  --verbose    show controller info logs\n",
+                 program);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char *programPath = argv[1];
+    int repeat = 1;
+    HostSimulationOptions options;
+    for (int i = 2; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeat = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--start") == 0 && i + 2 < argc)
+        {
+            options.initialS0_deg = static_cast<float>(std::atof(argv[++i]));
+            options.initialS1_deg = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--feedforward") == 0 && i + 1 < argc)
+        {
+            options.controlConfig.feedforwardGain = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--step-timer") == 0 && i + 1 < argc &&
+                 (std::strcmp(argv[i + 1], "shared") == 0 || std::strcmp(argv[i + 1], "per-motor") == 0))
+        {
+            options.sharedStepTimer = std::strcmp(argv[++i], "shared") == 0;
+        }
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+        {
+            esp_log_level_set("*", ESP_LOG_INFO);
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (repeat < 1)
+    {
+        repeat = 1;
+    }
+
+    std::ifstream file(programPath, std::ios::binary);
+    if (!file)
+    {
+        std::fprintf(stderr, "Cannot open %s\n", programPath);
+        return EXIT_FAILURE;
+    }
+    std::vector<uint8_t> stream((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    HostSimulationMetrics metrics;
+    double wallTotal_s = 0.0;
+    for (int run = 0; run < repeat; run++)
+    {
+        HostSimulation simulation(options);
+        if (!simulation.AppendPacketStream(stream.data(), stream.size()))
+        {
+            std::fprintf(stderr, "%s: truncated packet stream\n", programPath);
+            return EXIT_FAILURE;
+        }
+
+        auto wallStart = std::chrono::steady_clock::now();
+        metrics = simulation.Run();
+        wallTotal_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    }
+
+    const double wallMean_s = wallTotal_s / repeat;
+    std::printf("packets:              %u\n", metrics.packetCount);
+    std::printf("completed:            %s\n", metrics.completed ? "yes" : "no (timed out)");
+    std::printf("job duration:         %.2f s (%u cycles)\n", metrics.jobDuration_s, metrics.cycleCount);
+    std::printf("tracking error max:   %.3f mm\n", metrics.maxTrackingError_m * 1000.0);
+    std::printf("tracking error rms:   %.3f mm (%u samples)\n", metrics.rmsTrackingError_m * 1000.0,
+                metrics.trackingSampleCount);
+    std::printf("pump travel:          %.1f deg\n", metrics.pumpTravel_deg);
+    std::printf("step timer events:    %llu (%s)\n", static_cast<unsigned long long>(metrics.stepTimerEventCount),
+                options.sharedStepTimer ? "shared" : "per motor");
+    std::printf("path length:          %.1f mm\n", metrics.pathLength_m * 1000.0);
+    std::printf("step ISRs per mm:     %.1f\n",
+                metrics.pathLength_m > 0.0 ? metrics.stepTimerEventCount / (metrics.pathLength_m * 1000.0) : 0.0);
+    std::printf("wall time per run:    %.3f ms (%.0fx real time)\n", wallMean_s * 1000.0,
+                wallMean_s > 0.0 ? metrics.jobDuration_s / wallMean_s : 0.0);
+
+    return metrics.completed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
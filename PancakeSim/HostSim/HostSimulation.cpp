@@ -0,0 +1,290 @@
+#include "HostSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+#include "CNCOpCodes.h"
+#include "DataModel.h"
+#include "GPIOAssignments.h"
+#include "HostHardware.h"
+#include "PanMath.h"
+#include "ProgramPacket.h"
+
+// Same depths as CommandHandlerInit.
+static constexpr UBaseType_t CNC_QUEUE_DEPTH = 256;
+static constexpr UBaseType_t NOW_QUEUE_DEPTH = 8;
+
+static constexpr uint8_t PAUSE_OPCODE = 0x01;
+static constexpr uint8_t STOP_OPCODE = 0x03;
+
+struct PhysicalJoint
+{
+    gpio_num_t stepPin;
+    gpio_num_t dirPin;
+    bool wiredBackward;
+    float stepSize_deg;
+};
+
+// Indexed in the same order as the physical angles in OnGpioChange.
+static const PhysicalJoint PHYSICAL_JOINTS[] = {
+    {S0_MOTOR_PULSE, S0_MOTOR_DIR, S0_MOTOR_WIRED_BACKWARD, S0_STEP_SIZE_DEG},
+    {S1_MOTOR_PULSE, S1_MOTOR_DIR, S1_MOTOR_WIRED_BACKWARD, S1_STEP_SIZE_DEG},
+    {PUMP_MOTOR_PULSE, PUMP_MOTOR_DIR, PUMP_MOTOR_WIRED_BACKWARD, PUMP_STEP_SIZE_DEG},
+};
+
+HostSimulation::HostSimulation(const HostSimulationOptions &options)
+    : options(options), physicalS0_deg(options.initialS0_deg), physicalS1_deg(options.initialS1_deg)
+{
+    HostHardware::Reset();
+    HostHardware::SetGpioListener(OnGpioChange, this);
+    TelemetryData = telemetry_data_t{};
+
+    nowQueue = xQueueCreate(NOW_QUEUE_DEPTH, sizeof(uint8_t));
+    cncQueue = xQueueCreate(CNC_QUEUE_DEPTH, sizeof(cmd_handle_t));
+
+    if (options.sharedStepTimer)
+    {
+        stepGenerator.reset(new BresenhamStepGenerator("STEPGEN"));
+        s0Output.reset(new BresenhamStepGenerator::Channel(*stepGenerator, S0_MOTOR_PULSE,
+                                                           S0_MOTOR_DIR, "S0MOTOR"));
+        s1Output.reset(new BresenhamStepGenerator::Channel(*stepGenerator, S1_MOTOR_PULSE,
+                                                           S1_MOTOR_DIR, "S1MOTOR"));
+        pumpOutput.reset(new BresenhamStepGenerator::Channel(*stepGenerator, PUMP_MOTOR_PULSE,
+                                                             PUMP_MOTOR_DIR, "PUMPMOTOR"));
+    }
+    else
+    {
+        s0Output.reset(new GptimerStepBackend(S0_MOTOR_PULSE, S0_MOTOR_DIR, "S0MOTOR"));
+        s1Output.reset(new GptimerStepBackend(S1_MOTOR_PULSE, S1_MOTOR_DIR, "S1MOTOR"));
+        pumpOutput.reset(new GptimerStepBackend(PUMP_MOTOR_PULSE, PUMP_MOTOR_DIR, "PUMPMOTOR"));
+    }
+    s0Motor.reset(new StepperMotor(*s0Output, S0_ACCEL_LIMIT_DEGPS2, S0_SPEED_LIMIT_DEGPS,
+                                   S0_STEP_SIZE_DEG, "S0MOTOR", S0_MOTOR_WIRED_BACKWARD));
+    s1Motor.reset(new StepperMotor(*s1Output, S1_ACCEL_LIMIT_DEGPS2, S1_SPEED_LIMIT_DEGPS,
+                                   S1_STEP_SIZE_DEG, "S1MOTOR", S1_MOTOR_WIRED_BACKWARD));
+    pumpMotor.reset(new StepperMotor(*pumpOutput, PUMP_ACCEL_LIMIT_DEGPS2, PUMP_SPEED_LIMIT_DEGPS,
+                                     PUMP_STEP_SIZE_DEG, "PUMPMOTOR", PUMP_MOTOR_WIRED_BACKWARD));
+    s0Motor->InitializeTimers(MOTOR_CONTROL_PERIOD_MS);
+    s1Motor->InitializeTimers(MOTOR_CONTROL_PERIOD_MS);
+    pumpMotor->InitializeTimers(MOTOR_CONTROL_PERIOD_MS);
+
+    // The controller believes the arm is where it physically starts, as after a homing run.
+    s0Motor->SetPosition(options.initialS0_deg);
+    s1Motor->SetPosition(options.initialS1_deg);
+
+    controlLoop.reset(new MotorControlLoop(*s0Motor, *s1Motor, *pumpMotor, nowQueue, cncQueue,
+                                           commandSlab, options.controlConfig));
+}
+
+HostSimulation::~HostSimulation()
+{
+    controlLoop.reset();
+    s0Motor.reset();
+    s1Motor.reset();
+    pumpMotor.reset();
+    s0Output.reset();
+    s1Output.reset();
+    pumpOutput.reset();
+    stepGenerator.reset();
+    vQueueDelete(nowQueue);
+    vQueueDelete(cncQueue);
+    HostHardware::Reset();
+}
+
+bool HostSimulation::AppendPacketStream(const uint8_t *data, size_t length)
+{
+    size_t offset = 0;
+    while (offset < length)
+    {
+        if (data[offset] == CNC_PROGRAM_OPCODE)
+        {
+            // Unpacked here as CommandHandler would: a program that fails its checks is refused.
+            size_t programLength = GetProgramPacketLength(data + offset, length - offset);
+            ProgramPacket program;
+            if (programLength == 0 || programLength > length - offset ||
+                ParseProgramPacket(data + offset, programLength, program) != ProgramPacketStatus::Ok)
+            {
+                return false;
+            }
+
+            size_t instructionOffset = 0;
+            const uint8_t *instruction = nullptr;
+            size_t instructionLength = 0;
+            while (NextProgramInstruction(program, instructionOffset, instruction, instructionLength))
+            {
+                Packet packet;
+                packet.opcode = instruction[0];
+                packet.payload.assign(instruction + 2, instruction + instructionLength);
+                packets.push_back(packet);
+            }
+            offset += programLength;
+            continue;
+        }
+
+        if (length - offset < 2 || length - offset - 2 < data[offset + 1])
+        {
+            return false;
+        }
+
+        Packet packet;
+        packet.opcode = data[offset];
+        packet.payload.assign(data + offset + 2, data + offset + 2 + data[offset + 1]);
+        packets.push_back(packet);
+        offset += 2 + data[offset + 1];
+    }
+    return true;
+}
+
+void HostSimulation::OnGpioChange(gpio_num_t pin, uint32_t level, int64_t time_us, void *context)
+{
+    (void)time_us;
+    HostSimulation *sim = static_cast<HostSimulation *>(context);
+    double *angles_deg[] = {&sim->physicalS0_deg, &sim->physicalS1_deg, &sim->physicalPump_deg};
+
+    for (size_t i = 0; i < sizeof(PHYSICAL_JOINTS) / sizeof(PHYSICAL_JOINTS[0]); i++)
+    {
+        const PhysicalJoint &joint = PHYSICAL_JOINTS[i];
+        if (pin != joint.stepPin)
+        {
+            continue;
+        }
+
+        // The driver steps on the rising edge, in the direction the dir pin selects.
+        if (level != 0 && sim->driversEnabled)
+        {
+            const bool forward = (HostHardware::GetGpioLevel(joint.dirPin) != 0) != joint.wiredBackward;
+            *angles_deg[i] += forward ? joint.stepSize_deg : -joint.stepSize_deg;
+        }
+        return;
+    }
+}
+
+bool HostSimulation::DeliverNextPacket()
+{
+    if (nextPacket >= packets.size())
+    {
+        return false;
+    }
+
+    const Packet &packet = packets[nextPacket];
+    if (packet.opcode >= PAUSE_OPCODE && packet.opcode <= STOP_OPCODE)
+    {
+        if (xQueueSend(nowQueue, &packet.opcode, 0) != pdTRUE)
+        {
+            return false;
+        }
+    }
+    else if (packet.opcode >= CNC_SPIRAL_OPCODE && packet.opcode <= CNC_SET_LOCAL_ORIGIN_OPCODE)
+    {
+        // Stands in for CommandHandlerTask: the decoded record goes into the slab and only its
+        // handle is queued. A full slab holds the packet back like a full queue.
+        uint8_t *instructions = nullptr;
+        cmd_handle_t handle = commandSlab.Allocate(0, 2 + packet.payload.size(), instructions);
+        if (handle == CMD_HANDLE_INVALID)
+        {
+            return false;
+        }
+        instructions[0] = packet.opcode;
+        instructions[1] = static_cast<uint8_t>(packet.payload.size());
+        std::copy(packet.payload.begin(), packet.payload.end(), instructions + 2);
+        if (xQueueSend(cncQueue, &handle, 0) != pdTRUE)
+        {
+            commandSlab.Release(handle);
+            return false;
+        }
+    }
+    // Echo and diagnostic packets never reach the motor controller.
+
+    nextPacket++;
+    return true;
+}
+
+void HostSimulation::UpdateLimitSwitches()
+{
+    TelemetryData.S0LimitSwitch = physicalS0_deg >= S0_LIMIT_ANGLE_DEG;
+    TelemetryData.S1LimitSwitch = physicalS1_deg <= S1_LIMIT_ANGLE_DEG;
+    driversEnabled = !(HostHardware::GetLimitSwitchHardStop() &&
+                       (TelemetryData.S0LimitSwitch || TelemetryData.S1LimitSwitch));
+}
+
+bool HostSimulation::MotorsStopped()
+{
+    motor_tlm_t tlm;
+    for (StepperMotor *motor : {s0Motor.get(), s1Motor.get(), pumpMotor.get()})
+    {
+        motor->GetTlm(&tlm);
+        if (tlm.Speed_degps != 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+HostSimulationMetrics HostSimulation::Run()
+{
+    HostSimulationMetrics metrics;
+    metrics.packetCount = static_cast<uint32_t>(packets.size());
+
+    const int64_t start_us = HostHardware::Now_us();
+    const uint32_t maxCycles = options.maxDuration_ms / MOTOR_CONTROL_PERIOD_MS;
+    const double startPump_deg = physicalPump_deg;
+    double sumSquaredError_m2 = 0.0;
+    Vector2D lastTip_m;
+    AngToCart(static_cast<float>(physicalS0_deg), static_cast<float>(physicalS1_deg), lastTip_m);
+
+    while (metrics.cycleCount < maxCycles)
+    {
+        while (DeliverNextPacket())
+        {
+        }
+
+        UpdateLimitSwitches();
+        controlLoop->RunCycle(MOTOR_CONTROL_PERIOD_MS, true);
+        metrics.cycleCount++;
+
+        const MotorControlState &state = controlLoop->GetState();
+        const bool tracking = !state.instructionComplete && !state.pauseActive && !state.cmdViaAngle;
+        const Vector2D target_m = state.target_m;
+
+        // Step ISRs for the rest of the period run here.
+        HostHardware::AdvanceTo(HostHardware::Now_us() + MOTOR_CONTROL_PERIOD_MS * 1000);
+
+        Vector2D tip_m;
+        AngToCart(static_cast<float>(physicalS0_deg), static_cast<float>(physicalS1_deg), tip_m);
+        metrics.pathLength_m += (tip_m - lastTip_m).magnitude();
+        lastTip_m = tip_m;
+
+        if (tracking)
+        {
+            double error_m = (target_m - tip_m).magnitude();
+            sumSquaredError_m2 += error_m * error_m;
+            metrics.trackingSampleCount++;
+            if (error_m > metrics.maxTrackingError_m)
+            {
+                metrics.maxTrackingError_m = error_m;
+            }
+        }
+
+        if (cycleObserver != nullptr)
+        {
+            cycleObserver(*this, cycleObserverContext);
+        }
+
+        if (nextPacket >= packets.size() && controlLoop->IsIdle() && MotorsStopped())
+        {
+            metrics.completed = true;
+            break;
+        }
+    }
+
+    metrics.jobDuration_s = (HostHardware::Now_us() - start_us) / 1e6;
+    metrics.stepTimerEventCount = HostHardware::GetAlarmCount();
+    metrics.pumpTravel_deg = physicalPump_deg - startPump_deg;
+    if (metrics.trackingSampleCount > 0)
+    {
+        metrics.rmsTrackingError_m = std::sqrt(sumSquaredError_m2 / metrics.trackingSampleCount);
+    }
+    return metrics;
+}
@@ -0,0 +1,134 @@
+#ifndef HOST_SIMULATION_H
+#define HOST_SIMULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BresenhamStepGenerator.h"
+#include "CommandSlab.h"
+#include "GptimerStepBackend.h"
+#include "MotorControlLoop.h"
+
+struct HostSimulationOptions
+{
+    // Physical and believed joint angles at t = 0. The default is the go-home pose.
+    float initialS0_deg = GO_HOME_S0_ANGLE_DEG;
+    float initialS1_deg = GO_HOME_S1_ANGLE_DEG;
+
+    // Controller tuning at power-up, before any configuration packet is applied.
+    MotorControlConfig controlConfig;
+
+    // Step all motors from one shared BresenhamStepGenerator ISR rather than a gptimer each.
+    bool sharedStepTimer = SHARED_STEP_TIMER;
+
+    // Give up on a program that never goes idle (e.g. an unmatched pause) after this long.
+    uint32_t maxDuration_ms = 4 * 3600 * 1000;
+};
+
+struct HostSimulationMetrics
+{
+    bool completed = false;
+    uint32_t cycleCount = 0;
+    uint64_t stepTimerEventCount = 0;
+    uint32_t packetCount = 0;
+
+    // Simulated time from the first cycle until the queue drained and the motors stopped.
+    double jobDuration_s = 0.0;
+
+    // Distance between the guidance carrot and the physical tip while a Cartesian instruction
+    // is active.
+    double maxTrackingError_m = 0.0;
+    double rmsTrackingError_m = 0.0;
+    uint32_t trackingSampleCount = 0;
+
+    // Net pump shaft travel; multiply by the pump's displacement per degree for volume.
+    double pumpTravel_deg = 0.0;
+
+    // Distance the physical tip moved, sampled once per cycle, for step ISR load per mm.
+    double pathLength_m = 0.0;
+};
+
+class HostSimulation;
+
+// Called once per control cycle, after the step ISRs for the period have run.
+typedef void (*HostSimulationCycleObserver)(const HostSimulation &simulation, void *context);
+
+// Runs the real MotorControlLoop against the HostHardware virtual clock. Step pulses drive a
+// simple physical model of each joint so tracking error and limit switches are measured against
+// where the arm actually is, not where the controller believes it is.
+//
+// HostHardware is process-wide, so only one HostSimulation may exist at a time.
+class HostSimulation
+{
+  public:
+    explicit HostSimulation(const HostSimulationOptions &options = HostSimulationOptions());
+    ~HostSimulation();
+
+    HostSimulation(const HostSimulation &) = delete;
+    HostSimulation &operator=(const HostSimulation &) = delete;
+
+    // Append a concatenated [opcode][len][payload] stream, as written by
+    // `CommandTerminal.py compile`; program packets are unpacked into their instructions.
+    // Returns false on a truncated record or a program that fails its checks.
+    bool AppendPacketStream(const uint8_t *data, size_t length);
+
+    // Run until every packet has been delivered and the controller is idle with the motors
+    // stopped, or until maxDuration_ms of simulated time has passed.
+    HostSimulationMetrics Run();
+
+    // Watch the arm cycle by cycle, e.g. to trace where the pump was on.
+    void SetCycleObserver(HostSimulationCycleObserver observer, void *context)
+    {
+        cycleObserver = observer;
+        cycleObserverContext = context;
+    }
+
+    double GetPhysicalS0_deg() const { return physicalS0_deg; }
+    double GetPhysicalS1_deg() const { return physicalS1_deg; }
+    double GetPhysicalPump_deg() const { return physicalPump_deg; }
+    const MotorControlState &GetControllerState() const { return controlLoop->GetState(); }
+    const CommandSlab &GetCommandSlab() const { return commandSlab; }
+
+  private:
+    struct Packet
+    {
+        uint8_t opcode;
+        std::vector<uint8_t> payload;
+    };
+
+    static void OnGpioChange(gpio_num_t pin, uint32_t level, int64_t time_us, void *context);
+    bool DeliverNextPacket();
+    void UpdateLimitSwitches();
+    bool MotorsStopped();
+
+    HostSimulationOptions options;
+    CommandSlab commandSlab;
+    QueueHandle_t nowQueue = nullptr;
+    QueueHandle_t cncQueue = nullptr;
+    std::unique_ptr<BresenhamStepGenerator> stepGenerator;
+    std::unique_ptr<StepOutputBackend> s0Output;
+    std::unique_ptr<StepOutputBackend> s1Output;
+    std::unique_ptr<StepOutputBackend> pumpOutput;
+    std::unique_ptr<StepperMotor> s0Motor;
+    std::unique_ptr<StepperMotor> s1Motor;
+    std::unique_ptr<StepperMotor> pumpMotor;
+    std::unique_ptr<MotorControlLoop> controlLoop;
+
+    HostSimulationCycleObserver cycleObserver = nullptr;
+    void *cycleObserverContext = nullptr;
+
+    std::vector<Packet> packets;
+    size_t nextPacket = 0;
+
+    double physicalS0_deg = 0.0;
+    double physicalS1_deg = 0.0;
+    double physicalPump_deg = 0.0;
+
+    // Mirrors Safety.c: drivers are disabled while a limit switch is pressed unless homing has
+    // relaxed the hard-stop policy.
+    bool driversEnabled = true;
+};
+
+#endif // HOST_SIMULATION_H
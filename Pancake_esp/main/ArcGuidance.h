@@ -25,19 +25,56 @@ class ArcGuidance : public GeneralGuidance
     void ApplyConfig(const ArcConfig &cfg)
     {
         Config = cfg;
+        Profile.Reset(cfg.LinearSpeed_mps);
         initialized = false;
     }
 
+    SegmentSpeedProfile *GetSpeedProfile() override { return &Profile; }
+    float GetRemainingPathLength_m() const override
+    {
+        float sweep_rad = initialized ? fabsf(Config.EndTheta_rad - cur_theta)
+                                      : fabsf(Config.EndTheta_rad - Config.StartTheta_rad);
+        return sweep_rad * Config.Radius_m;
+    }
+
+    bool GetPathPointAhead(Vector2D CurPos_m, float Distance_m, Vector2D &Point_m) const override
+    {
+        (void)CurPos_m;
+        if (Config.Radius_m <= 0.0f || Distance_m > GetRemainingPathLength_m())
+        {
+            return false;
+        }
+        float theta = initialized ? cur_theta : Config.StartTheta_rad;
+        float direction = (Config.EndTheta_rad >= Config.StartTheta_rad) ? 1.0f : -1.0f;
+        theta += direction * Distance_m / Config.Radius_m;
+        Point_m.x = Config.CenterX_m + sinf(theta) * Config.Radius_m;
+        Point_m.y = Config.CenterY_m + cosf(theta) * Config.Radius_m;
+        return true;
+    }
+
+    void SetPathSpeedLimit(float Limit_mps) override { Profile.speedLimit_mps = Limit_mps; }
+
     bool GetTargetPosition(unsigned int DeltaTime_ms, Vector2D CurPos_m, Vector2D &CmdPos_m,
                            bool &CmdViaAngle, float &S0Speed_degps, float &S1Speed_degps) override
+    {
+        GuidanceSetpoint setpoint;
+        bool done = GetTargetSetpoint(DeltaTime_ms, CurPos_m, setpoint, CmdViaAngle, S0Speed_degps,
+                                      S1Speed_degps);
+        CmdPos_m = setpoint.position_m;
+        return done;
+    }
+
+    bool GetTargetSetpoint(unsigned int DeltaTime_ms, Vector2D CurPos_m, GuidanceSetpoint &Setpoint,
+                           bool &CmdViaAngle, float &S0Speed_degps, float &S1Speed_degps) override
     {
         (void)S0Speed_degps;
         (void)S1Speed_degps;
         CmdViaAngle = false;
+        Setpoint = GuidanceSetpoint{};
 
         if (Config.Radius_m <= 0.0f || Config.LinearSpeed_mps <= 0.0f)
         {
-            CmdPos_m = CurPos_m;
+            Setpoint.position_m = CurPos_m;
             return true;
         }
 
@@ -50,22 +87,35 @@ class ArcGuidance : public GeneralGuidance
             initialized = true;
         }
 
-        float omega = Config.LinearSpeed_mps / Config.Radius_m; // rad/s
-        cur_theta += dir * omega * (DeltaTime_ms * C_MSToS);
+        float remaining_m = fabsf(Config.EndTheta_rad - cur_theta) * Config.Radius_m;
+        float step_m = Profile.Step(remaining_m, DeltaTime_ms * C_MSToS);
+        cur_theta += dir * step_m / Config.Radius_m;
 
         bool done = (dir > 0) ? (cur_theta >= Config.EndTheta_rad) : (cur_theta <= Config.EndTheta_rad);
+        float speed_mps = Profile.currentSpeed_mps;
         if (done)
         {
             cur_theta = Config.EndTheta_rad;
+            speed_mps = Profile.exitSpeed_mps;
         }
 
-        CmdPos_m.x = Center.x + sinf(cur_theta) * Config.Radius_m;
-        CmdPos_m.y = Center.y + cosf(cur_theta) * Config.Radius_m;
+        float s = sinf(cur_theta);
+        float c = cosf(cur_theta);
+        Setpoint.position_m.x = Center.x + s * Config.Radius_m;
+        Setpoint.position_m.y = Center.y + c * Config.Radius_m;
+
+        // Tangent to the circle in the direction of travel, and the centripetal acceleration.
+        float centripetal_mps2 = speed_mps * speed_mps / Config.Radius_m;
+        Setpoint.velocity_mps = Vector2D(c, -s) * (dir * speed_mps);
+        Setpoint.acceleration_mps2 = Vector2D(s, c) * (-centripetal_mps2);
+        Setpoint.hasVelocity = true;
+        Setpoint.hasAcceleration = true;
 
         return done;
     }
 
     ArcConfig Config;
+    SegmentSpeedProfile Profile;
 
   private:
     bool initialized;
@@ -12,15 +12,34 @@ bool IsFiniteSpiralConfig(const SpiralConfig &config)
            isfinite(config.CenterY_m) &&
            isfinite(config.MaxRadius_m);
 }
+
+// Arc length of r = k * theta from the centre out to theta.
+float SpiralArcLength_m(float theta_rad, float k_mprad)
+{
+    return 0.5f * k_mprad * (theta_rad * sqrtf(1.0f + theta_rad * theta_rad) + asinhf(theta_rad));
+}
 } // namespace
 
 bool ArchimedeanSpiral::GetTargetPosition(unsigned int DeltaTime_ms, Vector2D CurPos_m,
                                           Vector2D &CmdPos_m, bool &CmdViaAngle,
                                           float &S0Speed_degps, float &S1Speed_degps)
+{
+    GuidanceSetpoint setpoint;
+    bool done = GetTargetSetpoint(DeltaTime_ms, CurPos_m, setpoint, CmdViaAngle, S0Speed_degps,
+                                  S1Speed_degps);
+    CmdPos_m = setpoint.position_m;
+    return done;
+}
+
+bool ArchimedeanSpiral::GetTargetSetpoint(unsigned int DeltaTime_ms, Vector2D CurPos_m,
+                                          GuidanceSetpoint &Setpoint, bool &CmdViaAngle,
+                                          float &S0Speed_degps, float &S1Speed_degps)
 {
     (void)S0Speed_degps;
     (void)S1Speed_degps;
     CmdViaAngle = false;
+    Setpoint = GuidanceSetpoint{};
+    Vector2D &CmdPos_m = Setpoint.position_m;
 
     if (!IsFiniteSpiralConfig(Config) || Config.SpiralConstant_mprad <= 0.0f ||
         Config.SpiralRate_radps <= 0.0f || Config.MaxRadius_m <= 0.0f)
@@ -59,17 +78,65 @@ bool ArchimedeanSpiral::GetTargetPosition(unsigned int DeltaTime_ms, Vector2D Cu
         spiralRate_rdps = Config.LinearSpeed_mps / radius_m;
     }
 
+    // The tip moves at rate * |d(position)/d(theta)| = rate * hypot(r, k).
+    float pathPerRad_m = hypotf(radius_m, Config.SpiralConstant_mprad);
+    if (spiralRate_rdps * pathPerRad_m > pathSpeedLimit_mps)
+    {
+        spiralRate_rdps = pathSpeedLimit_mps / pathPerRad_m;
+    }
+
     if (!isfinite(spiralRate_rdps))
     {
         CmdPos_m = CurPos_m;
         return true;
     }
 
+    // d/dt of r(sin, cos) with r = k * theta.
+    float sinTheta = sinf(theta_rad);
+    float cosTheta = cosf(theta_rad);
+    Setpoint.velocity_mps.x =
+        spiralRate_rdps * (Config.SpiralConstant_mprad * sinTheta + radius_m * cosTheta);
+    Setpoint.velocity_mps.y =
+        spiralRate_rdps * (Config.SpiralConstant_mprad * cosTheta - radius_m * sinTheta);
+    Setpoint.hasVelocity = true;
+
     theta_rad = theta_rad + DeltaTime_ms * spiralRate_rdps * 0.001f;
 
     if (radius_m > Config.MaxRadius_m)
     {
+        // The spiral ends at rest; nothing blends out of it.
+        Setpoint.velocity_mps = Vector2D(0.0f, 0.0f);
         return true;
     }
     return false;
 }
+
+bool ArchimedeanSpiral::GetPathPointAhead(Vector2D CurPos_m, float Distance_m,
+                                          Vector2D &Point_m) const
+{
+    (void)CurPos_m;
+    if (!IsFiniteSpiralConfig(Config) || Config.SpiralConstant_mprad <= 0.0f ||
+        Config.MaxRadius_m <= 0.0f)
+    {
+        return false;
+    }
+
+    // Newton's method on the arc length from the centre. Starting from the tangent at the
+    // current angle it approaches from above, since the arc length is convex in theta.
+    const float k = Config.SpiralConstant_mprad;
+    const float target_m = SpiralArcLength_m(theta_rad, k) + Distance_m;
+    float theta = theta_rad + Distance_m / (k * sqrtf(1.0f + theta_rad * theta_rad));
+    for (int i = 0; i < 6; i++)
+    {
+        theta -= (SpiralArcLength_m(theta, k) - target_m) / (k * sqrtf(1.0f + theta * theta));
+    }
+    float radius_m = theta * k;
+    if (radius_m > Config.MaxRadius_m)
+    {
+        return false;
+    }
+
+    Point_m.x = Config.CenterX_m + sinf(theta) * radius_m;
+    Point_m.y = Config.CenterY_m + cosf(theta) * radius_m;
+    return true;
+}
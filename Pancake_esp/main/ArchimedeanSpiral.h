@@ -22,22 +22,29 @@ class ArchimedeanSpiral : public GeneralGuidance
 
     bool GetTargetPosition(unsigned int DeltaTime_ms, Vector2D CurPos_m, Vector2D &CmdPos_m,
                            bool &CmdViaAngle, float &S0Speed_degps, float &S1Speed_degps) override;
+    bool GetTargetSetpoint(unsigned int DeltaTime_ms, Vector2D CurPos_m, GuidanceSetpoint &Setpoint,
+                           bool &CmdViaAngle, float &S0Speed_degps, float &S1Speed_degps) override;
 
     // Common to all guidance types
     uint8_t GetOpCode() const override { return CNC_SPIRAL_OPCODE; }
     const void *GetConfig() const override { return &Config; }
     size_t GetConfigLength() const override { return sizeof(Config); }
 
+    bool GetPathPointAhead(Vector2D CurPos_m, float Distance_m, Vector2D &Point_m) const override;
+    void SetPathSpeedLimit(float Limit_mps) override { pathSpeedLimit_mps = Limit_mps; }
+
     void ApplyConfig(const SpiralConfig &cfg)
     {
         Config = cfg;
         theta_rad = 0.0f;
+        pathSpeedLimit_mps = INFINITY;
     }
 
     SpiralConfig Config;
 
   private:
     float theta_rad = 0.0;
+    float pathSpeedLimit_mps = INFINITY;
 };
 
 #endif // ARCHIMEDEAN_SPIRAL_H
@@ -0,0 +1,297 @@
+#include "BresenhamStepGenerator.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+// High time of each step pulse. The handlers already run while the pins are high; this covers
+// the 1.9 us a DRV8825 needs on top of that.
+#define STEP_PULSE_WIDTH_US 2
+
+BresenhamStepGenerator::Channel::Channel(BresenhamStepGenerator &generator, gpio_num_t stepPin,
+                                         gpio_num_t dirPin, const char *name)
+    : m_Generator(generator), m_stepPin(stepPin), m_dirPin(dirPin), m_name(name),
+      m_Registered(false), m_OnStep(nullptr), m_Context(nullptr), m_Period_ticks(0),
+      m_SinceStep_ticks(0), m_Running(false)
+{
+    // Configure GPIO pins
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    io_conf.pin_bit_mask = (1ULL << m_stepPin) | (1ULL << m_dirPin);
+    gpio_config(&io_conf);
+
+    m_Registered = m_Generator.Register(this);
+}
+
+esp_err_t BresenhamStepGenerator::Channel::Init(uint32_t resolution_hz, StepHandler onStep,
+                                                void *context)
+{
+    if (!m_Registered)
+    {
+        ESP_LOGE(m_name, "No free channel on step generator %s", m_Generator.m_name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    m_OnStep = onStep;
+    m_Context = context;
+    return m_Generator.InitTimer(resolution_hz);
+}
+
+esp_err_t BresenhamStepGenerator::Channel::SetToggleInterval(uint64_t ticks)
+{
+    // The generator emits whole pulses, so it works in step periods rather than toggles.
+    portENTER_CRITICAL(&m_Generator.m_Mux);
+    m_Period_ticks = 2 * ticks;
+    bool running = m_Running;
+    portEXIT_CRITICAL(&m_Generator.m_Mux);
+
+    return running ? m_Generator.Reschedule() : ESP_OK;
+}
+
+esp_err_t BresenhamStepGenerator::Channel::Start()
+{
+    if (m_OnStep == nullptr)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&m_Generator.m_Mux);
+    if (m_Running)
+    {
+        portEXIT_CRITICAL(&m_Generator.m_Mux);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The next alarm adds everything since the last one, so back-date by what has already
+    // passed. As with a toggling timer the first rising edge comes half a period after the start.
+    uint64_t sinceAlarm_ticks = 0;
+    if (m_Generator.m_TimerRunning)
+    {
+        gptimer_get_raw_count(m_Generator.m_Timer, &sinceAlarm_ticks);
+    }
+    m_SinceStep_ticks =
+        static_cast<int64_t>(m_Period_ticks / 2) - static_cast<int64_t>(sinceAlarm_ticks);
+    m_Running = true;
+    portEXIT_CRITICAL(&m_Generator.m_Mux);
+
+    return m_Generator.Reschedule();
+}
+
+esp_err_t BresenhamStepGenerator::Channel::Stop()
+{
+    portENTER_CRITICAL(&m_Generator.m_Mux);
+    bool wasRunning = m_Running;
+    m_Running = false;
+    portEXIT_CRITICAL(&m_Generator.m_Mux);
+
+    if (!wasRunning)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return m_Generator.Reschedule();
+}
+
+void BresenhamStepGenerator::Channel::SetDirectionLevel(bool level)
+{
+    gpio_set_level(m_dirPin, level);
+}
+
+BresenhamStepGenerator::BresenhamStepGenerator(const char *name)
+    : m_name(name), m_Channels{}, m_ChannelCount(0), m_Timer(nullptr), m_Resolution_hz(0),
+      m_TimerRunning(false)
+{
+    m_Mux = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool BresenhamStepGenerator::Register(Channel *channel)
+{
+    if (m_ChannelCount >= MAX_CHANNELS)
+    {
+        return false;
+    }
+    m_Channels[m_ChannelCount++] = channel;
+    return true;
+}
+
+esp_err_t BresenhamStepGenerator::InitTimer(uint32_t resolution_hz)
+{
+    // Every channel's periods count in the same timer ticks.
+    if (m_Timer != nullptr)
+    {
+        return (resolution_hz == m_Resolution_hz) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+
+    gptimer_config_t timer_config = {};
+    timer_config.clk_src = GPTIMER_CLK_SRC_APB;
+    timer_config.direction = GPTIMER_COUNT_UP;
+    timer_config.resolution_hz = resolution_hz;
+
+    esp_err_t err = gptimer_new_timer(&timer_config, &m_Timer);
+    if (err != ESP_OK)
+    {
+        m_Timer = nullptr;
+        return err;
+    }
+    gptimer_event_callbacks_t step_cbs = {};
+    step_cbs.on_alarm = OnAlarm;
+    err = gptimer_register_event_callbacks(m_Timer, &step_cbs, this);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    m_Resolution_hz = resolution_hz;
+    ESP_LOGI(m_name, "Shared step timer: %lu hz", (unsigned long)resolution_hz);
+    return gptimer_enable(m_Timer);
+}
+
+esp_err_t BresenhamStepGenerator::Reschedule()
+{
+    if (m_Timer == nullptr)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&m_Mux);
+    const bool anyRunning = Master() != nullptr;
+    const bool timerRunning = m_TimerRunning;
+    esp_err_t err = ESP_OK;
+    if (anyRunning && timerRunning)
+    {
+        // Re-aim the pending alarm at the (possibly new) master's next step.
+        uint64_t sinceAlarm_ticks = 0;
+        err = gptimer_get_raw_count(m_Timer, &sinceAlarm_ticks);
+        if (err == ESP_OK)
+        {
+            gptimer_alarm_config_t alarm_config = {};
+            alarm_config.alarm_count = NextAlarm_ticks(sinceAlarm_ticks);
+            alarm_config.flags.auto_reload_on_alarm = true;
+            err = gptimer_set_alarm_action(m_Timer, &alarm_config);
+        }
+    }
+    portEXIT_CRITICAL(&m_Mux);
+
+    if (anyRunning && !timerRunning)
+    {
+        // Channels only start from task context, so nothing else can start the timer meanwhile.
+        err = gptimer_set_raw_count(m_Timer, 0);
+        if (err == ESP_OK)
+        {
+            gptimer_alarm_config_t alarm_config = {};
+            portENTER_CRITICAL(&m_Mux);
+            alarm_config.alarm_count = NextAlarm_ticks(0);
+            portEXIT_CRITICAL(&m_Mux);
+            alarm_config.flags.auto_reload_on_alarm = true;
+            err = gptimer_set_alarm_action(m_Timer, &alarm_config);
+        }
+        if (err == ESP_OK)
+        {
+            err = gptimer_start(m_Timer);
+        }
+        m_TimerRunning = (err == ESP_OK);
+    }
+    else if (!anyRunning && timerRunning)
+    {
+        err = gptimer_stop(m_Timer);
+        m_TimerRunning = false;
+    }
+    return err;
+}
+
+const BresenhamStepGenerator::Channel *IRAM_ATTR BresenhamStepGenerator::Master() const
+{
+    const Channel *master = nullptr;
+    for (size_t i = 0; i < m_ChannelCount; i++)
+    {
+        const Channel *channel = m_Channels[i];
+        if (channel->m_Running && channel->m_Period_ticks != 0 &&
+            (master == nullptr || channel->m_Period_ticks < master->m_Period_ticks))
+        {
+            master = channel;
+        }
+    }
+    return master;
+}
+
+uint64_t IRAM_ATTR BresenhamStepGenerator::NextAlarm_ticks(uint64_t sinceAlarm_ticks) const
+{
+    const Channel *master = Master();
+    if (master == nullptr)
+    {
+        return 0;
+    }
+
+    int64_t due_ticks = static_cast<int64_t>(master->m_Period_ticks) - master->m_SinceStep_ticks;
+    if (due_ticks <= static_cast<int64_t>(sinceAlarm_ticks))
+    {
+        due_ticks = static_cast<int64_t>(sinceAlarm_ticks) + 1;
+    }
+    return static_cast<uint64_t>(due_ticks);
+}
+
+// Shared step timer ISR callback
+bool IRAM_ATTR BresenhamStepGenerator::OnAlarm(gptimer_handle_t timer,
+                                               const gptimer_alarm_event_data_t *edata,
+                                               void *user_ctx)
+{
+    BresenhamStepGenerator *generator = static_cast<BresenhamStepGenerator *>(user_ctx);
+    // The alarm auto-reloads to 0, so its count is the time since the previous alarm.
+    const int64_t elapsed_ticks = static_cast<int64_t>(edata->alarm_value);
+
+    portENTER_CRITICAL_ISR(&generator->m_Mux);
+    const Channel *master = generator->Master();
+    const int64_t masterPeriod_ticks =
+        (master != nullptr) ? static_cast<int64_t>(master->m_Period_ticks) : 0;
+
+    // Raise every step pin that is due, nearest master edge first...
+    bool stepped[MAX_CHANNELS] = {};
+    for (size_t i = 0; i < generator->m_ChannelCount; i++)
+    {
+        Channel *channel = generator->m_Channels[i];
+        if (!channel->m_Running || channel->m_Period_ticks == 0)
+        {
+            continue;
+        }
+
+        int64_t sinceStep_ticks = channel->m_SinceStep_ticks + elapsed_ticks;
+        const int64_t period_ticks = static_cast<int64_t>(channel->m_Period_ticks);
+        if (2 * sinceStep_ticks + masterPeriod_ticks >= 2 * period_ticks)
+        {
+            sinceStep_ticks -= period_ticks;
+            stepped[i] = true;
+            gpio_set_level(channel->m_stepPin, 1);
+        }
+        channel->m_SinceStep_ticks = sinceStep_ticks;
+    }
+
+    // ...let each motor count its step and ramp to its next period while the pins are high...
+    for (size_t i = 0; i < generator->m_ChannelCount; i++)
+    {
+        if (stepped[i])
+        {
+            Channel *channel = generator->m_Channels[i];
+            uint64_t nextInterval = channel->m_OnStep(channel->m_Context);
+            if (nextInterval != 0)
+            {
+                channel->m_Period_ticks = 2 * nextInterval;
+            }
+        }
+    }
+
+    // ...and finish the pulses in the same interrupt.
+    esp_rom_delay_us(STEP_PULSE_WIDTH_US);
+    for (size_t i = 0; i < generator->m_ChannelCount; i++)
+    {
+        if (stepped[i])
+        {
+            gpio_set_level(generator->m_Channels[i]->m_stepPin, 0);
+        }
+    }
+
+    gptimer_alarm_config_t alarm_config = {};
+    alarm_config.alarm_count = generator->NextAlarm_ticks(0);
+    alarm_config.flags.auto_reload_on_alarm = true;
+    // With nothing running the task is about to stop the timer; disarm until it does.
+    gptimer_set_alarm_action(timer, (alarm_config.alarm_count != 0) ? &alarm_config : nullptr);
+    portEXIT_CRITICAL_ISR(&generator->m_Mux);
+
+    return false;
+}
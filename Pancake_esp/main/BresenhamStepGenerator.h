@@ -0,0 +1,90 @@
+#ifndef BRESENHAM_STEP_GENERATOR_H
+#define BRESENHAM_STEP_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+
+#include "StepOutputBackend.h"
+
+// One timer ISR for every axis. The running axis with the shortest step period is the master:
+// the alarm fires once per master step. Every other axis keeps a Bresenham-style error term (the
+// ticks since its last step) and steps on whichever master step lands nearest its own step
+// time, so S0 and S1 pulses share ISR edges instead of drifting against each other. Each ISR
+// emits complete pulses, raising and lowering the step pins in the same interrupt.
+//
+// Compared with a GptimerStepBackend per axis (two alarms per step per axis) this takes one
+// alarm per master step, at the cost of up to half a master period of jitter on the slower
+// axes. Needs CONFIG_GPTIMER_CTRL_FUNC_IN_IRAM and, to keep stepping through flash erases,
+// CONFIG_GPTIMER_ISR_IRAM_SAFE (both set in sdkconfig); see GptimerStepBackend.h.
+class BresenhamStepGenerator
+{
+  public:
+    static constexpr size_t MAX_CHANNELS = 3;
+
+    // One axis of the generator, handed to a StepperMotor in place of a GptimerStepBackend.
+    class Channel : public StepOutputBackend
+    {
+      public:
+        Channel(BresenhamStepGenerator &generator, gpio_num_t stepPin, gpio_num_t dirPin,
+                const char *name);
+
+        esp_err_t Init(uint32_t resolution_hz, StepHandler onStep, void *context) override;
+        esp_err_t SetToggleInterval(uint64_t ticks) override;
+        esp_err_t Start() override;
+        esp_err_t Stop() override;
+        void SetDirectionLevel(bool level) override;
+
+      private:
+        friend class BresenhamStepGenerator;
+
+        BresenhamStepGenerator &m_Generator;
+        gpio_num_t m_stepPin;
+        gpio_num_t m_dirPin;
+        const char *m_name;
+        bool m_Registered;
+
+        StepHandler m_OnStep;
+        void *m_Context;
+
+        // Shared with the ISR under the generator's mux.
+        volatile uint64_t m_Period_ticks;
+        // Ticks since this channel's last step as of the previous alarm; negative when a step
+        // was taken slightly early to line up with the master.
+        volatile int64_t m_SinceStep_ticks;
+        volatile bool m_Running;
+    };
+
+    explicit BresenhamStepGenerator(const char *name);
+
+  private:
+    static bool IRAM_ATTR OnAlarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata,
+                                  void *user_ctx);
+
+    bool Register(Channel *channel);
+    esp_err_t InitTimer(uint32_t resolution_hz);
+
+    // Start, re-arm or stop the shared timer after a channel changed state in task context.
+    esp_err_t Reschedule();
+
+    // Alarm count, measured from the last alarm, for the next master step; 0 when no channel
+    // is running. `sinceAlarm_ticks` is how much of that wait has already passed.
+    uint64_t IRAM_ATTR NextAlarm_ticks(uint64_t sinceAlarm_ticks) const;
+    const Channel *IRAM_ATTR Master() const;
+
+    const char *m_name;
+    Channel *m_Channels[MAX_CHANNELS];
+    size_t m_ChannelCount;
+
+    gptimer_handle_t m_Timer;
+    uint32_t m_Resolution_hz;
+    bool m_TimerRunning;
+
+    portMUX_TYPE m_Mux;
+};
+
+#endif // BRESENHAM_STEP_GENERATOR_H
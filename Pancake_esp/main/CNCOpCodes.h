@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 constexpr uint8_t CNC_SPIRAL_OPCODE = 0x11;
@@ -17,3 +18,68 @@ constexpr uint8_t CNC_GO_TO_ANGLE_OPCODE = 0x1C;
 constexpr uint8_t CNC_HOME_OPCODE = 0x1D;
 constexpr uint8_t CNC_GO_HOME_OPCODE = 0x1E;
 constexpr uint8_t CNC_SET_LOCAL_ORIGIN_OPCODE = 0x1F;
+
+// Container for many of the instructions above in one transport message (ProgramPacket.h).
+constexpr uint8_t CNC_PROGRAM_OPCODE = 0x20;
+
+// Program store commands, handled by CommandHandler (ProgramStore.h). Payloads are little-endian.
+constexpr uint8_t PROGRAM_STORE_BEGIN_OPCODE = 0x05;  // u32 hash, u32 length
+constexpr uint8_t PROGRAM_STORE_DATA_OPCODE = 0x06;   // u32 offset, program bytes
+constexpr uint8_t PROGRAM_STORE_COMMIT_OPCODE = 0x07; // u32 hash
+constexpr uint8_t PROGRAM_RUN_STORED_OPCODE = 0x08;   // u32 hash, u32 length
+
+// Control loop capture (ControlCapture.h), handled by CommandHandler.
+constexpr uint8_t CAPTURE_ARM_OPCODE = 0x09;     // u16 cycles kept after the trigger, u8 trigger mask
+constexpr uint8_t CAPTURE_TRIGGER_OPCODE = 0x0A; // no payload
+
+// Instructions that are executed by MotorControl, in order, from cmd_queue_cnc.
+inline bool IsCncOpcode(uint8_t opcode)
+{
+    return opcode >= CNC_SPIRAL_OPCODE && opcode <= CNC_SET_LOCAL_ORIGIN_OPCODE;
+}
+
+// Raw records on cmd_queue_fast_decode are base64 text from InfluxDB or binary commands from the
+// push channel. Every opcode is below '+', the lowest base64 character, so a record's first byte
+// says which it is.
+inline bool IsBinaryCommandOpcode(uint8_t opcode)
+{
+    return opcode != 0 && opcode < '+';
+}
+
+// Pause (0x01), resume (0x02) and stop (0x03), which go straight to MotorControl on cmd_queue_now
+// and may use the slab's reserve (COMMAND_SLAB_RESERVE_BYTES).
+inline bool IsImmediateOpcode(uint8_t opcode)
+{
+    return opcode >= 0x01 && opcode <= 0x03;
+}
+
+// Opcode of a raw record without decoding it: the first byte of a binary command, or the byte
+// encoded by the first two characters of base64 text. 0 if the record is too short to tell.
+inline uint8_t PeekRawCommandOpcode(const uint8_t *raw, size_t length)
+{
+    if (length > 0 && IsBinaryCommandOpcode(raw[0]))
+    {
+        return raw[0];
+    }
+    if (length < 2)
+    {
+        return 0;
+    }
+    auto sextet = [](uint8_t c) -> uint8_t
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            return c - 'A';
+        }
+        if (c >= 'a' && c <= 'z')
+        {
+            return c - 'a' + 26;
+        }
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0' + 52;
+        }
+        return (c == '+') ? 62 : 63;
+    };
+    return static_cast<uint8_t>((sextet(raw[0]) << 2) | (sextet(raw[1]) >> 4));
+}
@@ -0,0 +1,82 @@
+#include "CommandFrameReader.h"
+
+#include <cstring>
+
+#include "CNCOpCodes.h"
+#include "ProgramPacket.h"
+
+size_t CommandFrameReader::ExpectedLength() const
+{
+    if (received < 2)
+    {
+        return 0;
+    }
+    if (frame[0] != CNC_PROGRAM_OPCODE)
+    {
+        return 2 + static_cast<size_t>(frame[1]);
+    }
+    return GetProgramPacketLength(frame, received);
+}
+
+size_t CommandFrameReader::Consume(const uint8_t *data, size_t length)
+{
+    if (broken || frameReady)
+    {
+        return 0;
+    }
+
+    size_t used = 0;
+    while (used < length)
+    {
+        // Read the header a byte at a time, then the rest of the frame in one copy.
+        size_t expected = ExpectedLength();
+        size_t want = (expected == 0) ? 1 : expected - received;
+        size_t take = (length - used < want) ? length - used : want;
+        memcpy(frame + received, data + used, take);
+        received += take;
+        used += take;
+
+        if (received == 1 && !IsBinaryCommandOpcode(frame[0]))
+        {
+            broken = true;
+            return used;
+        }
+        if (expected == 0)
+        {
+            expected = ExpectedLength();
+            bool tooLong = (frame[0] == CNC_PROGRAM_OPCODE) ? expected > CMD_PROGRAM_MAX_LEN
+                                                            : received == 2 && frame[1] > CMD_INSTRUCTION_PAYLOAD_MAX_LEN;
+            bool badProgramHeader = frame[0] == CNC_PROGRAM_OPCODE && received == 2 && frame[1] != PROGRAM_HEADER_LEN;
+            if (tooLong || badProgramHeader)
+            {
+                broken = true;
+                return used;
+            }
+        }
+        if (expected != 0 && received == expected)
+        {
+            frameReady = true;
+            return used;
+        }
+    }
+    return used;
+}
+
+const uint8_t *CommandFrameReader::GetFrame(size_t &length) const
+{
+    length = frameReady ? received : 0;
+    return frameReady ? frame : nullptr;
+}
+
+void CommandFrameReader::TakeFrame()
+{
+    frameReady = false;
+    received = 0;
+}
+
+void CommandFrameReader::Reset()
+{
+    received = 0;
+    frameReady = false;
+    broken = false;
+}
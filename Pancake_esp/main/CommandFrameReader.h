@@ -0,0 +1,43 @@
+#ifndef COMMAND_FRAME_READER_H
+#define COMMAND_FRAME_READER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "DataModel.h"
+
+// Splits a byte stream back into the [opcode][len][payload] commands written into it, for the
+// push channel (PushCommandChannel.h), where a command may arrive in pieces and several may
+// share one read. Program packets are framed by their own header (ProgramPacket.h), so a whole
+// program comes out as one frame.
+//
+// A stream has no way to resynchronise after a bad frame, so an opcode that cannot start a
+// command or a length beyond the limits leaves the reader broken until Reset; the channel then
+// drops the connection and starts a fresh stream.
+class CommandFrameReader
+{
+  public:
+    // Take bytes from data[0..length) up to the end of the next frame. Returns how many were
+    // used; call again with the rest once the frame has been collected with TakeFrame.
+    size_t Consume(const uint8_t *data, size_t length);
+
+    bool HasFrame() const { return frameReady; }
+    bool IsBroken() const { return broken; }
+
+    // The completed frame, valid until the next Consume or Reset.
+    const uint8_t *GetFrame(size_t &length) const;
+    void TakeFrame();
+
+    void Reset();
+
+  private:
+    // Bytes the frame will have in total once its header is in, or 0 while that is unknown.
+    size_t ExpectedLength() const;
+
+    uint8_t frame[CMD_PROGRAM_MAX_LEN];
+    size_t received = 0;
+    bool frameReady = false;
+    bool broken = false;
+};
+
+#endif // COMMAND_FRAME_READER_H
@@ -1,68 +1,254 @@
 #include "CommandHandler.h"
 #include "CNCOpCodes.h"
+#include "ControlTelemetry.h"
 #include "CrashDebug.h"
+#include "PartitionProgramStorage.h"
+#include "ProgramFeeder.h"
+#include "ProgramPacket.h"
+#include "defines.h"
 
 static const char *TAG = "CommandHandler";
 
+// Handles are two bytes, so the queues can be far deeper than the slab is ever likely to fill.
+static constexpr UBaseType_t FAST_DECODE_QUEUE_DEPTH = 64;
+static constexpr UBaseType_t CNC_QUEUE_DEPTH = 256;
+
+CommandSlab cmd_slab;
 QueueHandle_t cmd_queue_fast_decode;
 QueueHandle_t cmd_queue_cnc;
 QueueHandle_t cmd_queue_now;
 
-static inline bool is_cnc_opcode(uint8_t op)
-{
-    switch (op)
-    {
-        case CNC_SPIRAL_OPCODE:
-        case CNC_JOG_OPCODE:
-        case CNC_WAIT_OPCODE:
-        case CNC_SINE_OPCODE:
-        case CNC_CONSTANT_SPEED_OPCODE:
-        case CNC_CONFIG_MOTOR_LIMITS_OPCODE:
-        case CNC_CONFIG_PUMP_CONSTANT_OPCODE:
-        case CNC_ARC_OPCODE:
-        case CNC_PUMP_PURGE_OPCODE:
-        case CNC_CONFIG_ACCEL_SCALE_OPCODE:
-        case CNC_RECTANGLE_OPCODE:
-        case CNC_GO_TO_ANGLE_OPCODE:
-        case CNC_HOME_OPCODE:
-        case CNC_GO_HOME_OPCODE:
-        case CNC_SET_LOCAL_ORIGIN_OPCODE:
-            return true;
-        default:
-            return false;
-    }
-}
+// Handles of one program's instructions between allocation and queueing. A program is only
+// unpacked when the CNC queue has room for all of it, so it never needs more than the depth.
+static cmd_handle_t program_handles[CNC_QUEUE_DEPTH];
+
+// Programs uploaded to flash and the feeder that runs them. Null when the partition is missing.
+static PartitionProgramStorage program_storage;
+static ProgramStore *program_store = nullptr;
+static ProgramFeeder *program_feeder = nullptr;
 
 void CommandHandlerInit(void)
 {
-    cmd_queue_fast_decode = xQueueCreate(32, sizeof(raw_cmd_payload_t));
+    cmd_queue_fast_decode = xQueueCreate(FAST_DECODE_QUEUE_DEPTH, sizeof(cmd_handle_t));
     assert(cmd_queue_fast_decode != NULL);
-    cmd_queue_cnc = xQueueCreate(32, sizeof(decoded_cmd_payload_t));
+    cmd_queue_cnc = xQueueCreate(CNC_QUEUE_DEPTH, sizeof(cmd_handle_t));
     assert(cmd_queue_cnc != NULL);
     cmd_queue_now = xQueueCreate(8, sizeof(uint8_t));
     assert(cmd_queue_now != NULL);
+
+    if (program_storage.Init() == ESP_OK)
+    {
+        static ProgramStore store(program_storage);
+        static ProgramFeeder feeder(store, cmd_slab, cmd_queue_cnc);
+        program_store = &store;
+        program_feeder = &feeder;
+    }
+}
+
+static bool stored_program_running(void)
+{
+    return program_feeder != nullptr && program_feeder->IsRunning();
+}
+
+// True while motion is queued or any motor is turning. Erasing flash turns the cache off for both
+// cores, which would stall the control task for the length of the erase.
+static bool arm_moving(void)
+{
+    control_tlm_t tlm;
+    ControlTelemetry.Read(tlm);
+    return uxQueueMessagesWaiting(cmd_queue_cnc) > 0 || tlm.S0MotorTlm.Speed_degps != 0.0f ||
+           tlm.S1MotorTlm.Speed_degps != 0.0f || tlm.PumpMotorTlm.Speed_degps != 0.0f;
+}
+
+static uint32_t read_u32(const uint8_t *data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Upload and run programs kept in flash. The payload layouts are listed with the opcodes.
+static void handle_program_store(const DecodedCommand &cmd)
+{
+    if (program_store == nullptr)
+    {
+        ESP_LOGE(TAG, "No program storage; ignoring opcode 0x%02X", cmd.opcode);
+        return;
+    }
+    const uint8_t *payload = cmd.instructions + 2;
+    const size_t expected_length = (cmd.opcode == PROGRAM_STORE_COMMIT_OPCODE) ? 4 : 8;
+    if ((cmd.opcode == PROGRAM_STORE_DATA_OPCODE) ? cmd.instruction_length < 4
+                                                  : cmd.instruction_length != expected_length)
+    {
+        ESP_LOGE(TAG, "Bad payload length %u for opcode 0x%02X", cmd.instruction_length, cmd.opcode);
+        return;
+    }
+
+    // The slot being fed from must not be erased under the feeder.
+    if (cmd.opcode != PROGRAM_RUN_STORED_OPCODE && stored_program_running())
+    {
+        ESP_LOGW(TAG, "Stored program running; ignoring upload opcode 0x%02X", cmd.opcode);
+        return;
+    }
+    // Beginning an upload erases its slot.
+    if (cmd.opcode == PROGRAM_STORE_BEGIN_OPCODE && arm_moving())
+    {
+        ESP_LOGW(TAG, "Arm moving; refusing to start a program upload");
+        return;
+    }
+
+    ProgramUploadStatus status = ProgramUploadStatus::Ok;
+    switch (cmd.opcode)
+    {
+        case PROGRAM_STORE_BEGIN_OPCODE:
+            status = program_store->BeginUpload(read_u32(payload), read_u32(payload + 4));
+            ESP_LOGI(TAG, "Program %08lx upload: %s", (unsigned long)read_u32(payload),
+                     ProgramUploadStatusName(status));
+            return;
+        case PROGRAM_STORE_DATA_OPCODE:
+            status = program_store->WriteChunk(read_u32(payload), payload + 4, cmd.instruction_length - 4);
+            if (status != ProgramUploadStatus::Ok && status != ProgramUploadStatus::AlreadyStored)
+            {
+                ESP_LOGE(TAG, "Program chunk at %lu: %s", (unsigned long)read_u32(payload),
+                         ProgramUploadStatusName(status));
+            }
+            return;
+        case PROGRAM_STORE_COMMIT_OPCODE:
+            status = program_store->CommitUpload(read_u32(payload));
+            ESP_LOGI(TAG, "Program %08lx stored: %s", (unsigned long)read_u32(payload),
+                     ProgramUploadStatusName(status));
+            return;
+        case PROGRAM_RUN_STORED_OPCODE:
+        {
+            StoredProgram program;
+            if (!program_store->Find(read_u32(payload), read_u32(payload + 4), program))
+            {
+                ESP_LOGE(TAG, "Program %08lx is not stored", (unsigned long)read_u32(payload));
+            }
+            else if (!program_feeder->Start(program))
+            {
+                ESP_LOGW(TAG, "A stored program is already running");
+            }
+            else
+            {
+                ESP_LOGI(TAG, "Running stored program %08lx (%lu bytes)", (unsigned long)program.hash,
+                         (unsigned long)program.length);
+            }
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+void CommandHandlerFeedStoredProgram(uint32_t queueClearCount)
+{
+    if (program_feeder != nullptr)
+    {
+        program_feeder->Feed(queueClearCount);
+    }
 }
 
-static void handle_command(const decoded_cmd_payload_t &cmd)
+// Unpack a program packet into one CNC queue record per instruction. Either every instruction
+// is queued, in order, or none is: the whole program is checked, and room in the queue and the
+// slab is secured, before the first handle goes out.
+static void handle_program(const DecodedCommand &cmd)
 {
-    // Expect at least opcode/len
-    if (cmd.instruction_length > CMD_INSTRUCTION_PAYLOAD_MAX_LEN) {
-        ESP_LOGE(TAG, "Instruction length too large: %u", cmd.instruction_length);
+    size_t length = 0;
+    int64_t timestamp_ms = 0;
+    const uint8_t *packet = cmd_slab.GetData(cmd.handle, length, timestamp_ms);
+    ProgramPacket program;
+    ProgramPacketStatus status =
+        (packet != nullptr) ? ParseProgramPacket(packet, length, program) : ProgramPacketStatus::Truncated;
+    if (status != ProgramPacketStatus::Ok)
+    {
+        ESP_LOGE(TAG, "Dropping program packet: %s", ProgramPacketStatusName(status));
+        return;
+    }
+
+    size_t offset = 0;
+    const uint8_t *instruction = nullptr;
+    size_t instruction_length = 0;
+    while (NextProgramInstruction(program, offset, instruction, instruction_length))
+    {
+        if (!IsCncOpcode(instruction[0]))
+        {
+            ESP_LOGE(TAG, "Program %u holds non-CNC opcode 0x%02X; dropping it", program.sequence, instruction[0]);
+            return;
+        }
+    }
+
+    // The controller only takes from the CNC queue, and the one other sender, the stored program
+    // feeder, is not running (handle_command checked). A feeder cancelled part way through a Feed
+    // may still send the instruction it was on, so leave room for that one too.
+    if (uxQueueSpacesAvailable(cmd_queue_cnc) < program.instruction_count + 1u)
+    {
+        ESP_LOGE(TAG, "CNC queue has no room for program %u (%u instructions); dropping it",
+                 program.sequence, program.instruction_count);
         return;
     }
 
-    if (is_cnc_opcode(cmd.opcode))
+    offset = 0;
+    size_t allocated = 0;
+    while (NextProgramInstruction(program, offset, instruction, instruction_length))
+    {
+        uint8_t *record = nullptr;
+        cmd_handle_t handle = cmd_slab.Allocate(timestamp_ms, instruction_length, record);
+        if (handle == CMD_HANDLE_INVALID)
+        {
+            ESP_LOGE(TAG, "Command slab full; dropping program %u", program.sequence);
+            for (size_t i = 0; i < allocated; i++)
+            {
+                cmd_slab.Release(program_handles[i]);
+            }
+            return;
+        }
+        memcpy(record, instruction, instruction_length);
+        program_handles[allocated++] = handle;
+    }
+
+    for (size_t i = 0; i < allocated; i++)
+    {
+        (void)xQueueSend(cmd_queue_cnc, &program_handles[i], 0);
+    }
+    ESP_LOGI(TAG, "Queued program %u (%u instructions)", program.sequence, program.instruction_count);
+}
+
+// Takes ownership of the decoded record: CNC commands pass it on to MotorControl, everything
+// else is handled here and released.
+static void handle_command(const DecodedCommand &cmd)
+{
+    // A stored program owns the CNC queue until it has been fed in full; motion from the network
+    // would land between its instructions.
+    if ((IsCncOpcode(cmd.opcode) || cmd.opcode == CNC_PROGRAM_OPCODE) && stored_program_running())
+    {
+        ESP_LOGW(TAG, "Stored program running; dropping opcode 0x%02X", cmd.opcode);
+        cmd_slab.Release(cmd.handle);
+        return;
+    }
+
+    if (IsCncOpcode(cmd.opcode))
     {
         // Queue CNC instruction for later execution by MotorControl
-        if (xQueueSend(cmd_queue_cnc, &cmd, 0) != pdTRUE)
+        if (xQueueSend(cmd_queue_cnc, &cmd.handle, 0) != pdTRUE)
         {
             ESP_LOGW(TAG, "CNC queue full; dropping opcode 0x%02X", cmd.opcode);
+            cmd_slab.Release(cmd.handle);
         }
         return;
     }
 
     switch (cmd.opcode)
     {
+        case CNC_PROGRAM_OPCODE:
+            handle_program(cmd);
+            break;
+        case PROGRAM_STORE_BEGIN_OPCODE:
+        case PROGRAM_STORE_DATA_OPCODE:
+        case PROGRAM_STORE_COMMIT_OPCODE:
+        case PROGRAM_RUN_STORED_OPCODE:
+            handle_program_store(cmd);
+            break;
         case 0x69: // Echo (legacy)
         {
             char msg[CMD_PAYLOAD_MAX_LEN];
@@ -89,10 +275,33 @@ static void handle_command(const decoded_cmd_payload_t &cmd)
         case 0x03: // Stop (clear queue + idle)
         {
             ESP_LOGW(TAG, "Stop Command Received");
+            // Stop feeding first, so the controller's queue clear is not refilled behind it.
+            if (program_feeder != nullptr)
+            {
+                program_feeder->Cancel();
+            }
             uint8_t code = 0x03;
             (void)xQueueSend(cmd_queue_now, &code, 0);
             break;
         }
+        case CAPTURE_ARM_OPCODE:
+        {
+            if (cmd.instruction_length != 3)
+            {
+                ESP_LOGE(TAG, "Bad payload length %u for opcode 0x%02X", cmd.instruction_length, cmd.opcode);
+                break;
+            }
+            uint16_t post_trigger = 0;
+            memcpy(&post_trigger, cmd.instructions + 2, sizeof(post_trigger));
+            uint8_t trigger_mask = cmd.instructions[4];
+            ControlLoopCapture.RequestArm(post_trigger, trigger_mask);
+            ESP_LOGI(TAG, "Capture armed: %u cycles after trigger, triggers 0x%02X", post_trigger, trigger_mask);
+            break;
+        }
+        case CAPTURE_TRIGGER_OPCODE:
+            ControlLoopCapture.RequestTrigger();
+            ESP_LOGI(TAG, "Capture triggered");
+            break;
         case 0x04: // Crash diagnostic
         {
             if (cmd.instruction_length != 0)
@@ -107,45 +316,108 @@ static void handle_command(const decoded_cmd_payload_t &cmd)
             ESP_LOGW(TAG, "Unknown opcode 0x%02X", cmd.opcode);
             break;
     }
+    cmd_slab.Release(cmd.handle);
+}
+
+// Check that a decoded command holds exactly one well-formed instruction, or a program packet.
+static bool check_decoded_command(const uint8_t *instructions, size_t length)
+{
+    if (length < 2)
+    {
+        ESP_LOGE(TAG, "Command too short: %u bytes", (unsigned)length);
+    }
+    else if (instructions[0] == CNC_PROGRAM_OPCODE)
+    {
+        // Checked as a whole, CRC included, when it is unpacked.
+        return length <= CMD_PROGRAM_MAX_LEN;
+    }
+    else if (length > CMD_PAYLOAD_MAX_LEN)
+    {
+        ESP_LOGE(TAG, "Command too long: %u bytes", (unsigned)length);
+    }
+    else if (instructions[1] > CMD_INSTRUCTION_PAYLOAD_MAX_LEN)
+    {
+        ESP_LOGE(TAG, "Instruction length too large: %u", instructions[1]);
+    }
+    else if (instructions[1] > length - 2)
+    {
+        ESP_LOGE(TAG, "Invalid instruction length %u for buffer %u", instructions[1], (unsigned)length);
+    }
+    else
+    {
+        return true;
+    }
+    return false;
+}
+
+// Decode one base64 record into a new record of exactly the decoded size. Returns the decoded
+// record's handle or CMD_HANDLE_INVALID; the raw record stays with the caller either way. A
+// binary record from the push channel is already decoded, so its own handle comes back.
+static cmd_handle_t decode_raw_command(cmd_handle_t raw)
+{
+    size_t raw_len = 0;
+    int64_t timestamp_ms = 0;
+    const uint8_t *text = cmd_slab.GetData(raw, raw_len, timestamp_ms);
+    if (text == nullptr)
+    {
+        ESP_LOGE(TAG, "Stale raw command handle %u", (unsigned)raw);
+        return CMD_HANDLE_INVALID;
+    }
+    if (raw_len > 0 && IsBinaryCommandOpcode(text[0]))
+    {
+        return check_decoded_command(text, raw_len) ? raw : CMD_HANDLE_INVALID;
+    }
+    size_t text_len = strnlen((const char *)text, raw_len);
+
+    // A null destination only reports the decoded size.
+    size_t out_len = 0;
+    int rc = mbedtls_base64_decode(NULL, 0, &out_len, text, text_len);
+    if ((rc != 0 && rc != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL) || out_len < 2 || out_len > CMD_PROGRAM_MAX_LEN)
+    {
+        ESP_LOGE(TAG, "Base64 decode failed or bad size (rc=%d, out_len=%u)", rc, (unsigned)out_len);
+        return CMD_HANDLE_INVALID;
+    }
+
+    const uint8_t opcode = PeekRawCommandOpcode(text, text_len);
+    uint8_t *instructions = nullptr;
+    cmd_handle_t decoded = cmd_slab.Allocate(timestamp_ms, out_len, instructions, IsImmediateOpcode(opcode));
+    if (decoded == CMD_HANDLE_INVALID)
+    {
+        ESP_LOGW(TAG, "Command slab full; dropping opcode 0x%02X", opcode);
+        return CMD_HANDLE_INVALID;
+    }
+
+    rc = mbedtls_base64_decode(instructions, out_len, &out_len, text, text_len);
+    if (rc != 0)
+    {
+        ESP_LOGE(TAG, "Base64 decode failed (rc=%d)", rc);
+    }
+    else if (check_decoded_command(instructions, out_len))
+    {
+        return decoded;
+    }
+    cmd_slab.Release(decoded);
+    return CMD_HANDLE_INVALID;
 }
 
 void CommandHandlerTask(void *param)
 {
-    raw_cmd_payload_t item;
+    cmd_handle_t raw;
     for (;;)
     {
-        if (xQueueReceive(cmd_queue_fast_decode, &item, portMAX_DELAY) == pdTRUE)
+        if (xQueueReceive(cmd_queue_fast_decode, &raw, portMAX_DELAY) == pdTRUE)
         {
-            decoded_cmd_payload_t decoded{};
-            decoded.timestamp_ms = item.timestamp_ms;
-
-            // Base64 decode (into instructions buffer)
-            size_t out_len = 0;
-            int rc = mbedtls_base64_decode(decoded.instructions, sizeof(decoded.instructions), &out_len,
-                                            (const unsigned char *)item.payload,
-                                            strlen(item.payload));
-            if (rc != 0 || out_len < 2)
+            cmd_handle_t decoded = decode_raw_command(raw);
+            if (decoded != raw)
             {
-                ESP_LOGE(TAG, "Base64 decode failed or too short (rc=%d, out_len=%u)", rc, (unsigned)out_len);
-                continue;
+                cmd_slab.Release(raw);
             }
 
-            decoded.opcode = decoded.instructions[0];
-            uint8_t payload_len = decoded.instructions[1];
-            if (payload_len > CMD_INSTRUCTION_PAYLOAD_MAX_LEN)
+            DecodedCommand cmd;
+            if (decoded != CMD_HANDLE_INVALID && cmd_slab.GetDecoded(decoded, cmd))
             {
-                ESP_LOGE(TAG, "Instruction length too large: %u", payload_len);
-                continue;
+                handle_command(cmd);
             }
-
-            if (payload_len > out_len - 2)
-            {
-                ESP_LOGE(TAG, "Invalid instruction length %u for buffer %u", payload_len, (unsigned)out_len);
-                continue;
-            }
-            decoded.instruction_length = payload_len;
-
-            handle_command(decoded);
         }
     }
 }
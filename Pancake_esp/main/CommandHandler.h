@@ -10,11 +10,16 @@
 #include <cassert>
 #include <cstdint>
 #include <freertos/task.h>
+#include "CommandSlab.h"
 #include "DataModel.h"
 
-// Raw command queue (base64-encoded payloads)
+// Records of every queued command, raw and decoded. The two queues below carry cmd_handle_t
+// handles into it; whoever takes a handle off a queue owns that record until it releases it.
+extern CommandSlab cmd_slab;
+// Raw command queue (handles to NUL-terminated base64 payloads from InfluxDB, or binary
+// [opcode][len][payload] commands from the push channel; see IsBinaryCommandOpcode)
 extern QueueHandle_t cmd_queue_fast_decode;
-// Decoded CNC command queue (opcode + payload bytes)
+// Decoded CNC command queue (handles to opcode + length + payload bytes)
 extern QueueHandle_t cmd_queue_cnc;
 // Immediate control command queue (e-stop/resume)
 extern QueueHandle_t cmd_queue_now;
@@ -22,5 +27,8 @@ extern QueueHandle_t cmd_queue_now;
 void CommandHandlerInit(void);
 void CommandHandlerStart(void);
 void CommandHandlerTask(void *param);
+// Top up the CNC queue from a running stored program (ProgramFeeder.h). MotorControlTask calls
+// this after every cycle, with the cycle's CNC queue clear count.
+void CommandHandlerFeedStoredProgram(uint32_t queueClearCount);
 
 #endif // COMMAND_HANDLER_H
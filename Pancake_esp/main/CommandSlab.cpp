@@ -0,0 +1,154 @@
+#include "CommandSlab.h"
+
+#include <cstring>
+
+CommandSlab::CommandSlab() : m_Head(0), m_Tail(0), m_UsedBlocks(0), m_LiveCount(0)
+{
+    m_Mux = portMUX_INITIALIZER_UNLOCKED;
+    std::memset(m_Blocks, 0, sizeof(m_Blocks));
+}
+
+cmd_handle_t CommandSlab::Allocate(int64_t timestamp_ms, size_t length, uint8_t *&data, bool immediate)
+{
+    data = nullptr;
+    const size_t blocks = 1 + (length + BLOCK_BYTES - 1) / BLOCK_BYTES;
+    if (length > UINT16_MAX || blocks >= BLOCK_COUNT)
+    {
+        return CMD_HANDLE_INVALID;
+    }
+
+    portENTER_CRITICAL(&m_Mux);
+    if (m_UsedBlocks == 0)
+    {
+        // Start an empty ring from the bottom so the largest record fits.
+        m_Head = 0;
+        m_Tail = 0;
+    }
+
+    size_t start = m_Head;
+    size_t pad = 0;
+    if (m_Head >= m_Tail && m_UsedBlocks < BLOCK_COUNT)
+    {
+        // Free space runs from the head to the end and then from the start to the tail. A record
+        // never wraps, so skip the end with a released filler if it is too short.
+        if (BLOCK_COUNT - m_Head < blocks)
+        {
+            pad = BLOCK_COUNT - m_Head;
+            start = 0;
+            if (blocks > m_Tail)
+            {
+                portEXIT_CRITICAL(&m_Mux);
+                return CMD_HANDLE_INVALID;
+            }
+        }
+    }
+    else if (m_UsedBlocks == BLOCK_COUNT || m_Tail - m_Head < blocks)
+    {
+        portEXIT_CRITICAL(&m_Mux);
+        return CMD_HANDLE_INVALID;
+    }
+
+    // Everything but an immediate command leaves the reserve free.
+    if (!immediate && BLOCK_COUNT - m_UsedBlocks < pad + blocks + RESERVE_BLOCKS)
+    {
+        portEXIT_CRITICAL(&m_Mux);
+        return CMD_HANDLE_INVALID;
+    }
+
+    if (pad > 0)
+    {
+        RecordHeader *filler = Record(m_Head);
+        filler->blocks = static_cast<uint16_t>(pad);
+        filler->length = 0;
+        filler->live = 0;
+    }
+
+    RecordHeader *record = Record(start);
+    record->blocks = static_cast<uint16_t>(blocks);
+    record->length = static_cast<uint16_t>(length);
+    record->live = 1;
+    record->timestamp_ms = timestamp_ms;
+    m_Head = (start + blocks) % BLOCK_COUNT;
+    m_UsedBlocks += pad + blocks;
+    m_LiveCount++;
+    portEXIT_CRITICAL(&m_Mux);
+
+    data = reinterpret_cast<uint8_t *>(record + 1);
+    return static_cast<cmd_handle_t>(start);
+}
+
+CommandSlab::RecordHeader *CommandSlab::LiveRecord(cmd_handle_t handle)
+{
+    if (handle >= BLOCK_COUNT || !m_Blocks[handle].live)
+    {
+        return nullptr;
+    }
+    return &m_Blocks[handle];
+}
+
+uint8_t *CommandSlab::GetData(cmd_handle_t handle, size_t &length, int64_t &timestamp_ms)
+{
+    RecordHeader *record = LiveRecord(handle);
+    if (record == nullptr)
+    {
+        length = 0;
+        return nullptr;
+    }
+
+    length = record->length;
+    timestamp_ms = record->timestamp_ms;
+    return reinterpret_cast<uint8_t *>(record + 1);
+}
+
+bool CommandSlab::GetDecoded(cmd_handle_t handle, DecodedCommand &command)
+{
+    size_t length = 0;
+    int64_t timestamp_ms = 0;
+    uint8_t *data = GetData(handle, length, timestamp_ms);
+    if (data == nullptr || length < 2 || data[1] > length - 2)
+    {
+        return false;
+    }
+
+    command.handle = handle;
+    command.timestamp_ms = timestamp_ms;
+    command.opcode = data[0];
+    command.instruction_length = data[1];
+    command.instructions = data;
+    return true;
+}
+
+void CommandSlab::Release(cmd_handle_t handle)
+{
+    portENTER_CRITICAL(&m_Mux);
+    if (handle < BLOCK_COUNT && m_Blocks[handle].live)
+    {
+        m_Blocks[handle].live = 0;
+        m_LiveCount--;
+
+        // Reclaim every released record at the old end of the ring, fillers included.
+        while (m_UsedBlocks > 0 && !Record(m_Tail)->live)
+        {
+            size_t blocks = Record(m_Tail)->blocks;
+            m_UsedBlocks -= blocks;
+            m_Tail = (m_Tail + blocks) % BLOCK_COUNT;
+        }
+    }
+    portEXIT_CRITICAL(&m_Mux);
+}
+
+size_t CommandSlab::GetFreeBytes() const
+{
+    portENTER_CRITICAL(&m_Mux);
+    size_t freeBytes = (BLOCK_COUNT - m_UsedBlocks) * BLOCK_BYTES;
+    portEXIT_CRITICAL(&m_Mux);
+    return freeBytes;
+}
+
+size_t CommandSlab::GetLiveCount() const
+{
+    portENTER_CRITICAL(&m_Mux);
+    size_t count = m_LiveCount;
+    portEXIT_CRITICAL(&m_Mux);
+    return count;
+}
@@ -0,0 +1,89 @@
+#ifndef COMMAND_SLAB_H
+#define COMMAND_SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "DataModel.h"
+#include "freertos/FreeRTOS.h"
+
+// Bytes shared by every command waiting anywhere in the pipeline. A jog record takes 48 bytes,
+// so this holds about 150 queued jogs, on top of the reserve below, in less RAM than the 32 fixed
+// 272-byte slots the CNC queue used to copy each command into.
+constexpr size_t COMMAND_SLAB_BYTES = 8192;
+// Kept back from everything but immediate commands (pause, resume, stop), so one still fits,
+// raw and decoded, behind a full backlog of motion. An immediate command takes 64 bytes both ways.
+constexpr size_t COMMAND_SLAB_RESERVE_BYTES = 1024;
+
+// A decoded command read in place from the slab. instructions[0] is the opcode and
+// instructions[1] the payload length, as sent; the payload follows. Whoever holds the handle
+// owns the record and may edit the payload until it releases it.
+struct DecodedCommand
+{
+    cmd_handle_t handle = CMD_HANDLE_INVALID;
+    int64_t timestamp_ms = 0;
+    uint8_t opcode = 0;
+    uint8_t instruction_length = 0;
+    uint8_t *instructions = nullptr;
+};
+
+// Fixed arena of variable-length command records. Commands are written once, where they are
+// received, and from then on only their 2-byte handle moves through the FreeRTOS queues; each
+// stage reads the record in place and either passes the handle on or releases it.
+//
+// Records are carved from a ring in allocation order. Releases may come in any order (the
+// decoder frees a base64 record after the decoded one it produced), but space is only reclaimed
+// from the oldest end, so one long-held record holds back everything allocated after it.
+// Allocate and Release may be called from any task.
+class CommandSlab
+{
+  public:
+    CommandSlab();
+
+    CommandSlab(const CommandSlab &) = delete;
+    CommandSlab &operator=(const CommandSlab &) = delete;
+
+    // Reserve a record for `length` bytes stamped with timestamp_ms and point data at them.
+    // Returns CMD_HANDLE_INVALID, leaving data null, when there is no contiguous room, or when
+    // the record would cut into COMMAND_SLAB_RESERVE_BYTES and is not `immediate`.
+    cmd_handle_t Allocate(int64_t timestamp_ms, size_t length, uint8_t *&data, bool immediate = false);
+
+    // Bytes and timestamp of a live record, or null for an invalid handle.
+    uint8_t *GetData(cmd_handle_t handle, size_t &length, int64_t &timestamp_ms);
+
+    // View a record as a decoded command. False if it is too short for its own length byte.
+    bool GetDecoded(cmd_handle_t handle, DecodedCommand &command);
+
+    void Release(cmd_handle_t handle);
+
+    size_t GetFreeBytes() const;
+    size_t GetLiveCount() const;
+
+  private:
+    struct RecordHeader
+    {
+        uint16_t blocks;
+        uint16_t length;
+        uint8_t live;
+        uint8_t reserved[3];
+        int64_t timestamp_ms;
+    };
+
+    static constexpr size_t BLOCK_BYTES = sizeof(RecordHeader);
+    static constexpr size_t BLOCK_COUNT = COMMAND_SLAB_BYTES / BLOCK_BYTES;
+    static constexpr size_t RESERVE_BLOCKS = COMMAND_SLAB_RESERVE_BYTES / BLOCK_BYTES;
+    static_assert(BLOCK_COUNT < CMD_HANDLE_INVALID, "handles index the slab's blocks");
+
+    RecordHeader *Record(size_t block) { return &m_Blocks[block]; }
+    RecordHeader *LiveRecord(cmd_handle_t handle);
+
+    // Each record is one header block followed by its data, rounded up to whole blocks.
+    RecordHeader m_Blocks[BLOCK_COUNT];
+    size_t m_Head;
+    size_t m_Tail;
+    size_t m_UsedBlocks;
+    size_t m_LiveCount;
+    mutable portMUX_TYPE m_Mux;
+};
+
+#endif // COMMAND_SLAB_H
@@ -0,0 +1,145 @@
+#include "ControlCapture.h"
+
+void ControlCapture::RequestArm(uint16_t postTriggerSamples, uint8_t triggerMask)
+{
+    uint8_t mask = triggerMask | CAPTURE_TRIGGER_COMMAND;
+    armRequest.store((static_cast<uint32_t>(postTriggerSamples) << 8) | mask, std::memory_order_release);
+}
+
+void ControlCapture::RequestTrigger()
+{
+    triggerRequest.store(true, std::memory_order_release);
+}
+
+void ControlCapture::Record(const control_tlm_t &tlm)
+{
+    const bool s0LimitSwitch = tlm.limitSwitch_S0;
+    const bool s1LimitSwitch = tlm.limitSwitch_S1;
+    const bool queueCleared = haveLastCycle && tlm.cncQueueClearCount != lastQueueClearCount;
+    const bool switchClosed = haveLastCycle && ((s0LimitSwitch && !lastS0LimitSwitch) ||
+                                                (s1LimitSwitch && !lastS1LimitSwitch));
+    lastQueueClearCount = tlm.cncQueueClearCount;
+    lastS0LimitSwitch = s0LimitSwitch;
+    lastS1LimitSwitch = s1LimitSwitch;
+    haveLastCycle = true;
+
+    ControlCaptureState current = state.load(std::memory_order_relaxed);
+    if (current == ControlCaptureState::Idle)
+    {
+        uint32_t request = armRequest.exchange(0, std::memory_order_acquire);
+        if (request == 0)
+        {
+            return;
+        }
+        triggerMask = static_cast<uint8_t>(request);
+        postTriggerSamples = request >> 8;
+        if (postTriggerSamples > CONTROL_CAPTURE_SAMPLES - 1)
+        {
+            postTriggerSamples = CONTROL_CAPTURE_SAMPLES - 1;
+        }
+        nextSlot = 0;
+        sampleCount = 0;
+        triggerSource = 0;
+        triggerRequest.store(false, std::memory_order_relaxed);
+        current = ControlCaptureState::Armed;
+        state.store(current, std::memory_order_relaxed);
+    }
+    else if (current == ControlCaptureState::Captured)
+    {
+        return;
+    }
+
+    ControlCaptureSample sample{};
+    sample.time_us = static_cast<uint32_t>(tlm.sampleTime_us);
+    sample.s0Pos_deg = tlm.S0MotorTlm.Position_deg;
+    sample.s1Pos_deg = tlm.S1MotorTlm.Position_deg;
+    sample.s0Target_deg = tlm.plannedTarget_S0_deg;
+    sample.s1Target_deg = tlm.plannedTarget_S1_deg;
+    sample.s0CmdSpeed_degps = tlm.S0MotorTlm.TargetSpeed_degps;
+    sample.s1CmdSpeed_degps = tlm.S1MotorTlm.TargetSpeed_degps;
+    sample.s0Speed_degps = tlm.S0MotorTlm.Speed_degps;
+    sample.s1Speed_degps = tlm.S1MotorTlm.Speed_degps;
+    sample.pumpSpeed_degps = tlm.PumpMotorTlm.Speed_degps;
+    sample.flags = (s0LimitSwitch ? CAPTURE_FLAG_S0_LIMIT_SWITCH : 0) |
+                   (s1LimitSwitch ? CAPTURE_FLAG_S1_LIMIT_SWITCH : 0) |
+                   (tlm.limitBlocked_S0 ? CAPTURE_FLAG_S0_LIMIT_BLOCKED : 0) |
+                   (tlm.limitBlocked_S1 ? CAPTURE_FLAG_S1_LIMIT_BLOCKED : 0) |
+                   (queueCleared ? CAPTURE_FLAG_QUEUE_CLEARED : 0);
+
+    if (current == ControlCaptureState::Armed)
+    {
+        uint8_t events = (triggerRequest.exchange(false, std::memory_order_acquire) ? CAPTURE_TRIGGER_COMMAND : 0) |
+                         (queueCleared ? CAPTURE_TRIGGER_STOP : 0) |
+                         (switchClosed ? CAPTURE_TRIGGER_LIMIT_SWITCH : 0);
+        triggerSource = events & triggerMask;
+        if (triggerSource != 0)
+        {
+            sample.flags |= CAPTURE_FLAG_TRIGGER;
+            triggerTime_us = tlm.sampleTime_us;
+            postTriggerRemaining = postTriggerSamples;
+            current = ControlCaptureState::Triggered;
+        }
+        Store(sample);
+    }
+    else
+    {
+        Store(sample);
+        postTriggerRemaining--;
+    }
+
+    if (current == ControlCaptureState::Triggered && postTriggerRemaining == 0)
+    {
+        triggerIndex = sampleCount - 1 - postTriggerSamples;
+        current = ControlCaptureState::Captured;
+    }
+    // Publishes the samples to the uploader along with Captured.
+    state.store(current, std::memory_order_release);
+}
+
+const ControlCaptureSample &ControlCapture::GetSample(size_t index) const
+{
+    const size_t oldest = (sampleCount < CONTROL_CAPTURE_SAMPLES) ? 0 : nextSlot;
+    return samples[(oldest + index) % CONTROL_CAPTURE_SAMPLES];
+}
+
+int64_t ControlCapture::GetSampleTime_us(size_t index) const
+{
+    // The ring spans seconds, so the low words differ from the trigger's by far less than 2^31.
+    const uint32_t offset_us = GetSample(index).time_us - static_cast<uint32_t>(triggerTime_us);
+    return triggerTime_us + static_cast<int32_t>(offset_us);
+}
+
+void ControlCapture::Release()
+{
+    if (GetState() == ControlCaptureState::Captured)
+    {
+        state.store(ControlCaptureState::Idle, std::memory_order_release);
+    }
+}
+
+void ControlCapture::Store(const ControlCaptureSample &sample)
+{
+    samples[nextSlot] = sample;
+    nextSlot = (nextSlot + 1) % CONTROL_CAPTURE_SAMPLES;
+    if (sampleCount < CONTROL_CAPTURE_SAMPLES)
+    {
+        sampleCount++;
+    }
+}
+
+size_t GetControlCaptureFields(const ControlCaptureSample &sample, TelemetryField *fields)
+{
+    // Keys match the tlm measurement's for the same quantities.
+    size_t count = 0;
+    fields[count++] = {"s0", sample.s0Pos_deg};
+    fields[count++] = {"s1", sample.s1Pos_deg};
+    fields[count++] = {"s0p", sample.s0Target_deg};
+    fields[count++] = {"s1p", sample.s1Target_deg};
+    fields[count++] = {"s0vt", sample.s0CmdSpeed_degps};
+    fields[count++] = {"s1vt", sample.s1CmdSpeed_degps};
+    fields[count++] = {"s0v", sample.s0Speed_degps};
+    fields[count++] = {"s1v", sample.s1Speed_degps};
+    fields[count++] = {"pv", sample.pumpSpeed_degps};
+    fields[count++] = {"f", static_cast<float>(sample.flags)};
+    return count;
+}
@@ -0,0 +1,118 @@
+#ifndef CONTROL_CAPTURE_H
+#define CONTROL_CAPTURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "Telemetry.h"
+#include "TelemetryLine.h"
+
+// Cycles kept by a capture: 5.12 s at 100 Hz, in about 22 KB.
+constexpr size_t CONTROL_CAPTURE_SAMPLES = 512;
+constexpr uint16_t CONTROL_CAPTURE_DEFAULT_POST_TRIGGER = CONTROL_CAPTURE_SAMPLES / 2;
+
+// Capture lines go to the telemetry bucket under their own measurement.
+constexpr const char *CONTROL_CAPTURE_LINE_PREFIX = "cap,location=us-midwest";
+constexpr size_t CONTROL_CAPTURE_FIELD_COUNT = 10;
+
+// What ends a capture. A command trigger is always accepted; the others are chosen when arming.
+constexpr uint8_t CAPTURE_TRIGGER_COMMAND = 1 << 0;
+constexpr uint8_t CAPTURE_TRIGGER_STOP = 1 << 1;         // stop command or limit stop
+constexpr uint8_t CAPTURE_TRIGGER_LIMIT_SWITCH = 1 << 2; // either switch closing
+constexpr uint8_t CAPTURE_TRIGGER_ALL = CAPTURE_TRIGGER_COMMAND | CAPTURE_TRIGGER_STOP | CAPTURE_TRIGGER_LIMIT_SWITCH;
+
+constexpr uint16_t CAPTURE_FLAG_S0_LIMIT_SWITCH = 1 << 0;
+constexpr uint16_t CAPTURE_FLAG_S1_LIMIT_SWITCH = 1 << 1;
+constexpr uint16_t CAPTURE_FLAG_S0_LIMIT_BLOCKED = 1 << 2;
+constexpr uint16_t CAPTURE_FLAG_S1_LIMIT_BLOCKED = 1 << 3;
+constexpr uint16_t CAPTURE_FLAG_QUEUE_CLEARED = 1 << 4;
+constexpr uint16_t CAPTURE_FLAG_TRIGGER = 1 << 5;
+
+// One control cycle. time_us is the low word of the cycle's esp_timer sample time; the capture
+// keeps the full trigger time to rebuild it (GetSampleTime_us).
+struct ControlCaptureSample
+{
+    uint32_t time_us;
+    float s0Pos_deg;
+    float s1Pos_deg;
+    float s0Target_deg;
+    float s1Target_deg;
+    float s0CmdSpeed_degps;
+    float s1CmdSpeed_degps;
+    float s0Speed_degps;
+    float s1Speed_degps;
+    float pumpSpeed_degps;
+    uint16_t flags;
+};
+
+enum class ControlCaptureState : uint8_t
+{
+    Idle,
+    Armed,     // recording into the ring, waiting for a trigger
+    Triggered, // recording the cycles after the trigger
+    Captured,  // frozen until the uploader releases it
+};
+
+// Every-cycle recorder for MotorControlTask, like a scope on single-shot: once armed it keeps the
+// last CONTROL_CAPTURE_SAMPLES cycles in a fixed ring, and after a trigger it records the chosen
+// number of further cycles and freezes, so the ring holds the run-up to the event and what
+// followed. The frozen capture is uploaded in bulk afterwards and then released for the next one.
+//
+// Record() is called by the control task only. Other tasks only post requests, which the next
+// Record() acts on, or read a capture once GetState() says it is Captured; the state is
+// published with release ordering after the samples, so no lock is needed on either side.
+class ControlCapture
+{
+  public:
+    // Arm once the ring is idle. postTriggerSamples is clamped to leave at least the trigger
+    // cycle before it. Any task.
+    void RequestArm(uint16_t postTriggerSamples, uint8_t triggerMask);
+    // Trigger an armed capture from the next cycle. Any task.
+    void RequestTrigger();
+
+    // Control task, once per cycle, with the cycle's published telemetry.
+    void Record(const control_tlm_t &tlm);
+
+    ControlCaptureState GetState() const { return state.load(std::memory_order_acquire); }
+
+    // The rest is for the uploader, and only while Captured. Samples are oldest first.
+    size_t GetSampleCount() const { return sampleCount; }
+    const ControlCaptureSample &GetSample(size_t index) const;
+    int64_t GetSampleTime_us(size_t index) const;
+    size_t GetTriggerIndex() const { return triggerIndex; }
+    uint8_t GetTriggerSource() const { return triggerSource; }
+
+    // Done with the capture; the ring may be armed again.
+    void Release();
+
+  private:
+    void Store(const ControlCaptureSample &sample);
+
+    ControlCaptureSample samples[CONTROL_CAPTURE_SAMPLES];
+    size_t nextSlot = 0;
+    size_t sampleCount = 0;
+    size_t postTriggerSamples = 0;
+    size_t postTriggerRemaining = 0;
+    size_t triggerIndex = 0;
+    uint8_t triggerMask = 0;
+    uint8_t triggerSource = 0;
+    int64_t triggerTime_us = 0;
+
+    // Edge detection for the event triggers, kept up to date even while idle.
+    uint32_t lastQueueClearCount = 0;
+    bool lastS0LimitSwitch = false;
+    bool lastS1LimitSwitch = false;
+    bool haveLastCycle = false;
+
+    std::atomic<ControlCaptureState> state{ControlCaptureState::Idle};
+    // Pending arm as (postTriggerSamples << 8 | triggerMask); 0 when there is none.
+    std::atomic<uint32_t> armRequest{0};
+    std::atomic<bool> triggerRequest{false};
+};
+
+// The sample as telemetry fields for CONTROL_CAPTURE_LINE_PREFIX lines. fields must have room
+// for CONTROL_CAPTURE_FIELD_COUNT. Returns the field count.
+size_t GetControlCaptureFields(const ControlCaptureSample &sample, TelemetryField *fields);
+
+#endif // CONTROL_CAPTURE_H
@@ -0,0 +1,111 @@
+#include "ControlLoopTiming.h"
+
+namespace
+{
+uint32_t ClampToUint32(int64_t value)
+{
+    if (value <= 0)
+    {
+        return 0;
+    }
+    if (value > static_cast<int64_t>(UINT32_MAX))
+    {
+        return UINT32_MAX;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+uint32_t AbsToUint32(int64_t value)
+{
+    return ClampToUint32(value < 0 ? -value : value);
+}
+} // namespace
+
+ControlLoopTiming::ControlLoopTiming(uint32_t period_us, uint32_t maxGuidanceStep_us,
+                                     uint32_t windowCycles)
+    : period_us(period_us > 0 ? period_us : 1),
+      maxGuidanceStep_us(maxGuidanceStep_us > period_us ? maxGuidanceStep_us : period_us),
+      windowCycles(windowCycles > 0 ? windowCycles : 1)
+{
+}
+
+void ControlLoopTiming::Start(int64_t now_us)
+{
+    lastCycleStart_us = now_us;
+    cycleDeadline_us = now_us;
+    nextDeadline_us = now_us;
+    guidanceRemainder_us = 0;
+    windowCycleCount = 0;
+    windowJitter_us = 0;
+    windowLatency_us = 0;
+    stats = ControlLoopTimingStats{};
+}
+
+unsigned int ControlLoopTiming::BeginCycle(int64_t now_us)
+{
+    cycleDeadline_us = nextDeadline_us;
+
+    int64_t jitter_us = now_us - cycleDeadline_us;
+    stats.lastJitter_us = (jitter_us > INT32_MAX)   ? INT32_MAX
+                          : (jitter_us < INT32_MIN) ? INT32_MIN
+                                                    : static_cast<int32_t>(jitter_us);
+    uint32_t absJitter_us = AbsToUint32(jitter_us);
+    if (absJitter_us > windowJitter_us)
+    {
+        windowJitter_us = absJitter_us;
+    }
+
+    uint32_t elapsed_us = ClampToUint32(now_us - lastCycleStart_us);
+    lastCycleStart_us = now_us;
+    stats.lastElapsed_us = elapsed_us;
+
+    // A long stall (debugger, flash write) should not teleport the guidance carrot.
+    if (elapsed_us > maxGuidanceStep_us)
+    {
+        elapsed_us = maxGuidanceStep_us;
+    }
+
+    uint32_t total_us = elapsed_us + guidanceRemainder_us;
+    guidanceRemainder_us = total_us % 1000U;
+    return total_us / 1000U;
+}
+
+bool ControlLoopTiming::EndCycle(int64_t now_us)
+{
+    stats.cycleCount++;
+
+    // Latency is measured from the deadline the cycle was meant to run at, so it covers both
+    // the late wake and the time spent computing outputs.
+    uint32_t latency_us = ClampToUint32(now_us - cycleDeadline_us);
+    stats.lastLatency_us = latency_us;
+    if (latency_us > stats.worstLatency_us)
+    {
+        stats.worstLatency_us = latency_us;
+    }
+    if (latency_us > windowLatency_us)
+    {
+        windowLatency_us = latency_us;
+    }
+
+    nextDeadline_us = cycleDeadline_us + period_us;
+    bool overran = now_us >= nextDeadline_us;
+    if (overran)
+    {
+        stats.overrunCount++;
+        int64_t missedPeriods = (now_us - nextDeadline_us) / period_us + 1;
+        nextDeadline_us += missedPeriods * period_us;
+        stats.skippedDeadlineCount += ClampToUint32(missedPeriods);
+    }
+
+    windowCycleCount++;
+    if (windowCycleCount >= windowCycles)
+    {
+        stats.windowWorstJitter_us = windowJitter_us;
+        stats.windowWorstLatency_us = windowLatency_us;
+        windowCycleCount = 0;
+        windowJitter_us = 0;
+        windowLatency_us = 0;
+    }
+
+    return overran;
+}
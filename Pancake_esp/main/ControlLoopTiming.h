@@ -0,0 +1,61 @@
+#ifndef CONTROL_LOOP_TIMING_H
+#define CONTROL_LOOP_TIMING_H
+
+#include <cstdint>
+
+struct ControlLoopTimingStats
+{
+    uint32_t cycleCount = 0;
+    uint32_t overrunCount = 0;
+    uint32_t skippedDeadlineCount = 0;
+    uint32_t lastElapsed_us = 0;
+    int32_t lastJitter_us = 0;
+    uint32_t lastLatency_us = 0;
+    uint32_t worstLatency_us = 0;
+
+    // Worst values over the most recently completed window of cycles.
+    uint32_t windowWorstJitter_us = 0;
+    uint32_t windowWorstLatency_us = 0;
+};
+
+// Absolute-deadline bookkeeping for a fixed-period control loop. The caller owns the clock and
+// the sleep; this class only tracks deadlines, measures how late each wake and each cycle's
+// output was, and converts measured wall time into the millisecond steps fed to guidance.
+class ControlLoopTiming
+{
+  public:
+    ControlLoopTiming(uint32_t period_us, uint32_t maxGuidanceStep_us, uint32_t windowCycles);
+
+    // Anchor the first deadline at now_us: the first cycle runs straight away, and each later
+    // one a period after the one before.
+    void Start(int64_t now_us);
+
+    // Call right after waking. Returns the whole milliseconds of wall time since the previous
+    // cycle started; sub-millisecond remainders are carried so guidance time never drifts.
+    unsigned int BeginCycle(int64_t now_us);
+
+    // Call once the cycle's outputs have been applied. Returns true if the work ran past the
+    // next deadline; missed deadlines are skipped rather than replayed in a burst.
+    bool EndCycle(int64_t now_us);
+
+    int64_t GetNextDeadline_us() const { return nextDeadline_us; }
+    const ControlLoopTimingStats &GetStats() const { return stats; }
+
+  private:
+    uint32_t period_us;
+    uint32_t maxGuidanceStep_us;
+    uint32_t windowCycles;
+
+    int64_t cycleDeadline_us = 0;
+    int64_t nextDeadline_us = 0;
+    int64_t lastCycleStart_us = 0;
+    uint32_t guidanceRemainder_us = 0;
+
+    uint32_t windowCycleCount = 0;
+    uint32_t windowJitter_us = 0;
+    uint32_t windowLatency_us = 0;
+
+    ControlLoopTimingStats stats;
+};
+
+#endif // CONTROL_LOOP_TIMING_H
@@ -0,0 +1,14 @@
+#ifndef CONTROL_TELEMETRY_H
+#define CONTROL_TELEMETRY_H
+
+#include "ControlCapture.h"
+#include "SeqlockSnapshot.h"
+#include "Telemetry.h"
+
+// Published by MotorControlTask once per cycle; read with ControlTelemetry.Read().
+extern SeqlockSnapshot<control_tlm_t> ControlTelemetry;
+
+// Recorded by MotorControlTask every cycle while armed; uploaded by the telemetry transmit task.
+extern ControlCapture ControlLoopCapture;
+
+#endif // CONTROL_TELEMETRY_H
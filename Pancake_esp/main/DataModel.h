@@ -6,17 +6,15 @@
 
 #define CMD_PAYLOAD_MAX_LEN 256
 #define CMD_INSTRUCTION_PAYLOAD_MAX_LEN (CMD_PAYLOAD_MAX_LEN - 2)
+// A program packet (ProgramPacket.h) carries many instructions in one message, so it may be
+// longer than any single instruction.
+#define CMD_PROGRAM_MAX_LEN 1024
+// Longest base64 text that can decode to a valid command or program.
+#define CMD_BASE64_MAX_LEN (((CMD_PROGRAM_MAX_LEN + 2) / 3) * 4)
 
-typedef struct {
-    int64_t timestamp_ms;
-    char payload[CMD_PAYLOAD_MAX_LEN];
-} raw_cmd_payload_t;
-
-typedef struct {
-    int64_t timestamp_ms;
-    uint8_t opcode;
-    uint8_t instructions[CMD_PAYLOAD_MAX_LEN];
-    uint8_t instruction_length;
-} decoded_cmd_payload_t;
+// Index of a command record in the command slab (CommandSlab.h). The command queues carry
+// these instead of copies of the commands.
+typedef uint16_t cmd_handle_t;
+#define CMD_HANDLE_INVALID ((cmd_handle_t)0xFFFF)
 
 #endif // DATA_MODEL_H
@@ -0,0 +1,92 @@
+#include "ElbowSelector.h"
+
+#include <cmath>
+
+ElbowSelector::ElbowSelector(const AngleMotion::AngleMoveLimitsDeg &s0Limits,
+                             const AngleMotion::AngleMoveLimitsDeg &s1Limits)
+    : s0Limits(s0Limits), s1Limits(s1Limits)
+{
+}
+
+float ElbowSelector::MoveCost_deg(float fromS0_deg, float fromS1_deg, float toS0_deg,
+                                  float toS1_deg) const
+{
+    bool s0Blocked = false;
+    bool s1Blocked = false;
+    float s0Delta_deg = AngleMotion::SelectDeltaWithinLimitsDeg(fromS0_deg, toS0_deg, s0Limits, s0Blocked);
+    float s1Delta_deg = AngleMotion::SelectDeltaWithinLimitsDeg(fromS1_deg, toS1_deg, s1Limits, s1Blocked);
+    if (s0Blocked || s1Blocked)
+    {
+        return -1.0f;
+    }
+
+    // Both joints move at once, so the longer move sets how long the reconfiguration takes.
+    return fmaxf(fabsf(s0Delta_deg), fabsf(s1Delta_deg));
+}
+
+ElbowBranch ElbowSelector::BeginPath(Vector2D start_m, Vector2D end_m, float currentS0_deg,
+                                     float currentS1_deg)
+{
+    holding = true;
+    switchedThisPath = false;
+    branch = GetElbowBranch(currentS1_deg);
+
+    float startS0_deg[2];
+    float startS1_deg[2];
+    float endS0_deg[2];
+    float endS1_deg[2];
+    if (CartToAngBothBranches(startS0_deg, startS1_deg, start_m) != E_OK ||
+        CartToAngBothBranches(endS0_deg, endS1_deg, end_m) != E_OK)
+    {
+        return branch;
+    }
+
+    float cost_deg[2];
+    for (int b = 0; b < 2; b++)
+    {
+        float toStart_deg = MoveCost_deg(currentS0_deg, currentS1_deg, startS0_deg[b], startS1_deg[b]);
+        float alongPath_deg = MoveCost_deg(startS0_deg[b], startS1_deg[b], endS0_deg[b], endS1_deg[b]);
+        cost_deg[b] = (toStart_deg < 0.0f || alongPath_deg < 0.0f) ? -1.0f : toStart_deg + alongPath_deg;
+    }
+
+    const int held = static_cast<int>(branch);
+    const int other = 1 - held;
+    const bool heldClear = cost_deg[held] >= 0.0f;
+    const bool otherClear = cost_deg[other] >= 0.0f;
+    if (otherClear && (!heldClear || cost_deg[other] + ELBOW_SWITCH_MARGIN_DEG < cost_deg[held]))
+    {
+        branch = static_cast<ElbowBranch>(other);
+    }
+    return branch;
+}
+
+bool ElbowSelector::SwitchBranch()
+{
+    if (!holding || switchedThisPath)
+    {
+        return false;
+    }
+
+    branch = (branch == ElbowBranch::Positive) ? ElbowBranch::Negative : ElbowBranch::Positive;
+    switchedThisPath = true;
+    return true;
+}
+
+MathErrorCodes ElbowSelector::Solve(Vector2D target_m, float currentS0_deg, float currentS1_deg,
+                                    float &s0Target_deg, float &s1Target_deg)
+{
+    if (!holding)
+    {
+        BeginPath(target_m, target_m, currentS0_deg, currentS1_deg);
+    }
+
+    float s0_deg[2];
+    float s1_deg[2];
+    MathErrorCodes result = CartToAngBothBranches(s0_deg, s1_deg, target_m);
+    if (result == E_OK)
+    {
+        s0Target_deg = s0_deg[static_cast<int>(branch)];
+        s1Target_deg = s1_deg[static_cast<int>(branch)];
+    }
+    return result;
+}
@@ -0,0 +1,58 @@
+#ifndef ELBOW_SELECTOR_H
+#define ELBOW_SELECTOR_H
+
+#include "AngleMotion.h"
+#include "PanMath.h"
+#include "Vector2D.h"
+
+// Chooses which inverse-kinematics branch a Cartesian path is run in. The branch is picked once
+// when a path starts, from the arm's current pose, and then held until the next path: flipping
+// the elbow part way along a path would swing the tip off it.
+//
+// At the start of a path each branch is scored by the joint travel to the path's first point plus
+// the travel from there to its last point, and is rejected if either move would cross a joint
+// limit. The branch the arm is already in is kept unless the other one saves more than
+// ELBOW_SWITCH_MARGIN_DEG or is the only one that clears the limits.
+constexpr float ELBOW_SWITCH_MARGIN_DEG = 2.0f;
+
+class ElbowSelector
+{
+  public:
+    ElbowSelector(const AngleMotion::AngleMoveLimitsDeg &s0Limits,
+                  const AngleMotion::AngleMoveLimitsDeg &s1Limits);
+
+    // Pick the branch for a path from start_m to end_m (equal when the end is not known ahead).
+    // An unreachable start or end leaves the arm's current branch selected.
+    ElbowBranch BeginPath(Vector2D start_m, Vector2D end_m, float currentS0_deg, float currentS1_deg);
+
+    // Forget the held branch so the next Solve starts a new path.
+    void EndPath()
+    {
+        holding = false;
+        switchedThisPath = false;
+    }
+
+    // Hold the other branch for the rest of the path, when a limit blocks the held one part way
+    // along it. Allowed once per path so two blocked branches cannot flip the elbow back and forth.
+    bool SwitchBranch();
+
+    // Joint targets for target_m in the held branch, starting a path first if none is held.
+    MathErrorCodes Solve(Vector2D target_m, float currentS0_deg, float currentS1_deg,
+                         float &s0Target_deg, float &s1Target_deg);
+
+    ElbowBranch GetBranch() const { return branch; }
+    bool IsHolding() const { return holding; }
+
+  private:
+    // Largest joint move from (fromS0, fromS1) to (toS0, toS1) within the limits, or a negative
+    // value if either joint is blocked.
+    float MoveCost_deg(float fromS0_deg, float fromS1_deg, float toS0_deg, float toS1_deg) const;
+
+    AngleMotion::AngleMoveLimitsDeg s0Limits;
+    AngleMotion::AngleMoveLimitsDeg s1Limits;
+    ElbowBranch branch = ElbowBranch::Negative;
+    bool holding = false;
+    bool switchedThisPath = false;
+};
+
+#endif // ELBOW_SELECTOR_H
@@ -8,6 +8,7 @@
 #include "Vector2D.h"
 #include "CNCOpCodes.h"
 #include "PanMath.h"
+#include "SegmentSpeedProfile.h"
 
 enum GuidanceMode
 {
@@ -18,6 +19,18 @@ enum GuidanceMode
     E_NEXT
 };
 
+// Where the carrot is this cycle and how it is moving. Guidance that can differentiate its path
+// fills in the velocity (and optionally acceleration) so the controller can feed the joint rates
+// forward instead of waiting for a position error to build up.
+struct GuidanceSetpoint
+{
+    Vector2D position_m{0.0f, 0.0f};
+    Vector2D velocity_mps{0.0f, 0.0f};
+    Vector2D acceleration_mps2{0.0f, 0.0f};
+    bool hasVelocity = false;
+    bool hasAcceleration = false;
+};
+
 class GeneralGuidance
 {
   public:
@@ -30,16 +43,47 @@ class GeneralGuidance
      * @param CmdPos_m Output: Target position in meters.
      * @return GuidanceMode The next guidance mode.
      */
-    // TODO, re-work interface to allow guidance to specify speeds for both motors. This is useful
-    // for homing and in the event I ever get around to solving the inverse kinematics problem for
-    // speed
     virtual bool GetTargetPosition(unsigned int DeltaTime_ms, Vector2D CurPos_m, Vector2D &CmdPos_m,
                                    bool &CmdViaAngle, float &S0Speed_degps,
                                    float &S1Speed_degps) = 0;
 
+    /**
+     * @brief Get the target position together with the path velocity and acceleration there.
+     *
+     * Same contract as GetTargetPosition. The default reports position only, which leaves the
+     * controller on pure position feedback.
+     */
+    virtual bool GetTargetSetpoint(unsigned int DeltaTime_ms, Vector2D CurPos_m,
+                                   GuidanceSetpoint &Setpoint, bool &CmdViaAngle,
+                                   float &S0Speed_degps, float &S1Speed_degps)
+    {
+        Setpoint = GuidanceSetpoint{};
+        return GetTargetPosition(DeltaTime_ms, CurPos_m, Setpoint.position_m, CmdViaAngle,
+                                 S0Speed_degps, S1Speed_degps);
+    }
+
     virtual uint8_t GetOpCode() const = 0;
     virtual size_t GetConfigLength() const = 0;
     virtual const void *GetConfig() const = 0; // pointer to config bytes
+
+    // Segment guidance (jog, arc) exposes its path-speed profile so the look-ahead planner can
+    // blend it into the next segment. Everything else returns nullptr and stops at its end.
+    virtual SegmentSpeedProfile *GetSpeedProfile() { return nullptr; }
+    virtual float GetRemainingPathLength_m() const { return 0.0f; }
+
+    // Guidance that follows a fixed path reports the point Distance_m further along it than
+    // CurPos_m, so the controller can plan how fast the joints let it go (PathSpeedPlanner).
+    // Returns false past the end of the path, and always for guidance without one.
+    virtual bool GetPathPointAhead(Vector2D CurPos_m, float Distance_m, Vector2D &Point_m) const
+    {
+        (void)CurPos_m;
+        (void)Distance_m;
+        (void)Point_m;
+        return false;
+    }
+
+    // Cap on the path speed for the following GetTargetSetpoint calls; INFINITY lifts it.
+    virtual void SetPathSpeedLimit(float Limit_mps) { (void)Limit_mps; }
 };
 
 class WaitGuidance : public GeneralGuidance
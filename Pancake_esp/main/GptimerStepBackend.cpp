@@ -0,0 +1,93 @@
+#include "GptimerStepBackend.h"
+#include "esp_clk_tree.h"
+#include "esp_log.h"
+
+GptimerStepBackend::GptimerStepBackend(gpio_num_t stepPin, gpio_num_t dirPin, const char *name)
+    : m_stepPin(stepPin), m_dirPin(dirPin), m_name(name), m_PulseTimer(nullptr), m_OnStep(nullptr),
+      m_Context(nullptr), m_stepState(false)
+{
+    // Configure GPIO pins
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    io_conf.pin_bit_mask = (1ULL << m_stepPin) | (1ULL << m_dirPin);
+    gpio_config(&io_conf);
+}
+
+esp_err_t GptimerStepBackend::Init(uint32_t resolution_hz, StepHandler onStep, void *context)
+{
+    m_OnStep = onStep;
+    m_Context = context;
+
+    // Timer configuration
+    gptimer_config_t timer_config = {};
+    timer_config.clk_src = GPTIMER_CLK_SRC_APB;
+    timer_config.direction = GPTIMER_COUNT_UP;
+    timer_config.resolution_hz = resolution_hz;
+
+    uint32_t apb_freq = 0;
+    esp_err_t err = esp_clk_tree_src_get_freq_hz(SOC_MOD_CLK_APB, ESP_CLK_TREE_SRC_FREQ_PRECISION_EXACT,
+                                                 &apb_freq);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    ESP_LOGI(m_name, "APB CLK FREQ %ld hz | Timer Resolution: %lu hz", apb_freq,
+             timer_config.resolution_hz);
+
+    // Create and configure step timer
+    err = gptimer_new_timer(&timer_config, &m_PulseTimer);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    gptimer_event_callbacks_t step_cbs = {};
+    step_cbs.on_alarm = OnAlarm;
+    err = gptimer_register_event_callbacks(m_PulseTimer, &step_cbs, this);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return gptimer_enable(m_PulseTimer);
+}
+
+esp_err_t GptimerStepBackend::SetToggleInterval(uint64_t ticks)
+{
+    gptimer_alarm_config_t alarm_config = {};
+    alarm_config.alarm_count = ticks;
+    alarm_config.flags.auto_reload_on_alarm = true;
+    return gptimer_set_alarm_action(m_PulseTimer, &alarm_config);
+}
+
+esp_err_t GptimerStepBackend::Start() { return gptimer_start(m_PulseTimer); }
+
+esp_err_t GptimerStepBackend::Stop() { return gptimer_stop(m_PulseTimer); }
+
+void GptimerStepBackend::SetDirectionLevel(bool level) { gpio_set_level(m_dirPin, level); }
+
+// Step timer ISR callback
+bool IRAM_ATTR GptimerStepBackend::OnAlarm(gptimer_handle_t timer,
+                                           const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    (void)edata;
+    GptimerStepBackend *backend = static_cast<GptimerStepBackend *>(user_ctx);
+
+    // Toggle STEP pin
+    backend->m_stepState = !backend->m_stepState;
+    gpio_set_level(backend->m_stepPin, backend->m_stepState);
+
+    if (backend->m_stepState)
+    {
+        uint64_t nextInterval = backend->m_OnStep(backend->m_Context);
+        if (nextInterval != 0)
+        {
+            // Takes effect from this alarm's reload, so the next toggle already uses it.
+            gptimer_alarm_config_t alarm_config = {};
+            alarm_config.alarm_count = nextInterval;
+            alarm_config.flags.auto_reload_on_alarm = true;
+            gptimer_set_alarm_action(timer, &alarm_config);
+        }
+    }
+
+    return false;
+}
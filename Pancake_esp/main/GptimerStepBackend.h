@@ -0,0 +1,42 @@
+#ifndef GPTIMER_STEP_BACKEND_H
+#define GPTIMER_STEP_BACKEND_H
+
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_attr.h"
+
+#include "StepOutputBackend.h"
+
+// Step pulses from a general-purpose timer alarm with auto-reload. The alarm ISR toggles the
+// step GPIO, reports rising edges to the motor and applies the interval the motor hands back,
+// which needs CONFIG_GPTIMER_CTRL_FUNC_IN_IRAM (set in sdkconfig).
+//
+// CONFIG_GPTIMER_ISR_IRAM_SAFE keeps the alarm firing while the flash cache is off for an erase
+// or write, so the ISR and everything it calls are IRAM_ATTR and the backend and its motor must
+// live in internal RAM (MotorControl's statics do).
+class GptimerStepBackend : public StepOutputBackend
+{
+  public:
+    GptimerStepBackend(gpio_num_t stepPin, gpio_num_t dirPin, const char *name);
+
+    esp_err_t Init(uint32_t resolution_hz, StepHandler onStep, void *context) override;
+    esp_err_t SetToggleInterval(uint64_t ticks) override;
+    esp_err_t Start() override;
+    esp_err_t Stop() override;
+    void SetDirectionLevel(bool level) override;
+
+  private:
+    static bool IRAM_ATTR OnAlarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata,
+                                  void *user_ctx);
+
+    gpio_num_t m_stepPin;
+    gpio_num_t m_dirPin;
+    const char *m_name;
+
+    gptimer_handle_t m_PulseTimer;
+    StepHandler m_OnStep;
+    void *m_Context;
+    volatile bool m_stepState;
+};
+
+#endif // GPTIMER_STEP_BACKEND_H
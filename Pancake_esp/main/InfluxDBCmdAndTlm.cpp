@@ -1,11 +1,18 @@
 #include "InfluxDBCmdAndTlm.h"
 #include "InfluxDBParser.h"
+#include "InfluxDBStreamParser.h"
+#include "PushCommandChannel.h"
+#include "TelemetryGzip.h"
+#include "LineProtocolWriter.h"
+#include "TelemetryBufferPool.h"
+#include "TelemetryStream.h"
+#include "CNCOpCodes.h"
 #include "CommandHandler.h"
+#include "ControlTelemetry.h"
 #include "DataModel.h"
 #include "GPIOAssignments.h"
 #include "PanMath.h"
 #include <cstring>
-#include <algorithm>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/portmacro.h"
@@ -37,17 +44,19 @@ namespace
 static constexpr int64_t TELEMETRY_PERIOD_1HZ_MS = 300;
 static constexpr int64_t TELEMETRY_PERIOD_0_25HZ_MS = 4000;
 static constexpr int64_t TELEMETRY_PERIOD_0_05HZ_MS = 20000;
-static constexpr size_t MAX_REGISTERED_TELEMETRY_POINTS = 32;
+static constexpr size_t MAX_REGISTERED_TELEMETRY_POINTS = 40;
 
 enum class TelemetryValueType
 {
     Float,
     Bool,
+    Uint32,
 };
 
 typedef struct
 {
     const char *measurement;
+    const char *key;  // field name on the telemetry line (TelemetryLine.h)
     const void *value;
     TelemetryValueType valueType;
     int64_t period_ms;
@@ -69,6 +78,7 @@ static void RegisterTelemetryPoint(registered_telemetry_point_t *registry,
 
     registry[registryCount++] = {
         .measurement = measurement,
+        .key = GetTelemetryFieldKey(measurement),
         .value = value,
         .valueType = TelemetryValueType::Float,
         .period_ms = period_ms,
@@ -91,6 +101,7 @@ static void RegisterTelemetryPoint(registered_telemetry_point_t *registry,
 
     registry[registryCount++] = {
         .measurement = measurement,
+        .key = GetTelemetryFieldKey(measurement),
         .value = value,
         .valueType = TelemetryValueType::Bool,
         .period_ms = period_ms,
@@ -98,6 +109,29 @@ static void RegisterTelemetryPoint(registered_telemetry_point_t *registry,
     };
 }
 
+static void RegisterTelemetryPoint(registered_telemetry_point_t *registry,
+                                   size_t registryCapacity,
+                                   size_t &registryCount,
+                                   const char *measurement,
+                                   const uint32_t *value,
+                                   int64_t period_ms)
+{
+    if (registryCount >= registryCapacity)
+    {
+        ESP_LOGE(TAG, "Telemetry registry full; dropping %s", measurement);
+        return;
+    }
+
+    registry[registryCount++] = {
+        .measurement = measurement,
+        .key = GetTelemetryFieldKey(measurement),
+        .value = value,
+        .valueType = TelemetryValueType::Uint32,
+        .period_ms = period_ms,
+        .lastPublished_ms = 0,
+    };
+}
+
 static float ReadTelemetryValue(const registered_telemetry_point_t &point)
 {
     if (point.valueType == TelemetryValueType::Bool)
@@ -105,18 +139,26 @@ static float ReadTelemetryValue(const registered_telemetry_point_t &point)
         return *(static_cast<const bool *>(point.value)) ? 1.0f : 0.0f;
     }
 
+    if (point.valueType == TelemetryValueType::Uint32)
+    {
+        return static_cast<float>(*(static_cast<const uint32_t *>(point.value)));
+    }
+
     return *(static_cast<const float *>(point.value));
 }
 }
 
 SemaphoreHandle_t TlmBufferMutex = nullptr;
 
-// Buffer for telemetry data
-static char WorkingTlmBuffer[BUFFER_SIZE];
-static char TransmitTlmBuffer[BUFFER_SIZE];
+// Telemetry buffers, filled by the producers and sent in place by TransmitTlmTask
+typedef TelemetryBufferPool<BUFFER_SIZE, TLM_BUFFER_COUNT> TlmBufferPool;
+static TlmBufferPool TlmBuffers;
 
-static size_t WorkingTlmBufferIdx = 0;
-static size_t TransmitTlmBufferIdx = 0;
+#if TLM_GZIP_ENABLED
+static_assert(BUFFER_SIZE <= GZIP_MAX_INPUT_BYTES, "telemetry buffer is larger than one gzip call takes");
+static GzipCompressor TlmCompressor;
+static uint8_t CompressedTlmBuffer[TelemetryGzipScratchBytes(BUFFER_SIZE)];
+#endif
 
 // Lightweight, lock-free ring buffer for log lines captured via vprintf hook.
 // Keep sizes modest to avoid memory pressure on the ESP32.
@@ -190,13 +232,6 @@ static TaskHandle_t SerialLogTaskHandle = NULL;
 esp_http_client_handle_t TlmHttpClient = NULL;
 esp_http_client_handle_t CmdHttpClient = NULL;
 
-// Maximum size of the HTTP response buffer. Adjust as needed.
-#define MAX_HTTP_OUTPUT_BUFFER 8192
-
-// Global variables for handling fragmented HTTP responses
-static char *output_buffer;  // Buffer to store HTTP response
-static int output_len;       // Length of the stored response
-
 // Variable to track the timestamp of the last received message
 int64_t last_message_timestamp_ms = 0;
 
@@ -207,6 +242,52 @@ void format_time_string(time_t raw_time, char *buffer, size_t buffer_size) {
     strftime(buffer, buffer_size, "%Y-%m-%d %H:%M:%S", &timeinfo);
 }
 
+// Hand one command row to the decoder through the slab. Returning false stops the parser, so
+// this row and everything after it are fetched again next poll. Only an immediate command is
+// held for; anything else that finds the slab full is refused like a full CNC queue refuses it,
+// so a stop behind a long backlog of motion is still read.
+static bool post_command_row(const InfluxDBCommandRow &row, void *context) {
+    (void)context;
+    if (row.timestamp_ms <= last_message_timestamp_ms) {
+        return true;
+    }
+    if (row.payloadTooLong || row.payload.size() > CMD_BASE64_MAX_LEN) {
+        ESP_LOGE(TAG, "Command payload too long; skipping.");
+        last_message_timestamp_ms = row.timestamp_ms;
+        return true;
+    }
+    // The command is written once, into the slab; the decoder takes the handle.
+    const uint8_t opcode =
+        PeekRawCommandOpcode(reinterpret_cast<const uint8_t *>(row.payload.data()), row.payload.size());
+    const bool immediate = IsImmediateOpcode(opcode);
+    uint8_t *text = nullptr;
+    cmd_handle_t handle = cmd_slab.Allocate(row.timestamp_ms, row.payload.size() + 1, text, immediate);
+    if (handle == CMD_HANDLE_INVALID) {
+        if (immediate) {
+            ESP_LOGE(TAG, "Command slab full; retrying from this command next poll.");
+            return false;
+        }
+        ESP_LOGW(TAG, "Command slab full; dropping opcode 0x%02X", opcode);
+        last_message_timestamp_ms = row.timestamp_ms;
+        return true;
+    }
+    memcpy(text, row.payload.data(), row.payload.size());
+    text[row.payload.size()] = '\0';
+    if (xQueueSend(cmd_queue_fast_decode, &handle, 0) != pdTRUE) {
+        cmd_slab.Release(handle);
+        ESP_LOGE(TAG, "Failed to post command to decode queue.");
+        return false;
+    }
+    last_message_timestamp_ms = row.timestamp_ms;
+    char time_str[50];
+    format_time_string((time_t)(last_message_timestamp_ms / 1000), time_str, sizeof(time_str));
+    ESP_LOGD(TAG, "Posted payload to decode queue. Time: %s, Payload: %s", time_str, (const char *)text);
+    return true;
+}
+
+// The response is parsed chunk by chunk as it arrives rather than buffered whole.
+static InfluxDBStreamParser command_parser(post_command_row, nullptr);
+
 // Function to handle HTTP events and process data
 esp_err_t _http_event_handler(esp_http_client_event_t *evt) {
     switch(evt->event_id) {
@@ -224,53 +305,15 @@ esp_err_t _http_event_handler(esp_http_client_event_t *evt) {
             break;
         case HTTP_EVENT_ON_DATA:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, %d bytes received:", evt->data_len);
-            // Append incoming data chunks to the output buffer
-            if (output_len + evt->data_len < MAX_HTTP_OUTPUT_BUFFER) {
-                memcpy(output_buffer + output_len, evt->data, evt->data_len);
-                output_len += evt->data_len;
-            } else {
-                ESP_LOGE(TAG, "Output buffer overflow.");
-            }
+            command_parser.Feed(static_cast<const char *>(evt->data), evt->data_len);
             break;
         case HTTP_EVENT_ON_FINISH:
             ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
-            // Null-terminate the buffer
-            output_buffer[output_len] = '\0';
-            ESP_LOGD(TAG, "Full response received:\n%s", output_buffer);
-            
-            // Trigger parsing of the full response
-            if (output_len > 0) {
-                std::vector<InfluxDBCommand> cmds;
-                size_t n = parse_influxdb_command_list(output_buffer, cmds);
-                if (n == 0) {
-                    if (strstr(output_buffer, ",_result,0,") == NULL) {
-                        ESP_LOGD(TAG, "No command in response.");
-                    } else {
-                        ESP_LOGE(TAG, "Failed to parse InfluxDB response.");
-                    }
-                } else {
-                    // Process in chronological order
-                    std::sort(cmds.begin(), cmds.end(), [](const InfluxDBCommand &a, const InfluxDBCommand &b){
-                        return a.timestamp_ms < b.timestamp_ms;
-                    });
-                    for (const auto &cmd : cmds) {
-                        if (cmd.timestamp_ms <= last_message_timestamp_ms) {
-                            continue;
-                        }
-                        raw_cmd_payload_t new_payload{};
-                        new_payload.timestamp_ms = cmd.timestamp_ms;
-                        strncpy(new_payload.payload, cmd.payload.c_str(), sizeof(new_payload.payload) - 1);
-                        if (xQueueSend(cmd_queue_fast_decode, &new_payload, 0) == pdTRUE) {
-                            last_message_timestamp_ms = cmd.timestamp_ms;
-                            char time_str[50];
-                            format_time_string((time_t)(last_message_timestamp_ms / 1000), time_str, sizeof(time_str));
-                            ESP_LOGD(TAG, "Posted payload to decode queue. Time: %s, Payload: %s", time_str, new_payload.payload);
-                        } else {
-                            ESP_LOGE(TAG, "Failed to post command to decode queue.");
-                            break;
-                        }
-                    }
-                }
+            command_parser.Finish();
+            if (command_parser.GetRejectedRowCount() > 0) {
+                ESP_LOGE(TAG, "Failed to parse %u InfluxDB rows.", (unsigned)command_parser.GetRejectedRowCount());
+            } else if (command_parser.GetRowCount() == 0) {
+                ESP_LOGD(TAG, "No command in response.");
             }
             break;
         case HTTP_EVENT_DISCONNECTED:
@@ -319,54 +362,28 @@ void AddLogToBuffer(const char *message)
     gettimeofday(&tv, NULL);
     timeStamp = (int64_t)tv.tv_sec * 1000.0 + (int64_t)tv.tv_usec / 1000L;
 
-    char escapedMessage[LOG_MSG_MAX_LEN * 2];
-    size_t escapedIdx = 0;
-    for (size_t i = 0; message[i] != '\0' && escapedIdx < sizeof(escapedMessage) - 1; ++i)
-    {
-        char c = message[i];
-        if (c == '\r' || c == '\n')
-        {
-            c = ' ';
-        }
-        if ((c == '"' || c == '\\') && escapedIdx < sizeof(escapedMessage) - 2)
-        {
-            escapedMessage[escapedIdx++] = '\\';
-        }
-        escapedMessage[escapedIdx++] = c;
-    }
-    escapedMessage[escapedIdx] = '\0';
-
+    // Escaped straight into the buffer; a line that does not fit anywhere is dropped whole.
     xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
-    if (WorkingTlmBufferIdx < BUFFER_SIZE)
-    {
-        size_t remaining = BUFFER_SIZE - WorkingTlmBufferIdx;
-        int written = snprintf(
-            WorkingTlmBuffer + WorkingTlmBufferIdx, remaining,
-            "logs,level=info,source=myApp message=\"%s\" %lld\n", escapedMessage, timeStamp);
-        if (written > 0 && (size_t)written < remaining)
+    TlmBuffers.Append(
+        [&](char *Out, size_t Capacity)
         {
-            WorkingTlmBufferIdx += written;
-        }
-    }
+            LineProtocolWriter writer(Out, Capacity);
+            writer.Append("logs,level=info,source=myApp message=\"");
+            writer.AppendEscaped(message);
+            writer.Append("\" ");
+            writer.AppendInt64(timeStamp);
+            writer.Append('\n');
+            return writer.Ok() ? writer.Length() : 0;
+        });
     xSemaphoreGive(TlmBufferMutex);
-    // else: drop silently
 }
 
-void AddDataToBuffer(const char *Measurement, const char *Field, float Value, int64_t TimeStamp)
+void AddFieldsToBuffer(const TelemetryField *Fields, size_t Count, int64_t TimeStamp)
 {
+    // A line that does not fit is dropped whole rather than cut short.
     xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
-    if (WorkingTlmBufferIdx < BUFFER_SIZE)
-    {
-        size_t remaining = BUFFER_SIZE - WorkingTlmBufferIdx;
-        int written =
-            snprintf(WorkingTlmBuffer + WorkingTlmBufferIdx, remaining,
-                     "%s,location=us-midwest %s=%.5f %lld\n", Measurement, Field, Value, TimeStamp);
-        if (written > 0 && (size_t)written < remaining)
-        {
-            WorkingTlmBufferIdx += written;
-        }
-        // else: drop silently
-    }
+    TlmBuffers.Append([&](char *Out, size_t Capacity)
+                      { return FormatTelemetryLine(Out, Capacity, TELEMETRY_LINE_PREFIX, Fields, Count, TimeStamp); });
     xSemaphoreGive(TlmBufferMutex);
 }
 
@@ -412,18 +429,11 @@ void CmdAndTlmStart(void)
     // Enable log capture to ring buffer and keep the prior UART/JTAG sink active.
     PreviousLogVprintf = esp_log_set_vprintf(InfluxVprintf);
     CommandHandlerStart();
+    PushCommandChannelStart();
 }
 
 void QueryCmdTask(void *Parameters)
 {
-    output_buffer = (char *)malloc(MAX_HTTP_OUTPUT_BUFFER);
-    if (!output_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate memory for HTTP output buffer");
-        vTaskDelete(NULL);
-        return;
-    }
-    memset(output_buffer, 0, MAX_HTTP_OUTPUT_BUFFER);
-
     for (;;)
     {   
         vTaskDelay(pdMS_TO_TICKS(TRANSMITPERIOD_MS));
@@ -465,19 +475,22 @@ void QueryCmdTask(void *Parameters)
         }
 
         // ESP_LOGW(TAG, "Looking for commands");
-        char fluxQuery[256];
-        // Query recent window and return all rows; device will de-dup by timestamp
+        char fluxQuery[384];
+        // Ask only for commands after the last one acknowledged, so each response carries new
+        // rows and nothing else. Until a command has been seen, fall back to a recent window.
         int lookback_s = CMD_QUERY_LOOKBACK_MS / 1000;
         if (lookback_s <= 0) lookback_s = 300; // default 5m
-        snprintf(fluxQuery, sizeof(fluxQuery),
-                 "from(bucket:\"%s\") |> range(start:-%ds) |> filter(fn:(r)=> r._measurement==\"cmd\" and r._field==\"data\")",
-                 INFLUXDB_CMD_BUCKET, lookback_s);
+        if (!build_influxdb_command_query(fluxQuery, sizeof(fluxQuery), INFLUXDB_CMD_BUCKET,
+                                          last_message_timestamp_ms, lookback_s, CMD_QUERY_MAX_ROWS))
+        {
+            ESP_LOGE(TAG, "Command query does not fit its buffer.");
+            xSemaphoreGive(WifiAvailableSemaphore);
+            continue;
+        }
         esp_http_client_set_post_field(CmdHttpClient, fluxQuery, strlen(fluxQuery));
 
         // Perform the HTTP request
-        // Reset buffer before each new request
-        memset(output_buffer, 0, MAX_HTTP_OUTPUT_BUFFER);
-        output_len = 0;
+        command_parser.Reset();
         esp_err_t err = esp_http_client_perform(CmdHttpClient);
         if (err == ESP_OK) {
             ESP_LOGD(TAG, "HTTP POST Status = %d, content_length = %d",
@@ -491,23 +504,74 @@ void QueryCmdTask(void *Parameters)
     }
 }
 
+// Next sample of a finished control loop capture to upload.
+static size_t CaptureUploadIdx = 0;
+
+// Send the next transmit buffer's worth of a finished capture as "cap" lines, and release the
+// capture once its last sample has gone.
+static void SendCaptureChunk()
+{
+    const size_t sampleCount = ControlLoopCapture.GetSampleCount();
+    if (CaptureUploadIdx == 0)
+    {
+        ESP_LOGI(TAG, "Uploading capture: %u samples, trigger 0x%02X at sample %u", (unsigned)sampleCount,
+                 ControlLoopCapture.GetTriggerSource(), (unsigned)ControlLoopCapture.GetTriggerIndex());
+    }
+
+    // Samples carry esp_timer time; lines carry wall-clock milliseconds like the rest of telemetry.
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    const int64_t wallOffset_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - esp_timer_get_time();
+
+    // Lines go into a free pool buffer, or wait for the next period if there is none.
+    xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
+    TlmBufferPool::Buffer *buffer = TlmBuffers.TakeFree();
+    xSemaphoreGive(TlmBufferMutex);
+    if (buffer == nullptr)
+    {
+        return;
+    }
+
+    while (CaptureUploadIdx < sampleCount)
+    {
+        TelemetryField fields[CONTROL_CAPTURE_FIELD_COUNT];
+        size_t fieldCount = GetControlCaptureFields(ControlLoopCapture.GetSample(CaptureUploadIdx), fields);
+        int64_t timeStamp = (ControlLoopCapture.GetSampleTime_us(CaptureUploadIdx) + wallOffset_us) / 1000;
+        size_t written = FormatTelemetryLine(buffer->data + buffer->length, BUFFER_SIZE - buffer->length,
+                                             CONTROL_CAPTURE_LINE_PREFIX, fields, fieldCount, timeStamp);
+        if (written == 0)
+        {
+            break;
+        }
+        buffer->length += written;
+        CaptureUploadIdx++;
+    }
+    TelemetryChunk chunk = {buffer->data, buffer->length};
+    SendDataToInflux(&chunk, 1);
+
+    xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
+    TlmBuffers.Give(&buffer, 1);
+    xSemaphoreGive(TlmBufferMutex);
+
+    if (CaptureUploadIdx >= sampleCount)
+    {
+        CaptureUploadIdx = 0;
+        ControlLoopCapture.Release();
+        ESP_LOGI(TAG, "Capture uploaded");
+    }
+}
+
 void TransmitTlmTask(void *Parameters)
 {
     for (;;)
     {
-        // Copy the telemetry buffer to a transmit buffer
-        bool has_new_data = false;
-        // Take the buffer mutex and copy to transmit buffer
+        // Take the filled buffers; the mutex is held only to move their pointers. One buffer
+        // always stays with the producers while these are sent.
+        TlmBufferPool::Buffer *sending[TLM_BUFFER_COUNT - 1];
         xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
-        if (WorkingTlmBufferIdx > 0)
-        {
-            TransmitTlmBufferIdx = WorkingTlmBufferIdx;
-            memcpy(TransmitTlmBuffer, WorkingTlmBuffer, WorkingTlmBufferIdx);
-            WorkingTlmBufferIdx = 0;
-            has_new_data = true;
-        }
+        size_t sendingCount = TlmBuffers.Take(sending, TLM_BUFFER_COUNT - 1);
         xSemaphoreGive(TlmBufferMutex);
-        
+
         // Create a new HTTP client if needed
         if (TlmHttpClient == NULL)
         {
@@ -525,14 +589,23 @@ void TransmitTlmTask(void *Parameters)
             snprintf(authHeader, sizeof(authHeader), "Token %s", INFLUXDB_TOKEN);
             esp_http_client_set_header(TlmHttpClient, "Authorization", authHeader);
             esp_http_client_set_header(TlmHttpClient, "Content-Type", "text/plain");
+#if TLM_GZIP_ENABLED
+            // Every chunk goes out as a gzip member (StreamTelemetryChunks).
+            esp_http_client_set_header(TlmHttpClient, "Content-Encoding", "gzip");
+#endif
         }
 
-        // Attempt to send the telemetry data only if we copied new data
-        if (has_new_data)
+        // Attempt to send the telemetry data only if there is new data
+        if (sendingCount > 0)
         {
             if (xSemaphoreTake(WifiAvailableSemaphore, pdMS_TO_TICKS(100)) == pdTRUE)
             {
-                SendDataToInflux(TransmitTlmBuffer, TransmitTlmBufferIdx);
+                TelemetryChunk chunks[TLM_BUFFER_COUNT - 1];
+                for (size_t i = 0; i < sendingCount; i++)
+                {
+                    chunks[i] = {sending[i]->data, sending[i]->length};
+                }
+                SendDataToInflux(chunks, sendingCount);
                 xSemaphoreGive(WifiAvailableSemaphore);
             }
             else if (TlmHttpClient)
@@ -541,8 +614,18 @@ void TransmitTlmTask(void *Parameters)
                 TlmHttpClient = NULL;
             }
 
-            // Clear transmit buffer index so we don't resend stale data next cycle
-            TransmitTlmBufferIdx = 0;
+            // Sent or not, the buffers go back so stale data is not resent next cycle
+            xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
+            TlmBuffers.Give(sending, sendingCount);
+            xSemaphoreGive(TlmBufferMutex);
+        }
+
+        // A finished capture goes up one buffer per period, so telemetry keeps its cadence.
+        if (TlmHttpClient && ControlLoopCapture.GetState() == ControlCaptureState::Captured &&
+            xSemaphoreTake(WifiAvailableSemaphore, pdMS_TO_TICKS(100)) == pdTRUE)
+        {
+            SendCaptureChunk();
+            xSemaphoreGive(WifiAvailableSemaphore);
         }
 
         vTaskDelay(pdMS_TO_TICKS(TRANSMITPERIOD_MS));
@@ -573,54 +656,65 @@ void AggregateTlmTask(void *Parameters)
         ESP_LOGE(TAG, "Reachable Cartesian boundary corners unavailable for telemetry");
     }
 
+    // Control loop points are registered against this task's own copy, refreshed from the
+    // seqlock once per pass, so every point in a pass comes from the same control cycle.
+    control_tlm_t controlTlm{};
     registered_telemetry_point_t telemetryRegistry[MAX_REGISTERED_TELEMETRY_POINTS];
     size_t telemetryRegistryCount = 0;
 
     // Register telemetry point cadences in one place rather than hard-coding named buckets.
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "tipPos_X_m", &TelemetryData.tipPos_X_m, TELEMETRY_PERIOD_1HZ_MS);
+                           "tipPos_X_m", &controlTlm.tipPos_X_m, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "tipPos_Y_m", &TelemetryData.tipPos_Y_m, TELEMETRY_PERIOD_1HZ_MS);
+                           "tipPos_Y_m", &controlTlm.tipPos_Y_m, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "targetPos_X_m", &TelemetryData.targetPos_X_m, TELEMETRY_PERIOD_1HZ_MS);
+                           "targetPos_X_m", &controlTlm.targetPos_X_m, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "targetPos_Y_m", &TelemetryData.targetPos_Y_m, TELEMETRY_PERIOD_1HZ_MS);
+                           "targetPos_Y_m", &controlTlm.targetPos_Y_m, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "S0_Speed_degps", &TelemetryData.S0MotorTlm.Speed_degps, TELEMETRY_PERIOD_1HZ_MS);
+                           "S0_Speed_degps", &controlTlm.S0MotorTlm.Speed_degps, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "S0_TargetSpeed_degps", &TelemetryData.S0MotorTlm.TargetSpeed_degps, TELEMETRY_PERIOD_1HZ_MS);
+                           "S0_TargetSpeed_degps", &controlTlm.S0MotorTlm.TargetSpeed_degps, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "S1_Speed_degps", &TelemetryData.S1MotorTlm.Speed_degps, TELEMETRY_PERIOD_1HZ_MS);
+                           "S1_Speed_degps", &controlTlm.S1MotorTlm.Speed_degps, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "S1_TargetSpeed_degps", &TelemetryData.S1MotorTlm.TargetSpeed_degps, TELEMETRY_PERIOD_1HZ_MS);
+                           "S1_TargetSpeed_degps", &controlTlm.S1MotorTlm.TargetSpeed_degps, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "Pump_Speed_degps", &TelemetryData.PumpMotorTlm.Speed_degps, TELEMETRY_PERIOD_1HZ_MS);
+                           "Pump_Speed_degps", &controlTlm.PumpMotorTlm.Speed_degps, TELEMETRY_PERIOD_1HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "Pump_TargetSpeed_degps", &TelemetryData.PumpMotorTlm.TargetSpeed_degps, TELEMETRY_PERIOD_1HZ_MS);
+                           "Pump_TargetSpeed_degps", &controlTlm.PumpMotorTlm.TargetSpeed_degps, TELEMETRY_PERIOD_1HZ_MS);
 
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "targetPos_S0_deg", &TelemetryData.targetPos_S0_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "targetPos_S0_deg", &controlTlm.targetPos_S0_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+    RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
+                           "targetPos_S1_deg", &controlTlm.targetPos_S1_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+    RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
+                           "plannedTarget_S0_deg", &controlTlm.plannedTarget_S0_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+    RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
+                           "plannedTarget_S1_deg", &controlTlm.plannedTarget_S1_deg, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "targetPos_S1_deg", &TelemetryData.targetPos_S1_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "plannedDelta_S0_deg", &controlTlm.plannedDelta_S0_deg, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "plannedTarget_S0_deg", &TelemetryData.plannedTarget_S0_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "plannedDelta_S1_deg", &controlTlm.plannedDelta_S1_deg, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "plannedTarget_S1_deg", &TelemetryData.plannedTarget_S1_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "S0_Pos_deg", &controlTlm.S0MotorTlm.Position_deg, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "plannedDelta_S0_deg", &TelemetryData.plannedDelta_S0_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "S1_Pos_deg", &controlTlm.S1MotorTlm.Position_deg, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "plannedDelta_S1_deg", &TelemetryData.plannedDelta_S1_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "loopWindowJitter_us", &controlTlm.loopWindowJitter_us, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "S0_Pos_deg", &TelemetryData.S0MotorTlm.Position_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "loopWindowLatency_us", &controlTlm.loopWindowLatency_us, TELEMETRY_PERIOD_0_25HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "S1_Pos_deg", &TelemetryData.S1MotorTlm.Position_deg, TELEMETRY_PERIOD_0_25HZ_MS);
+                           "loopWorstLatency_us", &controlTlm.loopWorstLatency_us, TELEMETRY_PERIOD_0_25HZ_MS);
+    RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
+                           "loopOverrunCount", &controlTlm.loopOverrunCount, TELEMETRY_PERIOD_0_25HZ_MS);
 
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
                            "espTemp_C", &TelemetryData.espTemp_C, TELEMETRY_PERIOD_0_05HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "limitBlocked_S0", &TelemetryData.limitBlocked_S0, TELEMETRY_PERIOD_0_05HZ_MS);
+                           "limitBlocked_S0", &controlTlm.limitBlocked_S0, TELEMETRY_PERIOD_0_05HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
-                           "limitBlocked_S1", &TelemetryData.limitBlocked_S1, TELEMETRY_PERIOD_0_05HZ_MS);
+                           "limitBlocked_S1", &controlTlm.limitBlocked_S1, TELEMETRY_PERIOD_0_05HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
                            "S0_LimitSwitch", &TelemetryData.S0LimitSwitch, TELEMETRY_PERIOD_0_05HZ_MS);
     RegisterTelemetryPoint(telemetryRegistry, MAX_REGISTERED_TELEMETRY_POINTS, telemetryRegistryCount,
@@ -657,43 +751,78 @@ void AggregateTlmTask(void *Parameters)
             ++drained;
         }
 
-        if (sendBufferOverflowWarning && WorkingTlmBufferIdx > WARN_BUFFER_SIZE)
+        xSemaphoreTake(TlmBufferMutex, portMAX_DELAY);
+        size_t droppedLines = TlmBuffers.GetDroppedCount();
+        xSemaphoreGive(TlmBufferMutex);
+        if (sendBufferOverflowWarning && droppedLines > 0)
         {
-            ESP_LOGW(TAG, "Buffer overflow warning: %d bytes used", WorkingTlmBufferIdx);
+            ESP_LOGW(TAG, "Buffer overflow warning: telemetry buffers full, %u lines dropped",
+                     (unsigned)droppedLines);
             sendBufferOverflowWarning = false;
         }
 
+        // Every point due this cycle goes out as a field of one line.
+        ControlTelemetry.Read(controlTlm);
+        TelemetryField dueFields[MAX_REGISTERED_TELEMETRY_POINTS];
+        size_t dueCount = 0;
         for (size_t i = 0; i < telemetryRegistryCount; ++i)
         {
             registered_telemetry_point_t &point = telemetryRegistry[i];
             if (point.lastPublished_ms == 0 || timeStamp - point.lastPublished_ms >= point.period_ms)
             {
-                AddDataToBuffer(point.measurement, "data", ReadTelemetryValue(point), timeStamp);
+                dueFields[dueCount++] = {point.key, ReadTelemetryValue(point)};
                 point.lastPublished_ms = timeStamp;
             }
         }
+        AddFieldsToBuffer(dueFields, dueCount, timeStamp);
 
         vTaskDelay(bufferAddPeriod_Ticks);
 
     }
 }
 
-void SendDataToInflux(const char *Data, size_t Length)
+// Body writes for StreamTelemetryChunks.
+static bool WriteTlmRequest(void *Context, const char *Data, size_t Length)
 {
-    //ESP_LOGW(TAG, "Attempting to send data");
+    esp_http_client_handle_t client = static_cast<esp_http_client_handle_t>(Context);
+    return esp_http_client_write(client, Data, (int)Length) == (int)Length;
+}
 
-    esp_http_client_set_post_field(TlmHttpClient, Data, Length);
+// Stream the chunks to InfluxDB as one chunked request, straight from the buffers they are in.
+void SendDataToInflux(const TelemetryChunk *Chunks, size_t Count)
+{
+#if TLM_GZIP_ENABLED
+    GzipCompressor *compressor = &TlmCompressor;
+    uint8_t *scratch = CompressedTlmBuffer;
+    size_t scratchCapacity = sizeof(CompressedTlmBuffer);
+#else
+    GzipCompressor *compressor = nullptr;
+    uint8_t *scratch = nullptr;
+    size_t scratchCapacity = 0;
+#endif
 
     int retryDelay_ms = 1000;
     esp_err_t err = ESP_FAIL;
 
     for (int i = 0; i < 3; i++)
     {
-        err = esp_http_client_perform(TlmHttpClient);
+        // A negative length opens the request with Transfer-Encoding: chunked.
+        err = esp_http_client_open(TlmHttpClient, -1);
+        size_t bodyBytes = 0;
+        if (err == ESP_OK &&
+            !StreamTelemetryChunks(Chunks, Count, compressor, scratch, scratchCapacity, WriteTlmRequest, TlmHttpClient,
+                                   bodyBytes))
+        {
+            err = ESP_FAIL;
+        }
+        if (err == ESP_OK && esp_http_client_fetch_headers(TlmHttpClient) < 0)
+        {
+            err = ESP_FAIL;
+        }
 
         int status = esp_http_client_get_status_code(TlmHttpClient);
 
-        if (status >= 400)
+        if (err == ESP_OK && status >= 400)
         {
             char buf[256];
             int len = esp_http_client_read_response(TlmHttpClient, buf, sizeof(buf) - 1);
@@ -704,12 +833,13 @@ void SendDataToInflux(const char *Data, size_t Length)
             buf[len] = 0; // NUL-terminate
             ESP_LOGE(TAG, "InfluxDB error %d: %s", status, buf);
         }
+        esp_http_client_close(TlmHttpClient);
 
         if (err == ESP_OK)
         {
             ESP_LOGD(TAG, "Data sent successfully, attempt %d", i + 1);
-            ESP_LOGD(TAG, "Data size: %d bytes", Length);
-            ESP_LOGD(TAG, "HTTP Status Code: %d", esp_http_client_get_status_code(TlmHttpClient));
+            ESP_LOGD(TAG, "Data size: %u bytes in %u chunks", (unsigned)bodyBytes, (unsigned)Count);
+            ESP_LOGD(TAG, "HTTP Status Code: %d", status);
             break;
         }
         else
@@ -13,15 +13,24 @@
 #include "Secret.h"
 #include "WifiHandler.h"
 #include "Telemetry.h"
+#include "TelemetryLine.h"
+#include "TelemetryStream.h"
 #include "freertos/queue.h"
 #include <stdlib.h>
 #include <string.h>
 
 // Telemetry buffer settings
 #define BUFFER_SIZE 6000
-#define WARN_BUFFER_SIZE 5500
+// Buffers in the telemetry pool; the transmit task sends at most all but one at a time.
+#define TLM_BUFFER_COUNT 3
 #define TRANSMITPERIOD_MS 900
+// Gzip each telemetry upload (Content-Encoding: gzip); 0 sends plain line protocol.
+#ifndef TLM_GZIP_ENABLED
+#define TLM_GZIP_ENABLED 1
+#endif
 #define CMD_QUERY_LOOKBACK_MS 10000
+// Commands fetched per poll; later ones wait for the next poll.
+#define CMD_QUERY_MAX_ROWS 32
 
 // Function declarations
 void CmdAndTlmInit(void);
@@ -29,8 +38,8 @@ void CmdAndTlmStart(void);
 void TransmitTlmTask(void *Parameters);
 void AggregateTlmTask(void *Parameters);
 void QueryCmdTask(void *Parameters);
-void SendDataToInflux(const char *data, size_t length);
-void AddDataToBuffer(const char *measurement, const char *field, float value, int64_t timestamp);
+void SendDataToInflux(const TelemetryChunk *chunks, size_t count);
+void AddFieldsToBuffer(const TelemetryField *fields, size_t count, int64_t timestamp);
 void AddLogToBuffer(const char *message);
 
 typedef struct
@@ -4,20 +4,18 @@
 #include <cctype>
 #include <vector>
 #include <cstdint>
+#include <cstdio>
 
-// Calculate days since Unix epoch for a given civil date.
 // Algorithm adapted from Howard Hinnant's date algorithms:
 // https://howardhinnant.github.io/date_algorithms.html
-#if !defined(_WIN32) && !defined(__GLIBC__)
-static int days_from_civil(int y, unsigned m, unsigned d) {
+int64_t days_from_civil(int y, unsigned m, unsigned d) {
     y -= m <= 2;
     const int era = (y >= 0 ? y : y - 399) / 400;
     const unsigned yoe = static_cast<unsigned>(y - era * 400);      // [0, 399]
     const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1; // [0, 365]
     const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;     // [0, 146096]
-    return era * 146097 + static_cast<int>(doe) - 719468;
+    return static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(doe) - 719468;
 }
-#endif
 
 static time_t utc_mktime(const struct tm &tm) {
 #if defined(_WIN32)
@@ -123,14 +121,19 @@ size_t parse_influxdb_command_list(const std::string &body, std::vector<InfluxDB
         return 0;
     }
 
+    // Column positions of a full, unprojected response; replaced by the header row if present.
+    size_t time_col = 5;
+    size_t value_col = 6;
+
     std::istringstream stream(body);
     std::string line;
     size_t count = 0;
     while (std::getline(stream, line)) {
+        // A line the buffer cut short has no newline after it.
+        if (stream.eof()) break;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
         // Skip comments/headers
         if (line.empty() || line[0] == '#') continue;
-        // Expect data rows to contain ",_result,"
-        if (line.find(",_result,") == std::string::npos) continue;
 
         std::vector<std::string> tokens;
         std::stringstream ss(line);
@@ -138,16 +141,54 @@ size_t parse_influxdb_command_list(const std::string &body, std::vector<InfluxDB
         while (std::getline(ss, item, ',')) {
             tokens.push_back(item);
         }
-        if (tokens.size() < 7) continue;
+
+        if (tokens.size() > 1 && tokens[1] == "result") {
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (tokens[i] == "_time") time_col = i;
+                if (tokens[i] == "_value") value_col = i;
+            }
+            continue;
+        }
+        // Expect data rows to contain ",_result,"
+        if (tokens.size() < 2 || tokens[1] != "_result") continue;
+        if (tokens.size() <= std::max(time_col, value_col)) continue;
 
         int64_t timestamp_ms;
-        if (!parse_iso8601_ms(tokens[5], timestamp_ms)) continue;
+        if (!parse_iso8601_ms(tokens[time_col], timestamp_ms)) continue;
 
         InfluxDBCommand cmd;
         cmd.timestamp_ms = timestamp_ms;
-        cmd.payload = tokens[6];
+        cmd.payload = tokens[value_col];
         out.push_back(std::move(cmd));
         ++count;
     }
     return count;
 }
+
+bool build_influxdb_command_query(char *out, size_t out_len, const char *bucket, int64_t after_ms,
+                                  int lookback_s, int max_rows) {
+    // Flux's range start is inclusive and commands are written with millisecond precision, so
+    // the next possible command is 1 ms after the last one acknowledged.
+    char start[40];
+    if (after_ms > 0) {
+        int64_t start_ms = after_ms + 1;
+        time_t seconds = static_cast<time_t>(start_ms / 1000);
+        struct tm tm = {};
+        if (!gmtime_r(&seconds, &tm)) {
+            return false;
+        }
+        size_t n = strftime(start, sizeof(start), "%Y-%m-%dT%H:%M:%S", &tm);
+        snprintf(start + n, sizeof(start) - n, ".%03dZ", static_cast<int>(start_ms % 1000));
+    } else {
+        snprintf(start, sizeof(start), "-%ds", lookback_s);
+    }
+
+    // group() merges any per-tag tables so the sort and limit apply across all commands.
+    int written = snprintf(out, out_len,
+                           "from(bucket:\"%s\") |> range(start:%s)"
+                           " |> filter(fn:(r)=> r._measurement==\"cmd\" and r._field==\"data\")"
+                           " |> keep(columns:[\"_time\",\"_value\"]) |> group()"
+                           " |> sort(columns:[\"_time\"]) |> limit(n:%d)",
+                           bucket, start, max_rows);
+    return written > 0 && static_cast<size_t>(written) < out_len;
+}
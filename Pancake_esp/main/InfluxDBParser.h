@@ -14,6 +14,9 @@ struct InfluxDBCommand {
     std::string payload;   // Base64 encoded payload
 };
 
+// Days since the Unix epoch for a civil date (month and day from 1), for any year.
+int64_t days_from_civil(int y, unsigned m, unsigned d);
+
 // Return the last non-empty line from an InfluxDB CSV response.
 std::string get_last_non_empty_line(const std::string &body);
 
@@ -21,7 +24,15 @@ std::string get_last_non_empty_line(const std::string &body);
 bool parse_influxdb_command(const std::string &body, InfluxDBCommand &cmd);
 
 // Parse all commands contained in the CSV body. Appends to 'out'.
-// Returns the number of commands parsed.
+// Returns the number of commands parsed. The _time and _value columns are located from the
+// header row when there is one, so projected responses parse as well as full ones. A final line
+// without its newline is a row cut short by a full response buffer and is left for the next poll.
 size_t parse_influxdb_command_list(const std::string &body, std::vector<InfluxDBCommand> &out);
 
+// Build the Flux query for commands written after after_ms, oldest first and at most max_rows of
+// them, projected to the _time and _value columns. With no acknowledged command yet (after_ms <= 0)
+// the query falls back to the last lookback_s seconds. Returns false if 'out' is too small.
+bool build_influxdb_command_query(char *out, size_t out_len, const char *bucket, int64_t after_ms,
+                                  int lookback_s, int max_rows);
+
 #endif // INFLUXDB_PARSER_H
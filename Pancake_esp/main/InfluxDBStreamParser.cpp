@@ -0,0 +1,239 @@
+#include "InfluxDBStreamParser.h"
+
+#include <cstring>
+
+#include "InfluxDBParser.h"
+
+namespace
+{
+bool IsDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+bool ReadDigits(std::string_view text, size_t pos, size_t count, int &value)
+{
+    value = 0;
+    for (size_t i = pos; i < pos + count; i++)
+    {
+        if (!IsDigit(text[i]))
+        {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+} // namespace
+
+bool ParseIso8601Ms(std::string_view text, int64_t &out_ms)
+{
+    if (text.size() < 19 || text[4] != '-' || text[7] != '-' || text[10] != 'T' || text[13] != ':' ||
+        text[16] != ':')
+    {
+        return false;
+    }
+
+    int year, month, day, hour, minute, second;
+    if (!ReadDigits(text, 0, 4, year) || !ReadDigits(text, 5, 2, month) || !ReadDigits(text, 8, 2, day) ||
+        !ReadDigits(text, 11, 2, hour) || !ReadDigits(text, 14, 2, minute) ||
+        !ReadDigits(text, 17, 2, second))
+    {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+    {
+        return false;
+    }
+
+    size_t pos = 19;
+    int64_t millis = 0;
+    if (pos < text.size() && text[pos] == '.')
+    {
+        pos++;
+        int digits = 0;
+        while (pos < text.size() && IsDigit(text[pos]))
+        {
+            if (digits < 3)
+            {
+                millis = millis * 10 + (text[pos] - '0');
+            }
+            digits++;
+            pos++;
+        }
+        if (digits == 0)
+        {
+            return false;
+        }
+        for (; digits < 3; digits++)
+        {
+            millis *= 10;
+        }
+    }
+    if (pos < text.size() && text[pos] == 'Z')
+    {
+        pos++;
+    }
+    if (pos != text.size())
+    {
+        return false;
+    }
+
+    int64_t days = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+    out_ms = ((days * 24 + hour) * 60 + minute) * 60000 + static_cast<int64_t>(second) * 1000 + millis;
+    return true;
+}
+
+InfluxDBStreamParser::InfluxDBStreamParser(RowHandler handler, void *context)
+    : handler(handler), context(context)
+{
+}
+
+void InfluxDBStreamParser::Reset()
+{
+    carryLength = 0;
+    carryTruncated = false;
+    timeColumn = 5;
+    valueColumn = 6;
+    rowCount = 0;
+    rejectedRowCount = 0;
+    stopped = false;
+}
+
+bool InfluxDBStreamParser::Feed(const char *data, size_t length)
+{
+    std::string_view rest(data, length);
+    while (!rest.empty() && !stopped)
+    {
+        size_t newline = rest.find('\n');
+        std::string_view piece = rest.substr(0, newline);
+        bool inCarry = carryLength > 0 || carryTruncated || newline == std::string_view::npos;
+        if (inCarry)
+        {
+            size_t room = sizeof(carry) - carryLength;
+            size_t copied = piece.size() < room ? piece.size() : room;
+            memcpy(carry + carryLength, piece.data(), copied);
+            carryLength += copied;
+            carryTruncated = carryTruncated || copied < piece.size();
+        }
+        if (newline == std::string_view::npos)
+        {
+            break;
+        }
+
+        rest.remove_prefix(newline + 1);
+        if (inCarry)
+        {
+            ConsumeLine(std::string_view(carry, carryLength), carryTruncated);
+            carryLength = 0;
+            carryTruncated = false;
+        }
+        else
+        {
+            ConsumeLine(piece, false);
+        }
+    }
+    return !stopped;
+}
+
+void InfluxDBStreamParser::Finish()
+{
+    carryLength = 0;
+    carryTruncated = false;
+}
+
+void InfluxDBStreamParser::ConsumeLine(std::string_view line, bool truncated)
+{
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+    // Skip blank lines and annotations
+    if (line.empty() || line[0] == '#')
+    {
+        return;
+    }
+
+    std::string_view kind;
+    std::string_view time;
+    std::string_view value;
+    bool haveTime = false;
+    bool haveValue = false;
+    size_t column = 0;
+    size_t start = 0;
+    for (;;)
+    {
+        size_t comma = line.find(',', start);
+        std::string_view field = line.substr(start, comma == std::string_view::npos ? std::string_view::npos
+                                                                                    : comma - start);
+        if (column == 1)
+        {
+            kind = field;
+        }
+        if (column == timeColumn)
+        {
+            time = field;
+            haveTime = true;
+        }
+        if (column == valueColumn)
+        {
+            value = field;
+            haveValue = true;
+        }
+        if (comma == std::string_view::npos)
+        {
+            break;
+        }
+        start = comma + 1;
+        column++;
+    }
+
+    if (kind == "result")
+    {
+        // Header row: find the columns the rows below it use.
+        column = 0;
+        start = 0;
+        for (;;)
+        {
+            size_t comma = line.find(',', start);
+            std::string_view field = line.substr(
+                start, comma == std::string_view::npos ? std::string_view::npos : comma - start);
+            if (field == "_time")
+            {
+                timeColumn = column;
+            }
+            if (field == "_value")
+            {
+                valueColumn = column;
+            }
+            if (comma == std::string_view::npos)
+            {
+                break;
+            }
+            start = comma + 1;
+            column++;
+        }
+        return;
+    }
+    if (kind != "_result")
+    {
+        return;
+    }
+
+    InfluxDBCommandRow row;
+    // A row cut off by the carry limit keeps its timestamp if that came before the cut; the
+    // payload, being the long part, is what gets lost.
+    if (!haveTime || !(haveValue || truncated) || (truncated && valueColumn < timeColumn) ||
+        !ParseIso8601Ms(time, row.timestamp_ms))
+    {
+        rejectedRowCount++;
+        return;
+    }
+    row.payload = value;
+    row.payloadTooLong = truncated;
+    rowCount++;
+    if (!handler(row, context))
+    {
+        stopped = true;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef INFLUXDB_STREAM_PARSER_H
+#define INFLUXDB_STREAM_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "DataModel.h"
+
+// Longest row kept whole when it straddles two chunks: a full-size base64 command plus the
+// result, table and time columns ahead of it.
+constexpr size_t INFLUXDB_STREAM_LINE_BYTES = CMD_BASE64_MAX_LEN + 128;
+
+// One command row. payload points into the chunk being fed or the parser's carry buffer and is
+// only valid during the callback. A row longer than INFLUXDB_STREAM_LINE_BYTES still reports its
+// timestamp, with payloadTooLong set and the payload cut short.
+struct InfluxDBCommandRow
+{
+    int64_t timestamp_ms = 0;
+    std::string_view payload;
+    bool payloadTooLong = false;
+};
+
+// Parse an InfluxDB CSV response as it arrives, without buffering the body or touching the heap.
+// Rows that fall within one chunk are parsed in place; only a row split across chunks is copied,
+// into a fixed carry buffer, until its newline arrives. The _time and _value columns come from
+// the header row, as in parse_influxdb_command_list.
+//
+// Each complete row goes to the handler. A handler returning false stops the parser: the rest
+// of the response is ignored until Reset, so rows after a refused one are fetched again on the
+// next poll rather than delivered out of order.
+class InfluxDBStreamParser
+{
+  public:
+    using RowHandler = bool (*)(const InfluxDBCommandRow &row, void *context);
+
+    InfluxDBStreamParser(RowHandler handler, void *context);
+
+    // Forget any partial row and header ready for a new response.
+    void Reset();
+
+    // Consume the next chunk of the body. Returns false once the handler has stopped the parser.
+    bool Feed(const char *data, size_t length);
+
+    // End of the response. A row still waiting for its newline was cut short and is dropped.
+    void Finish();
+
+    size_t GetRowCount() const { return rowCount; }
+    size_t GetRejectedRowCount() const { return rejectedRowCount; }
+    bool IsStopped() const { return stopped; }
+
+  private:
+    void ConsumeLine(std::string_view line, bool truncated);
+
+    RowHandler handler;
+    void *context;
+    char carry[INFLUXDB_STREAM_LINE_BYTES];
+    size_t carryLength = 0;
+    bool carryTruncated = false;
+    size_t timeColumn = 5;
+    size_t valueColumn = 6;
+    size_t rowCount = 0;
+    size_t rejectedRowCount = 0;
+    bool stopped = false;
+};
+
+// Parse "YYYY-MM-DDTHH:MM:SS[.fff...][Z]" as UTC milliseconds from fixed positions, without
+// strptime or the C library's time zone handling. Digits past milliseconds are ignored.
+bool ParseIso8601Ms(std::string_view text, int64_t &out_ms);
+
+#endif // INFLUXDB_STREAM_PARSER_H
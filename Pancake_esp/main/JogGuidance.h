@@ -14,20 +14,55 @@ struct JogConfig
 class JogGuidance : public GeneralGuidance
 {
   public:
-    JogGuidance() : Config{} {}
+    JogGuidance() : Config{}, remaining_m(0.0f), heading{0.0f, 0.0f} {}
 
     uint8_t GetOpCode() const override { return CNC_JOG_OPCODE; }
     const void *GetConfig() const override { return &Config; }
     size_t GetConfigLength() const override { return sizeof(Config); }
 
-    void ApplyConfig(const JogConfig &cfg) { Config = cfg; }
+    void ApplyConfig(const JogConfig &cfg)
+    {
+        Config = cfg;
+        Profile.Reset(cfg.MaxLinearSpeed_mps);
+        remaining_m = 0.0f;
+        heading = Vector2D(0.0f, 0.0f);
+    }
+
+    SegmentSpeedProfile *GetSpeedProfile() override { return &Profile; }
+    float GetRemainingPathLength_m() const override { return remaining_m; }
+
+    bool GetPathPointAhead(Vector2D CurPos_m, float Distance_m, Vector2D &Point_m) const override
+    {
+        Vector2D delta = Vector2D(Config.TargetX_m, Config.TargetY_m) - CurPos_m;
+        float dist = delta.magnitude();
+        if (dist <= 1e-3f || Distance_m > dist)
+        {
+            return false;
+        }
+        Point_m = CurPos_m + delta * (Distance_m / dist);
+        return true;
+    }
+
+    void SetPathSpeedLimit(float Limit_mps) override { Profile.speedLimit_mps = Limit_mps; }
 
     bool GetTargetPosition(unsigned int DeltaTime_ms, Vector2D CurPos_m, Vector2D &CmdPos_m,
                            bool &CmdViaAngle, float &S0Speed_degps, float &S1Speed_degps) override
+    {
+        GuidanceSetpoint setpoint;
+        bool done = GetTargetSetpoint(DeltaTime_ms, CurPos_m, setpoint, CmdViaAngle, S0Speed_degps,
+                                      S1Speed_degps);
+        CmdPos_m = setpoint.position_m;
+        return done;
+    }
+
+    bool GetTargetSetpoint(unsigned int DeltaTime_ms, Vector2D CurPos_m, GuidanceSetpoint &Setpoint,
+                           bool &CmdViaAngle, float &S0Speed_degps, float &S1Speed_degps) override
     {
         (void)S0Speed_degps;
         (void)S1Speed_degps;
         CmdViaAngle = false;
+        Setpoint = GuidanceSetpoint{};
+        Setpoint.hasVelocity = true;
 
         // Move towards target with capped linear speed
         Vector2D target{Config.TargetX_m, Config.TargetY_m};
@@ -35,23 +70,37 @@ class JogGuidance : public GeneralGuidance
         float dist = delta.magnitude();
         if (dist <= 1e-3f)
         {
-            CmdPos_m = target;
+            // Only a segment that blends into the next one is still moving at its end.
+            Setpoint.position_m = target;
+            Setpoint.velocity_mps = heading * Profile.exitSpeed_mps;
+            remaining_m = 0.0f;
             return true;
         }
 
-        float maxStep = Config.MaxLinearSpeed_mps * (DeltaTime_ms * C_MSToS);
+        heading = delta * (1.0f / dist);
+
+        float maxStep = Profile.Step(dist, DeltaTime_ms * C_MSToS);
         if (maxStep <= 0.0f || maxStep >= dist)
         {
-            CmdPos_m = target;
+            Setpoint.position_m = target;
+            Setpoint.velocity_mps = heading * Profile.exitSpeed_mps;
+            remaining_m = 0.0f;
             return (dist <= 1e-3f);
         }
 
         Vector2D step = delta * (maxStep / dist);
-        CmdPos_m = CurPos_m + step;
+        Setpoint.position_m = CurPos_m + step;
+        Setpoint.velocity_mps = heading * Profile.currentSpeed_mps;
+        remaining_m = dist - maxStep;
         return false;
     }
 
     JogConfig Config;
+    SegmentSpeedProfile Profile;
+
+  private:
+    float remaining_m;
+    Vector2D heading; // unit direction of travel
 };
 
 #endif // JOG_GUIDANCE_H
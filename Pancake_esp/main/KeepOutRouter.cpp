@@ -0,0 +1,52 @@
+#include "KeepOutRouter.h"
+
+#include <cmath>
+
+KeepOutRouter::KeepOutRouter(const AngleMotion::AngleMoveLimitsDeg &s0Limits,
+                             const AngleMotion::AngleMoveLimitsDeg &s1Limits)
+    : s0Limits(s0Limits), s1Limits(s1Limits)
+{
+}
+
+bool KeepOutRouter::MoveClear(float fromS0_deg, float fromS1_deg, float toS0_deg,
+                              float toS1_deg) const
+{
+    bool s0Blocked = false;
+    bool s1Blocked = false;
+    AngleMotion::SelectDeltaWithinLimitsDeg(fromS0_deg, toS0_deg, s0Limits, s0Blocked);
+    AngleMotion::SelectDeltaWithinLimitsDeg(fromS1_deg, toS1_deg, s1Limits, s1Blocked);
+    return !s0Blocked && !s1Blocked;
+}
+
+JointRoute KeepOutRouter::Route(float currentS0_deg, float currentS1_deg, float goalS0_deg,
+                                float goalS1_deg) const
+{
+    JointRoute route;
+    route.s0Target_deg = goalS0_deg;
+    route.s1Target_deg = goalS1_deg;
+    if (MoveClear(currentS0_deg, currentS1_deg, goalS0_deg, goalS1_deg))
+    {
+        route.kind = JointRouteKind::Direct;
+        return route;
+    }
+
+    Vector2D tip_m;
+    AngToCart(goalS0_deg, goalS1_deg, tip_m);
+    float s0_deg[2];
+    float s1_deg[2];
+    if (CartToAngBothBranches(s0_deg, s1_deg, tip_m) != E_OK)
+    {
+        return route;
+    }
+
+    // With the arm straight both branches are the same pose, so there is nothing to mirror to.
+    const int mirrored = 1 - static_cast<int>(GetElbowBranch(goalS1_deg));
+    if (fabsf(s1_deg[mirrored]) > 1.0e-3f &&
+        MoveClear(currentS0_deg, currentS1_deg, s0_deg[mirrored], s1_deg[mirrored]))
+    {
+        route.kind = JointRouteKind::MirroredElbow;
+        route.s0Target_deg = s0_deg[mirrored];
+        route.s1Target_deg = s1_deg[mirrored];
+    }
+    return route;
+}
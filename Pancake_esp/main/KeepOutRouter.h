@@ -0,0 +1,45 @@
+#ifndef KEEP_OUT_ROUTER_H
+#define KEEP_OUT_ROUTER_H
+
+#include "AngleMotion.h"
+#include "PanMath.h"
+
+// Finds a legal joint-space route to a goal pose that a direct move cannot reach. Each joint
+// already picks whichever way round keeps it out of its own limits (SelectDeltaWithinLimitsDeg),
+// and the limits are per joint, so a direct move is only blocked when the goal pose itself lies
+// in a limit, e.g. an S0 angle inside the keep-out zone. The tip can still get there: the
+// mirrored elbow pose reaches the same point with a different S0, and often clears the zone.
+enum class JointRouteKind
+{
+    Direct,
+    MirroredElbow,
+    Blocked,
+};
+
+struct JointRoute
+{
+    JointRouteKind kind = JointRouteKind::Blocked;
+    float s0Target_deg = 0.0f;
+    float s1Target_deg = 0.0f;
+};
+
+class KeepOutRouter
+{
+  public:
+    KeepOutRouter(const AngleMotion::AngleMoveLimitsDeg &s0Limits,
+                  const AngleMotion::AngleMoveLimitsDeg &s1Limits);
+
+    // Joint target to command instead of (goalS0, goalS1): the goal itself when both joints can
+    // reach it, otherwise the mirrored elbow pose at the same tip if that one is clear. Blocked
+    // when neither is, leaving the targets at the goal.
+    JointRoute Route(float currentS0_deg, float currentS1_deg, float goalS0_deg,
+                     float goalS1_deg) const;
+
+  private:
+    bool MoveClear(float fromS0_deg, float fromS1_deg, float toS0_deg, float toS1_deg) const;
+
+    AngleMotion::AngleMoveLimitsDeg s0Limits;
+    AngleMotion::AngleMoveLimitsDeg s1Limits;
+};
+
+#endif // KEEP_OUT_ROUTER_H
@@ -0,0 +1,208 @@
+#include "LineProtocolWriter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+// Digits of value, at least minDigits with leading zeros. Everything here divides in 32 bits:
+// 64-bit division is a library call on the ESP32.
+size_t FormatUint32(char *out, uint32_t value, size_t minDigits)
+{
+    char digits[10];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count < minDigits)
+    {
+        digits[count++] = '0';
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = digits[count - 1 - i];
+    }
+    return count;
+}
+
+// value / 100000, with value % 100000 in remainder, in 32-bit divisions: 100000 = 2^5 * 3125, and
+// 3125 is small enough to divide value >> 5 a 16-bit piece at a time.
+uint64_t DivMod100000(uint64_t value, uint32_t &remainder)
+{
+    constexpr uint32_t kDivisor = 3125;
+    const uint64_t shifted = value >> 5;
+    const uint32_t high = static_cast<uint32_t>(shifted >> 32);
+    const uint32_t low = static_cast<uint32_t>(shifted);
+
+    const uint32_t quotientHigh = high / kDivisor;
+    uint32_t piece = ((high % kDivisor) << 16) | (low >> 16);
+    const uint32_t quotientMid = piece / kDivisor;
+    piece = ((piece % kDivisor) << 16) | (low & 0xFFFF);
+    const uint32_t quotientLow = piece / kDivisor;
+
+    remainder = (piece % kDivisor) * 32 + (static_cast<uint32_t>(value) & 31);
+    return (static_cast<uint64_t>(quotientHigh) << 32) | (quotientMid << 16) | quotientLow;
+}
+
+size_t FormatUint64(char *out, uint64_t value)
+{
+    if (value <= UINT32_MAX)
+    {
+        return FormatUint32(out, static_cast<uint32_t>(value), 1);
+    }
+    // Millisecond timestamps take one split into 5-digit pieces; only the largest values need more.
+    uint32_t low = 0;
+    const uint64_t high = DivMod100000(value, low);
+    size_t length = FormatUint64(out, high);
+    return length + FormatUint32(out + length, low, 5);
+}
+} // namespace
+
+size_t FormatFixed5(char *out, float value)
+{
+    // Also false for nan.
+    if (!(std::fabs(value) < 1e13f))
+    {
+        char text[FORMAT_FIXED5_MAX_CHARS + 1];
+        int written = snprintf(text, sizeof(text), "%.5f", value);
+        size_t length = (written > 0) ? static_cast<size_t>(written) : 0;
+        if (length > FORMAT_FIXED5_MAX_CHARS)
+        {
+            length = FORMAT_FIXED5_MAX_CHARS;
+        }
+        if (memchr(text, '.', length) != nullptr)
+        {
+            while (text[length - 1] == '0')
+            {
+                length--;
+            }
+            if (text[length - 1] == '.')
+            {
+                length--;
+            }
+        }
+        memcpy(out, text, length);
+        return length;
+    }
+
+    // Exact: a float has 24 significant bits and 10^5 = 3125 * 2^5 adds 12, well inside a double.
+    // rint rounds ties to even, as printf does with the exact binary value.
+    const uint64_t scaled = static_cast<uint64_t>(std::rint(std::fabs(static_cast<double>(value)) * 100000.0));
+    size_t length = 0;
+    if (std::signbit(value))
+    {
+        out[length++] = '-';
+    }
+    uint32_t fraction = 0;
+    const uint64_t whole = DivMod100000(scaled, fraction);
+    length += FormatUint64(out + length, whole);
+    if (fraction != 0)
+    {
+        size_t digits = 5;
+        while (fraction % 10 == 0)
+        {
+            fraction /= 10;
+            digits--;
+        }
+        out[length++] = '.';
+        length += FormatUint32(out + length, fraction, digits);
+    }
+    return length;
+}
+
+size_t FormatInt64(char *out, int64_t value)
+{
+    if (value < 0)
+    {
+        out[0] = '-';
+        // Negating in unsigned arithmetic keeps INT64_MIN in range.
+        return 1 + FormatUint64(out + 1, 0 - static_cast<uint64_t>(value));
+    }
+    return FormatUint64(out, static_cast<uint64_t>(value));
+}
+
+LineProtocolWriter::LineProtocolWriter(char *out, size_t capacity) : out(out), capacity(capacity), ok(capacity > 0)
+{
+    Terminate();
+}
+
+bool LineProtocolWriter::Reserve(size_t count)
+{
+    if (ok && count >= capacity - used)
+    {
+        ok = false;
+    }
+    return ok;
+}
+
+void LineProtocolWriter::Terminate()
+{
+    if (ok)
+    {
+        out[used] = '\0';
+    }
+}
+
+void LineProtocolWriter::Append(const char *text)
+{
+    size_t length = strlen(text);
+    if (Reserve(length))
+    {
+        memcpy(out + used, text, length);
+        used += length;
+        Terminate();
+    }
+}
+
+void LineProtocolWriter::Append(char c)
+{
+    if (Reserve(1))
+    {
+        out[used++] = c;
+        Terminate();
+    }
+}
+
+void LineProtocolWriter::AppendFixed5(float value)
+{
+    char text[FORMAT_FIXED5_MAX_CHARS];
+    size_t length = FormatFixed5(text, value);
+    if (Reserve(length))
+    {
+        memcpy(out + used, text, length);
+        used += length;
+        Terminate();
+    }
+}
+
+void LineProtocolWriter::AppendInt64(int64_t value)
+{
+    char text[FORMAT_INT64_MAX_CHARS];
+    size_t length = FormatInt64(text, value);
+    if (Reserve(length))
+    {
+        memcpy(out + used, text, length);
+        used += length;
+        Terminate();
+    }
+}
+
+void LineProtocolWriter::AppendEscaped(const char *text)
+{
+    for (; *text != '\0' && ok; text++)
+    {
+        char c = *text;
+        if (c == '\r' || c == '\n')
+        {
+            c = ' ';
+        }
+        if (c == '"' || c == '\\')
+        {
+            Append('\\');
+        }
+        Append(c);
+    }
+}
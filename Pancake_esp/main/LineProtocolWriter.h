@@ -0,0 +1,51 @@
+#ifndef LINE_PROTOCOL_WRITER_H
+#define LINE_PROTOCOL_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Longest text FormatFixed5 or FormatInt64 writes.
+constexpr size_t FORMAT_FIXED5_MAX_CHARS = 48;
+constexpr size_t FORMAT_INT64_MAX_CHARS = 20;
+
+// value as snprintf "%.5f" prints it, less trailing zeros and then the point ("0.5", "3", "-0").
+// A float times 10^5 is exact in a double, so rounding that to an integer gives the same digits
+// as printf's correctly rounded conversion without going through newlib's dtoa, which is slow and
+// stack-hungry on the ESP32. Values of 1e13 and over, inf and nan still go through snprintf.
+// Writes no terminator; returns the length.
+size_t FormatFixed5(char *out, float value);
+
+// Decimal value, as "%lld". Writes no terminator; returns the length.
+size_t FormatInt64(char *out, int64_t value);
+
+// Appends InfluxDB line protocol straight into a caller's buffer, in place of snprintf calls on a
+// scratch line. Once something does not fit the writer stops writing and Ok() turns false; the
+// caller commits Length() only when Ok(), so a line is kept whole or not at all. The text is kept
+// terminated while there is room, as snprintf would.
+class LineProtocolWriter
+{
+  public:
+    LineProtocolWriter(char *out, size_t capacity);
+
+    void Append(const char *text);
+    void Append(char c);
+    void AppendFixed5(float value);
+    void AppendInt64(int64_t value);
+    // A string field value's contents: '"' and '\\' escaped, line breaks turned into spaces.
+    void AppendEscaped(const char *text);
+
+    bool Ok() const { return ok; }
+    size_t Length() const { return used; }
+
+  private:
+    // Room for count more characters and the terminator.
+    bool Reserve(size_t count);
+    void Terminate();
+
+    char *out;
+    size_t capacity;
+    size_t used = 0;
+    bool ok;
+};
+
+#endif // LINE_PROTOCOL_WRITER_H
@@ -0,0 +1,237 @@
+#include "MotionLookahead.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "ArcGuidance.h"
+#include "CNCOpCodes.h"
+#include "JogGuidance.h"
+#include "PanMath.h"
+
+namespace
+{
+// Cosine of the junction angle beyond which two segments are treated as collinear or reversed.
+constexpr float COLLINEAR_COS_LIMIT = 0.9999f;
+
+float MinFloat(float lhs, float rhs) { return (lhs < rhs) ? lhs : rhs; }
+
+// Arc guidance measures theta from +Y towards +X.
+Vector2D ArcPoint(Vector2D center_m, float radius_m, float theta_rad)
+{
+    return center_m + Vector2D(sinf(theta_rad), cosf(theta_rad)) * radius_m;
+}
+
+Vector2D ArcTangent(float theta_rad, int dir)
+{
+    return Vector2D(cosf(theta_rad), -sinf(theta_rad)) * static_cast<float>(dir);
+}
+
+bool DescribeJog(const JogConfig &config, Vector2D start_m, Vector2D localOrigin_m,
+                 LookaheadSegment &segment)
+{
+    Vector2D end_m(config.TargetX_m + localOrigin_m.x, config.TargetY_m + localOrigin_m.y);
+    Vector2D delta = end_m - start_m;
+    float length_m = delta.magnitude();
+    if (!std::isfinite(length_m) || length_m <= 1.0e-6f || !(config.MaxLinearSpeed_mps > 0.0f))
+    {
+        return false;
+    }
+
+    segment = LookaheadSegment{};
+    segment.start_m = start_m;
+    segment.end_m = end_m;
+    segment.startDirection = delta / length_m;
+    segment.endDirection = segment.startDirection;
+    segment.length_m = length_m;
+    segment.cruiseSpeed_mps = config.MaxLinearSpeed_mps;
+    segment.pumpOn = config.PumpOn != 0;
+    return true;
+}
+
+bool DescribeArc(const ArcConfig &config, Vector2D localOrigin_m, LookaheadSegment &segment)
+{
+    float sweep_rad = fabsf(config.EndTheta_rad - config.StartTheta_rad);
+    float length_m = sweep_rad * config.Radius_m;
+    if (!(config.Radius_m > 0.0f) || !(config.LinearSpeed_mps > 0.0f) ||
+        !std::isfinite(length_m) || length_m <= 1.0e-6f)
+    {
+        return false;
+    }
+
+    int dir = (config.EndTheta_rad >= config.StartTheta_rad) ? 1 : -1;
+    Vector2D center_m(config.CenterX_m + localOrigin_m.x, config.CenterY_m + localOrigin_m.y);
+
+    segment = LookaheadSegment{};
+    segment.start_m = ArcPoint(center_m, config.Radius_m, config.StartTheta_rad);
+    segment.end_m = ArcPoint(center_m, config.Radius_m, config.EndTheta_rad);
+    segment.startDirection = ArcTangent(config.StartTheta_rad, dir);
+    segment.endDirection = ArcTangent(config.EndTheta_rad, dir);
+    segment.length_m = length_m;
+    segment.cruiseSpeed_mps = config.LinearSpeed_mps;
+    segment.pumpOn = true;
+    return true;
+}
+
+float SegmentAccelLimit_mps2(const LookaheadSegment &segment, const LookaheadLimits &limits)
+{
+    float startAccel_mps2 =
+        ComputeDirectionalAccelLimit_mps2(segment.start_m, segment.startDirection, limits);
+    float endAccel_mps2 = ComputeDirectionalAccelLimit_mps2(segment.end_m, segment.endDirection, limits);
+    return MinFloat(startAccel_mps2, endAccel_mps2);
+}
+} // namespace
+
+bool IsLookaheadOpcode(uint8_t opcode)
+{
+    return opcode == CNC_JOG_OPCODE || opcode == CNC_ARC_OPCODE;
+}
+
+bool DescribeLookaheadSegment(uint8_t opcode, const uint8_t *payload, size_t payloadLength,
+                              Vector2D start_m, Vector2D localOrigin_m,
+                              LookaheadSegment &segment)
+{
+    if (payload == nullptr)
+    {
+        return false;
+    }
+
+    if (opcode == CNC_JOG_OPCODE && payloadLength == sizeof(JogConfig))
+    {
+        JogConfig config{};
+        memcpy(&config, payload, sizeof(config));
+        return DescribeJog(config, start_m, localOrigin_m, segment);
+    }
+
+    if (opcode == CNC_ARC_OPCODE && payloadLength == sizeof(ArcConfig))
+    {
+        ArcConfig config{};
+        memcpy(&config, payload, sizeof(config));
+        return DescribeArc(config, localOrigin_m, segment);
+    }
+
+    return false;
+}
+
+float ComputeDirectionalAccelLimit_mps2(Vector2D position_m, Vector2D direction,
+                                        const LookaheadLimits &limits)
+{
+    float branchS0_deg[2];
+    float branchS1_deg[2];
+    if (CartToAngBothBranches(branchS0_deg, branchS1_deg, position_m) != E_OK)
+    {
+        return 0.0f;
+    }
+    float s0_deg = branchS0_deg[static_cast<int>(limits.elbow)];
+    float s1_deg = branchS1_deg[static_cast<int>(limits.elbow)];
+
+    // Joint acceleration needed per 1 m/s^2 of tip acceleration along `direction`.
+    float s0PerUnit_degps2 = 0.0f;
+    float s1PerUnit_degps2 = 0.0f;
+    if (!CartRateToAngRate(s0_deg, s1_deg, direction, s0PerUnit_degps2, s1PerUnit_degps2))
+    {
+        return 0.0f;
+    }
+
+    float accel_mps2 = INFINITY;
+    float s0Limit_degps2 = limits.s0Accel_degps2 * limits.accelScale;
+    float s1Limit_degps2 = limits.s1Accel_degps2 * limits.accelScale;
+    if (fabsf(s0PerUnit_degps2) > 1.0e-6f)
+    {
+        accel_mps2 = MinFloat(accel_mps2, s0Limit_degps2 / fabsf(s0PerUnit_degps2));
+    }
+    if (fabsf(s1PerUnit_degps2) > 1.0e-6f)
+    {
+        accel_mps2 = MinFloat(accel_mps2, s1Limit_degps2 / fabsf(s1PerUnit_degps2));
+    }
+
+    if (!std::isfinite(accel_mps2) || accel_mps2 < 0.0f)
+    {
+        return 0.0f;
+    }
+    return accel_mps2;
+}
+
+float ComputeJunctionSpeed_mps(const LookaheadSegment &previous, const LookaheadSegment &next,
+                               const LookaheadLimits &limits)
+{
+    if (previous.length_m <= 0.0f || next.length_m <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    // Switching the pump mid-motion smears batter, so the arm settles first.
+    if (previous.pumpOn != next.pumpOn)
+    {
+        return 0.0f;
+    }
+
+    if ((next.start_m - previous.end_m).magnitude() > limits.maxJoinGap_m)
+    {
+        return 0.0f;
+    }
+
+    float speedCap_mps = MinFloat(previous.cruiseSpeed_mps, next.cruiseSpeed_mps);
+    float cosTurn = dot(previous.endDirection, next.startDirection);
+    if (cosTurn >= COLLINEAR_COS_LIMIT)
+    {
+        return speedCap_mps;
+    }
+    if (cosTurn <= -COLLINEAR_COS_LIMIT)
+    {
+        return 0.0f;
+    }
+
+    // Treat the corner as a circular arc that stays within junctionDeviation_m of the sharp
+    // corner, and take the speed whose centripetal acceleration the joints can deliver in the
+    // direction the velocity has to change.
+    float sinHalfAngle = sqrtf(0.5f * (1.0f + cosTurn));
+    float radius_m = limits.junctionDeviation_m * sinHalfAngle / (1.0f - sinHalfAngle);
+
+    Vector2D turn = next.startDirection - previous.endDirection;
+    float turnMagnitude = turn.magnitude();
+    if (turnMagnitude <= 0.0f)
+    {
+        return speedCap_mps;
+    }
+    float accel_mps2 =
+        ComputeDirectionalAccelLimit_mps2(previous.end_m, turn / turnMagnitude, limits);
+
+    return MinFloat(sqrtf(accel_mps2 * radius_m), speedCap_mps);
+}
+
+void PlanLookaheadSpeeds(LookaheadSegment *segments, size_t count, float entrySpeed_mps,
+                         const LookaheadLimits &limits)
+{
+    if (segments == nullptr || count == 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        segments[i].accel_mps2 = SegmentAccelLimit_mps2(segments[i], limits);
+        segments[i].exitSpeed_mps = 0.0f;
+    }
+
+    // Backward pass: every exit must be a speed the following segments can still brake from.
+    for (size_t i = count - 1; i-- > 0;)
+    {
+        const LookaheadSegment &next = segments[i + 1];
+        float brakeLimited_mps = sqrtf(next.exitSpeed_mps * next.exitSpeed_mps +
+                                       2.0f * next.accel_mps2 * next.length_m);
+        segments[i].exitSpeed_mps =
+            MinFloat(ComputeJunctionSpeed_mps(segments[i], next, limits), brakeLimited_mps);
+    }
+
+    // Forward pass: every exit must be reachable from the segment's entry speed.
+    float entry_mps = (entrySpeed_mps > 0.0f) ? entrySpeed_mps : 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        LookaheadSegment &segment = segments[i];
+        segment.entrySpeed_mps = entry_mps;
+        float accelLimited_mps =
+            sqrtf(entry_mps * entry_mps + 2.0f * segment.accel_mps2 * segment.length_m);
+        segment.exitSpeed_mps = MinFloat(segment.exitSpeed_mps, accelLimited_mps);
+        entry_mps = segment.exitSpeed_mps;
+    }
+}
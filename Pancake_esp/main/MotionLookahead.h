@@ -0,0 +1,65 @@
+#ifndef MOTION_LOOKAHEAD_H
+#define MOTION_LOOKAHEAD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "PanMath.h"
+#include "Vector2D.h"
+
+// Number of queued jog/arc commands the router holds back for planning.
+constexpr size_t MOTION_LOOKAHEAD_WINDOW = 8;
+
+struct LookaheadLimits
+{
+    float s0Accel_degps2 = 0.0f;
+    float s1Accel_degps2 = 0.0f;
+    float accelScale = 1.0f;
+    // Allowed deviation from the sharp corner when rounding a junction (GRBL-style).
+    float junctionDeviation_m = 0.0005f;
+    // Segments whose end and start are further apart than this always stop between them.
+    float maxJoinGap_m = 0.001f;
+    // Branch the arm runs the path in; the joint rates for a tip acceleration differ between them.
+    ElbowBranch elbow = ElbowBranch::Negative;
+};
+
+struct LookaheadSegment
+{
+    Vector2D start_m;
+    Vector2D end_m;
+    Vector2D startDirection; // unit tangent of travel at start_m
+    Vector2D endDirection;   // unit tangent of travel at end_m
+    float length_m = 0.0f;
+    float cruiseSpeed_mps = 0.0f;
+    bool pumpOn = false;
+
+    // Filled in by PlanLookaheadSpeeds.
+    float accel_mps2 = 0.0f;
+    float entrySpeed_mps = 0.0f;
+    float exitSpeed_mps = 0.0f;
+};
+
+bool IsLookaheadOpcode(uint8_t opcode);
+
+// Describe a jog/arc payload as a path segment. localOrigin_m is added to the payload coordinates
+// the same way the motor loop does when it loads the instruction. Returns false for opcodes that
+// are not blendable, malformed payloads, and degenerate (zero length or zero speed) segments.
+bool DescribeLookaheadSegment(uint8_t opcode, const uint8_t *payload, size_t payloadLength,
+                              Vector2D start_m, Vector2D localOrigin_m,
+                              LookaheadSegment &segment);
+
+// Largest Cartesian acceleration along `direction` at `position_m` that keeps both joints within
+// their scaled accel limits. Returns 0 if the position is unreachable or singular.
+float ComputeDirectionalAccelLimit_mps2(Vector2D position_m, Vector2D direction,
+                                        const LookaheadLimits &limits);
+
+// Speed at which `next` may be entered straight from `previous` without stopping.
+float ComputeJunctionSpeed_mps(const LookaheadSegment &previous, const LookaheadSegment &next,
+                               const LookaheadLimits &limits);
+
+// Forward/backward pass over a chain of segments. The first segment starts at entrySpeed_mps and
+// the last one always ends at rest, since nothing is known about what follows the window.
+void PlanLookaheadSpeeds(LookaheadSegment *segments, size_t count, float entrySpeed_mps,
+                         const LookaheadLimits &limits);
+
+#endif // MOTION_LOOKAHEAD_H
@@ -2,33 +2,62 @@
 #define MOTOR_COMMAND_ROUTER_H
 
 #include "CNCOpCodes.h"
-#include "CommandHandler.h"
+#include "CommandSlab.h"
+#include "DataModel.h"
 #include "MotorControlState.h"
+#include "MotionLookahead.h"
 #include "MotionSafety.h"
 #include "StepperMotor.h"
 
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
 #include <inttypes.h>
 #include <cstring>
 
 class MotorCommandRouter
 {
   public:
-    MotorCommandRouter(QueueHandle_t nowQueue, QueueHandle_t cncQueue, const char *logTag)
-        : nowQueue(nowQueue), cncQueue(cncQueue), logTag(logTag)
+    // cncQueue carries cmd_handle_t records in `slab`; the router owns each record from the
+    // moment it takes the handle off the queue.
+    MotorCommandRouter(QueueHandle_t nowQueue, QueueHandle_t cncQueue, CommandSlab &slab,
+                       const char *logTag)
+        : nowQueue(nowQueue), cncQueue(cncQueue), slab(slab), logTag(logTag)
     {
     }
 
     int DrainCncCommandQueue()
     {
-        decoded_cmd_payload_t tmp;
-        int drained = 0;
-        while (xQueueReceive(cncQueue, &tmp, 0) == pdTRUE)
+        int drained = static_cast<int>(lookaheadCount);
+        for (size_t i = 0; i < lookaheadCount; i++)
+        {
+            slab.Release(PeekLookahead(i).handle);
+        }
+        lookaheadHead = 0;
+        lookaheadCount = 0;
+
+        cmd_handle_t handle;
+        while (xQueueReceive(cncQueue, &handle, 0) == pdTRUE)
         {
+            slab.Release(handle);
             drained++;
         }
+        clearCount++;
         return drained;
     }
 
+    // Times the queue has been cleared by a stop, so a feeder can tell its instructions are gone.
+    uint32_t GetClearCount() const { return clearCount; }
+
+    // Hand a command taken with ReceiveNextMotionCommand back to the slab once it has been
+    // dispatched. Its payload must not be used afterwards.
+    void ReleaseCommand(DecodedCommand &command)
+    {
+        slab.Release(command.handle);
+        command = DecodedCommand();
+    }
+
     void ConsumeImmediateCommands(MotorControlState &state, Vector2D currentPosition_m,
                                   float currentS0_deg, float currentS1_deg)
     {
@@ -61,45 +90,95 @@ class MotorCommandRouter
     void ConsumePendingConfigurationCommands(MotorControlConfig &config, StepperMotor &s0Motor, StepperMotor &s1Motor,
                                              StepperMotor &pumpMotor)
     {
-        decoded_cmd_payload_t peeked{};
-        while (xQueuePeek(cncQueue, &peeked, 0) == pdTRUE)
+        // Anything still in the queue was sent after the held-back window, so it has to wait.
+        if (lookaheadCount > 0)
         {
-            if (peeked.opcode == CNC_CONFIG_MOTOR_LIMITS_OPCODE)
+            return;
+        }
+
+        DecodedCommand cfg;
+        while (PeekQueuedCommand(cfg))
+        {
+            if (cfg.opcode == CNC_CONFIG_MOTOR_LIMITS_OPCODE)
             {
-                decoded_cmd_payload_t cfg;
-                xQueueReceive(cncQueue, &cfg, 0);
                 ApplyMotorLimits(cfg, s0Motor, s1Motor, pumpMotor);
             }
-            else if (peeked.opcode == CNC_CONFIG_PUMP_CONSTANT_OPCODE)
+            else if (cfg.opcode == CNC_CONFIG_PUMP_CONSTANT_OPCODE)
             {
-                decoded_cmd_payload_t cfg;
-                xQueueReceive(cncQueue, &cfg, 0);
                 ApplyPumpConstant(cfg, config);
             }
-            else if (peeked.opcode == CNC_CONFIG_ACCEL_SCALE_OPCODE)
+            else if (cfg.opcode == CNC_CONFIG_ACCEL_SCALE_OPCODE)
             {
-                decoded_cmd_payload_t cfg;
-                xQueueReceive(cncQueue, &cfg, 0);
                 ApplyAccelScale(cfg, config);
             }
             else
             {
                 break;
             }
+            DropQueuedCommand();
         }
     }
 
-    bool ReceiveNextMotionCommand(bool controllerReady, decoded_cmd_payload_t &decoded)
+    // Take the next motion command, read in place from the slab. The caller owns it until it
+    // calls ReleaseCommand.
+    bool ReceiveNextMotionCommand(bool controllerReady, DecodedCommand &decoded)
     {
         if (!controllerReady)
         {
             return false;
         }
 
-        return xQueueReceive(cncQueue, &decoded, 0) == pdTRUE;
+        if (lookaheadCount > 0)
+        {
+            decoded = lookahead[lookaheadHead];
+            lookaheadHead = (lookaheadHead + 1) % MOTION_LOOKAHEAD_WINDOW;
+            lookaheadCount--;
+            return true;
+        }
+
+        if (!PeekQueuedCommand(decoded))
+        {
+            return false;
+        }
+        cmd_handle_t handle;
+        xQueueReceive(cncQueue, &handle, 0);
+        return true;
+    }
+
+    // Move queued jog/arc commands into the look-ahead window so the planner can see past the
+    // active instruction. Filling stops at the first other opcode, which keeps configuration and
+    // mode changes in program order. Returns how many commands were pulled.
+    size_t FillLookaheadWindow()
+    {
+        size_t pulled = 0;
+        while (lookaheadCount < MOTION_LOOKAHEAD_WINDOW)
+        {
+            size_t tail = (lookaheadHead + lookaheadCount) % MOTION_LOOKAHEAD_WINDOW;
+            DecodedCommand &slot = lookahead[tail];
+            if (!PeekQueuedCommand(slot) || !IsLookaheadOpcode(slot.opcode))
+            {
+                break;
+            }
+
+            cmd_handle_t handle;
+            xQueueReceive(cncQueue, &handle, 0);
+            lookaheadCount++;
+            pulled++;
+        }
+        return pulled;
+    }
+
+    size_t GetLookaheadCount() const { return lookaheadCount; }
+
+    // Motion commands still waiting in the CNC queue, not counting the look-ahead window.
+    size_t GetQueuedCount() const { return uxQueueMessagesWaiting(cncQueue); }
+
+    const DecodedCommand &PeekLookahead(size_t index) const
+    {
+        return lookahead[(lookaheadHead + index) % MOTION_LOOKAHEAD_WINDOW];
     }
 
-    bool StartPumpPurgeInstruction(const decoded_cmd_payload_t &cfg, MotorControlState &state,
+    bool StartPumpPurgeInstruction(const DecodedCommand &cfg, MotorControlState &state,
                                    Vector2D currentPosition_m, float currentS0_deg, float currentS1_deg) const
     {
         if (!ValidatePayloadLength(cfg, PUMP_PURGE_PAYLOAD_LEN))
@@ -119,11 +198,39 @@ class MotorCommandRouter
 
   private:
     static constexpr size_t MOTOR_LIMITS_PAYLOAD_LEN = sizeof(uint8_t) + sizeof(float) * 2;
+    // Optional trailing jerk limit; the short form leaves the motor's jerk limit unchanged.
+    static constexpr size_t MOTOR_LIMITS_WITH_JERK_PAYLOAD_LEN = MOTOR_LIMITS_PAYLOAD_LEN + sizeof(float);
     static constexpr size_t PUMP_CONSTANT_PAYLOAD_LEN = sizeof(float);
     static constexpr size_t ACCEL_SCALE_PAYLOAD_LEN = sizeof(float);
     static constexpr size_t PUMP_PURGE_PAYLOAD_LEN = sizeof(float) + sizeof(int32_t);
 
-    bool ValidatePayloadLength(const decoded_cmd_payload_t &cmd, size_t expectedLength) const
+    // View the command at the front of the CNC queue without taking it. A record too short for
+    // its own length byte is dropped here, so every view handed out is well formed.
+    bool PeekQueuedCommand(DecodedCommand &command)
+    {
+        cmd_handle_t handle;
+        while (xQueuePeek(cncQueue, &handle, 0) == pdTRUE)
+        {
+            if (slab.GetDecoded(handle, command))
+            {
+                return true;
+            }
+            ESP_LOGE(logTag, "Dropping malformed command record %u", (unsigned)handle);
+            DropQueuedCommand();
+        }
+        return false;
+    }
+
+    void DropQueuedCommand()
+    {
+        cmd_handle_t handle;
+        if (xQueueReceive(cncQueue, &handle, 0) == pdTRUE)
+        {
+            slab.Release(handle);
+        }
+    }
+
+    bool ValidatePayloadLength(const DecodedCommand &cmd, size_t expectedLength) const
     {
         if (cmd.instruction_length == expectedLength)
         {
@@ -135,10 +242,11 @@ class MotorCommandRouter
         return false;
     }
 
-    void ApplyMotorLimits(const decoded_cmd_payload_t &cfg, StepperMotor &s0Motor,
+    void ApplyMotorLimits(const DecodedCommand &cfg, StepperMotor &s0Motor,
                           StepperMotor &s1Motor, StepperMotor &pumpMotor) const
     {
-        if (!ValidatePayloadLength(cfg, MOTOR_LIMITS_PAYLOAD_LEN))
+        const bool hasJerk = cfg.instruction_length == MOTOR_LIMITS_WITH_JERK_PAYLOAD_LEN;
+        if (!hasJerk && !ValidatePayloadLength(cfg, MOTOR_LIMITS_PAYLOAD_LEN))
         {
             return;
         }
@@ -146,12 +254,21 @@ class MotorCommandRouter
         uint8_t motor_id = cfg.instructions[2];
         float accel = 0.0f;
         float speed = 0.0f;
+        float jerk = 0.0f;
         std::memcpy(&accel, &cfg.instructions[3], sizeof(float));
         std::memcpy(&speed, &cfg.instructions[7], sizeof(float));
+        if (hasJerk)
+        {
+            std::memcpy(&jerk, &cfg.instructions[11], sizeof(float));
+        }
 
         auto apply_limits = [&](StepperMotor &m) {
             m.SetAccelLimit(accel);
             m.SetSpeedLimit(speed);
+            if (hasJerk)
+            {
+                m.SetJerkLimit(jerk);
+            }
         };
         if (motor_id == 0 || motor_id == 255)
         {
@@ -165,10 +282,19 @@ class MotorCommandRouter
         {
             apply_limits(pumpMotor);
         }
-        ESP_LOGI(logTag, "Applied motor limits: id=%u accel=%.3f speed=%.3f", motor_id, accel, speed);
+        if (hasJerk)
+        {
+            ESP_LOGI(logTag, "Applied motor limits: id=%u accel=%.3f speed=%.3f jerk=%.3f", motor_id,
+                     accel, speed, jerk);
+        }
+        else
+        {
+            ESP_LOGI(logTag, "Applied motor limits: id=%u accel=%.3f speed=%.3f", motor_id, accel,
+                     speed);
+        }
     }
 
-    void ApplyPumpConstant(const decoded_cmd_payload_t &cfg, MotorControlConfig &config) const
+    void ApplyPumpConstant(const DecodedCommand &cfg, MotorControlConfig &config) const
     {
         if (!ValidatePayloadLength(cfg, PUMP_CONSTANT_PAYLOAD_LEN))
         {
@@ -179,7 +305,7 @@ class MotorCommandRouter
         ESP_LOGI(logTag, "Applied pumpConstant_degpm=%.3f", config.pumpConstant_degpm);
     }
 
-    void ApplyAccelScale(const decoded_cmd_payload_t &cfg, MotorControlConfig &config) const
+    void ApplyAccelScale(const DecodedCommand &cfg, MotorControlConfig &config) const
     {
         if (!ValidatePayloadLength(cfg, ACCEL_SCALE_PAYLOAD_LEN))
         {
@@ -192,7 +318,14 @@ class MotorCommandRouter
 
     QueueHandle_t nowQueue;
     QueueHandle_t cncQueue;
+    CommandSlab &slab;
     const char *logTag;
+
+    // Views of records the router has taken off the queue but not yet handed out.
+    DecodedCommand lookahead[MOTION_LOOKAHEAD_WINDOW] = {};
+    size_t lookaheadHead = 0;
+    size_t lookaheadCount = 0;
+    uint32_t clearCount = 0;
 };
 
 #endif // MOTOR_COMMAND_ROUTER_H
@@ -0,0 +1,802 @@
+#include "MotorControlLoop.h"
+#include "AngleMotion.h"
+#include "CNCOpCodes.h"
+#include "MotionSafety.h"
+#include "Safety.h"
+#include "esp_timer.h"
+
+#include <cmath>
+#include <cstring>
+
+static const char *TAG = "CNCControl";
+
+static constexpr float DEFAULT_ANGLE_TOLERANCE_DEG = 0.25f;
+// Point spacing for the joint-limited path speed plan; the plan looks this times
+// PATH_SPEED_MAX_POINTS - 1 ahead of the carrot.
+static constexpr float PATH_SPEED_SPACING_M = 0.001f;
+// How far past the carrot a Cartesian path is checked against the keep-out zone, so the elbow
+// flips before the tip reaches it.
+static constexpr float KEEP_OUT_LOOKAHEAD_M = 0.002f;
+static constexpr AngleMotion::KeepOutZoneDeg S0_KEEP_OUT_ZONE_DEG{210.0f, 300.0f};
+static constexpr AngleMotion::TravelBoundsDeg S1_TRAVEL_BOUNDS_DEG{-270.0f, 270.0f};
+static constexpr AngleMotion::AngleMoveLimitsDeg S0_ANGLE_LIMITS_DEG{
+    true, S0_KEEP_OUT_ZONE_DEG, false, {0.0f, 0.0f}};
+static constexpr AngleMotion::AngleMoveLimitsDeg S1_ANGLE_LIMITS_DEG{
+    false, {0.0f, 0.0f}, true, S1_TRAVEL_BOUNDS_DEG};
+
+static HomingConstants MakeHomingConstants()
+{
+    HomingConstants homingConstants;
+    homingConstants.s0LimitAngle_deg = S0_LIMIT_ANGLE_DEG;
+    homingConstants.s1LimitAngle_deg = S1_LIMIT_ANGLE_DEG;
+    homingConstants.s0HomeAngle_deg = GO_HOME_S0_ANGLE_DEG;
+    homingConstants.s1HomeAngle_deg = GO_HOME_S1_ANGLE_DEG;
+    return homingConstants;
+}
+
+static bool ResolveJogPumpEnabled(const GeneralGuidance &guidance)
+{
+    return static_cast<const JogGuidance &>(guidance).Config.PumpOn != 0;
+}
+
+static bool ApplyGoHomeGuidanceConfig(GeneralGuidance &guidance, const uint8_t *payload)
+{
+    (void)payload;
+    GoToAngleConfig config{GO_HOME_S0_ANGLE_DEG, GO_HOME_S1_ANGLE_DEG, DEFAULT_ANGLE_TOLERANCE_DEG};
+    static_cast<GoToAngleGuidance &>(guidance).ApplyConfig(config);
+    return true;
+}
+
+struct LocalOriginConfig
+{
+    float OriginX_m;
+    float OriginY_m;
+};
+
+static void ApplyLocalOriginToCartesianConfig(uint8_t opcode, uint8_t *payload, Vector2D localOrigin_m)
+{
+    if (opcode == CNC_JOG_OPCODE)
+    {
+        JogConfig *config = reinterpret_cast<JogConfig *>(payload);
+        config->TargetX_m += localOrigin_m.x;
+        config->TargetY_m += localOrigin_m.y;
+    }
+    else if (opcode == CNC_ARC_OPCODE)
+    {
+        ArcConfig *config = reinterpret_cast<ArcConfig *>(payload);
+        config->CenterX_m += localOrigin_m.x;
+        config->CenterY_m += localOrigin_m.y;
+    }
+    else if (opcode == CNC_SPIRAL_OPCODE)
+    {
+        SpiralConfig *config = reinterpret_cast<SpiralConfig *>(payload);
+        config->CenterX_m += localOrigin_m.x;
+        config->CenterY_m += localOrigin_m.y;
+    }
+}
+
+static void LogGuidanceLoadError(const GuidanceLoadError &error)
+{
+    if (!error.opcodeKnown)
+    {
+        ESP_LOGE(TAG, "Unknown OpCode: 0x%02X", error.opcode);
+        return;
+    }
+
+    ESP_LOGE(TAG, "Invalid payload length for OpCode 0x%02X: expected %u got %u",
+             error.opcode, (unsigned)error.expectedPayloadLength, (unsigned)error.actualPayloadLength);
+}
+
+static void ApplyStoppedHold(MotorControlState &state, MotorCommandRouter &commandRouter,
+                             Vector2D currentPosition_m, float currentS0_deg, float currentS1_deg,
+                             const char *reason)
+{
+    MotionHoldCommand stopCommand = MakeStoppedHoldCommand(currentPosition_m, currentS0_deg, currentS1_deg);
+    ApplyHoldCommand(state, stopCommand);
+
+    int drained = stopCommand.clearCommandQueue ? commandRouter.DrainCncCommandQueue() : 0;
+    ESP_LOGW(TAG, "%s: cleared %d queued commands", reason, drained);
+}
+
+static bool ApplyLimitStopIfBlocked(MotorControlState &state, MotorCommandRouter &commandRouter,
+                                    Vector2D currentPosition_m, float currentS0_deg,
+                                    float currentS1_deg, float requestedS0_deg,
+                                    float requestedS1_deg,
+                                    const AngleMotion::AngleMovePlan &s0Plan,
+                                    const AngleMotion::AngleMovePlan &s1Plan,
+                                    const char *mode)
+{
+    if (s0Plan.blocked)
+    {
+        ESP_LOGE(TAG, "S0 %s move %.2f -> requested %.2f crosses keep-out %.2f..%.2f deg",
+                 mode, currentS0_deg, requestedS0_deg,
+                 S0_KEEP_OUT_ZONE_DEG.start_deg, S0_KEEP_OUT_ZONE_DEG.end_deg);
+        ApplyStoppedHold(state, commandRouter, currentPosition_m, currentS0_deg, currentS1_deg,
+                         "S0 limit stop");
+        return true;
+    }
+
+    if (s1Plan.blocked)
+    {
+        ESP_LOGE(TAG, "S1 %s move %.2f -> requested %.2f exceeds travel bounds %.2f..%.2f deg",
+                 mode, currentS1_deg, requestedS1_deg,
+                 S1_TRAVEL_BOUNDS_DEG.min_deg, S1_TRAVEL_BOUNDS_DEG.max_deg);
+        ApplyStoppedHold(state, commandRouter, currentPosition_m, currentS0_deg, currentS1_deg,
+                         "S1 limit stop");
+        return true;
+    }
+
+    return false;
+}
+
+MotorControlLoop::MotorControlLoop(StepperMotor &s0Motor, StepperMotor &s1Motor,
+                                   StepperMotor &pumpMotor, QueueHandle_t nowQueue,
+                                   QueueHandle_t cncQueue, CommandSlab &commandSlab,
+                                   const MotorControlConfig &initialConfig)
+    : s0Motor(s0Motor), s1Motor(s1Motor), pumpMotor(pumpMotor), config(initialConfig),
+      commandRouter(nowQueue, cncQueue, commandSlab, TAG), homingController(MakeHomingConstants()),
+      elbowSelector(S0_ANGLE_LIMITS_DEG, S1_ANGLE_LIMITS_DEG),
+      keepOutRouter(S0_ANGLE_LIMITS_DEG, S1_ANGLE_LIMITS_DEG)
+{
+    guidanceRegistry.Register({CNC_SPIRAL_OPCODE, sizeof(SpiralConfig), PumpPolicySource::AlwaysOn, GuidanceCommandMode::Cartesian,
+                               ApplyTypedGuidanceConfig<ArchimedeanSpiral, SpiralConfig>, &spiralGuidance, nullptr});
+    guidanceRegistry.Register({CNC_JOG_OPCODE, sizeof(JogConfig), PumpPolicySource::FromPayload, GuidanceCommandMode::Cartesian,
+                               ApplyTypedGuidanceConfig<JogGuidance, JogConfig>, &jogGuidance, ResolveJogPumpEnabled});
+    guidanceRegistry.Register({CNC_ARC_OPCODE, sizeof(ArcConfig), PumpPolicySource::AlwaysOn, GuidanceCommandMode::Cartesian,
+                               ApplyTypedGuidanceConfig<ArcGuidance, ArcConfig>, &arcGuidance, nullptr});
+    guidanceRegistry.Register({CNC_RECTANGLE_OPCODE, sizeof(RectangleConfig), PumpPolicySource::AlwaysOn, GuidanceCommandMode::Cartesian,
+                               ApplyTypedGuidanceConfig<RectangleGuidance, RectangleConfig>, &rectangleGuidance, nullptr});
+    guidanceRegistry.Register({CNC_GO_TO_ANGLE_OPCODE, sizeof(GoToAngleConfig), PumpPolicySource::AlwaysOff, GuidanceCommandMode::Angle,
+                               ApplyTypedGuidanceConfig<GoToAngleGuidance, GoToAngleConfig>, &goToAngleGuidance, nullptr});
+    guidanceRegistry.Register({CNC_GO_HOME_OPCODE, 0, PumpPolicySource::AlwaysOff, GuidanceCommandMode::Angle,
+                               ApplyGoHomeGuidanceConfig, &goToAngleGuidance, nullptr});
+    guidanceRegistry.Register({CNC_WAIT_OPCODE, sizeof(WaitGuidance::WaitConfig), PumpPolicySource::AlwaysOff, GuidanceCommandMode::Cartesian,
+                               ApplyTypedGuidanceConfig<WaitGuidance, WaitGuidance::WaitConfig>, &waitGuidance, nullptr});
+    guidanceRegistry.Register({CNC_SINE_OPCODE, sizeof(SineGuidance::SineConfig), PumpPolicySource::AlwaysOff, GuidanceCommandMode::Angle,
+                               ApplyTypedGuidanceConfig<SineGuidance, SineGuidance::SineConfig>, &sineGuidance, nullptr});
+    guidanceRegistry.Register({CNC_CONSTANT_SPEED_OPCODE, sizeof(ConstantSpeed::ConstantSpeedConfig), PumpPolicySource::AlwaysOff, GuidanceCommandMode::Angle,
+                               ApplyTypedGuidanceConfig<ConstantSpeed, ConstantSpeed::ConstantSpeedConfig>, &constantSpeed, nullptr});
+
+    RefreshTelemetryAndPosition();
+    state.target_m = state.currentPosition_m;
+}
+
+bool MotorControlLoop::IsIdle() const
+{
+    return state.instructionComplete && !state.pumpPurgeActive && !homingController.IsActive() &&
+           commandRouter.GetLookaheadCount() == 0 && commandRouter.GetQueuedCount() == 0;
+}
+
+void MotorControlLoop::RunCycle(unsigned int elapsed_ms, bool cncEnabled)
+{
+    state.BeginLoop();
+    commandRouter.ConsumeImmediateCommands(state, state.currentPosition_m,
+                                           s0Tlm.Position_deg, s1Tlm.Position_deg);
+    RefreshTelemetryAndPosition();
+
+    float plannedTargetS0_deg = s0Tlm.Position_deg;
+    float plannedTargetS1_deg = s1Tlm.Position_deg;
+    float plannedDeltaS0_deg = 0.0f;
+    float plannedDeltaS1_deg = 0.0f;
+    bool limitBlockedS0 = false;
+    bool limitBlockedS1 = false;
+    GuidanceSetpoint setpoint{};
+
+    if (homingController.IsActive() && (state.pauseActive || state.instructionComplete))
+    {
+        homingController.Cancel();
+        SetLimitSwitchPolicy(true);
+        state.CompleteInstruction();
+        ESP_LOGW(TAG, "Homing cancelled");
+    }
+
+    // Apply any pending configuration commands (non-blocking)
+    if (!state.pauseActive && !homingController.IsActive())
+    {
+        commandRouter.ConsumePendingConfigurationCommands(config, s0Motor, s1Motor, pumpMotor);
+    }
+
+    // Newly visible segments may let the active one finish faster than it was planned to.
+    if (commandRouter.FillLookaheadWindow() > 0 && activeSegmentPlanned &&
+        !state.instructionComplete && state.activeGuidance != nullptr)
+    {
+        PlanActiveSegmentSpeeds(state.activeGuidance->GetRemainingPathLength_m());
+    }
+
+    const bool readyForNextMotionCommand =
+        state.instructionComplete && !state.pauseActive && !homingController.IsActive();
+    const bool blendingIntoNext = readyForNextMotionCommand && state.blendIntoNextInstruction &&
+                                  commandRouter.GetLookaheadCount() > 0;
+    if (readyForNextMotionCommand && !blendingIntoNext)
+    {
+        state.IdleAtCurrentPosition(state.currentPosition_m, s0Tlm.Position_deg, s1Tlm.Position_deg);
+    }
+
+    // If ready for the next instruction, check queue without blocking
+    DecodedCommand decoded;
+    if (commandRouter.ReceiveNextMotionCommand(readyForNextMotionCommand, decoded))
+    {
+        const float entrySpeed_mps = blendingIntoNext ? state.blendSpeed_mps : 0.0f;
+        pathSpeed_mps = entrySpeed_mps;
+        state.ClearBlend();
+        activeSegmentPlanned = false;
+        if (!blendingIntoNext)
+        {
+            elbowSelector.EndPath();
+            reconfiguringElbow = false;
+        }
+        size_t payloadLength = decoded.instruction_length;
+        if (payloadLength > CMD_INSTRUCTION_PAYLOAD_MAX_LEN)
+        {
+            ESP_LOGE(TAG, "Payload too large: %u", (unsigned)payloadLength);
+        }
+        else
+        {
+            uint8_t *payload = decoded.instructions + 2;
+            ESP_LOGI(TAG, "Configuring OpCode: 0x%02X", decoded.opcode);
+
+            if (decoded.opcode == CNC_HOME_OPCODE)
+            {
+                if (payloadLength != 0)
+                {
+                    ESP_LOGE(TAG, "Invalid payload length for OpCode 0x%02X: expected 0 got %u",
+                             decoded.opcode, (unsigned)payloadLength);
+                    state.instructionComplete = true;
+                }
+                else
+                {
+                    homingController.Start();
+                    SetLimitSwitchPolicy(false);
+                    state.StopPurge();
+                    state.instructionComplete = false;
+                    state.activeGuidance = nullptr;
+                    state.pumpThisMode = false;
+                    state.cmdViaAngle = true;
+                    state.pumpSpeed_degps = 0.0f;
+                    ESP_LOGI(TAG, "Starting homing operation");
+                }
+            }
+            else if (decoded.opcode == CNC_SET_LOCAL_ORIGIN_OPCODE)
+            {
+                if (payloadLength != sizeof(LocalOriginConfig))
+                {
+                    ESP_LOGE(TAG, "Invalid payload length for OpCode 0x%02X: expected %u got %u",
+                             decoded.opcode, (unsigned)sizeof(LocalOriginConfig), (unsigned)payloadLength);
+                }
+                else
+                {
+                    LocalOriginConfig originConfig{};
+                    memcpy(&originConfig, payload, sizeof(originConfig));
+                    localOrigin_m = {originConfig.OriginX_m, originConfig.OriginY_m};
+                    ESP_LOGI(TAG, "Local origin set to %.3f, %.3f m", localOrigin_m.x, localOrigin_m.y);
+                }
+                state.instructionComplete = true;
+            }
+            else if (decoded.opcode == CNC_PUMP_PURGE_OPCODE)
+            {
+                if (!commandRouter.StartPumpPurgeInstruction(decoded, state, state.currentPosition_m,
+                                                             s0Tlm.Position_deg,
+                                                             s1Tlm.Position_deg))
+                {
+                    state.instructionComplete = true;
+                }
+            }
+            else
+            {
+                ApplyLocalOriginToCartesianConfig(decoded.opcode, payload, localOrigin_m);
+                GuidanceLoadResult loadResult{};
+                GuidanceLoadError loadError{};
+                bool configApplied = guidanceRegistry.Load(decoded.opcode, payload, payloadLength, loadResult, loadError);
+
+                if (!configApplied || loadResult.guidance == nullptr)
+                {
+                    LogGuidanceLoadError(loadError);
+                    state.instructionComplete = true;
+                }
+                else
+                {
+                    state.StartInstruction(loadResult.guidance, loadResult.pumpEnabled,
+                                           loadResult.commandMode == GuidanceCommandMode::Angle);
+
+                    // The carrot is either the idle arm position or, when blending, the end
+                    // of the previous segment, so it is the start of this one either way.
+                    SegmentSpeedProfile *profile = loadResult.guidance->GetSpeedProfile();
+                    activeSegmentPlanned =
+                        profile != nullptr &&
+                        DescribeLookaheadSegment(decoded.opcode, payload, payloadLength,
+                                                 state.target_m, Vector2D(0.0f, 0.0f), activeSegment);
+
+                    // A blended segment carries on in the branch its path started in.
+                    if (!blendingIntoNext && !state.cmdViaAngle)
+                    {
+                        const Vector2D pathEnd_m = activeSegmentPlanned ? activeSegment.end_m : state.target_m;
+                        ElbowBranch branch = elbowSelector.BeginPath(state.target_m, pathEnd_m,
+                                                                     s0Tlm.Position_deg, s1Tlm.Position_deg);
+                        if (branch != GetElbowBranch(s1Tlm.Position_deg))
+                        {
+                            ESP_LOGI(TAG, "Path runs in the %s elbow branch; reconfiguring the arm first",
+                                     (branch == ElbowBranch::Positive) ? "positive" : "negative");
+                            reconfiguringElbow = true;
+                        }
+                    }
+                    if (activeSegmentPlanned)
+                    {
+                        profile->currentSpeed_mps = entrySpeed_mps;
+                        PlanActiveSegmentSpeeds(activeSegment.length_m);
+                    }
+                    ESP_LOGI(TAG, "Starting OpCode: 0x%02X", decoded.opcode);
+                }
+            }
+        }
+        // Guidances copy what they need out of the payload when they load it.
+        commandRouter.ReleaseCommand(decoded);
+    }
+
+    if (homingController.IsActive() && !state.pauseActive)
+    {
+        HomingCommand homingCommand = homingController.Update({s0Tlm.Position_deg,
+                                                               s1Tlm.Position_deg,
+                                                               s0LimitSwitch,
+                                                               s1LimitSwitch});
+
+        if (homingCommand.setS0Position)
+        {
+            s0Motor.SetPosition(homingCommand.s0PositionToSet_deg);
+        }
+        if (homingCommand.setS1Position)
+        {
+            s1Motor.SetPosition(homingCommand.s1PositionToSet_deg);
+        }
+        if (homingCommand.setS0Position || homingCommand.setS1Position)
+        {
+            RefreshTelemetryAndPosition();
+        }
+
+        state.cmdViaAngle = true;
+        state.instructionComplete = homingCommand.complete;
+        state.activeGuidance = nullptr;
+        state.pumpThisMode = false;
+        state.target_m = state.currentPosition_m;
+        state.targetS0_deg = homingCommand.targetS0_deg;
+        state.targetS1_deg = homingCommand.targetS1_deg;
+        plannedTargetS0_deg = homingCommand.targetS0_deg;
+        plannedTargetS1_deg = homingCommand.targetS1_deg;
+        plannedDeltaS0_deg = plannedTargetS0_deg - s0Tlm.Position_deg;
+        plannedDeltaS1_deg = plannedTargetS1_deg - s1Tlm.Position_deg;
+        state.s0CmdSpeed_degps = homingCommand.s0Speed_degps;
+        state.s1CmdSpeed_degps = homingCommand.s1Speed_degps;
+        state.pumpSpeed_degps = 0.0f;
+        state.forceSpeedUpdate = homingCommand.setS0Position || homingCommand.setS1Position ||
+                                 homingCommand.complete;
+
+        if (homingCommand.complete)
+        {
+            state.CompleteInstruction();
+            SetLimitSwitchPolicy(true);
+            ESP_LOGI(TAG, "Homing complete");
+        }
+    }
+    else if (!state.pauseActive && !state.instructionComplete && state.activeGuidance != nullptr &&
+             reconfiguringElbow)
+    {
+        // Hold the carrot, and the guidance's progress along the path, until the elbow is in the
+        // held branch. A pause leaves the carrot at the measured tip, so go back to Cartesian mode.
+        state.cmdViaAngle = false;
+        pathSpeed_mps = 0.0f;
+    }
+    else if (!state.pauseActive && !state.instructionComplete && state.activeGuidance != nullptr)
+    {
+        if (!state.cmdViaAngle)
+        {
+            LimitPathSpeedToJoints(elapsed_ms);
+        }
+        state.instructionComplete = state.activeGuidance->GetTargetSetpoint(
+            elapsed_ms, state.target_m, setpoint, state.cmdViaAngle, state.s0CmdSpeed_degps, state.s1CmdSpeed_degps);
+        state.target_m = setpoint.position_m;
+        pathSpeed_mps = setpoint.hasVelocity ? setpoint.velocity_mps.magnitude() : 0.0f;
+
+        const SegmentSpeedProfile *profile = state.activeGuidance->GetSpeedProfile();
+        if (state.instructionComplete && activeSegmentPlanned && profile != nullptr &&
+            profile->exitSpeed_mps > 0.0f && commandRouter.GetLookaheadCount() > 0)
+        {
+            state.blendIntoNextInstruction = true;
+            state.blendSpeed_mps = profile->currentSpeed_mps;
+        }
+    }
+    else
+    {
+        // A paused segment resumes from the measured arm position, so it restarts from rest.
+        pathSpeed_mps = 0.0f;
+        if (state.activeGuidance != nullptr && state.activeGuidance->GetSpeedProfile() != nullptr)
+        {
+            state.activeGuidance->GetSpeedProfile()->currentSpeed_mps = 0.0f;
+        }
+
+        // Idle when no instruction is active or E-Stop engaged
+        state.IdleAtCurrentPosition(state.currentPosition_m, s0Tlm.Position_deg, s1Tlm.Position_deg);
+    }
+
+    if (!homingController.IsActive() && !state.instructionComplete && !state.pauseActive && state.cmdViaAngle)
+    {
+        state.pumpSpeed_degps = 0.0f;
+        if (state.activeGuidance != nullptr && state.activeGuidance->GetOpCode() == CNC_GO_TO_ANGLE_OPCODE)
+        {
+            float requestedS0_deg = goToAngleGuidance.Config.TargetS0_deg;
+            float requestedS1_deg = goToAngleGuidance.Config.TargetS1_deg;
+            if (config.keepOutRouting)
+            {
+                JointRoute route = keepOutRouter.Route(s0Tlm.Position_deg, s1Tlm.Position_deg,
+                                                       requestedS0_deg, requestedS1_deg);
+                if (route.kind == JointRouteKind::MirroredElbow)
+                {
+                    // Retarget the instruction itself so later cycles go straight there.
+                    ESP_LOGW(TAG, "Angle target %.2f, %.2f deg is blocked; going to the mirrored elbow pose %.2f, %.2f deg",
+                             requestedS0_deg, requestedS1_deg, route.s0Target_deg, route.s1Target_deg);
+                    goToAngleGuidance.Config.TargetS0_deg = route.s0Target_deg;
+                    goToAngleGuidance.Config.TargetS1_deg = route.s1Target_deg;
+                    requestedS0_deg = route.s0Target_deg;
+                    requestedS1_deg = route.s1Target_deg;
+                }
+            }
+
+            AngleMotion::AngleMovePlan s0Plan = AngleMotion::PlanDecelLimitedMoveWithLimitsDeg(
+                s0Tlm.Position_deg, requestedS0_deg, s0Motor.GetAccelLimit(),
+                config.accelScale, S0_ANGLE_LIMITS_DEG);
+            AngleMotion::AngleMovePlan s1Plan = AngleMotion::PlanDecelLimitedMoveWithLimitsDeg(
+                s1Tlm.Position_deg, requestedS1_deg, s1Motor.GetAccelLimit(),
+                config.accelScale, S1_ANGLE_LIMITS_DEG);
+
+            state.targetS0_deg = s0Plan.target_deg;
+            state.targetS1_deg = s1Plan.target_deg;
+            plannedTargetS0_deg = s0Plan.target_deg;
+            plannedTargetS1_deg = s1Plan.target_deg;
+            plannedDeltaS0_deg = s0Plan.delta_deg;
+            plannedDeltaS1_deg = s1Plan.delta_deg;
+            limitBlockedS0 = s0Plan.blocked;
+            limitBlockedS1 = s1Plan.blocked;
+
+            if (!s0Plan.blocked && !s1Plan.blocked &&
+                fabsf(s0Plan.delta_deg) <= goToAngleGuidance.Config.AngleTolerance_deg &&
+                fabsf(s1Plan.delta_deg) <= goToAngleGuidance.Config.AngleTolerance_deg)
+            {
+                state.CompleteInstruction();
+            }
+            else if (ApplyLimitStopIfBlocked(state, commandRouter, state.currentPosition_m,
+                                             s0Tlm.Position_deg, s1Tlm.Position_deg,
+                                             requestedS0_deg, requestedS1_deg, s0Plan, s1Plan,
+                                             "angle"))
+            {
+                state.targetS0_deg = plannedTargetS0_deg;
+                state.targetS1_deg = plannedTargetS1_deg;
+            }
+            else
+            {
+                state.s0CmdSpeed_degps = s0Plan.speed_degps;
+                state.s1CmdSpeed_degps = s1Plan.speed_degps;
+            }
+        }
+        else
+        {
+            state.targetS0_deg = 0.0f;
+            state.targetS1_deg = 0.0f;
+            plannedTargetS0_deg = state.targetS0_deg;
+            plannedTargetS1_deg = state.targetS1_deg;
+            plannedDeltaS0_deg = plannedTargetS0_deg - s0Tlm.Position_deg;
+            plannedDeltaS1_deg = plannedTargetS1_deg - s1Tlm.Position_deg;
+        }
+    }
+    else if (!homingController.IsActive() && !state.cmdViaAngle)
+    {
+        MathErrorCodes cartToAngRet = elbowSelector.Solve(state.target_m, s0Tlm.Position_deg,
+                                                          s1Tlm.Position_deg, state.targetS0_deg,
+                                                          state.targetS1_deg);
+
+        if (cartToAngRet != E_OK)
+        {
+            const char *reason = (cartToAngRet == E_UNREACHABLE_TOO_CLOSE) ? "close" : "far";
+            ESP_LOGE(TAG, "Unreachable target position %.2f X %.2f Y is too %s. Stopping",
+                     state.target_m.x, state.target_m.y, reason);
+            ApplyStoppedHold(state, commandRouter, state.currentPosition_m,
+                             s0Tlm.Position_deg, s1Tlm.Position_deg,
+                             "Out-of-bounds stop");
+        }
+        else
+        {
+            float requestedS0_deg = state.targetS0_deg;
+            float requestedS1_deg = state.targetS1_deg;
+            if (config.keepOutRouting)
+            {
+                // Route the path a little ahead of the carrot: the tip can lead the carrot slightly,
+                // and once it is inside the keep-out zone no move out of it is allowed.
+                float aheadS0_deg = requestedS0_deg;
+                float aheadS1_deg = requestedS1_deg;
+                Vector2D ahead_m;
+                if (!reconfiguringElbow && state.activeGuidance != nullptr &&
+                    state.activeGuidance->GetPathPointAhead(state.target_m, KEEP_OUT_LOOKAHEAD_M, ahead_m) &&
+                    elbowSelector.Solve(ahead_m, s0Tlm.Position_deg, s1Tlm.Position_deg,
+                                        aheadS0_deg, aheadS1_deg) != E_OK)
+                {
+                    aheadS0_deg = requestedS0_deg;
+                    aheadS1_deg = requestedS1_deg;
+                }
+                JointRoute route = keepOutRouter.Route(s0Tlm.Position_deg, s1Tlm.Position_deg,
+                                                       aheadS0_deg, aheadS1_deg);
+                if (route.kind == JointRouteKind::MirroredElbow && elbowSelector.SwitchBranch())
+                {
+                    // The tip leaves the path while the elbow flips, so the carrot waits here and
+                    // the segment restarts from rest once the arm is back on it.
+                    ESP_LOGW(TAG, "Path past %.3f X %.3f Y is blocked in this elbow branch; finishing it in the other one",
+                             state.target_m.x, state.target_m.y);
+                    elbowSelector.Solve(state.target_m, s0Tlm.Position_deg, s1Tlm.Position_deg,
+                                        requestedS0_deg, requestedS1_deg);
+                    reconfiguringElbow = true;
+                    setpoint.hasVelocity = false;
+                    pathSpeed_mps = 0.0f;
+                    state.blendSpeed_mps = 0.0f;
+                    if (state.activeGuidance != nullptr && state.activeGuidance->GetSpeedProfile() != nullptr)
+                    {
+                        state.activeGuidance->GetSpeedProfile()->currentSpeed_mps = 0.0f;
+                    }
+                }
+            }
+            AngleMotion::AngleMovePlan s0Plan = AngleMotion::PlanDecelLimitedMoveWithLimitsDeg(
+                s0Tlm.Position_deg, requestedS0_deg, s0Motor.GetAccelLimit(),
+                config.accelScale, S0_ANGLE_LIMITS_DEG);
+            AngleMotion::AngleMovePlan s1Plan = AngleMotion::PlanDecelLimitedMoveWithLimitsDeg(
+                s1Tlm.Position_deg, requestedS1_deg, s1Motor.GetAccelLimit(),
+                config.accelScale, S1_ANGLE_LIMITS_DEG);
+            state.targetS0_deg = s0Plan.target_deg;
+            state.targetS1_deg = s1Plan.target_deg;
+            plannedTargetS0_deg = s0Plan.target_deg;
+            plannedTargetS1_deg = s1Plan.target_deg;
+            plannedDeltaS0_deg = s0Plan.delta_deg;
+            plannedDeltaS1_deg = s1Plan.delta_deg;
+            limitBlockedS0 = s0Plan.blocked;
+            limitBlockedS1 = s1Plan.blocked;
+
+            // Control motor speed by assuming a constant deceleration.
+            // Solve the quadratic to find the max speed that can be decelerated
+            // over the given angle, using a configurable fraction of the motors'
+            // acceleration capability.
+            if (ApplyLimitStopIfBlocked(state, commandRouter, state.currentPosition_m,
+                                        s0Tlm.Position_deg, s1Tlm.Position_deg,
+                                        requestedS0_deg, requestedS1_deg, s0Plan, s1Plan,
+                                        "cartesian angle"))
+            {
+                state.targetS0_deg = plannedTargetS0_deg;
+                state.targetS1_deg = plannedTargetS1_deg;
+            }
+            else
+            {
+                // Feed the path velocity forward so the decel-limited feedback only has to
+                // close the residual. The speed command is applied over the coming period, so
+                // lead the path acceleration by half of it.
+                float s0Feedforward_degps = 0.0f;
+                float s1Feedforward_degps = 0.0f;
+                if (setpoint.hasVelocity && config.feedforwardGain != 0.0f)
+                {
+                    Vector2D accel_mps2 = setpoint.hasAcceleration ? setpoint.acceleration_mps2
+                                                                   : Vector2D(0.0f, 0.0f);
+                    CartVelToAngRateFeedforward(requestedS0_deg, requestedS1_deg,
+                                                setpoint.velocity_mps * config.feedforwardGain,
+                                                accel_mps2 * config.feedforwardGain,
+                                                0.5f * elapsed_ms * C_MSToS, s0Feedforward_degps,
+                                                s1Feedforward_degps);
+                }
+
+                state.s0CmdSpeed_degps = s0Feedforward_degps + s0Plan.speed_degps;
+                state.s1CmdSpeed_degps = s1Feedforward_degps + s1Plan.speed_degps;
+
+                if (reconfiguringElbow && !state.pauseActive &&
+                    fabsf(s0Plan.delta_deg) <= DEFAULT_ANGLE_TOLERANCE_DEG &&
+                    fabsf(s1Plan.delta_deg) <= DEFAULT_ANGLE_TOLERANCE_DEG)
+                {
+                    ESP_LOGI(TAG, "Elbow reconfigured; continuing the path");
+                    reconfiguringElbow = false;
+                }
+
+                // Control pump speed
+                state.pumpSpeed_degps =
+                    (!state.pauseActive && !reconfiguringElbow &&
+                     (!state.instructionComplete || state.blendIntoNextInstruction) &&
+                     state.pumpThisMode &&
+                     ((state.target_m - state.currentPosition_m).magnitude() < config.posTol_m))
+                        ? state.currentVelocity_mps.magnitude() * config.pumpConstant_degpm
+                        : 0.0;
+            }
+        }
+    }
+
+    // A purge is a queued pump-only instruction, so it blocks later motion commands.
+    if (!state.pauseActive && !homingController.IsActive() && state.pumpPurgeActive)
+    {
+        bool purgeStillActive = state.AdvancePurge(elapsed_ms);
+        if (!purgeStillActive)
+        {
+            ESP_LOGI(TAG, "Pump purge complete");
+        }
+    }
+
+    const bool pumpMotorInUse =
+        (fabsf(state.pumpSpeed_degps) > 0.001f) || (fabsf(pumpTlm.Speed_degps) > 0.001f);
+    SetPumpMotorInUse(cncEnabled && !eStopActive && pumpMotorInUse);
+
+    // Command Speed
+    if (cncEnabled)
+    {
+
+        pumpMotor.setTargetSpeed(state.pumpSpeed_degps);
+        s0Motor.setTargetSpeed(state.s0CmdSpeed_degps);
+        s1Motor.setTargetSpeed(state.s1CmdSpeed_degps);
+
+        // Force speed updates for pause and calibration events; stop decelerates normally.
+        s0Motor.UpdateSpeed(state.pauseActive || state.forceSpeedUpdate);
+        s1Motor.UpdateSpeed(state.pauseActive || state.forceSpeedUpdate);
+        pumpMotor.UpdateSpeed(state.pauseActive || state.forceSpeedUpdate);
+    }
+    else
+    {
+        StopMotors();
+    }
+
+    eStopActive = state.pauseActive;
+
+    // Readers get this through the ControlTelemetry seqlock, one whole cycle at a time.
+    telemetry.sampleTime_us = tlmSampleTime_us;
+    telemetry.PumpMotorTlm = pumpTlm;
+    telemetry.S0MotorTlm = s0Tlm;
+    telemetry.S1MotorTlm = s1Tlm;
+
+    telemetry.tipPos_X_m = state.currentPosition_m.x;
+    telemetry.tipPos_Y_m = state.currentPosition_m.y;
+
+    telemetry.targetPos_X_m = state.target_m.x;
+    telemetry.targetPos_Y_m = state.target_m.y;
+
+    telemetry.targetPos_S0_deg = state.targetS0_deg;
+    telemetry.targetPos_S1_deg = state.targetS1_deg;
+    telemetry.plannedTarget_S0_deg = plannedTargetS0_deg;
+    telemetry.plannedTarget_S1_deg = plannedTargetS1_deg;
+    telemetry.plannedDelta_S0_deg = plannedDeltaS0_deg;
+    telemetry.plannedDelta_S1_deg = plannedDeltaS1_deg;
+    telemetry.limitBlocked_S0 = limitBlockedS0;
+    telemetry.limitBlocked_S1 = limitBlockedS1;
+    telemetry.limitSwitch_S0 = s0LimitSwitch;
+    telemetry.limitSwitch_S1 = s1LimitSwitch;
+    telemetry.cncQueueClearCount = commandRouter.GetClearCount();
+
+    // Read the limit switches, adjust inhibits, and calibrate known switch angles.
+    if (homingController.IsActive())
+    {
+        s0Motor.SetDirectionalInhibit(StepperMotor::E_NO_INHIBIT);
+        s1Motor.SetDirectionalInhibit(StepperMotor::E_NO_INHIBIT);
+    }
+    else
+    {
+        if (s0LimitSwitch)
+        {
+            s0Motor.SetDirectionalInhibit(StepperMotor::E_INHIBIT_FORWARD);
+            s0Motor.SetPosition(S0_LIMIT_ANGLE_DEG);
+
+            // Force the next instruction
+            state.CompleteInstruction();
+        }
+        else
+        {
+            s0Motor.SetDirectionalInhibit(StepperMotor::E_NO_INHIBIT);
+        }
+
+        if (s1LimitSwitch)
+        {
+            s1Motor.SetDirectionalInhibit(StepperMotor::E_INHIBIT_BACKWARD);
+            s1Motor.SetPosition(S1_LIMIT_ANGLE_DEG);
+
+            // Force the next instruction
+            state.CompleteInstruction();
+        }
+        else
+        {
+            s1Motor.SetDirectionalInhibit(StepperMotor::E_NO_INHIBIT);
+        }
+    }
+}
+
+void MotorControlLoop::PlanActiveSegmentSpeeds(float remaining_m)
+{
+    SegmentSpeedProfile *profile =
+        (state.activeGuidance != nullptr) ? state.activeGuidance->GetSpeedProfile() : nullptr;
+    if (profile == nullptr)
+    {
+        return;
+    }
+
+    LookaheadLimits limits;
+    limits.s0Accel_degps2 = s0Motor.GetAccelLimit();
+    limits.s1Accel_degps2 = s1Motor.GetAccelLimit();
+    limits.accelScale = config.accelScale;
+    limits.junctionDeviation_m = config.junctionDeviation_m;
+    limits.elbow = elbowSelector.GetBranch();
+
+    LookaheadSegment segments[MOTION_LOOKAHEAD_WINDOW + 1];
+    segments[0] = activeSegment;
+    segments[0].length_m = remaining_m;
+    size_t count = 1;
+    for (size_t i = 0; i < commandRouter.GetLookaheadCount(); i++)
+    {
+        const DecodedCommand &queued = commandRouter.PeekLookahead(i);
+        if (!DescribeLookaheadSegment(queued.opcode, queued.instructions + 2, queued.instruction_length,
+                                      segments[count - 1].end_m, localOrigin_m, segments[count]))
+        {
+            break;
+        }
+        count++;
+    }
+
+    PlanLookaheadSpeeds(segments, count, profile->currentSpeed_mps, limits);
+    profile->accel_mps2 = segments[0].accel_mps2;
+    profile->exitSpeed_mps = segments[0].exitSpeed_mps;
+}
+
+void MotorControlLoop::LimitPathSpeedToJoints(unsigned int elapsed_ms)
+{
+    GeneralGuidance *guidance = state.activeGuidance;
+    if (!config.jointLimitedPathSpeed)
+    {
+        guidance->SetPathSpeedLimit(INFINITY);
+        return;
+    }
+
+    Vector2D points[PATH_SPEED_MAX_POINTS];
+    size_t count = 0;
+    while (count < PATH_SPEED_MAX_POINTS &&
+           guidance->GetPathPointAhead(state.target_m, PATH_SPEED_SPACING_M * count, points[count]))
+    {
+        count++;
+    }
+
+    PathJointLimits limits;
+    limits.s0Speed_degps = s0Motor.GetSpeedLimit();
+    limits.s1Speed_degps = s1Motor.GetSpeedLimit();
+    limits.s0Accel_degps2 = s0Motor.GetAccelLimit() * config.accelScale;
+    limits.s1Accel_degps2 = s1Motor.GetAccelLimit() * config.accelScale;
+    limits.elbow = elbowSelector.GetBranch();
+
+    // Nothing is known past the horizon, so the plan must be able to stop there. A horizon that
+    // reaches the end of the path leaves the exit to the segment's own look-ahead profile.
+    const float exitSpeed_mps = (count == PATH_SPEED_MAX_POINTS) ? 0.0f : -1.0f;
+    if (!pathSpeedPlan.Plan(points, count, PATH_SPEED_SPACING_M, pathSpeed_mps, exitSpeed_mps, limits))
+    {
+        guidance->SetPathSpeedLimit(INFINITY);
+        return;
+    }
+    guidance->SetPathSpeedLimit(pathSpeedPlan.GetStepSpeed_mps(elapsed_ms * C_MSToS));
+}
+
+void MotorControlLoop::RefreshTelemetryAndPosition()
+{
+    StepperMotor *const motors[] = {&s0Motor, &s1Motor, &pumpMotor};
+    motor_tlm_t tlms[3];
+    StepperMotor::GetTlmTogether(motors, tlms, 3);
+    tlmSampleTime_us = esp_timer_get_time();
+    s0Tlm = tlms[0];
+    s1Tlm = tlms[1];
+    pumpTlm = tlms[2];
+    // The safety task writes the switches; read each once so the whole cycle, and its published
+    // telemetry, act on the same values.
+    s0LimitSwitch = TelemetryData.S0LimitSwitch;
+    s1LimitSwitch = TelemetryData.S1LimitSwitch;
+
+    AngToCart(s0Tlm.Position_deg, s1Tlm.Position_deg, s0Tlm.Speed_degps,
+              s1Tlm.Speed_degps, state.currentPosition_m, state.currentVelocity_mps);
+}
+
+void MotorControlLoop::StopMotors()
+{
+    s0Motor.setTargetSpeed(0.0);
+    s1Motor.setTargetSpeed(0.0);
+    pumpMotor.setTargetSpeed(0.0);
+
+    s0Motor.UpdateSpeed(true);
+    s1Motor.UpdateSpeed(true);
+    pumpMotor.UpdateSpeed(true);
+}
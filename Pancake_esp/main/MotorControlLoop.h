@@ -0,0 +1,124 @@
+#ifndef MOTOR_CONTROL_LOOP_H
+#define MOTOR_CONTROL_LOOP_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "ArcGuidance.h"
+#include "ArchimedeanSpiral.h"
+#include "CommandSlab.h"
+#include "ElbowSelector.h"
+#include "GoToAngleGuidance.h"
+#include "GuidanceRegistry.h"
+#include "HomingController.h"
+#include "JogGuidance.h"
+#include "KeepOutRouter.h"
+#include "MotionLookahead.h"
+#include "MotorCommandRouter.h"
+#include "MotorControlState.h"
+#include "PathSpeedPlanner.h"
+#include "RectangleGuidance.h"
+#include "StepperMotor.h"
+#include "Telemetry.h"
+
+// Step size = gear ratio * motor step size / micro step reduction
+constexpr float MOTOR_STEP_SIZE_DEG = 0.9 / 16.0; // TODO, track down 16 error term
+constexpr float S0_STEP_SIZE_DEG = MOTOR_STEP_SIZE_DEG * 16.0 / 108.0;
+constexpr float S1_STEP_SIZE_DEG = MOTOR_STEP_SIZE_DEG * 10.0 / 24.0;
+constexpr float PUMP_STEP_SIZE_DEG = MOTOR_STEP_SIZE_DEG;
+
+constexpr float S0_ACCEL_LIMIT_DEGPS2 = 800.0f;
+constexpr float S0_SPEED_LIMIT_DEGPS = 50.0f;
+constexpr float S1_ACCEL_LIMIT_DEGPS2 = 800.0f;
+constexpr float S1_SPEED_LIMIT_DEGPS = 50.0f;
+constexpr float PUMP_ACCEL_LIMIT_DEGPS2 = 10.0f;
+constexpr float PUMP_SPEED_LIMIT_DEGPS = 600.0f;
+
+constexpr bool S0_MOTOR_WIRED_BACKWARD = false;
+constexpr bool S1_MOTOR_WIRED_BACKWARD = true;
+constexpr bool PUMP_MOTOR_WIRED_BACKWARD = true;
+
+// Angles at which the limit switches trip, used to calibrate the joint positions.
+constexpr float S0_LIMIT_ANGLE_DEG = 210.0 - 17.0;
+constexpr float S1_LIMIT_ANGLE_DEG = -180.0f;
+constexpr float GO_HOME_S0_ANGLE_DEG = 120.0f;
+constexpr float GO_HOME_S1_ANGLE_DEG = -115.0f;
+
+// One 100 Hz cycle of the CNC controller: immediate commands, queued instruction dispatch,
+// guidance, joint planning, motor speed commands and limit switch handling. The loop owns no
+// timing or hardware of its own, so the FreeRTOS task and the host simulation drive the same
+// code with a real or a virtual clock.
+class MotorControlLoop
+{
+  public:
+    MotorControlLoop(StepperMotor &s0Motor, StepperMotor &s1Motor, StepperMotor &pumpMotor,
+                     QueueHandle_t nowQueue, QueueHandle_t cncQueue, CommandSlab &commandSlab,
+                     const MotorControlConfig &initialConfig = MotorControlConfig());
+
+    // Run one cycle. `elapsed_ms` is the wall time since the previous cycle; motors are only
+    // commanded while `cncEnabled`, otherwise they are brought to a stop.
+    void RunCycle(unsigned int elapsed_ms, bool cncEnabled);
+
+    // True once no instruction, purge or homing sequence is running and no motion commands
+    // remain queued.
+    bool IsIdle() const;
+
+    const MotorControlState &GetState() const { return state; }
+
+    // This cycle's motor and planner telemetry, complete after RunCycle except for the loop
+    // timing fields, which the caller fills in before publishing it.
+    const control_tlm_t &GetTelemetry() const { return telemetry; }
+
+  private:
+    // Plan entry/exit speeds for the active jog/arc together with the segments waiting in the
+    // look-ahead window. `activeSegment` describes the whole active instruction; only the
+    // `remaining_m` still ahead of the carrot is planned.
+    void PlanActiveSegmentSpeeds(float remaining_m);
+    // Plan the joint-limited speed over the path just ahead of the carrot and cap the active
+    // guidance to it for this cycle's step.
+    void LimitPathSpeedToJoints(unsigned int elapsed_ms);
+    void RefreshTelemetryAndPosition();
+    void StopMotors();
+
+    StepperMotor &s0Motor;
+    StepperMotor &s1Motor;
+    StepperMotor &pumpMotor;
+
+    MotorControlConfig config;
+    MotorControlState state;
+
+    // Guidance objects
+    ArchimedeanSpiral spiralGuidance;
+    WaitGuidance waitGuidance;
+    SineGuidance sineGuidance;
+    ConstantSpeed constantSpeed;
+    JogGuidance jogGuidance;
+    ArcGuidance arcGuidance;
+    RectangleGuidance rectangleGuidance;
+    GoToAngleGuidance goToAngleGuidance;
+
+    GuidanceRegistry guidanceRegistry;
+    MotorCommandRouter commandRouter;
+    HomingController homingController;
+    ElbowSelector elbowSelector;
+    KeepOutRouter keepOutRouter;
+    LookaheadSegment activeSegment;
+    bool activeSegmentPlanned = false;
+    PathSpeedPlan pathSpeedPlan;
+    float pathSpeed_mps = 0.0f;
+    // Set while the joints move into the held elbow branch. The carrot waits where it is until the
+    // arm reaches it, so the path is drawn from the point where the flip began.
+    bool reconfiguringElbow = false;
+
+    motor_tlm_t s0Tlm{};
+    motor_tlm_t s1Tlm{};
+    motor_tlm_t pumpTlm{};
+    int64_t tlmSampleTime_us = 0;
+    bool s0LimitSwitch = false;
+    bool s1LimitSwitch = false;
+    control_tlm_t telemetry{};
+    Vector2D localOrigin_m{0.0f, 0.0f};
+    bool eStopActive = false;
+};
+
+#endif // MOTOR_CONTROL_LOOP_H
@@ -10,6 +10,16 @@ struct MotorControlConfig
     float pumpConstant_degpm = 3.0e4f;
     float accelScale = 0.01f;
     float posTol_m = 1.0f;
+    float junctionDeviation_m = 0.0005f;
+    // Fraction of the guidance path velocity fed forward to the joints through the inverse
+    // Jacobian. Position feedback only corrects what is left; 0 restores pure feedback.
+    float feedforwardGain = 1.0f;
+    // Cap jog, arc and spiral path speed to what the joints can follow over the next few
+    // centimetres of path (PathSpeedPlanner); false runs them at their commanded speed.
+    bool jointLimitedPathSpeed = true;
+    // When a joint limit blocks a target, move to the mirrored elbow pose at the same tip instead
+    // of stopping and draining the queue (KeepOutRouter). A Cartesian path may switch once.
+    bool keepOutRouting = true;
 };
 
 struct MotorControlState
@@ -30,6 +40,10 @@ struct MotorControlState
     bool cmdViaAngle = false;
     bool pauseActive = false;
     bool forceSpeedUpdate = false;
+    // Set when a segment finished above rest speed; the next segment then continues from the
+    // carrot at blendSpeed_mps instead of restarting from the measured arm position.
+    bool blendIntoNextInstruction = false;
+    float blendSpeed_mps = 0.0f;
     GeneralGuidance *activeGuidance = nullptr;
 
     void BeginLoop()
@@ -44,8 +58,15 @@ struct MotorControlState
         pumpPurgeSpeed_degps = 0.0f;
     }
 
+    void ClearBlend()
+    {
+        blendIntoNextInstruction = false;
+        blendSpeed_mps = 0.0f;
+    }
+
     void CompleteInstruction()
     {
+        ClearBlend();
         instructionComplete = true;
         activeGuidance = nullptr;
         s0CmdSpeed_degps = 0.0f;
@@ -96,6 +117,7 @@ struct MotorControlState
 
     void IdleAtCurrentPosition(Vector2D position_m, float currentS0_deg, float currentS1_deg)
     {
+        ClearBlend();
         cmdViaAngle = true;
         s0CmdSpeed_degps = 0.0f;
         s1CmdSpeed_degps = 0.0f;
@@ -120,6 +142,7 @@ inline void ApplyHoldCommand(MotorControlState &state, const MotionHoldCommand &
     state.instructionComplete = command.instructionComplete;
     state.activeGuidance = nullptr;
     state.pumpThisMode = false;
+    state.ClearBlend();
     state.StopPurge();
     state.cmdViaAngle = command.cmdViaAngle;
     state.target_m = command.target_m;
@@ -1,29 +1,21 @@
 #include "PanMath.h"
+#include "PanMathKernels.h"
+
+#include <cfloat>
+#include <cstdint>
 
 namespace
 {
 float ClampUnitRange(float value)
 {
-    if (value > 1.0f)
-    {
-        return 1.0f;
-    }
-    if (value < -1.0f)
-    {
-        return -1.0f;
-    }
-    return value;
+    value = (value > 1.0f) ? 1.0f : value;
+    return (value < -1.0f) ? -1.0f : value;
 }
 
 float NonNegativeInset(float inset_m)
 {
     return (inset_m > 0.0f) ? inset_m : 0.0f;
 }
-
-bool IsFiniteVector(Vector2D value)
-{
-    return std::isfinite(value.x) && std::isfinite(value.y);
-}
 } // namespace
 
 /*
@@ -50,17 +42,24 @@ const float C_Inv_2_TIMES_S0L_TIMES_S1L_1pm2 = 1.0f / (2.0f * C_S0Length_m * C_S
 const float C_MAX_REACH_m = C_S0Length_m + C_S1Length_m;
 const float C_MIN_REACH_m = C_S0Length_m - C_S1Length_m;
 
-void AngToCart(float S0Ang_deg, float S1Ang_deg, Vector2D &CartPos_m)
+namespace
+{
+inline void AngToCartLane(float S0Ang_deg, float S1Ang_deg, float &X_m, float &Y_m)
 {
     float phi_rad = (S0Ang_deg + S1Ang_deg) * C_DEGToRAD;
     float theta_rad = S0Ang_deg * C_DEGToRAD;
-    float cp = cos(phi_rad);
-    float sp = sin(phi_rad);
-    float ct = cos(theta_rad);
-    float st = sin(theta_rad);
+    float cp, sp, ct, st;
+    FastSinCos(phi_rad, sp, cp);
+    FastSinCos(theta_rad, st, ct);
 
-    CartPos_m.x = st * C_S0Length_m + sp * C_S1Length_m;
-    CartPos_m.y = ct * C_S0Length_m + cp * C_S1Length_m;
+    X_m = st * C_S0Length_m + sp * C_S1Length_m;
+    Y_m = ct * C_S0Length_m + cp * C_S1Length_m;
+}
+} // namespace
+
+void AngToCart(float S0Ang_deg, float S1Ang_deg, Vector2D &CartPos_m)
+{
+    AngToCartLane(S0Ang_deg, S1Ang_deg, CartPos_m.x, CartPos_m.y);
 }
 
 void AngToCart(float S0Ang_deg, float S1Ang_deg, float S0Rate_degps, float S1Rate_degps,
@@ -68,10 +67,9 @@ void AngToCart(float S0Ang_deg, float S1Ang_deg, float S0Rate_degps, float S1Rat
 {
     float phi_rad = (S0Ang_deg + S1Ang_deg) * C_DEGToRAD;
     float theta_rad = S0Ang_deg * C_DEGToRAD;
-    float cp = cos(phi_rad);
-    float sp = sin(phi_rad);
-    float ct = cos(theta_rad);
-    float st = sin(theta_rad);
+    float cp, sp, ct, st;
+    FastSinCos(phi_rad, sp, cp);
+    FastSinCos(theta_rad, st, ct);
 
     float phi_rate_radps = (S0Rate_degps + S1Rate_degps) * C_DEGToRAD;
     float theta_rate_radps = S0Rate_degps * C_DEGToRAD;
@@ -83,55 +81,164 @@ void AngToCart(float S0Ang_deg, float S1Ang_deg, float S0Rate_degps, float S1Rat
     CartPos_m.y = ct * C_S0Length_m + cp * C_S1Length_m;
 }
 
+namespace
+{
+// Inverse kinematics for one sample without early returns, shared by CartToAng and
+// CartToAngBatch. The angles are only meaningful when the result is E_OK.
+inline MathErrorCodes CartToAngLane(float X_m, float Y_m, float &S0Ang_deg, float &S1Ang_deg)
+{
+    // Compute the squared distance from the origin to the target point (r^2)
+    float targetDistSquared_m2 = X_m * X_m + Y_m * Y_m;
+
+    // Compute the distance to the target point (r)
+    float targetDist_m = sqrtf(targetDistSquared_m2);
+
+    // Compute the angle from the base to the target point using atan2 for full quadrant coverage
+    float targetAng_rd = FastAtan2(X_m, Y_m); // Angle in radians
+
+    // Convert the triangle's inner angles to motor positions, negative elbow branch.
+
+    float s0CosArg = (C_S0L2_MINUS_S1L2_m2 + targetDistSquared_m2) /
+                     (2.0f * C_S0Length_m * targetDist_m);
+    float s1CosArg =
+        (C_S0L2_PLUS_S1L2_m2 - targetDistSquared_m2) * C_Inv_2_TIMES_S0L_TIMES_S1L_1pm2;
+
+    S0Ang_deg = (targetAng_rd + FastAcos(ClampUnitRange(s0CosArg))) * C_RADToDEG;
+    S1Ang_deg = (FastAcos(ClampUnitRange(s1CosArg)) - static_cast<float>(M_PI)) * C_RADToDEG;
+
+    // Reachability as selects, later checks taking precedence: non-finite input (or a square
+    // that overflows), inside then outside the annulus, then the origin. EPSILON is far below a
+    // float ulp of either reach, so the reach comparisons need no margin in float.
+    MathErrorCodes result =
+        (targetDistSquared_m2 <= FLT_MAX) ? E_OK : E_UNREACHABLE_TOO_FAR; // NaN fails too
+    result = (targetDist_m < C_MIN_REACH_m) ? E_UNREACHABLE_TOO_CLOSE : result;
+    result = (targetDist_m > C_MAX_REACH_m) ? E_UNREACHABLE_TOO_FAR : result;
+    result = (targetDistSquared_m2 < static_cast<float>(EPSILON)) ? E_UNREACHABLE_TOO_CLOSE : result;
+    return result;
+}
+} // namespace
+
 MathErrorCodes CartToAng(float &S0Ang_deg, float &S1Ang_deg, Vector2D Pos_m)
 {
-    if (!IsFiniteVector(Pos_m))
+    // A batch of one keeps a single inlined copy of the lane, which the batch loop needs in
+    // order to vectorise.
+    float s0Ang_deg = 0.0f;
+    float s1Ang_deg = 0.0f;
+    MathErrorCodes result = E_OK;
+    CartToAngBatch(&Pos_m.x, &Pos_m.y, &s0Ang_deg, &s1Ang_deg, &result, 1);
+    if (result == E_OK)
     {
-        return E_UNREACHABLE_TOO_FAR;
+        S0Ang_deg = s0Ang_deg;
+        S1Ang_deg = s1Ang_deg;
     }
+    return result;
+}
 
-    // Compute the squared distance from the origin to the target point (r^2)
-    float targetDistSquared_m2 = dot(Pos_m, Pos_m);
-    if (!std::isfinite(targetDistSquared_m2))
+MathErrorCodes CartToAngBothBranches(float S0Ang_deg[2], float S1Ang_deg[2], Vector2D Pos_m)
+{
+    float s0Ang_deg = 0.0f;
+    float s1Ang_deg = 0.0f;
+    MathErrorCodes result = CartToAng(s0Ang_deg, s1Ang_deg, Pos_m);
+    if (result != E_OK)
     {
-        return E_UNREACHABLE_TOO_FAR;
+        return result;
     }
 
-    if (targetDistSquared_m2 < EPSILON)
+    // Mirroring about the base-to-tip line swaps S0 = target + a for target - a and negates S1.
+    float targetAng_deg = FastAtan2(Pos_m.x, Pos_m.y) * C_RADToDEG;
+    S0Ang_deg[static_cast<int>(ElbowBranch::Negative)] = s0Ang_deg;
+    S1Ang_deg[static_cast<int>(ElbowBranch::Negative)] = s1Ang_deg;
+    S0Ang_deg[static_cast<int>(ElbowBranch::Positive)] = 2.0f * targetAng_deg - s0Ang_deg;
+    S1Ang_deg[static_cast<int>(ElbowBranch::Positive)] = -s1Ang_deg;
+    return E_OK;
+}
+
+ElbowBranch GetElbowBranch(float S1Ang_deg)
+{
+    float wrapped_deg = S1Ang_deg - 360.0f * floorf((S1Ang_deg + 180.0f) / 360.0f);
+    return (wrapped_deg > 0.0f) ? ElbowBranch::Positive : ElbowBranch::Negative;
+}
+
+void AngToCartBatch(const float *__restrict S0Ang_deg, const float *__restrict S1Ang_deg,
+                    float *__restrict X_m, float *__restrict Y_m, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
     {
-        // If the target is at the origin, return an error
-        return E_UNREACHABLE_TOO_CLOSE;
+        AngToCartLane(S0Ang_deg[i], S1Ang_deg[i], X_m[i], Y_m[i]);
     }
+}
 
-    // Compute the distance to the target point (r)
-    float targetDist_m = sqrtf(targetDistSquared_m2);
-
-    // Compute the angle from the base to the target point using atan2 for full quadrant coverage
-    float targetAng_rd = atan2f(Pos_m.x, Pos_m.y); // Angle in radians
+size_t CartToAngBatch(const float *__restrict X_m, const float *__restrict Y_m,
+                      float *__restrict S0Ang_deg, float *__restrict S1Ang_deg,
+                      MathErrorCodes *__restrict Errors, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float s0Ang_deg;
+        float s1Ang_deg;
+        MathErrorCodes result = CartToAngLane(X_m[i], Y_m[i], s0Ang_deg, s1Ang_deg);
+        bool ok = (result == E_OK);
+        S0Ang_deg[i] = ok ? s0Ang_deg : 0.0f;
+        S1Ang_deg[i] = ok ? s1Ang_deg : 0.0f;
+        Errors[i] = result;
+    }
 
-    // Check if the target is reachable
-    if (targetDist_m > C_MAX_REACH_m + EPSILON)
+    // Counted separately: a running count in the loop above stops it vectorising.
+    uint32_t unreachable = 0;
+    for (size_t i = 0; i < count; i++)
     {
-        return E_UNREACHABLE_TOO_FAR;
+        unreachable += (Errors[i] != E_OK) ? 1u : 0u;
     }
-    else if (targetDist_m < C_MIN_REACH_m - EPSILON)
+    return unreachable;
+}
+
+bool CartRateToAngRate(float S0Ang_deg, float S1Ang_deg, Vector2D CartRate, float &S0Rate_degps,
+                       float &S1Rate_degps)
+{
+    float phi_rad = (S0Ang_deg + S1Ang_deg) * C_DEGToRAD;
+    float theta_rad = S0Ang_deg * C_DEGToRAD;
+    float cp, sp, ct, st;
+    FastSinCos(phi_rad, sp, cp);
+    FastSinCos(theta_rad, st, ct);
+
+    // Jacobian of AngToCart with respect to (S0, S1) in m/rad.
+    float j00 = C_S0Length_m * ct + C_S1Length_m * cp;
+    float j01 = C_S1Length_m * cp;
+    float j10 = -(C_S0Length_m * st + C_S1Length_m * sp);
+    float j11 = -C_S1Length_m * sp;
+
+    // det = -L0 * L1 * sin(S1), so this rejects S1 within ~0.6 deg of 0 or +/-180.
+    float det = j00 * j11 - j01 * j10;
+    if (!std::isfinite(det) || fabsf(det) < 1.0e-2f * C_S0Length_m * C_S1Length_m)
     {
-        return E_UNREACHABLE_TOO_CLOSE;
+        return false;
     }
 
-    // Convert the triangle's inner angles to motor positions
-    // TODO, add criteria to select for which of the two solutions to use.
+    float invDet = 1.0f / det;
+    S0Rate_degps = (j11 * CartRate.x - j01 * CartRate.y) * invDet * C_RADToDEG;
+    S1Rate_degps = (-j10 * CartRate.x + j00 * CartRate.y) * invDet * C_RADToDEG;
+    return true;
+}
 
-    float s0CosArg = (C_S0L2_MINUS_S1L2_m2 + targetDistSquared_m2) /
-                     (2.0f * C_S0Length_m * targetDist_m);
-    float s1CosArg =
-        (C_S0L2_PLUS_S1L2_m2 - targetDistSquared_m2) * C_Inv_2_TIMES_S0L_TIMES_S1L_1pm2;
+bool CartVelToAngRateFeedforward(float S0Ang_deg, float S1Ang_deg, Vector2D CartVel_mps,
+                                 Vector2D CartAccel_mps2, float Lead_s, float &S0Rate_degps,
+                                 float &S1Rate_degps)
+{
+    S0Rate_degps = 0.0f;
+    S1Rate_degps = 0.0f;
+
+    Vector2D leadVel_mps = CartVel_mps + CartAccel_mps2 * Lead_s;
+    float s0Rate_degps = 0.0f;
+    float s1Rate_degps = 0.0f;
+    if (!CartRateToAngRate(S0Ang_deg, S1Ang_deg, leadVel_mps, s0Rate_degps, s1Rate_degps) ||
+        !std::isfinite(s0Rate_degps) || !std::isfinite(s1Rate_degps))
+    {
+        return false;
+    }
 
-    S0Ang_deg = (targetAng_rd + acosf(ClampUnitRange(s0CosArg))) * C_RADToDEG;
-    S1Ang_deg =
-        (acosf(ClampUnitRange(s1CosArg)) - M_PI) *
-        C_RADToDEG;
-    return E_OK;
+    S0Rate_degps = s0Rate_degps;
+    S1Rate_degps = s1Rate_degps;
+    return true;
 }
 
 float GetMinReach_m() { return C_MIN_REACH_m; }
@@ -2,6 +2,7 @@
 #define PANMATH_H
 
 #include <cmath>
+#include <cstddef>
 
 #include "esp_err.h"
 
@@ -20,11 +21,48 @@ enum MathErrorCodes
     E_UNREACHABLE_TOO_CLOSE = -2
 };
 
+// The two inverse-kinematics solutions for one tip position, mirror images about the line from
+// the base to the tip. Negative has S1 in [-180, 0] deg and is the one CartToAng returns.
+enum class ElbowBranch
+{
+    Negative = 0,
+    Positive = 1
+};
+
 void AngToCart(float S0Ang_deg, float S1Ang_deg, Vector2D &CartPos_m);
 void AngToCart(float S0Ang_deg, float S1Ang_deg, float S0Rate_degps, float S1Rate_degps,
                Vector2D &CartPos_m, Vector2D &CartVel_mps);
 
 MathErrorCodes CartToAng(float &S0Ang_deg, float &S1Ang_deg, Vector2D Pos_m);
+// Both solutions, indexed by ElbowBranch. The outputs are left untouched unless the result is E_OK.
+MathErrorCodes CartToAngBothBranches(float S0Ang_deg[2], float S1Ang_deg[2], Vector2D Pos_m);
+// Branch a joint pose is in; S1 may be any number of turns.
+ElbowBranch GetElbowBranch(float S1Ang_deg);
+
+// Whole-array kinematics for preflight checks and simulation, on structure-of-arrays buffers of
+// `count` samples. Same results as the scalar calls. The loops are branch-free so GCC vectorises
+// them on the host (-O3 -fno-math-errno -fno-trapping-math, as scripts/run_benchmarks.sh builds);
+// the ESP32-S3 has no float SIMD and runs them as plain scalar loops. Outputs must not alias
+// inputs.
+void AngToCartBatch(const float *S0Ang_deg, const float *S1Ang_deg, float *X_m, float *Y_m,
+                    size_t count);
+// Errors[i] is CartToAng's result for sample i; angles of unreachable samples are set to 0.
+// Returns the number of unreachable samples.
+size_t CartToAngBatch(const float *X_m, const float *Y_m, float *S0Ang_deg, float *S1Ang_deg,
+                      MathErrorCodes *Errors, size_t count);
+
+// Map a Cartesian rate (velocity, or acceleration ignoring the velocity-product terms) at the given
+// joint angles to joint rates through the inverse Jacobian. Returns false near the fully extended
+// or folded singularity where the mapping is unbounded.
+bool CartRateToAngRate(float S0Ang_deg, float S1Ang_deg, Vector2D CartRate, float &S0Rate_degps,
+                       float &S1Rate_degps);
+
+// Joint-rate feedforward for a moving Cartesian setpoint: the path velocity, advanced by Lead_s of
+// path acceleration, mapped through the inverse Jacobian at the setpoint's joint angles. On false
+// (near a singularity) both rates are zero and the caller is left with position feedback only.
+bool CartVelToAngRateFeedforward(float S0Ang_deg, float S1Ang_deg, Vector2D CartVel_mps,
+                                 Vector2D CartAccel_mps2, float Lead_s, float &S0Rate_degps,
+                                 float &S1Rate_degps);
 float GetMinReach_m();
 float GetMaxReach_m();
 bool GetReachableRectangleCorners(Vector2D corners_m[4], float inset_m = 0.0f);
@@ -0,0 +1,136 @@
+#ifndef PANMATH_KERNELS_H
+#define PANMATH_KERNELS_H
+
+#include <cmath>
+#include <cstdint>
+
+// Single-precision trig kernels for the arm kinematics. libm's float routines handle every input
+// to the last ulp, which costs range reduction for huge arguments, errno and NaN paths, and on the
+// ESP32-S3 a call into flash for each one. Joint angles here stay within a few turns, so short
+// minimax polynomials (the Cephes single-precision coefficients) with a cheap range reduction
+// are enough.
+//
+// Worst-case error over the kinematics' input ranges, checked by PanMathKernelsTest:
+//   FastSinCos  < 1e-6 for |x| <= 8 pi
+//   FastAtan2   < 1e-6 rad
+//   FastAcos    < 1e-6 rad
+// One S0 microstep is 1.45e-4 rad (0.0083 deg), so none of this is visible at the motors.
+// scripts/run_benchmarks.sh compares their speed and error against libm. On an x86-64 host at -O3
+// FastAtan2 and FastAcos run about 3.4x and 1.6x faster than glibc, but FastSinCos only matches
+// glibc's sinf/cosf (0.98-1.01x). Its gain on the ESP32-S3 has not been measured.
+
+namespace PanMathKernels
+{
+constexpr float PI = 3.14159265358979f;
+constexpr float HALF_PI = 1.57079632679490f;
+constexpr float QUARTER_PI = 0.785398163397448f;
+constexpr float TWO_OVER_PI = 0.636619772367581f;
+
+// pi/2 split so that k * PI_2_HI is exact for the k a few turns produce (Cody-Waite).
+constexpr float PI_2_HI = 1.5703125f;
+constexpr float PI_2_MID = 4.837512969970703125e-4f;
+constexpr float PI_2_LO = 7.54978995489188216e-8f;
+// Largest quarter-turn count FastSinCos converts to int32_t (2^30).
+constexpr float MAX_QUARTER_TURNS = 1073741824.0f;
+
+// sin(r) and cos(r) for |r| <= pi/4.
+inline float SinPoly(float r)
+{
+    float z = r * r;
+    return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+}
+
+inline float CosPoly(float r)
+{
+    float z = r * r;
+    return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z *
+               z -
+           0.5f * z + 1.0f;
+}
+
+// atan(t) for |t| <= tan(pi/8).
+inline float AtanPoly(float t)
+{
+    float z = t * t;
+    return (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z -
+            3.33329491539e-1f) *
+               z * t +
+           t;
+}
+
+// asin(x) for |x| <= 0.5.
+inline float AsinPoly(float x)
+{
+    float z = x * x;
+    return ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z + 4.5470025998e-2f) * z +
+             7.4953002686e-2f) *
+                z +
+            1.6666752422e-1f) *
+               z * x +
+           x;
+}
+} // namespace PanMathKernels
+
+// sin and cos of one angle in radians, sharing the range reduction.
+inline void FastSinCos(float x_rad, float &sin_out, float &cos_out)
+{
+    using namespace PanMathKernels;
+
+    // Nearest quarter turn, then the remainder in [-pi/4, pi/4]. The quarter-turn count is
+    // clamped before the int conversion, which is undefined for nan, inf and anything past int32;
+    // nan and inf still come out as nan through r, larger finite inputs as meaningless values.
+    float kf = x_rad * TWO_OVER_PI;
+    kf = (kf >= -MAX_QUARTER_TURNS) ? kf : -MAX_QUARTER_TURNS; // nan lands here
+    kf = (kf <= MAX_QUARTER_TURNS) ? kf : MAX_QUARTER_TURNS;
+    int32_t k = static_cast<int32_t>(kf + ((kf >= 0.0f) ? 0.5f : -0.5f));
+    float n = static_cast<float>(k);
+    float r = ((x_rad - n * PI_2_HI) - n * PI_2_MID) - n * PI_2_LO;
+
+    // Odd quadrants swap sin and cos; the sign flips follow the quadrant's bits.
+    float s = SinPoly(r);
+    float c = CosPoly(r);
+    bool odd = (k & 1) != 0;
+    float sinMagnitude = odd ? c : s;
+    float cosMagnitude = odd ? s : c;
+    sin_out = (k & 2) ? -sinMagnitude : sinMagnitude;
+    cos_out = ((k + 1) & 2) ? -cosMagnitude : cosMagnitude;
+}
+
+// The kernels below pick between precomputed values instead of branching, so loops over arrays
+// of samples (AngToCartBatch / CartToAngBatch) vectorise on the host.
+inline float FastAtan2(float y, float x)
+{
+    using namespace PanMathKernels;
+
+    // atan of the smaller over the larger magnitude, folded once more about pi/8.
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float hi = (ay > ax) ? ay : ax;
+    float lo = (ay > ax) ? ax : ay;
+    float t = lo / ((hi > 0.0f) ? hi : 1.0f);
+    float foldedT = (t - 1.0f) / (t + 1.0f);
+    bool folded = t > 0.414213562373095f;
+    float u = folded ? foldedT : t;
+    float angle = AtanPoly(u) + (folded ? QUARTER_PI : 0.0f);
+
+    angle = (ay > ax) ? HALF_PI - angle : angle;
+    angle = (x < 0.0f) ? PI - angle : angle;
+    return (y < 0.0f) ? -angle : angle;
+}
+
+// Input outside [-1, 1] is clamped, as CartToAng already does before calling acos.
+inline float FastAcos(float x)
+{
+    using namespace PanMathKernels;
+
+    // Near +/-1 use acos(|x|) = 2 asin(sqrt((1 - |x|) / 2)); otherwise pi/2 - asin(x).
+    float ax = fabsf(x);
+    ax = (ax < 1.0f) ? ax : 1.0f;
+    float wideArg = sqrtf(0.5f * (1.0f - ax));
+    bool wide = ax > 0.5f;
+    float p = AsinPoly(wide ? wideArg : x);
+    float wideAngle = (x < 0.0f) ? PI - 2.0f * p : 2.0f * p;
+    return wide ? wideAngle : HALF_PI - p;
+}
+
+#endif // PANMATH_KERNELS_H
@@ -0,0 +1,78 @@
+#include "PartitionProgramStorage.h"
+
+#include <cstring>
+
+#include "esp_log.h"
+
+static const char *TAG = "ProgramStorage";
+
+esp_err_t PartitionProgramStorage::Init()
+{
+    m_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, PROGRAM_PARTITION_SUBTYPE,
+                                           PROGRAM_PARTITION_LABEL);
+    if (m_partition == nullptr)
+    {
+        ESP_LOGE(TAG, "No \"%s\" partition; program storage disabled", PROGRAM_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "Program partition: %lu bytes at 0x%lx", (unsigned long)m_partition->size,
+             (unsigned long)m_partition->address);
+
+    const void *mapped = nullptr;
+    esp_err_t err = esp_partition_mmap(m_partition, 0, m_partition->size, ESP_PARTITION_MMAP_DATA, &mapped,
+                                       &m_mapHandle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Cannot map the program partition (%s); reading through the flash driver",
+                 esp_err_to_name(err));
+        return ESP_OK;
+    }
+    m_mapped = static_cast<const uint8_t *>(mapped);
+    return ESP_OK;
+}
+
+size_t PartitionProgramStorage::GetSize() const
+{
+    return (m_partition != nullptr) ? m_partition->size : 0;
+}
+
+size_t PartitionProgramStorage::GetEraseSize() const
+{
+    return (m_partition != nullptr) ? m_partition->erase_size : 0;
+}
+
+esp_err_t PartitionProgramStorage::Read(size_t offset, void *data, size_t length)
+{
+    if (m_partition == nullptr)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (m_mapped == nullptr)
+    {
+        return esp_partition_read(m_partition, offset, data, length);
+    }
+    if (offset > m_partition->size || length > m_partition->size - offset)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    std::memcpy(data, m_mapped + offset, length);
+    return ESP_OK;
+}
+
+esp_err_t PartitionProgramStorage::Write(size_t offset, const void *data, size_t length)
+{
+    if (m_partition == nullptr)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return esp_partition_write(m_partition, offset, data, length);
+}
+
+esp_err_t PartitionProgramStorage::Erase(size_t offset, size_t length)
+{
+    if (m_partition == nullptr)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return esp_partition_erase_range(m_partition, offset, length);
+}
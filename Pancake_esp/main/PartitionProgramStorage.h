@@ -0,0 +1,35 @@
+#ifndef PARTITION_PROGRAM_STORAGE_H
+#define PARTITION_PROGRAM_STORAGE_H
+
+#include "esp_partition.h"
+
+#include "ProgramStorage.h"
+
+// Custom data subtype and label of the program partition in partitions.csv.
+constexpr esp_partition_subtype_t PROGRAM_PARTITION_SUBTYPE = static_cast<esp_partition_subtype_t>(0x40);
+constexpr const char *PROGRAM_PARTITION_LABEL = "programs";
+
+// Program storage on the "programs" flash data partition. Reads come through a memory mapping of
+// the partition, so the feeder reading a running program never takes the flash driver, which
+// turns the cache off for both cores while it works. Writes and erases still do; the flash driver
+// flushes the mapped range after each, so reads see what was written.
+class PartitionProgramStorage : public ProgramStorage
+{
+  public:
+    // ESP_ERR_NOT_FOUND if the partition table has no program partition.
+    esp_err_t Init();
+
+    size_t GetSize() const override;
+    size_t GetEraseSize() const override;
+    esp_err_t Read(size_t offset, void *data, size_t length) override;
+    esp_err_t Write(size_t offset, const void *data, size_t length) override;
+    esp_err_t Erase(size_t offset, size_t length) override;
+
+  private:
+    const esp_partition_t *m_partition = nullptr;
+    // The whole partition, mapped by Init; null if mapping failed and reads go to the driver.
+    const uint8_t *m_mapped = nullptr;
+    esp_partition_mmap_handle_t m_mapHandle = 0;
+};
+
+#endif // PARTITION_PROGRAM_STORAGE_H
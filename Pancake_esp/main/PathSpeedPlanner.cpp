@@ -0,0 +1,240 @@
+#include "PathSpeedPlanner.h"
+
+#include <cmath>
+
+namespace
+{
+constexpr int kBisectionSteps = 20;
+// Squared speed used when neither joint limits it, i.e. 100 m/s.
+constexpr float kUnboundedSpeedSquared_m2ps2 = 1.0e4f;
+
+// Joint angle per metre of path (q') and its rate of change (q'') at one point.
+struct JointDerivatives
+{
+    float first_degpm[2];
+    float second_degpm2[2];
+};
+
+// Range of path acceleration that keeps both joints within their accel limits at squared path
+// speed u. False if there is none, i.e. u is above what the joints can hold on this curve.
+bool PathAccelBounds(const JointDerivatives &d, const float accel_degps2[2], float u,
+                     float &lower_mps2, float &upper_mps2)
+{
+    lower_mps2 = -INFINITY;
+    upper_mps2 = INFINITY;
+    for (int j = 0; j < 2; j++)
+    {
+        float curvatureAccel_degps2 = d.second_degpm2[j] * u;
+        if (fabsf(d.first_degpm[j]) < 1.0e-6f)
+        {
+            if (fabsf(curvatureAccel_degps2) > accel_degps2[j])
+            {
+                return false;
+            }
+            continue;
+        }
+
+        float a = (-accel_degps2[j] - curvatureAccel_degps2) / d.first_degpm[j];
+        float b = (accel_degps2[j] - curvatureAccel_degps2) / d.first_degpm[j];
+        lower_mps2 = fmaxf(lower_mps2, fminf(a, b));
+        upper_mps2 = fminf(upper_mps2, fmaxf(a, b));
+    }
+    return lower_mps2 <= upper_mps2;
+}
+
+// Largest squared path speed at one point within the joint speed and accel limits. Joint j
+// allows path accelerations within +/-A_j/|q'_j| of -(q''_j/q'_j) u, so the two joints agree
+// until their centres drift apart by the sum of their half-widths.
+float MaxSpeedSquared(const JointDerivatives &d, const float speed_degps[2],
+                      const float accel_degps2[2])
+{
+    float uMax = kUnboundedSpeedSquared_m2ps2;
+    float halfWidth_mps2[2] = {0.0f, 0.0f};
+    float slope_m2[2] = {0.0f, 0.0f};
+    bool constrains[2] = {false, false};
+    for (int j = 0; j < 2; j++)
+    {
+        float rate_degpm = fabsf(d.first_degpm[j]);
+        if (rate_degpm < 1.0e-6f)
+        {
+            // A joint that is not moving along the path only feels the curvature term.
+            float curvature_degpm2 = fabsf(d.second_degpm2[j]);
+            if (curvature_degpm2 > 1.0e-6f)
+            {
+                uMax = fminf(uMax, accel_degps2[j] / curvature_degpm2);
+            }
+            continue;
+        }
+
+        float v_mps = speed_degps[j] / rate_degpm;
+        uMax = fminf(uMax, v_mps * v_mps);
+        halfWidth_mps2[j] = accel_degps2[j] / rate_degpm;
+        slope_m2[j] = -d.second_degpm2[j] / d.first_degpm[j];
+        constrains[j] = true;
+    }
+
+    float slopeGap_m2 = fabsf(slope_m2[0] - slope_m2[1]);
+    if (constrains[0] && constrains[1] && slopeGap_m2 > 0.0f)
+    {
+        uMax = fminf(uMax, (halfWidth_mps2[0] + halfWidth_mps2[1]) / slopeGap_m2);
+    }
+    return uMax;
+}
+
+float UnwrapNear(float angle_deg, float reference_deg)
+{
+    float delta_deg = angle_deg - reference_deg;
+    return reference_deg + delta_deg - 360.0f * roundf(delta_deg / 360.0f);
+}
+} // namespace
+
+bool PathSpeedPlan::Plan(const Vector2D *points, size_t pointCount, float pointSpacing_m,
+                         float entrySpeed_mps, float exitSpeed_mps, const PathJointLimits &limits)
+{
+    count = 0;
+    if (points == nullptr || pointCount < 2 || pointCount > PATH_SPEED_MAX_POINTS ||
+        !(pointSpacing_m > 0.0f))
+    {
+        return false;
+    }
+
+    const int branch = static_cast<int>(limits.elbow);
+    float s0_deg[PATH_SPEED_MAX_POINTS];
+    float s1_deg[PATH_SPEED_MAX_POINTS];
+    for (size_t i = 0; i < pointCount; i++)
+    {
+        float branchS0_deg[2];
+        float branchS1_deg[2];
+        if (CartToAngBothBranches(branchS0_deg, branchS1_deg, points[i]) != E_OK)
+        {
+            return false;
+        }
+        s0_deg[i] = (i == 0) ? branchS0_deg[branch] : UnwrapNear(branchS0_deg[branch], s0_deg[i - 1]);
+        s1_deg[i] = (i == 0) ? branchS1_deg[branch] : UnwrapNear(branchS1_deg[branch], s1_deg[i - 1]);
+    }
+
+    const float speed_degps[2] = {limits.s0Speed_degps, limits.s1Speed_degps};
+    const float accel_degps2[2] = {limits.s0Accel_degps2, limits.s1Accel_degps2};
+    const float *joint_deg[2] = {s0_deg, s1_deg};
+    JointDerivatives derivatives[PATH_SPEED_MAX_POINTS];
+    float maxSpeedSquared[PATH_SPEED_MAX_POINTS];
+    for (size_t i = 0; i < pointCount; i++)
+    {
+        size_t prev = (i > 0) ? i - 1 : 0;
+        size_t next = (i + 1 < pointCount) ? i + 1 : i;
+        // Second differences need three points; the ends reuse their neighbour's.
+        size_t mid = (i == 0) ? 1 : ((i + 1 == pointCount) ? i - 1 : i);
+        for (int j = 0; j < 2; j++)
+        {
+            const float *q = joint_deg[j];
+            derivatives[i].first_degpm[j] =
+                (q[next] - q[prev]) / (static_cast<float>(next - prev) * pointSpacing_m);
+            derivatives[i].second_degpm2[j] =
+                (pointCount < 3) ? 0.0f
+                                 : (q[mid + 1] - 2.0f * q[mid] + q[mid - 1]) /
+                                       (pointSpacing_m * pointSpacing_m);
+        }
+        maxSpeedSquared[i] = MaxSpeedSquared(derivatives[i], speed_degps, accel_degps2);
+    }
+
+    // Forward: accelerate as hard as the joints allow from the entry speed.
+    float entrySquared = entrySpeed_mps * entrySpeed_mps;
+    speedSquared_m2ps2[0] = fminf(entrySquared, maxSpeedSquared[0]);
+    for (size_t i = 0; i + 1 < pointCount; i++)
+    {
+        float lower_mps2 = 0.0f;
+        float upper_mps2 = 0.0f;
+        if (!PathAccelBounds(derivatives[i], accel_degps2, speedSquared_m2ps2[i], lower_mps2, upper_mps2))
+        {
+            upper_mps2 = 0.0f;
+        }
+        float reachable = speedSquared_m2ps2[i] + 2.0f * upper_mps2 * pointSpacing_m;
+        speedSquared_m2ps2[i + 1] = fminf(maxSpeedSquared[i + 1], fmaxf(reachable, 0.0f));
+    }
+
+    // Backward: every point must be able to brake into the next one with an acceleration the
+    // joints allow at that point and speed. Braking gets easier as the speed drops, so bisect
+    // for the fastest speed that still makes it.
+    if (exitSpeed_mps >= 0.0f)
+    {
+        speedSquared_m2ps2[pointCount - 1] =
+            fminf(speedSquared_m2ps2[pointCount - 1], exitSpeed_mps * exitSpeed_mps);
+    }
+    for (size_t i = pointCount - 1; i > 0; i--)
+    {
+        const JointDerivatives &d = derivatives[i - 1];
+        const float next = speedSquared_m2ps2[i];
+        auto canBrake = [&](float u)
+        {
+            float lower_mps2 = 0.0f;
+            float upper_mps2 = 0.0f;
+            return PathAccelBounds(d, accel_degps2, u, lower_mps2, upper_mps2) &&
+                   u + 2.0f * lower_mps2 * pointSpacing_m <= next;
+        };
+        if (canBrake(speedSquared_m2ps2[i - 1]))
+        {
+            continue;
+        }
+
+        float lo = 0.0f;
+        float hi = speedSquared_m2ps2[i - 1];
+        for (int step = 0; step < kBisectionSteps; step++)
+        {
+            float mid = 0.5f * (lo + hi);
+            if (canBrake(mid))
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        speedSquared_m2ps2[i - 1] = lo;
+    }
+
+    count = pointCount;
+    spacing_m = pointSpacing_m;
+    return true;
+}
+
+float PathSpeedPlan::GetSpeed_mps(float distance_m) const
+{
+    if (count == 0)
+    {
+        return INFINITY;
+    }
+
+    float position = fmaxf(distance_m, 0.0f) / spacing_m;
+    size_t i = static_cast<size_t>(position);
+    if (i + 1 >= count)
+    {
+        return sqrtf(speedSquared_m2ps2[count - 1]);
+    }
+
+    float fraction = position - static_cast<float>(i);
+    return sqrtf(speedSquared_m2ps2[i] + fraction * (speedSquared_m2ps2[i + 1] - speedSquared_m2ps2[i]));
+}
+
+float PathSpeedPlan::GetStepSpeed_mps(float dt_s) const
+{
+    if (count == 0)
+    {
+        return INFINITY;
+    }
+
+    // With the squared speed linear between points, v^2 = u_i + k (v dt - i spacing) is a
+    // quadratic in v; take the first interval whose solution lands inside it.
+    for (size_t i = 0; i + 1 < count; i++)
+    {
+        float k = (speedSquared_m2ps2[i + 1] - speedSquared_m2ps2[i]) / spacing_m;
+        float c = speedSquared_m2ps2[i] - k * static_cast<float>(i) * spacing_m;
+        float kdt = k * dt_s;
+        float v_mps = 0.5f * (kdt + sqrtf(fmaxf(kdt * kdt + 4.0f * c, 0.0f)));
+        if (v_mps * dt_s <= static_cast<float>(i + 1) * spacing_m)
+        {
+            return v_mps;
+        }
+    }
+    return sqrtf(speedSquared_m2ps2[count - 1]);
+}
@@ -0,0 +1,56 @@
+#ifndef PATH_SPEED_PLANNER_H
+#define PATH_SPEED_PLANNER_H
+
+#include <cstddef>
+
+#include "PanMath.h"
+#include "Vector2D.h"
+
+// Fastest path speed along a stretch of Cartesian path that keeps both joints within their speed
+// and acceleration limits (time-optimal path parameterisation). The path is given as points an
+// equal arc length apart; joint velocity and acceleration per unit of path speed come from finite
+// differences of the inverse kinematics there. Along the path a joint's acceleration is
+// q' * (path accel) + q'' * (path speed)^2, so near full extension or minimum reach, where q' and
+// q'' grow, the joints cap the path speed well below what the guidance asks for.
+//
+// The planner bounds the squared speed at each point by the joint speed limits and by the
+// largest speed at which some path acceleration still satisfies both joint accel limits, then
+// runs a forward pass accelerating as hard as the joints allow and a backward pass braking as
+// hard as they allow into every later point.
+constexpr size_t PATH_SPEED_MAX_POINTS = 48;
+
+struct PathJointLimits
+{
+    float s0Speed_degps = 0.0f;
+    float s1Speed_degps = 0.0f;
+    float s0Accel_degps2 = 0.0f;
+    float s1Accel_degps2 = 0.0f;
+    ElbowBranch elbow = ElbowBranch::Negative;
+};
+
+class PathSpeedPlan
+{
+  public:
+    // Plan over points[0..count), spaced spacing_m apart, with points[0] where the path speed is
+    // entrySpeed_mps now. The speed at the last point ends at or below exitSpeed_mps; pass a
+    // negative exit speed to leave it free. Returns false for a degenerate or unreachable path, in
+    // which case the plan places no limit on the speed.
+    bool Plan(const Vector2D *points, size_t count, float spacing_m, float entrySpeed_mps,
+              float exitSpeed_mps, const PathJointLimits &limits);
+
+    // Planned speed distance_m along the path.
+    float GetSpeed_mps(float distance_m) const;
+
+    // Speed to run the next dt_s at: the speed v for which the plan allows v at the point v * dt_s
+    // ahead, so a follower that steps its carrot once per cycle tracks the plan from rest.
+    float GetStepSpeed_mps(float dt_s) const;
+
+    bool IsValid() const { return count > 0; }
+
+  private:
+    float speedSquared_m2ps2[PATH_SPEED_MAX_POINTS] = {};
+    size_t count = 0;
+    float spacing_m = 0.0f;
+};
+
+#endif // PATH_SPEED_PLANNER_H
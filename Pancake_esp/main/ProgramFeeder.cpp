@@ -0,0 +1,121 @@
+#include "ProgramFeeder.h"
+
+#include "esp_log.h"
+
+#include "CNCOpCodes.h"
+
+static const char *TAG = "ProgramFeeder";
+
+ProgramFeeder::ProgramFeeder(ProgramStore &store, CommandSlab &slab, QueueHandle_t cncQueue)
+    : store(store), slab(slab), cncQueue(cncQueue)
+{
+    m_Mux = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool ProgramFeeder::Start(const StoredProgram &storedProgram)
+{
+    portENTER_CRITICAL(&m_Mux);
+    const bool idle = state.load() == FeedState::Idle;
+    if (idle)
+    {
+        requestedProgram = storedProgram;
+        state.store(FeedState::Starting);
+    }
+    portEXIT_CRITICAL(&m_Mux);
+    return idle;
+}
+
+void ProgramFeeder::Cancel()
+{
+    portENTER_CRITICAL(&m_Mux);
+    state.store(FeedState::Idle);
+    portEXIT_CRITICAL(&m_Mux);
+}
+
+size_t ProgramFeeder::Feed(uint32_t queueClearCount)
+{
+    portENTER_CRITICAL(&m_Mux);
+    if (state.load() == FeedState::Starting)
+    {
+        program = requestedProgram;
+        offset = 0;
+        startClearCount = queueClearCount;
+        state.store(FeedState::Running);
+    }
+    portEXIT_CRITICAL(&m_Mux);
+
+    if (state.load() == FeedState::Running && queueClearCount != startClearCount)
+    {
+        ESP_LOGW(TAG, "CNC queue cleared; abandoning program %08lx at byte %u", (unsigned long)program.hash,
+                 (unsigned)offset);
+        Stop();
+    }
+
+    size_t queued = 0;
+    while (state.load() == FeedState::Running && offset < program.length &&
+           uxQueueMessagesWaiting(cncQueue) < PROGRAM_FEED_QUEUE_AHEAD)
+    {
+        uint8_t header[2];
+        if (store.Read(program, offset, header, sizeof(header)) != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Read failed at byte %u of program %08lx; stopping it", (unsigned)offset,
+                     (unsigned long)program.hash);
+            Stop();
+            break;
+        }
+
+        const size_t length = 2 + header[1];
+        if (slab.GetFreeBytes() < length + PROGRAM_FEED_SLAB_RESERVE_BYTES)
+        {
+            break;
+        }
+        uint8_t *instructions = nullptr;
+        cmd_handle_t handle = slab.Allocate(0, length, instructions);
+        if (handle == CMD_HANDLE_INVALID)
+        {
+            break;
+        }
+        if (store.Read(program, offset, instructions, length) != ESP_OK)
+        {
+            slab.Release(handle);
+            ESP_LOGE(TAG, "Read failed at byte %u of program %08lx; stopping it", (unsigned)offset,
+                     (unsigned long)program.hash);
+            Stop();
+            break;
+        }
+
+        if (!IsCncOpcode(instructions[0]))
+        {
+            ESP_LOGW(TAG, "Skipping non-CNC opcode 0x%02X in program %08lx", instructions[0],
+                     (unsigned long)program.hash);
+            slab.Release(handle);
+            offset += length;
+            continue;
+        }
+        if (xQueueSend(cncQueue, &handle, 0) != pdTRUE)
+        {
+            slab.Release(handle);
+            break;
+        }
+        offset += length;
+        queued++;
+    }
+
+    if (state.load() == FeedState::Running && offset >= program.length)
+    {
+        ESP_LOGI(TAG, "Program %08lx fully queued", (unsigned long)program.hash);
+        Stop();
+    }
+    return queued;
+}
+
+void ProgramFeeder::Stop()
+{
+    // Only the running program: a Cancel and a new Start may already have replaced it.
+    portENTER_CRITICAL(&m_Mux);
+    if (state.load() == FeedState::Running)
+    {
+        state.store(FeedState::Idle);
+    }
+    portEXIT_CRITICAL(&m_Mux);
+}
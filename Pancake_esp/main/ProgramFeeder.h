@@ -0,0 +1,76 @@
+#ifndef PROGRAM_FEEDER_H
+#define PROGRAM_FEEDER_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+#include "CommandSlab.h"
+#include "ProgramStore.h"
+
+// Instructions a running stored program keeps queued ahead of the controller. Enough to cover
+// the look-ahead window and a few control cycles; more would only delay a stop.
+constexpr UBaseType_t PROGRAM_FEED_QUEUE_AHEAD = 16;
+// Slab bytes the feeder leaves free, so commands arriving over the network, a stop among them,
+// still find room while a long program runs.
+constexpr size_t PROGRAM_FEED_SLAB_RESERVE_BYTES = 2048;
+
+// Streams a stored program into the CNC queue as fast as the controller takes it: each Feed
+// tops the queue up to PROGRAM_FEED_QUEUE_AHEAD instructions, reading them from flash into slab
+// records exactly as CommandHandler would have queued them off the network.
+//
+// Feed runs on the control task, after each cycle, with that cycle's count of CNC queue clears
+// (cncQueueClearCount in control_tlm_t). A stop or limit stop clears the queue; a feeder that
+// sees the count change stops too, instead of refilling the queue with the rest of the program.
+// Running on the task that clears the queue means no instruction can be sent between a clear and
+// the count that reports it. Start and Cancel come from the command task and only post requests
+// that the next Feed acts on; an instruction sent after a Cancel is still ahead of the stop that
+// follows it, which the control task drains first.
+class ProgramFeeder
+{
+  public:
+    ProgramFeeder(ProgramStore &store, CommandSlab &slab, QueueHandle_t cncQueue);
+
+    ProgramFeeder(const ProgramFeeder &) = delete;
+    ProgramFeeder &operator=(const ProgramFeeder &) = delete;
+
+    // Run a program from the next Feed. False if one is already running or about to start.
+    // One task only.
+    bool Start(const StoredProgram &program);
+    // Stop feeding; the next Feed queues nothing more. Any task.
+    void Cancel();
+    // True from Start until the program has been queued in full or abandoned.
+    bool IsRunning() const { return state.load() != FeedState::Idle; }
+
+    // Queue what fits of the rest of the program. Returns the number of instructions queued.
+    // Control task only.
+    size_t Feed(uint32_t queueClearCount);
+
+  private:
+    enum class FeedState : uint8_t
+    {
+        Idle,
+        Starting,
+        Running,
+    };
+
+    // Running -> Idle, from Feed.
+    void Stop();
+
+    ProgramStore &store;
+    CommandSlab &slab;
+    QueueHandle_t cncQueue;
+
+    // Start's request, handed to Feed under m_Mux along with the state changes.
+    StoredProgram requestedProgram;
+    // Feed's own copy of the running program.
+    StoredProgram program;
+    size_t offset = 0;
+    uint32_t startClearCount = 0;
+    std::atomic<FeedState> state{FeedState::Idle};
+    portMUX_TYPE m_Mux;
+};
+
+#endif // PROGRAM_FEEDER_H
@@ -0,0 +1,126 @@
+#include "ProgramPacket.h"
+
+#include "CNCOpCodes.h"
+
+namespace
+{
+// Nibble table for the reflected IEEE polynomial 0xEDB88320: 64 bytes instead of 1 KiB, and
+// a program is checked once on arrival, so the extra shift per byte does not matter.
+constexpr uint32_t kCrcNibbleTable[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint16_t ReadU16(const uint8_t *data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t ReadU32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+} // namespace
+
+uint32_t ProgramCrc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ kCrcNibbleTable[crc & 0x0F];
+        crc = (crc >> 4) ^ kCrcNibbleTable[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+size_t GetProgramPacketLength(const uint8_t *packet, size_t available)
+{
+    if (available < 2 + PROGRAM_HEADER_LEN || packet[0] != CNC_PROGRAM_OPCODE ||
+        packet[1] != PROGRAM_HEADER_LEN)
+    {
+        return 0;
+    }
+    return 2 + PROGRAM_HEADER_LEN + ReadU16(packet + 6);
+}
+
+ProgramPacketStatus ParseProgramPacket(const uint8_t *packet, size_t length, ProgramPacket &program)
+{
+    size_t packetLength = GetProgramPacketLength(packet, length);
+    if (packetLength == 0)
+    {
+        return (length < 2 + PROGRAM_HEADER_LEN) ? ProgramPacketStatus::Truncated : ProgramPacketStatus::BadHeader;
+    }
+    if (packetLength != length)
+    {
+        return (packetLength > length) ? ProgramPacketStatus::Truncated : ProgramPacketStatus::BadHeader;
+    }
+
+    ProgramPacket parsed;
+    parsed.sequence = ReadU16(packet + 2);
+    parsed.instruction_count = ReadU16(packet + 4);
+    parsed.body_length = ReadU16(packet + 6);
+    parsed.crc32 = ReadU32(packet + 8);
+    parsed.body = packet + 2 + PROGRAM_HEADER_LEN;
+    if (parsed.instruction_count == 0)
+    {
+        return ProgramPacketStatus::BadHeader;
+    }
+    if (ProgramCrc32(parsed.body, parsed.body_length) != parsed.crc32)
+    {
+        return ProgramPacketStatus::BadCrc;
+    }
+
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset < parsed.body_length)
+    {
+        size_t remaining = parsed.body_length - offset;
+        if (remaining < 2 || parsed.body[offset + 1] > remaining - 2 ||
+            parsed.body[offset] == CNC_PROGRAM_OPCODE)
+        {
+            return ProgramPacketStatus::BadInstruction;
+        }
+        offset += 2 + parsed.body[offset + 1];
+        count++;
+    }
+    if (count != parsed.instruction_count)
+    {
+        return ProgramPacketStatus::BadInstruction;
+    }
+
+    program = parsed;
+    return ProgramPacketStatus::Ok;
+}
+
+bool NextProgramInstruction(const ProgramPacket &program, size_t &offset, const uint8_t *&instruction,
+                            size_t &instructionLength)
+{
+    if (program.body == nullptr || offset + 2 > program.body_length)
+    {
+        return false;
+    }
+    instruction = program.body + offset;
+    instructionLength = 2 + instruction[1];
+    offset += instructionLength;
+    return true;
+}
+
+const char *ProgramPacketStatusName(ProgramPacketStatus status)
+{
+    switch (status)
+    {
+        case ProgramPacketStatus::Ok:
+            return "ok";
+        case ProgramPacketStatus::Truncated:
+            return "truncated";
+        case ProgramPacketStatus::BadHeader:
+            return "bad header";
+        case ProgramPacketStatus::BadCrc:
+            return "CRC mismatch";
+        case ProgramPacketStatus::BadInstruction:
+            return "malformed instruction";
+    }
+    return "unknown";
+}
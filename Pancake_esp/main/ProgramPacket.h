@@ -0,0 +1,55 @@
+#ifndef PROGRAM_PACKET_H
+#define PROGRAM_PACKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// A program packet carries many CNC instructions in one transport message, so a long drawing
+// arrives in a handful of command rows instead of one row per segment and is either queued
+// whole or not at all. Little-endian layout:
+//
+//   [CNC_PROGRAM_OPCODE][10][u16 sequence][u16 instruction_count][u16 body_length][u32 crc32][body]
+//
+// The length byte covers only the program header, so the packet still splits like any other
+// [opcode][len][payload] record, followed by body_length bytes of body. The body is the
+// instructions back to back, each exactly as it would be sent alone, and crc32 is the IEEE
+// CRC-32 (zlib.crc32) of the body.
+constexpr size_t PROGRAM_HEADER_LEN = 10;
+
+enum class ProgramPacketStatus
+{
+    Ok,
+    Truncated,
+    BadHeader,
+    BadCrc,
+    BadInstruction,
+};
+
+struct ProgramPacket
+{
+    uint16_t sequence = 0;
+    uint16_t instruction_count = 0;
+    uint16_t body_length = 0;
+    uint32_t crc32 = 0;
+    const uint8_t *body = nullptr;
+};
+
+uint32_t ProgramCrc32(const uint8_t *data, size_t length);
+
+// Whole size of the program packet at `packet`, read from its header, or 0 if the `available`
+// bytes do not hold a program header.
+size_t GetProgramPacketLength(const uint8_t *packet, size_t available);
+
+// Validate a complete program packet of `length` bytes: header, CRC, and that the body splits
+// into exactly instruction_count well-formed instructions, none of them another program. On Ok,
+// program points into `packet`; otherwise it is left untouched.
+ProgramPacketStatus ParseProgramPacket(const uint8_t *packet, size_t length, ProgramPacket &program);
+
+// Step through the instructions of a parsed program. Start with offset 0; each call returns the
+// next [opcode][len][payload] instruction and its length, or false past the last one.
+bool NextProgramInstruction(const ProgramPacket &program, size_t &offset, const uint8_t *&instruction,
+                            size_t &instructionLength);
+
+const char *ProgramPacketStatusName(ProgramPacketStatus status);
+
+#endif // PROGRAM_PACKET_H
@@ -0,0 +1,25 @@
+#ifndef PROGRAM_STORAGE_H
+#define PROGRAM_STORAGE_H
+
+#include <cstddef>
+
+#include "esp_err.h"
+
+// Raw NOR-flash-like medium behind a ProgramStore: erased bytes read 0xFF, a write can only
+// clear bits, and erases cover whole GetEraseSize() blocks. The target uses a data partition
+// (PartitionProgramStorage); host tests use a file with the same rules.
+class ProgramStorage
+{
+  public:
+    virtual ~ProgramStorage() {}
+
+    virtual size_t GetSize() const = 0;
+    virtual size_t GetEraseSize() const = 0;
+
+    virtual esp_err_t Read(size_t offset, void *data, size_t length) = 0;
+    virtual esp_err_t Write(size_t offset, const void *data, size_t length) = 0;
+    // offset and length must be multiples of GetEraseSize().
+    virtual esp_err_t Erase(size_t offset, size_t length) = 0;
+};
+
+#endif // PROGRAM_STORAGE_H
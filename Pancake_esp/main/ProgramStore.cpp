@@ -0,0 +1,244 @@
+#include "ProgramStore.h"
+
+#include <cstring>
+
+namespace
+{
+constexpr uint32_t kSlotMagic = 0x314D4750; // "PGM1"
+constexpr uint32_t kFnvPrime = 16777619u;
+constexpr size_t kReadChunkBytes = 64;
+} // namespace
+
+uint32_t ProgramHash(const uint8_t *data, size_t length, uint32_t hash)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ data[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+const char *ProgramUploadStatusName(ProgramUploadStatus status)
+{
+    switch (status)
+    {
+        case ProgramUploadStatus::Ok:
+            return "ok";
+        case ProgramUploadStatus::AlreadyStored:
+            return "already stored";
+        case ProgramUploadStatus::TooLarge:
+            return "too large";
+        case ProgramUploadStatus::NotUploading:
+            return "no upload in progress";
+        case ProgramUploadStatus::OutOfOrder:
+            return "chunk out of order";
+        case ProgramUploadStatus::BadHash:
+            return "hash mismatch";
+        case ProgramUploadStatus::Malformed:
+            return "malformed instructions";
+        case ProgramUploadStatus::StorageError:
+            return "storage error";
+    }
+    return "unknown";
+}
+
+ProgramStore::ProgramStore(ProgramStorage &storage) : storage(storage)
+{
+    // Slots must start on erase blocks so that erasing one never touches its neighbour.
+    size_t eraseSize = storage.GetEraseSize();
+    if (eraseSize > 0 && PROGRAM_SLOT_BYTES % eraseSize == 0)
+    {
+        slotCount = storage.GetSize() / PROGRAM_SLOT_BYTES;
+    }
+}
+
+size_t ProgramStore::GetMaxProgramLength() const
+{
+    return PROGRAM_SLOT_BYTES - sizeof(SlotHeader);
+}
+
+bool ProgramStore::ReadHeader(size_t slot, SlotHeader &header)
+{
+    return storage.Read(SlotOffset(slot), &header, sizeof(header)) == ESP_OK && header.magic == kSlotMagic &&
+           header.length > 0 && header.length <= GetMaxProgramLength();
+}
+
+bool ProgramStore::Find(uint32_t hash, uint32_t length, StoredProgram &program)
+{
+    for (size_t slot = 0; slot < slotCount; slot++)
+    {
+        SlotHeader header;
+        if (ReadHeader(slot, header) && header.hash == hash && header.length == length)
+        {
+            program.slot = slot;
+            program.hash = hash;
+            program.length = length;
+            return true;
+        }
+    }
+    return false;
+}
+
+ProgramUploadStatus ProgramStore::BeginUpload(uint32_t hash, uint32_t length)
+{
+    uploadState = UploadState::Idle;
+    StoredProgram existing;
+    if (Find(hash, length, existing))
+    {
+        uploadState = UploadState::Skipping;
+        uploadHash = hash;
+        return ProgramUploadStatus::AlreadyStored;
+    }
+    if (length == 0 || length > GetMaxProgramLength() || slotCount == 0)
+    {
+        return ProgramUploadStatus::TooLarge;
+    }
+
+    // An empty slot if there is one, else the one written longest ago.
+    size_t slot = 0;
+    bool haveEmpty = false;
+    uint32_t oldestGeneration = UINT32_MAX;
+    for (size_t i = 0; i < slotCount && !haveEmpty; i++)
+    {
+        SlotHeader header;
+        if (!ReadHeader(i, header))
+        {
+            slot = i;
+            haveEmpty = true;
+        }
+        else if (header.generation < oldestGeneration)
+        {
+            oldestGeneration = header.generation;
+            slot = i;
+        }
+    }
+
+    if (storage.Erase(SlotOffset(slot), PROGRAM_SLOT_BYTES) != ESP_OK)
+    {
+        return ProgramUploadStatus::StorageError;
+    }
+    uploadState = UploadState::Writing;
+    uploadSlot = slot;
+    uploadHash = hash;
+    uploadLength = length;
+    uploadWritten = 0;
+    return ProgramUploadStatus::Ok;
+}
+
+ProgramUploadStatus ProgramStore::WriteChunk(uint32_t offset, const uint8_t *data, size_t length)
+{
+    if (uploadState == UploadState::Skipping)
+    {
+        return ProgramUploadStatus::AlreadyStored;
+    }
+    if (uploadState != UploadState::Writing)
+    {
+        return ProgramUploadStatus::NotUploading;
+    }
+    if (offset != uploadWritten || length > uploadLength - uploadWritten)
+    {
+        AbortUpload();
+        return ProgramUploadStatus::OutOfOrder;
+    }
+    if (storage.Write(SlotOffset(uploadSlot) + sizeof(SlotHeader) + offset, data, length) != ESP_OK)
+    {
+        AbortUpload();
+        return ProgramUploadStatus::StorageError;
+    }
+    uploadWritten += static_cast<uint32_t>(length);
+    return ProgramUploadStatus::Ok;
+}
+
+bool ProgramStore::CheckStoredProgram(size_t slot, uint32_t length, uint32_t &hash)
+{
+    const size_t base = SlotOffset(slot) + sizeof(SlotHeader);
+    uint8_t buffer[kReadChunkBytes];
+    hash = ProgramHash(nullptr, 0);
+    for (size_t offset = 0; offset < length; offset += kReadChunkBytes)
+    {
+        size_t chunk = (length - offset < kReadChunkBytes) ? length - offset : kReadChunkBytes;
+        if (storage.Read(base + offset, buffer, chunk) != ESP_OK)
+        {
+            return false;
+        }
+        hash = ProgramHash(buffer, chunk, hash);
+    }
+
+    // Follow the length bytes: the program must split into whole instructions.
+    size_t offset = 0;
+    while (offset < length)
+    {
+        uint8_t payloadLength = 0;
+        if (length - offset < 2 || storage.Read(base + offset + 1, &payloadLength, 1) != ESP_OK)
+        {
+            return false;
+        }
+        offset += 2 + payloadLength;
+    }
+    return offset == length;
+}
+
+ProgramUploadStatus ProgramStore::CommitUpload(uint32_t hash)
+{
+    if (uploadState == UploadState::Skipping && hash == uploadHash)
+    {
+        uploadState = UploadState::Idle;
+        return ProgramUploadStatus::AlreadyStored;
+    }
+    if (uploadState != UploadState::Writing || hash != uploadHash)
+    {
+        AbortUpload();
+        return ProgramUploadStatus::NotUploading;
+    }
+    if (uploadWritten != uploadLength)
+    {
+        AbortUpload();
+        return ProgramUploadStatus::OutOfOrder;
+    }
+
+    uint32_t storedHash = 0;
+    if (!CheckStoredProgram(uploadSlot, uploadLength, storedHash))
+    {
+        AbortUpload();
+        return ProgramUploadStatus::Malformed;
+    }
+    if (storedHash != uploadHash)
+    {
+        AbortUpload();
+        return ProgramUploadStatus::BadHash;
+    }
+
+    uint32_t newestGeneration = 0;
+    for (size_t slot = 0; slot < slotCount; slot++)
+    {
+        SlotHeader header;
+        if (slot != uploadSlot && ReadHeader(slot, header) && header.generation > newestGeneration)
+        {
+            newestGeneration = header.generation;
+        }
+    }
+
+    SlotHeader header = {kSlotMagic, uploadHash, uploadLength, newestGeneration + 1};
+    uploadState = UploadState::Idle;
+    if (storage.Write(SlotOffset(uploadSlot), &header, sizeof(header)) != ESP_OK)
+    {
+        return ProgramUploadStatus::StorageError;
+    }
+    return ProgramUploadStatus::Ok;
+}
+
+void ProgramStore::AbortUpload()
+{
+    // The slot keeps no header, so whatever was written is never found and the slot counts as
+    // empty for the next upload.
+    uploadState = UploadState::Idle;
+}
+
+esp_err_t ProgramStore::Read(const StoredProgram &program, size_t offset, uint8_t *data, size_t length)
+{
+    if (program.slot >= slotCount || offset > program.length || length > program.length - offset)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return storage.Read(SlotOffset(program.slot) + sizeof(SlotHeader) + offset, data, length);
+}
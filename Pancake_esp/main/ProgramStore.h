@@ -0,0 +1,101 @@
+#ifndef PROGRAM_STORE_H
+#define PROGRAM_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ProgramStorage.h"
+
+// Compiled programs kept on the device, so a drawing is uploaded once and afterwards runs from
+// flash instead of from InfluxDB. A program is the same concatenated [opcode][len][payload]
+// stream `CommandTerminal.py compile` writes, named by its FNV-1a hash; an upload of a program
+// that is already stored is skipped.
+//
+// Storage is split into equal slots, PROGRAM_SLOT_BYTES each. A slot starts with a header
+// naming the program it holds and the program bytes follow. An upload erases the slot, writes
+// the bytes, checks them back against the hash, and writes the header last, so a program cut
+// off mid-upload or by a reset is never found. New uploads reuse an empty slot or else the
+// oldest one.
+constexpr size_t PROGRAM_SLOT_BYTES = 16384;
+
+struct StoredProgram
+{
+    size_t slot = 0;
+    uint32_t hash = 0;
+    uint32_t length = 0;
+};
+
+enum class ProgramUploadStatus
+{
+    Ok,
+    AlreadyStored,
+    TooLarge,
+    NotUploading,
+    OutOfOrder,
+    BadHash,
+    Malformed,
+    StorageError,
+};
+
+uint32_t ProgramHash(const uint8_t *data, size_t length, uint32_t hash = 2166136261u);
+
+const char *ProgramUploadStatusName(ProgramUploadStatus status);
+
+class ProgramStore
+{
+  public:
+    explicit ProgramStore(ProgramStorage &storage);
+
+    ProgramStore(const ProgramStore &) = delete;
+    ProgramStore &operator=(const ProgramStore &) = delete;
+
+    size_t GetSlotCount() const { return slotCount; }
+    size_t GetMaxProgramLength() const;
+
+    bool Find(uint32_t hash, uint32_t length, StoredProgram &program);
+
+    // Start uploading a program of `length` bytes. AlreadyStored when it is stored already, in
+    // which case the chunks and commit that follow are accepted and ignored.
+    ProgramUploadStatus BeginUpload(uint32_t hash, uint32_t length);
+    // Chunks must arrive in order, each starting where the last ended.
+    ProgramUploadStatus WriteChunk(uint32_t offset, const uint8_t *data, size_t length);
+    // Check the whole program and make it findable. Ok or AlreadyStored on success.
+    ProgramUploadStatus CommitUpload(uint32_t hash);
+    void AbortUpload();
+    bool IsUploading() const { return uploadState == UploadState::Writing; }
+
+    // Read program bytes [offset, offset + length).
+    esp_err_t Read(const StoredProgram &program, size_t offset, uint8_t *data, size_t length);
+
+  private:
+    enum class UploadState
+    {
+        Idle,
+        Writing,
+        Skipping,
+    };
+
+    struct SlotHeader
+    {
+        uint32_t magic;
+        uint32_t hash;
+        uint32_t length;
+        uint32_t generation;
+    };
+
+    bool ReadHeader(size_t slot, SlotHeader &header);
+    size_t SlotOffset(size_t slot) const { return slot * PROGRAM_SLOT_BYTES; }
+    // Hash and instruction framing of a slot's bytes as read back from storage.
+    bool CheckStoredProgram(size_t slot, uint32_t length, uint32_t &hash);
+
+    ProgramStorage &storage;
+    size_t slotCount = 0;
+
+    UploadState uploadState = UploadState::Idle;
+    size_t uploadSlot = 0;
+    uint32_t uploadHash = 0;
+    uint32_t uploadLength = 0;
+    uint32_t uploadWritten = 0;
+};
+
+#endif // PROGRAM_STORE_H
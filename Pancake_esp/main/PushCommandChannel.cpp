@@ -0,0 +1,175 @@
+#include "PushCommandChannel.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/time.h>
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+#include "CNCOpCodes.h"
+#include "CommandFrameReader.h"
+#include "CommandHandler.h"
+#include "WifiHandler.h"
+
+static const char *TAG = "PushCommandChannel";
+
+// How long a frame waits before retrying the decode queue or the slab. While the decode queue is
+// full the task stops reading and TCP holds the ground station back. A full slab refuses motion
+// frames, as a full CNC queue does; only pause, resume and stop wait for slab room.
+static constexpr TickType_t PUSH_CMD_RETRY_TICKS = pdMS_TO_TICKS(10);
+
+static CommandFrameReader push_frame_reader;
+
+static int64_t now_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + (int64_t)tv.tv_usec / 1000;
+}
+
+static int connect_to_ground_station(void)
+{
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", PUSH_CMD_PORT);
+
+    struct addrinfo *address = nullptr;
+    if (getaddrinfo(PUSH_CMD_HOST, port, &hints, &address) != 0 || address == nullptr)
+    {
+        ESP_LOGW(TAG, "Cannot resolve %s", PUSH_CMD_HOST);
+        return -1;
+    }
+    int sock = socket(address->ai_family, address->ai_socktype, 0);
+    if (sock >= 0 && connect(sock, address->ai_addr, address->ai_addrlen) != 0)
+    {
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(address);
+    if (sock < 0)
+    {
+        return -1;
+    }
+
+    // Commands are small and latency is the point. Keepalives notice a ground station that went
+    // away without closing, so the channel reconnects instead of waiting on a dead socket.
+    int one = 1;
+    int keepIdle_s = 5;
+    int keepInterval_s = 1;
+    int keepCount = 3;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle_s, sizeof(keepIdle_s));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval_s, sizeof(keepInterval_s));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(keepCount));
+    return sock;
+}
+
+// Copy one frame into the slab and hand it to the decoder, waiting for the decoder if need be.
+// Only an immediate command waits for slab room; anything else is refused when the slab is full,
+// as a full CNC queue refuses it, so frames behind it (a stop among them) are still read.
+static void post_frame(const uint8_t *frame, size_t length)
+{
+    const bool immediate = IsImmediateOpcode(frame[0]);
+    bool warned = false;
+    for (;;)
+    {
+        uint8_t *data = nullptr;
+        cmd_handle_t handle = cmd_slab.Allocate(now_ms(), length, data, immediate);
+        if (handle != CMD_HANDLE_INVALID)
+        {
+            memcpy(data, frame, length);
+            if (xQueueSend(cmd_queue_fast_decode, &handle, PUSH_CMD_RETRY_TICKS) == pdTRUE)
+            {
+                return;
+            }
+            cmd_slab.Release(handle);
+        }
+        else if (!immediate)
+        {
+            ESP_LOGW(TAG, "Command slab full; dropping opcode 0x%02X", frame[0]);
+            return;
+        }
+        if (!warned)
+        {
+            ESP_LOGW(TAG, "Command pipeline full; holding the push stream");
+            warned = true;
+        }
+        vTaskDelay(PUSH_CMD_RETRY_TICKS);
+    }
+}
+
+// Read frames until the connection drops or the stream stops making sense.
+static void serve_connection(int sock)
+{
+    uint8_t rx[256];
+    push_frame_reader.Reset();
+    for (;;)
+    {
+        int received = recv(sock, rx, sizeof(rx), 0);
+        if (received <= 0)
+        {
+            ESP_LOGW(TAG, "Ground station connection closed");
+            return;
+        }
+
+        size_t offset = 0;
+        while (offset < (size_t)received)
+        {
+            offset += push_frame_reader.Consume(rx + offset, (size_t)received - offset);
+            if (push_frame_reader.IsBroken())
+            {
+                ESP_LOGE(TAG, "Bad frame on push channel; reconnecting");
+                return;
+            }
+            if (push_frame_reader.HasFrame())
+            {
+                size_t length = 0;
+                const uint8_t *frame = push_frame_reader.GetFrame(length);
+                post_frame(frame, length);
+                push_frame_reader.TakeFrame();
+            }
+        }
+    }
+}
+
+static void PushCommandTask(void *param)
+{
+    (void)param;
+    for (;;)
+    {
+        // Wait for Wi-Fi, then hand the token straight back: the connection is long lived and
+        // must not keep the InfluxDB tasks off the network.
+        if (xSemaphoreTake(WifiAvailableSemaphore, pdMS_TO_TICKS(PUSH_CMD_RECONNECT_MS)) != pdTRUE)
+        {
+            continue;
+        }
+        xSemaphoreGive(WifiAvailableSemaphore);
+
+        int sock = connect_to_ground_station();
+        if (sock >= 0)
+        {
+            ESP_LOGI(TAG, "Connected to ground station %s:%d", PUSH_CMD_HOST, PUSH_CMD_PORT);
+            serve_connection(sock);
+            shutdown(sock, SHUT_RDWR);
+            close(sock);
+        }
+        vTaskDelay(pdMS_TO_TICKS(PUSH_CMD_RECONNECT_MS));
+    }
+}
+
+void PushCommandChannelStart(void)
+{
+    if (PUSH_CMD_HOST[0] == '\0')
+    {
+        ESP_LOGI(TAG, "No PUSH_CMD_HOST set; commands arrive by InfluxDB poll only");
+        return;
+    }
+    xTaskCreate(PushCommandTask, "CmdPush", 3072, NULL, 1, NULL);
+}
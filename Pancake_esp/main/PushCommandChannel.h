@@ -0,0 +1,28 @@
+#ifndef PUSH_COMMAND_CHANNEL_H
+#define PUSH_COMMAND_CHANNEL_H
+
+// Low-latency command path alongside the InfluxDB poll. The device keeps a TCP connection open
+// to the ground station (GroundStation/PushServer.py), which writes commands into it as bare
+// [opcode][len][payload] frames, program packets included. Each frame goes into the command slab
+// and onto cmd_queue_fast_decode the moment it arrives, so a stop or a jog reaches the handler in
+// a round trip rather than a poll period.
+//
+// Nothing else changes: the InfluxDB poll keeps running, so commands written there still arrive
+// while the push channel is down. The ground station sends each command over one path only.
+//
+// PUSH_CMD_HOST and PUSH_CMD_PORT come from Secret.h; with no host set the channel stays off.
+#include "Secret.h"
+
+#ifndef PUSH_CMD_HOST
+#define PUSH_CMD_HOST ""
+#endif
+#ifndef PUSH_CMD_PORT
+#define PUSH_CMD_PORT 8095
+#endif
+
+// Wait between connection attempts while the ground station is not listening.
+#define PUSH_CMD_RECONNECT_MS 2000
+
+void PushCommandChannelStart(void);
+
+#endif // PUSH_COMMAND_CHANNEL_H
@@ -0,0 +1,60 @@
+#ifndef SEGMENT_SPEED_PROFILE_H
+#define SEGMENT_SPEED_PROFILE_H
+
+#include <cmath>
+
+// Path-speed state for guidance that follows a fixed-length segment. With accel_mps2 <= 0 the
+// carrot runs at cruise speed from the first tick, which is the historical stop-start behaviour;
+// the look-ahead planner fills in accel and entry/exit speeds so segments can blend.
+struct SegmentSpeedProfile
+{
+    float cruiseSpeed_mps = 0.0f;
+    float exitSpeed_mps = 0.0f;
+    float accel_mps2 = 0.0f;
+    float currentSpeed_mps = 0.0f;
+    // What the joints can follow here, from PathSpeedPlanner; lowers the cruise speed when set.
+    float speedLimit_mps = INFINITY;
+
+    void Reset(float cruiseSpeed)
+    {
+        cruiseSpeed_mps = cruiseSpeed;
+        exitSpeed_mps = 0.0f;
+        accel_mps2 = 0.0f;
+        currentSpeed_mps = 0.0f;
+        speedLimit_mps = INFINITY;
+    }
+
+    // Advance the path speed by one step and return the distance to travel during it.
+    float Step(float remaining_m, float dt_s)
+    {
+        float cruiseSpeed = (speedLimit_mps < cruiseSpeed_mps) ? speedLimit_mps : cruiseSpeed_mps;
+        if (accel_mps2 <= 0.0f)
+        {
+            currentSpeed_mps = cruiseSpeed;
+            return cruiseSpeed * dt_s;
+        }
+
+        float remaining = (remaining_m > 0.0f) ? remaining_m : 0.0f;
+        float exitSpeed = (exitSpeed_mps < cruiseSpeed) ? exitSpeed_mps : cruiseSpeed;
+        // Fastest speed that, after covering speed * dt this step, can still brake to the exit
+        // speed over what is left: v^2 = exit^2 + 2a(remaining - v*dt).
+        float accelStep_mps = accel_mps2 * dt_s;
+        float brakeBudget = exitSpeed * exitSpeed + 2.0f * accel_mps2 * remaining;
+        float brakeLimited_mps = sqrtf(accelStep_mps * accelStep_mps + brakeBudget) - accelStep_mps;
+
+        float speed_mps = currentSpeed_mps + accel_mps2 * dt_s;
+        if (speed_mps > cruiseSpeed)
+        {
+            speed_mps = cruiseSpeed;
+        }
+        if (speed_mps > brakeLimited_mps)
+        {
+            speed_mps = brakeLimited_mps;
+        }
+
+        currentSpeed_mps = speed_mps;
+        return speed_mps * dt_s;
+    }
+};
+
+#endif // SEGMENT_SPEED_PROFILE_H
@@ -0,0 +1,93 @@
+#ifndef SEQLOCK_SNAPSHOT_H
+#define SEQLOCK_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Latest value of a plain struct, handed from one writer task to any number of reader tasks
+// without a lock. The writer never waits: it bumps the sequence to odd, copies the payload and
+// bumps it back to even. A reader copies the payload between two sequence reads and keeps the
+// copy only if both were the same even number, so it either gets one whole publish or retries.
+//
+// Only one task may call Publish(). Readers may run on either core at any priority; they never
+// hold anything the writer needs.
+template <typename T> class SeqlockSnapshot
+{
+    static_assert(std::is_trivially_copyable<T>::value, "snapshot payload must be a plain struct");
+
+  public:
+    SeqlockSnapshot() : m_Sequence(0)
+    {
+        for (std::atomic<uint32_t> &word : m_Words)
+        {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    SeqlockSnapshot(const SeqlockSnapshot &) = delete;
+    SeqlockSnapshot &operator=(const SeqlockSnapshot &) = delete;
+
+    void Publish(const T &value)
+    {
+        uint32_t words[WORD_COUNT] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint32_t sequence = m_Sequence.load(std::memory_order_relaxed);
+        m_Sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            m_Words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_Sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // One attempt; false if a publish was in progress or landed during the copy.
+    bool TryRead(T &out) const
+    {
+        const uint32_t before = m_Sequence.load(std::memory_order_acquire);
+        if (before & 1u)
+        {
+            return false;
+        }
+
+        uint32_t words[WORD_COUNT];
+        for (size_t i = 0; i < WORD_COUNT; i++)
+        {
+            words[i] = m_Words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_Sequence.load(std::memory_order_relaxed) != before)
+        {
+            return false;
+        }
+
+        std::memcpy(&out, words, sizeof(T));
+        return true;
+    }
+
+    // Retries until it gets a whole publish. A publish takes well under a microsecond and comes
+    // once per control cycle, so this only loops when it races one. A reader that outranks the
+    // writer on the writer's core could spin on a publish it preempted; such a reader should use
+    // TryRead and keep its previous copy instead.
+    void Read(T &out) const
+    {
+        while (!TryRead(out))
+        {
+        }
+    }
+
+    // Even and increasing by 2 per publish; 0 until the first one.
+    uint32_t GetSequence() const { return m_Sequence.load(std::memory_order_acquire); }
+
+  private:
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> m_Sequence;
+    std::atomic<uint32_t> m_Words[WORD_COUNT];
+};
+
+#endif // SEQLOCK_SNAPSHOT_H
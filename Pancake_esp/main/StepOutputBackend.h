@@ -0,0 +1,37 @@
+#ifndef STEP_OUTPUT_BACKEND_H
+#define STEP_OUTPUT_BACKEND_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Pulse generator behind a StepperMotor. The backend owns the step and direction outputs and a
+// periodic source that toggles the step output; the motor only chooses the toggle interval and
+// direction and counts the steps reported back to it.
+class StepOutputBackend
+{
+  public:
+    // Called on every rising step edge. On the target this runs in ISR context, so the handler
+    // must be IRAM-safe and is passed as a plain function pointer rather than a virtual call.
+    // It returns the toggle interval to use from this edge on, or 0 to keep the current one,
+    // which lets the motor ramp the step rate one step at a time.
+    typedef uint64_t (*StepHandler)(void *context);
+
+    virtual ~StepOutputBackend() {}
+
+    // Create the pulse source. `resolution_hz` is the tick rate SetToggleInterval counts in.
+    virtual esp_err_t Init(uint32_t resolution_hz, StepHandler onStep, void *context) = 0;
+
+    // Ticks between step output toggles, i.e. half a step period. Measured from the previous
+    // toggle; an interval that has already elapsed toggles immediately.
+    virtual esp_err_t SetToggleInterval(uint64_t ticks) = 0;
+
+    // ESP_ERR_INVALID_STATE if the pulse source is already running / already stopped.
+    virtual esp_err_t Start() = 0;
+    virtual esp_err_t Stop() = 0;
+
+    // Drive the direction output to `level`; wiring polarity is the caller's concern.
+    virtual void SetDirectionLevel(bool level) = 0;
+};
+
+#endif // STEP_OUTPUT_BACKEND_H
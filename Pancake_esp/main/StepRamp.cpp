@@ -0,0 +1,151 @@
+#include "StepRamp.h"
+
+#include <cmath>
+
+void StepRamp::Configure(uint32_t tickRate_hz, float accel_stepsps2)
+{
+    this->tickRate_hz = tickRate_hz;
+    this->accel_stepsps2 = (std::isfinite(accel_stepsps2) && accel_stepsps2 > 0.0f) ? accel_stepsps2
+                                                                                      : 0.0f;
+
+    // Austin's corrected first step: 0.676 * sqrt(2 / a), the time to cover one step from rest.
+    if (this->accel_stepsps2 > 0.0f)
+    {
+        double firstPeriod_s = 0.676 * std::sqrt(2.0 / this->accel_stepsps2);
+        double firstPeriod_q8 = firstPeriod_s * tickRate_hz * (1u << FRACTION_BITS);
+        firstPeriod_q8 = (firstPeriod_q8 > MAX_PERIOD_Q8) ? MAX_PERIOD_Q8 : firstPeriod_q8;
+        this->firstPeriod_q8 =
+            (firstPeriod_q8 < MIN_PERIOD_Q8) ? MIN_PERIOD_Q8 : static_cast<uint32_t>(firstPeriod_q8);
+    }
+    else
+    {
+        firstPeriod_q8 = MAX_PERIOD_Q8;
+    }
+}
+
+uint32_t StepRamp::PeriodForRate_q8(float rate_stepsps) const
+{
+    if (!std::isfinite(rate_stepsps) || rate_stepsps <= 0.0f)
+    {
+        return 0;
+    }
+
+    double period_q8 = static_cast<double>(tickRate_hz) * (1u << FRACTION_BITS) / rate_stepsps;
+    if (period_q8 > MAX_PERIOD_Q8)
+    {
+        return MAX_PERIOD_Q8;
+    }
+    if (period_q8 < MIN_PERIOD_Q8)
+    {
+        return MIN_PERIOD_Q8;
+    }
+    return static_cast<uint32_t>(period_q8 + 0.5);
+}
+
+void StepRamp::Retarget(float targetRate_stepsps)
+{
+    if (accel_stepsps2 <= 0.0f)
+    {
+        Jump(targetRate_stepsps);
+        return;
+    }
+
+    uint32_t requested_q8 = PeriodForRate_q8(targetRate_stepsps);
+    if (period_q8 == 0)
+    {
+        if (requested_q8 == 0)
+        {
+            return;
+        }
+        // Rates below the first step's need no ramp at all.
+        rampSteps = 0;
+        targetPeriod_q8 = requested_q8;
+        period_q8 = (requested_q8 >= firstPeriod_q8) ? requested_q8 : firstPeriod_q8;
+        mode = (requested_q8 >= firstPeriod_q8) ? 0 : 1;
+        return;
+    }
+
+    uint32_t target_q8 = requested_q8;
+    if (requested_q8 == 0 || requested_q8 > firstPeriod_q8)
+    {
+        if (period_q8 >= firstPeriod_q8)
+        {
+            // Already no faster than the first step: change rate (or hold, for 0) at once.
+            targetPeriod_q8 = (requested_q8 == 0) ? period_q8 : requested_q8;
+            period_q8 = targetPeriod_q8;
+            mode = 0;
+            return;
+        }
+        // Otherwise slow down to the first-step rate first.
+        target_q8 = firstPeriod_q8;
+    }
+
+    // Steps from rest to the current rate: n = v^2 / 2a.
+    double rate_stepsps = static_cast<double>(tickRate_hz) * (1u << FRACTION_BITS) / period_q8;
+    double steps = rate_stepsps * rate_stepsps / (2.0 * accel_stepsps2) + 0.5;
+    steps = (steps > MAX_RAMP_STEPS) ? MAX_RAMP_STEPS : steps;
+    rampSteps = (steps < 1.0) ? 1 : static_cast<int32_t>(steps);
+
+    targetPeriod_q8 = target_q8;
+    mode = (target_q8 < period_q8) ? 1 : ((target_q8 > period_q8) ? -1 : 0);
+}
+
+void StepRamp::Jump(float rate_stepsps)
+{
+    period_q8 = PeriodForRate_q8(rate_stepsps);
+    targetPeriod_q8 = period_q8;
+    rampSteps = 0;
+    mode = 0;
+}
+
+void StepRamp::Stop() { Jump(0.0f); }
+
+uint32_t IRAM_ATTR StepRamp::Step()
+{
+    uint32_t period = period_q8;
+    uint32_t target = targetPeriod_q8;
+    int32_t n = rampSteps;
+
+    if (mode > 0)
+    {
+        if (n < MAX_RAMP_STEPS)
+        {
+            n++;
+        }
+        period -= (2u * period) / (4u * static_cast<uint32_t>(n) + 1u);
+        if (period <= target)
+        {
+            period = target;
+            mode = 0;
+        }
+    }
+    else if (mode < 0)
+    {
+        // Run the recurrence backwards: c_{n-1} = c_n + 2 c_n / (4n - 1).
+        if (n > 1)
+        {
+            uint32_t increase = (2u * period) / (4u * static_cast<uint32_t>(n) - 1u);
+            period = (increase > MAX_PERIOD_Q8 - period) ? MAX_PERIOD_Q8 : period + increase;
+            n--;
+        }
+        if (period >= target || n <= 1)
+        {
+            period = target;
+            mode = 0;
+        }
+    }
+
+    period_q8 = period;
+    rampSteps = n;
+    return period >> FRACTION_BITS;
+}
+
+float StepRamp::GetRate_stepsps() const
+{
+    uint32_t period = period_q8;
+    if (period == 0)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(static_cast<double>(tickRate_hz) * (1u << FRACTION_BITS) / period);
+}
@@ -0,0 +1,66 @@
+#ifndef STEP_RAMP_H
+#define STEP_RAMP_H
+
+#include <cstdint>
+
+#include "esp_attr.h"
+
+// Constant-acceleration ramp evaluated once per step, after D. Austin, "Generate stepper-motor
+// speed profiles in real time" (2005). Each step moves the step period along
+//     c_n = c_{n-1} - 2 c_{n-1} / (4n + 1)
+// where n is the number of steps since rest, so the step rate changes smoothly between control
+// ticks instead of in one jump per tick.
+//
+// Step() is integer-only so it can run in the step ISR, where the FPU may not be used. Periods
+// are kept in timer ticks with 8 fractional bits. Everything else runs in task context and must
+// be serialised against the ISR by the caller.
+class StepRamp
+{
+  public:
+    // `tickRate_hz` is the timer the periods count in. With `accel_stepsps2` <= 0 every change
+    // of rate is applied immediately.
+    void Configure(uint32_t tickRate_hz, float accel_stepsps2);
+
+    // Ramp from the current rate toward `targetRate_stepsps`. A target of 0 slows down to the
+    // slowest ramp rate and holds it; stopping is left to the caller. From rest the ramp starts
+    // with its first-step period.
+    void Retarget(float targetRate_stepsps);
+
+    // Run at `rate_stepsps` from the next step on, with no ramp. 0 is the same as Stop().
+    void Jump(float rate_stepsps);
+    void Stop();
+
+    // Account for the step just taken and return the period of the next one in timer ticks.
+    uint32_t IRAM_ATTR Step();
+
+    float GetRate_stepsps() const;
+    uint32_t GetPeriod_ticks() const { return period_q8 >> FRACTION_BITS; }
+    uint32_t GetFirstStepPeriod_ticks() const { return firstPeriod_q8 >> FRACTION_BITS; }
+    bool IsStopped() const { return period_q8 == 0; }
+    bool IsRamping() const { return mode != 0; }
+
+    // True once a ramp toward 0 has reached the slowest rate it holds.
+    bool AtSlowestRate() const { return period_q8 != 0 && period_q8 >= firstPeriod_q8; }
+
+  private:
+    static constexpr uint32_t FRACTION_BITS = 8;
+    // Keeps 2 * period inside 32 bits in Step().
+    static constexpr uint32_t MAX_PERIOD_Q8 = 0x7FFFFFFFu;
+    static constexpr uint32_t MIN_PERIOD_Q8 = 1u << FRACTION_BITS;
+    // Keeps 4n + 1 inside 32 bits in Step().
+    static constexpr int32_t MAX_RAMP_STEPS = 0x1FFFFFFF;
+
+    uint32_t PeriodForRate_q8(float rate_stepsps) const;
+
+    uint32_t tickRate_hz = 1000000;
+    float accel_stepsps2 = 0.0f;
+    uint32_t firstPeriod_q8 = MAX_PERIOD_Q8;
+
+    // Shared with the ISR. period_q8 == 0 means stopped.
+    volatile uint32_t period_q8 = 0;
+    volatile uint32_t targetPeriod_q8 = 0;
+    volatile int32_t rampSteps = 0;
+    volatile int8_t mode = 0; // +1 accelerating, -1 decelerating, 0 holding the period
+};
+
+#endif // STEP_RAMP_H
@@ -3,69 +3,51 @@
 #include <cmath>
 
 #define TIMER_PRECISION 1000000
+// Below this many steps per control tick the S-curve sets the rate directly instead of ramping
+#define SCURVE_MIN_STEPS_PER_TICK 4.0f
+
+// Half a step period, since the backend toggles the step output twice per step. Ensure a
+// minimum of 1 tick between toggles.
+static inline uint64_t IRAM_ATTR ToggleIntervalTicks(uint32_t stepPeriod_ticks)
+{
+    uint64_t ticks = (static_cast<uint64_t>(stepPeriod_ticks) + 1) / 2;
+    return (ticks < 1) ? 1 : ticks;
+}
+
 // Constructor implementation
-StepperMotor::StepperMotor(gpio_num_t stepPin, gpio_num_t dirPin, float AccelLimit_degps2,
-                           float SpeedLimit_degps, float StepSize_deg, const char *name, bool wiredBackward)
-    : name(name), m_stepPin(stepPin), m_dirPin(dirPin), m_AccelLimit_degps2(AccelLimit_degps2),
-      m_SpeedLimit_degps(SpeedLimit_degps), m_StepSize_deg(StepSize_deg), m_TimerRunning(false), m_WiredBackward(wiredBackward)
+StepperMotor::StepperMotor(StepOutputBackend &output, float AccelLimit_degps2, float SpeedLimit_degps,
+                           float StepSize_deg, const char *name, bool wiredBackward)
+    : name(name), m_Output(output), m_AccelLimit_degps2(AccelLimit_degps2),
+      m_SpeedLimit_degps(SpeedLimit_degps), m_JerkLimit_degps3(0.0f), m_StepSize_deg(StepSize_deg), m_TimerRunning(false), m_WiredBackward(wiredBackward)
 {
     // Initialize variables
     m_stepCount = 0;
     m_direction = 1;
-    m_stepState = false;
     m_CurrentSpeed_degps = 0;
     m_TargetSpeed_degps = 0;
-    m_SpeedIncrement_hz = 0.0;
     m_DirectionalInhibit = E_NO_INHIBIT;
+    m_ProfileRate_stepsps = 0.0f;
+    m_ProfileAccel_stepsps2 = 0.0f;
     m_CriticalMemoryMux = portMUX_INITIALIZER_UNLOCKED;
     m_AngleOffset_deg = 0.0;
-
-    // Configure GPIO pins
-    gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    io_conf.pin_bit_mask = (1ULL << m_stepPin) | (1ULL << m_dirPin);
-    gpio_config(&io_conf);
 }
 
 // Initialize timers
 void StepperMotor::InitializeTimers(uint32_t MotorControlPeriod_ms)
 {
+    // Resulting max speed with at least one tick between toggles
+    float maxSpeed_degps = m_StepSize_deg * TIMER_PRECISION;
+    ESP_LOGI(name, "Timer Resolution: %lu hz | Max Speed %f deg/s", (unsigned long)TIMER_PRECISION,
+             maxSpeed_degps);
 
-    // Timer configuration
-    gptimer_config_t timer_config = {};
-    timer_config.clk_src = GPTIMER_CLK_SRC_APB;
-    timer_config.direction = GPTIMER_COUNT_UP;
-
-    uint32_t apb_freq = 0;
-    CUSTOM_ERROR_CHECK(esp_clk_tree_src_get_freq_hz(
-        SOC_MOD_CLK_APB, ESP_CLK_TREE_SRC_FREQ_PRECISION_EXACT, &apb_freq));
-
-    // Set the resolution to center the ref speed at timer midpoint
-    //  float RefSpeed_degps = 360;
-    timer_config.resolution_hz = TIMER_PRECISION; // RefSpeed_degps / m_StepSize_deg * (1ULL <<
-                                                  // (SOC_TIMER_GROUP_COUNTER_BIT_WIDTH/2));
-
-    // Resulting min and max speed
-    float maxSpeed_degps = m_StepSize_deg * timer_config.resolution_hz;
-    //  float minSpeed_degps = maxSpeed_degps / (1ULL << SOC_TIMER_GROUP_COUNTER_BIT_WIDTH);
-    ESP_LOGI(name, "APB CLK FREQ %ld hz | Timer Resolution: %lu hz | Max Speed %f deg/s", apb_freq,
-             timer_config.resolution_hz, maxSpeed_degps);
-
-    // Create and configure step timer
-    CUSTOM_ERROR_CHECK(gptimer_new_timer(&timer_config, &m_PulseTimer));
-    gptimer_event_callbacks_t step_cbs = {};
-    step_cbs.on_alarm = onStepTimerCallback;
-    CUSTOM_ERROR_CHECK(gptimer_register_event_callbacks(m_PulseTimer, &step_cbs, this));
-    CUSTOM_ERROR_CHECK(gptimer_enable(m_PulseTimer));
-    // Set speed SpeedIncrement_hz based on acceleration
+    CUSTOM_ERROR_CHECK(m_Output.Init(TIMER_PRECISION, onStep, this));
 
     m_ControlPeriod_ms = MotorControlPeriod_ms;
-    m_SpeedIncrement_hz = (m_AccelLimit_degps2 / m_StepSize_deg * m_ControlPeriod_ms / 1000.0);
+    m_Ramp.Configure(TIMER_PRECISION, RampAccel_stepsps2());
 
-    float localSpeedIncrement_hz = m_SpeedIncrement_hz;
-    ESP_LOGI(name, "Acceleration: %f degps2 | Speed Increment: %f hz", m_AccelLimit_degps2,
-             localSpeedIncrement_hz);
+    unsigned long firstStep_ticks = m_Ramp.GetFirstStepPeriod_ticks();
+    ESP_LOGI(name, "Acceleration: %f degps2 | First Step: %lu ticks", m_AccelLimit_degps2,
+             firstStep_ticks);
 
     ESP_LOGI(name, "Init Complete");
 }
@@ -79,7 +61,7 @@ void StepperMotor::setDirection(bool dir)
     portEXIT_CRITICAL(&m_CriticalMemoryMux);
 
     // Could I re-wire this? Yes. Will I? No.
-    gpio_set_level(m_dirPin, m_WiredBackward ? !dir : dir);
+    m_Output.SetDirectionLevel(m_WiredBackward ? !dir : dir);
 }
 
 // Set target speed
@@ -114,24 +96,17 @@ void StepperMotor::logStatus(void)
              (long int)steps, speed, m_TargetSpeed_degps);
 }
 
-// Step timer ISR callback
-bool IRAM_ATTR StepperMotor::onStepTimerCallback(gptimer_handle_t timer,
-                                                 const gptimer_alarm_event_data_t *edata,
-                                                 void *user_ctx)
+// Step edge callback from the output backend
+uint64_t IRAM_ATTR StepperMotor::onStep(void *user_ctx)
 {
     StepperMotor *motor = static_cast<StepperMotor *>(user_ctx);
+    portENTER_CRITICAL_ISR(&motor->m_CriticalMemoryMux);
+    motor->m_stepCount += motor->m_direction;
+    uint32_t nextPeriod_ticks = motor->m_Ramp.Step();
+    portEXIT_CRITICAL_ISR(&motor->m_CriticalMemoryMux);
 
-    // Toggle STEP pin
-    motor->m_stepState = !motor->m_stepState;
-    gpio_set_level(motor->m_stepPin, motor->m_stepState);
-
-    // Update step count
-    if (motor->m_stepState)
-    {
-        motor->m_stepCount += motor->m_direction;
-    }
-
-    return false;
+    // A stopped ramp means the task is about to stop the timer; leave the interval alone.
+    return (nextPeriod_ticks == 0) ? 0 : ToggleIntervalTicks(nextPeriod_ticks);
 }
 
 void StepperMotor::Zero(void)
@@ -159,10 +134,45 @@ void StepperMotor::GetTlm(motor_tlm_t *Tlm)
     Tlm->TargetSpeed_degps = m_TargetSpeed_degps;
 }
 
+void StepperMotor::GetTlmTogether(StepperMotor *const *motors, motor_tlm_t *tlms, size_t count)
+{
+    // Always nested in the caller's order; the ISRs only ever take one motor's mux at a time.
+    for (size_t i = 0; i < count; i++)
+    {
+        portENTER_CRITICAL(&motors[i]->m_CriticalMemoryMux);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        tlms[i].Position_deg =
+            motors[i]->m_stepCount * motors[i]->m_StepSize_deg + motors[i]->m_AngleOffset_deg;
+    }
+    for (size_t i = count; i > 0; i--)
+    {
+        portEXIT_CRITICAL(&motors[i - 1]->m_CriticalMemoryMux);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        tlms[i].Speed_degps = motors[i]->m_CurrentSpeed_degps;
+        tlms[i].TargetSpeed_degps = motors[i]->m_TargetSpeed_degps;
+    }
+}
+
 void StepperMotor::SetAccelLimit(float AccelLimit_degps2)
 {
     m_AccelLimit_degps2 = AccelLimit_degps2;
-    m_SpeedIncrement_hz = (m_AccelLimit_degps2 / m_StepSize_deg * m_ControlPeriod_ms / 1000.0);
+    float accel_stepsps2 = RampAccel_stepsps2();
+    portENTER_CRITICAL(&m_CriticalMemoryMux);
+    m_Ramp.Configure(TIMER_PRECISION, accel_stepsps2);
+    portEXIT_CRITICAL(&m_CriticalMemoryMux);
+}
+
+// The ramp used to add AccelLimit / StepSize * period to the speed in deg/s once per control
+// tick, i.e. AccelLimit / StepSize deg/s^2. Every tuned limit depends on that slope, so the
+// per-step ramp keeps it.
+float StepperMotor::RampAccel_stepsps2() const
+{
+    return m_AccelLimit_degps2 / (m_StepSize_deg * m_StepSize_deg);
 }
 
 float StepperMotor::GetAccelLimit() const { return m_AccelLimit_degps2; }
@@ -171,6 +181,77 @@ void StepperMotor::SetSpeedLimit(float SpeedLimit_degps) { m_SpeedLimit_degps =
 
 float StepperMotor::GetSpeedLimit() const { return m_SpeedLimit_degps; }
 
+void StepperMotor::SetJerkLimit(float JerkLimit_degps3)
+{
+    m_JerkLimit_degps3 =
+        (std::isfinite(JerkLimit_degps3) && JerkLimit_degps3 > 0.0f) ? JerkLimit_degps3 : 0.0f;
+    m_ProfileAccel_stepsps2 = 0.0f;
+
+    // The S-curve reconfigures the ramp every tick; put the trapezoid's slope back.
+    if (!JerkLimited())
+    {
+        float accel_stepsps2 = RampAccel_stepsps2();
+        portENTER_CRITICAL(&m_CriticalMemoryMux);
+        m_Ramp.Configure(TIMER_PRECISION, accel_stepsps2);
+        portEXIT_CRITICAL(&m_CriticalMemoryMux);
+    }
+}
+
+float StepperMotor::GetJerkLimit() const { return m_JerkLimit_degps3; }
+
+bool StepperMotor::JerkLimited() const
+{
+    return m_JerkLimit_degps3 > 0.0f && RampAccel_stepsps2() > 0.0f;
+}
+
+// Advance the S-curve by one control tick toward `targetRate_stepsps` and return the rate it
+// reaches. The acceleration changes by at most the jerk limit per tick, and starts winding down
+// early enough to arrive at the target with no acceleration left.
+float StepperMotor::NextSCurveRate_stepsps(float targetRate_stepsps)
+{
+    const float period_s = m_ControlPeriod_ms / 1000.0f;
+    const float accelLimit_stepsps2 = RampAccel_stepsps2();
+    // Same scaling as the accel limit, so their ratio (the build-up time) is kept.
+    const float jerk_stepsps3 = m_JerkLimit_degps3 / (m_StepSize_deg * m_StepSize_deg);
+    const float accelStep_stepsps2 = jerk_stepsps3 * period_s;
+
+    float rate_stepsps = m_ProfileRate_stepsps;
+    float accel_stepsps2 = m_ProfileAccel_stepsps2;
+    const float error_stepsps = targetRate_stepsps - rate_stepsps;
+    if (error_stepsps == 0.0f && accel_stepsps2 == 0.0f)
+    {
+        return rate_stepsps;
+    }
+    const float towardTarget = (error_stepsps >= 0.0f) ? 1.0f : -1.0f;
+
+    // Speed still gained while the acceleration steps down to zero one tick at a time.
+    const float windDown_stepsps = accel_stepsps2 * accel_stepsps2 / (2.0f * jerk_stepsps3) -
+                                   0.5f * fabsf(accel_stepsps2) * period_s;
+    if (accel_stepsps2 * towardTarget > 0.0f && fabsf(error_stepsps) <= windDown_stepsps)
+    {
+        accel_stepsps2 -= towardTarget * accelStep_stepsps2;
+        if (accel_stepsps2 * towardTarget < 0.0f)
+        {
+            accel_stepsps2 = 0.0f;
+        }
+    }
+    else
+    {
+        accel_stepsps2 += towardTarget * accelStep_stepsps2;
+        accel_stepsps2 = fminf(fmaxf(accel_stepsps2, -accelLimit_stepsps2), accelLimit_stepsps2);
+    }
+
+    rate_stepsps += accel_stepsps2 * period_s;
+    if ((targetRate_stepsps - rate_stepsps) * towardTarget <= 0.0f)
+    {
+        rate_stepsps = targetRate_stepsps;
+        accel_stepsps2 = 0.0f;
+    }
+
+    m_ProfileAccel_stepsps2 = accel_stepsps2;
+    return rate_stepsps;
+}
+
 // Update the motor pulse freq
 void StepperMotor::UpdateSpeed(bool ForceUpdate)
 {
@@ -178,103 +259,159 @@ void StepperMotor::UpdateSpeed(bool ForceUpdate)
     {
         m_TargetSpeed_degps = 0.0f;
     }
-    if (!std::isfinite(m_CurrentSpeed_degps))
+
+    // The step ISR has been ramping since the last tick; carry on from the rate it reached.
+    portENTER_CRITICAL(&m_CriticalMemoryMux);
+    float rate_stepsps = m_Ramp.GetRate_stepsps();
+    bool atSlowestRate = m_Ramp.AtSlowestRate();
+    int8_t direction = m_direction;
+    portEXIT_CRITICAL(&m_CriticalMemoryMux);
+    m_CurrentSpeed_degps = m_TimerRunning ? direction * rate_stepsps * m_StepSize_deg : 0.0f;
+
+    const int8_t targetDirection =
+        (m_TargetSpeed_degps > 0.0f) ? 1 : ((m_TargetSpeed_degps < 0.0f) ? -1 : 0);
+    const int8_t currentDirection =
+        (m_CurrentSpeed_degps > 0.0f) ? 1 : ((m_CurrentSpeed_degps < 0.0f) ? -1 : 0);
+
+    // Direction of travel until the next tick (0 to stop) and the speed the ramp heads for.
+    int8_t moveDirection = targetDirection;
+    float rampSpeed_degps = fabsf(m_TargetSpeed_degps);
+    const bool sCurve = JerkLimited() && !ForceUpdate;
+    if (sCurve)
     {
-        m_CurrentSpeed_degps = 0.0f;
+        // The profile passes through zero on its own; stand still for the tick it crosses.
+        float profileRate_stepsps = NextSCurveRate_stepsps(m_TargetSpeed_degps / m_StepSize_deg);
+        if (profileRate_stepsps * m_ProfileRate_stepsps < 0.0f)
+        {
+            profileRate_stepsps = 0.0f;
+        }
+        m_ProfileRate_stepsps = profileRate_stepsps;
+        moveDirection = (profileRate_stepsps > 0.0f) ? 1 : ((profileRate_stepsps < 0.0f) ? -1 : 0);
+        rampSpeed_degps = fabsf(profileRate_stepsps) * m_StepSize_deg;
+    }
+    else if (!ForceUpdate && currentDirection != 0 && targetDirection != currentDirection)
+    {
+        // Decelerate to zero before changing direction
+        moveDirection = atSlowestRate ? 0 : currentDirection;
+        rampSpeed_degps = 0.0f;
     }
 
-    if (ForceUpdate)
+    // Handle directional inhibits
+    if (DirectionInhibited(moveDirection))
     {
-        m_CurrentSpeed_degps = m_TargetSpeed_degps;
+        moveDirection = 0;
+        m_ProfileAccel_stepsps2 = 0.0f;
     }
-    // Adjust CurrentSpeed_degps towards TargetSpeed_degps
-    else if ((m_CurrentSpeed_degps > 0.0 && m_TargetSpeed_degps < 0.0) ||
-             (m_CurrentSpeed_degps < 0.0 && m_TargetSpeed_degps > 0.0))
+
+    if (moveDirection == 0)
     {
-        // Decelerate to zero before changing direction
-        if (fabs(m_CurrentSpeed_degps) > m_SpeedIncrement_hz)
+        portENTER_CRITICAL(&m_CriticalMemoryMux);
+        m_Ramp.Stop();
+        portEXIT_CRITICAL(&m_CriticalMemoryMux);
+        m_CurrentSpeed_degps = 0.0f;
+    }
+    else
+    {
+        float rampRate_stepsps = rampSpeed_degps / m_StepSize_deg;
+        // Under the S-curve the ISR ramps at whatever slope reaches the profile's rate by the
+        // next tick, so the acceleration between ticks follows the profile too.
+        // With only a few steps per tick the ISR ramp would lag the profile by a step period;
+        // a step change per tick is as fine as those speeds can resolve.
+        float tickAccel_stepsps2 = 0.0f;
+        bool jumpToRate = ForceUpdate;
+        if (sCurve)
         {
-            m_CurrentSpeed_degps +=
-                (m_CurrentSpeed_degps > 0.0) ? -m_SpeedIncrement_hz : m_SpeedIncrement_hz;
+            float measuredRate_stepsps = (currentDirection == moveDirection) ? rate_stepsps : 0.0f;
+            tickAccel_stepsps2 = fminf(fabsf(rampRate_stepsps - measuredRate_stepsps) * 1000.0f /
+                                           m_ControlPeriod_ms,
+                                       RampAccel_stepsps2());
+            jumpToRate = rampRate_stepsps * m_ControlPeriod_ms <
+                         SCURVE_MIN_STEPS_PER_TICK * 1000.0f;
         }
-        else
+        portENTER_CRITICAL(&m_CriticalMemoryMux);
+        uint32_t previousPeriod_ticks = m_Ramp.GetPeriod_ticks();
+        if (sCurve)
         {
-            m_CurrentSpeed_degps = 0.0;
+            m_Ramp.Configure(TIMER_PRECISION, tickAccel_stepsps2);
         }
-    }
-    else
-    {
-        // Accelerate or decelerate towards TargetSpeed_degps
-        if (fabs(m_TargetSpeed_degps - m_CurrentSpeed_degps) > m_SpeedIncrement_hz)
+        if (jumpToRate)
         {
-            m_CurrentSpeed_degps += (m_TargetSpeed_degps > m_CurrentSpeed_degps)
-                                        ? m_SpeedIncrement_hz
-                                        : -m_SpeedIncrement_hz;
+            m_Ramp.Jump(rampRate_stepsps);
         }
         else
         {
-            m_CurrentSpeed_degps = m_TargetSpeed_degps;
+            m_Ramp.Retarget(rampRate_stepsps);
+        }
+        uint32_t period_ticks = m_Ramp.GetPeriod_ticks();
+        rate_stepsps = m_Ramp.GetRate_stepsps();
+        portEXIT_CRITICAL(&m_CriticalMemoryMux);
+
+        // While ramping the ISR applies each new period itself. A start, or a rate change made
+        // here (a forced jump, or a slow rate that needs no ramp), has to program the timer now
+        // rather than a whole step period later.
+        if (!m_TimerRunning || period_ticks != previousPeriod_ticks)
+        {
+            esp_err_t err = m_Output.SetToggleInterval(ToggleIntervalTicks(period_ticks));
+            if (err != ESP_OK)
+            {
+                ESP_LOGE(name, "Failed to set step timer alarm: %s", esp_err_to_name(err));
+                moveDirection = 0;
+            }
         }
-    }
-
-    // Handle directional inhibits
-    EnforceDirectionalInhibit();
-
-    // Update timer alarm value
-    if (!std::isfinite(m_CurrentSpeed_degps))
-    {
-        m_CurrentSpeed_degps = 0.0f;
-    }
 
-    if (m_CurrentSpeed_degps != 0.0)
-    {
-        float absSpeed_hz = fabs(m_CurrentSpeed_degps) / m_StepSize_deg;
-        if (!std::isfinite(absSpeed_hz) || absSpeed_hz <= 0.0f)
+        // Only a start or a forced update can change direction; settle it before the next edge.
+        if (moveDirection != 0)
         {
-            m_CurrentSpeed_degps = 0.0f;
+            setDirection(moveDirection > 0);
         }
-    }
 
-    if (m_CurrentSpeed_degps != 0.0)
-    {
-        float absSpeed_hz = fabs(m_CurrentSpeed_degps) / m_StepSize_deg;
-        // Ensure a minimum of 1 tick between toggles
-        double ticks_d = (double)TIMER_PRECISION / (absSpeed_hz * 2.0);
-        uint64_t alarm_count = (ticks_d < 1.0) ? 1 : static_cast<uint64_t>(ticks_d);
-
-        gptimer_alarm_config_t alarm_config = {};
-        alarm_config.alarm_count = alarm_count;
-        alarm_config.flags.auto_reload_on_alarm = true;
-        esp_err_t err = gptimer_set_alarm_action(m_PulseTimer, &alarm_config);
-        if (err != ESP_OK)
+        if (moveDirection != 0 && !m_TimerRunning)
         {
-            ESP_LOGE(name, "Failed to set step timer alarm: %s", esp_err_to_name(err));
-            m_CurrentSpeed_degps = 0.0f;
+            esp_err_t err = m_Output.Start();
+            if (err == ESP_OK)
+            {
+                m_TimerRunning = true;
+            }
+            else if (err == ESP_ERR_INVALID_STATE)
+            {
+                m_TimerRunning = true;
+                ESP_LOGW(name, "Step timer already running while state was stopped");
+            }
+            else
+            {
+                ESP_LOGE(name, "Failed to start step timer: %s", esp_err_to_name(err));
+                moveDirection = 0;
+            }
         }
-    }
 
-    if (m_CurrentSpeed_degps != 0.0 && !m_TimerRunning)
-    {
-        esp_err_t err = gptimer_start(m_PulseTimer);
-        if (err == ESP_OK)
+        if (moveDirection == 0)
         {
-            m_TimerRunning = true;
+            portENTER_CRITICAL(&m_CriticalMemoryMux);
+            m_Ramp.Stop();
+            portEXIT_CRITICAL(&m_CriticalMemoryMux);
         }
-        else if (err == ESP_ERR_INVALID_STATE)
+        m_CurrentSpeed_degps = moveDirection * rate_stepsps * m_StepSize_deg;
+        if (sCurve && moveDirection != 0)
         {
-            m_TimerRunning = true;
-            ESP_LOGW(name, "Step timer already running while state was stopped");
+            // Report the profile, which the ISR reaches by the next tick.
+            m_CurrentSpeed_degps = moveDirection * rampSpeed_degps;
         }
-        else
+    }
+
+    // Outside the S-curve, or when the motor was made to stop, the profile restarts from the
+    // speed actually commanded.
+    if (!sCurve || moveDirection == 0)
+    {
+        m_ProfileRate_stepsps = m_CurrentSpeed_degps / m_StepSize_deg;
+        if (!sCurve)
         {
-            ESP_LOGE(name, "Failed to start step timer: %s", esp_err_to_name(err));
-            m_CurrentSpeed_degps = 0.0f;
+            m_ProfileAccel_stepsps2 = 0.0f;
         }
     }
 
     if (m_CurrentSpeed_degps == 0.0 && m_TimerRunning)
     {
-        esp_err_t err = gptimer_stop(m_PulseTimer);
+        esp_err_t err = m_Output.Stop();
         if (err == ESP_OK)
         {
             m_TimerRunning = false;
@@ -289,17 +426,12 @@ void StepperMotor::UpdateSpeed(bool ForceUpdate)
             ESP_LOGE(name, "Failed to stop step timer: %s", esp_err_to_name(err));
         }
     }
-
-    setDirection(m_CurrentSpeed_degps >= 0);
 }
 
-void StepperMotor::EnforceDirectionalInhibit(void)
+bool StepperMotor::DirectionInhibited(int8_t direction) const
 {
-    if (((E_INHIBIT_FORWARD == m_DirectionalInhibit) && m_CurrentSpeed_degps > 0.0) ||
-        ((E_INHIBIT_BACKWARD == m_DirectionalInhibit) && m_CurrentSpeed_degps < 0.0))
-    {
-        m_CurrentSpeed_degps = 0.0;
-    }
+    return ((E_INHIBIT_FORWARD == m_DirectionalInhibit) && direction > 0) ||
+           ((E_INHIBIT_BACKWARD == m_DirectionalInhibit) && direction < 0);
 }
 
 void StepperMotor::SetDirectionalInhibit(direction_inhibit_type_t Inhibit)
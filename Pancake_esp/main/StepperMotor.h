@@ -1,15 +1,16 @@
 #ifndef STEPPERMOTOR_H
 #define STEPPERMOTOR_H
 
-#include "driver/gptimer.h"
+#include <cstddef>
+
 #include "esp_attr.h"
-#include "esp_clk_tree.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
-#include "driver/gpio.h"
 
 #include "defines.h"
+#include "StepOutputBackend.h"
+#include "StepRamp.h"
 #include "Telemetry.h"
 
 class StepperMotor
@@ -23,8 +24,8 @@ class StepperMotor
     } direction_inhibit_type_t;
 
     // Constructor
-    StepperMotor(gpio_num_t stepPin, gpio_num_t dirPin, float AccelLimit_degps2,
-                 float SpeedLimit_degps, float StepSize_deg, const char *name, bool wiredBackward);
+    StepperMotor(StepOutputBackend &output, float AccelLimit_degps2, float SpeedLimit_degps,
+                 float StepSize_deg, const char *name, bool wiredBackward);
 
     // Public methods
     void setDirection(bool dir);
@@ -35,10 +36,9 @@ class StepperMotor
     void SetPosition(float Position_deg);
     void Zero(void);
     
-    // ISR callback for the step timer
-    static bool IRAM_ATTR onStepTimerCallback(gptimer_handle_t timer,
-                                              const gptimer_alarm_event_data_t *edata,
-                                              void *user_ctx);
+    // Rising step edge reported by the output backend (ISR context on the target). Advances the
+    // speed ramp and returns the toggle interval for the next step.
+    static uint64_t IRAM_ATTR onStep(void *user_ctx);
 
     // Method to handle updating motor speed / PWM freq
     void UpdateSpeed(bool ForceUpdate);
@@ -47,39 +47,49 @@ class StepperMotor
     const char *name;
 
     void GetTlm(motor_tlm_t *Tlm);
+    // GetTlm for several motors with every step count read under one critical section, so the
+    // positions describe the same instant even while the step ISRs are running.
+    static void GetTlmTogether(StepperMotor *const *motors, motor_tlm_t *tlms, size_t count);
 
     // Runtime configuration
     void SetAccelLimit(float AccelLimit_degps2);
     float GetAccelLimit() const;
     void SetSpeedLimit(float SpeedLimit_degps);
     float GetSpeedLimit() const;
+    // Jerk limit in the same units as the accel limit per second, so AccelLimit / JerkLimit is
+    // the time taken to build up to full acceleration. 0 keeps the trapezoidal profile.
+    void SetJerkLimit(float JerkLimit_degps3);
+    float GetJerkLimit() const;
 
   private:
-    void EnforceDirectionalInhibit(void);
+    bool DirectionInhibited(int8_t direction) const;
+    float RampAccel_stepsps2() const;
+    bool JerkLimited() const;
+    float NextSCurveRate_stepsps(float targetRate_stepsps);
 
-    // GPIO pins
-    gpio_num_t m_stepPin;
-    gpio_num_t m_dirPin;
+    // Step/direction pulse generator
+    StepOutputBackend &m_Output;
 
     // Motion parameters
     volatile int32_t m_stepCount;
     volatile int8_t m_direction;
-    volatile bool m_stepState;
     float m_CurrentSpeed_degps;
     float m_TargetSpeed_degps;
-    float m_SpeedIncrement_hz;
+    // Step rate between control ticks; shared with the step ISR under m_CriticalMemoryMux
+    StepRamp m_Ramp;
     direction_inhibit_type_t m_DirectionalInhibit;
+    // S-curve state in signed steps/s and steps/s^2, advanced once per control tick
+    float m_ProfileRate_stepsps;
+    float m_ProfileAccel_stepsps2;
 
     // Acceleration parameter
     float m_AccelLimit_degps2;
     float m_SpeedLimit_degps;
+    float m_JerkLimit_degps3;
     float m_StepSize_deg;
     float m_AngleOffset_deg;
     float m_ControlPeriod_ms;
 
-    // GPTimer handle for the step timer
-    gptimer_handle_t m_PulseTimer;
-
     // Mutex for critical sections
     portMUX_TYPE m_CriticalMemoryMux;
 
@@ -6,6 +6,7 @@ extern "C" {
 #define TELEMETRY_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct {
     float Speed_degps;
@@ -13,14 +14,14 @@ typedef struct {
     float Position_deg;
 } motor_tlm_t;
 
+// Everything the motor control task publishes once per cycle. The motor values are sampled
+// together at sampleTime_us and the planner values come from the same cycle. Shared through the
+// ControlTelemetry seqlock (ControlTelemetry.h) so readers always see one whole cycle.
 typedef struct {
+    int64_t sampleTime_us;
     motor_tlm_t PumpMotorTlm;
     motor_tlm_t S0MotorTlm;
     motor_tlm_t S1MotorTlm;
-    float temp_F;
-    float espTemp_C;
-    bool S0LimitSwitch;
-    bool S1LimitSwitch;
     float tipPos_X_m;
     float tipPos_Y_m;
     float targetPos_X_m;
@@ -33,6 +34,21 @@ typedef struct {
     float plannedDelta_S1_deg;
     bool limitBlocked_S0;
     bool limitBlocked_S1;
+    bool limitSwitch_S0;
+    bool limitSwitch_S1;
+    uint32_t loopWindowJitter_us;
+    uint32_t loopWindowLatency_us;
+    uint32_t loopWorstLatency_us;
+    uint32_t loopOverrunCount;
+    uint32_t cncQueueClearCount;
+} control_tlm_t;
+
+// Values with their own writers (the safety task, telemetry start-up) that are single words.
+typedef struct {
+    float temp_F;
+    float espTemp_C;
+    bool S0LimitSwitch;
+    bool S1LimitSwitch;
     float cartesianBoundaryCorner0_X_m;
     float cartesianBoundaryCorner0_Y_m;
     float cartesianBoundaryCorner1_X_m;
@@ -0,0 +1,127 @@
+#ifndef TELEMETRY_BUFFER_POOL_H
+#define TELEMETRY_BUFFER_POOL_H
+
+#include <cstddef>
+
+// Fixed set of telemetry buffers passed between the producers and the transmit task by pointer.
+// Producers append lines to the buffer being filled. When a line does not fit, that buffer is
+// sealed and the next free one is started. The transmit task takes the sealed buffers and the
+// one being filled, sends them from where they are and gives them back. Nothing is copied, and
+// the caller's lock is only held to move pointers, not while a buffer is sent.
+//
+// No locking of its own: every call must hold the same lock (TlmBufferMutex on the target).
+template <size_t BufferBytes, size_t BufferCount> class TelemetryBufferPool
+{
+    static_assert(BufferCount >= 2, "the transmit task and the producers each need a buffer");
+
+  public:
+    struct Buffer
+    {
+        char data[BufferBytes];
+        size_t length;
+    };
+
+    TelemetryBufferPool()
+    {
+        for (size_t i = 0; i < BufferCount; i++)
+        {
+            buffers[i].length = 0;
+            freeBuffers[i] = &buffers[BufferCount - 1 - i];
+        }
+        freeCount = BufferCount;
+    }
+
+    TelemetryBufferPool(const TelemetryBufferPool &) = delete;
+    TelemetryBufferPool &operator=(const TelemetryBufferPool &) = delete;
+
+    // Append one line. format(out, capacity) writes it and returns its length, or 0 if it does
+    // not fit. Returns false, counting the line as dropped, if no buffer had room for it.
+    template <typename Format> bool Append(Format format)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            if (filling == nullptr)
+            {
+                if (freeCount == 0)
+                {
+                    break;
+                }
+                filling = freeBuffers[--freeCount];
+            }
+            size_t written = format(filling->data + filling->length, BufferBytes - filling->length);
+            if (written > 0)
+            {
+                filling->length += written;
+                return true;
+            }
+            if (filling->length == 0)
+            {
+                break; // too long for any buffer
+            }
+            Seal();
+        }
+        droppedCount++;
+        return false;
+    }
+
+    // Hand over up to maxCount buffers holding data, oldest first, sealing the one being filled.
+    // Returns the count. They stay out of the pool until Give().
+    size_t Take(Buffer **out, size_t maxCount)
+    {
+        if (filling != nullptr && filling->length > 0)
+        {
+            Seal();
+        }
+        size_t count = (readyCount < maxCount) ? readyCount : maxCount;
+        for (size_t i = 0; i < readyCount; i++)
+        {
+            if (i < count)
+            {
+                out[i] = ready[i];
+            }
+            else
+            {
+                ready[i - count] = ready[i];
+            }
+        }
+        readyCount -= count;
+        return count;
+    }
+
+    // An empty buffer for the caller's own lines, or nullptr if none is free. Give it back too.
+    Buffer *TakeFree()
+    {
+        return (freeCount > 0) ? freeBuffers[--freeCount] : nullptr;
+    }
+
+    // Return buffers from Take() or TakeFree(), emptied.
+    void Give(Buffer *const *returned, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            returned[i]->length = 0;
+            freeBuffers[freeCount++] = returned[i];
+        }
+    }
+
+    // Lines dropped since boot because every buffer was full or out with the transmit task.
+    size_t GetDroppedCount() const { return droppedCount; }
+
+  private:
+    void Seal()
+    {
+        ready[readyCount++] = filling;
+        filling = nullptr;
+    }
+
+    Buffer buffers[BufferCount];
+    Buffer *freeBuffers[BufferCount];
+    size_t freeCount = 0;
+    // Sealed buffers, oldest first.
+    Buffer *ready[BufferCount];
+    size_t readyCount = 0;
+    Buffer *filling = nullptr;
+    size_t droppedCount = 0;
+};
+
+#endif // TELEMETRY_BUFFER_POOL_H
@@ -0,0 +1,295 @@
+#include "TelemetryGzip.h"
+
+namespace
+{
+constexpr size_t MIN_MATCH = 3;
+constexpr size_t MAX_MATCH = 258;
+// Hash chain entries tried per position. Telemetry lines repeat a handful of keys, so the best
+// match is almost always among the last few lines.
+constexpr int MAX_CHAIN = 16;
+// Matches this long are taken at once rather than checked against the next position.
+constexpr size_t LAZY_MATCH_LIMIT = 32;
+
+constexpr uint16_t LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t LENGTH_EXTRA_BITS[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                           2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t DISTANCE_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t DISTANCE_EXTRA_BITS[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                             6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+struct Crc32Table
+{
+    uint32_t entries[256];
+
+    constexpr Crc32Table() : entries()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+constexpr Crc32Table CRC32_TABLE;
+
+// Deflate packs bits from the least significant end of each byte. Writes past capacity are
+// counted rather than made, so one check at the end covers the whole stream.
+class BitWriter
+{
+  public:
+    BitWriter(uint8_t *out, size_t capacity) : out(out), capacity(capacity) {}
+
+    void PutByte(uint8_t value)
+    {
+        if (used < capacity)
+        {
+            out[used] = value;
+        }
+        used++;
+    }
+
+    void PutBits(uint32_t value, int count)
+    {
+        bits |= value << bitCount;
+        bitCount += count;
+        while (bitCount >= 8)
+        {
+            PutByte(static_cast<uint8_t>(bits));
+            bits >>= 8;
+            bitCount -= 8;
+        }
+    }
+
+    // Huffman codes are defined most significant bit first.
+    void PutCode(uint32_t code, int count)
+    {
+        uint32_t reversed = 0;
+        for (int i = 0; i < count; i++)
+        {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        PutBits(reversed, count);
+    }
+
+    void PutUint32(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            PutByte(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void AlignToByte()
+    {
+        if (bitCount > 0)
+        {
+            PutBits(0, 8 - bitCount);
+        }
+    }
+
+    size_t GetLength() const { return used; }
+    bool Overflowed() const { return used > capacity; }
+
+  private:
+    uint8_t *out;
+    size_t capacity;
+    size_t used = 0;
+    uint32_t bits = 0;
+    int bitCount = 0;
+};
+
+// Fixed literal/length code (RFC 1951 3.2.6).
+void PutLiteralOrLengthSymbol(BitWriter &writer, uint32_t symbol)
+{
+    if (symbol < 144)
+    {
+        writer.PutCode(0x30 + symbol, 8);
+    }
+    else if (symbol < 256)
+    {
+        writer.PutCode(0x190 + (symbol - 144), 9);
+    }
+    else if (symbol < 280)
+    {
+        writer.PutCode(symbol - 256, 7);
+    }
+    else
+    {
+        writer.PutCode(0xC0 + (symbol - 280), 8);
+    }
+}
+
+void PutMatch(BitWriter &writer, size_t length, size_t distance)
+{
+    int lengthCode = 28;
+    while (LENGTH_BASE[lengthCode] > length)
+    {
+        lengthCode--;
+    }
+    PutLiteralOrLengthSymbol(writer, 257 + lengthCode);
+    writer.PutBits(static_cast<uint32_t>(length - LENGTH_BASE[lengthCode]), LENGTH_EXTRA_BITS[lengthCode]);
+
+    int distanceCode = 29;
+    while (DISTANCE_BASE[distanceCode] > distance)
+    {
+        distanceCode--;
+    }
+    writer.PutCode(static_cast<uint32_t>(distanceCode), 5);
+    writer.PutBits(static_cast<uint32_t>(distance - DISTANCE_BASE[distanceCode]), DISTANCE_EXTRA_BITS[distanceCode]);
+}
+
+template <size_t HashBits>
+uint32_t HashTriple(const uint8_t *bytes)
+{
+    uint32_t triple = (uint32_t(bytes[0]) << 16) | (uint32_t(bytes[1]) << 8) | bytes[2];
+    return (triple * 2654435761u) >> (32 - HashBits);
+}
+} // namespace
+
+uint32_t GzipCrc32(uint32_t crc, const void *data, size_t length)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = CRC32_TABLE.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+size_t GzipCompressor::LongestMatch(const uint8_t *bytes, size_t length, size_t position, size_t &distance) const
+{
+    if (position + MIN_MATCH > length)
+    {
+        return 0;
+    }
+
+    size_t longest = (length - position < MAX_MATCH) ? length - position : MAX_MATCH;
+    size_t bestLength = 0;
+    uint16_t candidate = head[HashTriple<HASH_BITS>(bytes + position)];
+    for (int probe = 0; probe < MAX_CHAIN && candidate != NO_POSITION && candidate < position; probe++)
+    {
+        if (position - candidate >= WINDOW_BYTES)
+        {
+            break;
+        }
+
+        size_t matched = 0;
+        while (matched < longest && bytes[candidate + matched] == bytes[position + matched])
+        {
+            matched++;
+        }
+        if (matched > bestLength)
+        {
+            bestLength = matched;
+            distance = position - candidate;
+            if (matched == longest)
+            {
+                break;
+            }
+        }
+
+        // A slot overwritten by a newer position no longer links further back.
+        uint16_t next = previous[candidate % WINDOW_BYTES];
+        if (next >= candidate)
+        {
+            break;
+        }
+        candidate = next;
+    }
+    return bestLength;
+}
+
+size_t GzipCompressor::Compress(const void *input, size_t length, uint8_t *out, size_t capacity)
+{
+    if (length == 0 || length > GZIP_MAX_INPUT_BYTES)
+    {
+        return 0;
+    }
+
+    const uint8_t *bytes = static_cast<const uint8_t *>(input);
+    for (uint16_t &entry : head)
+    {
+        entry = NO_POSITION;
+    }
+
+    BitWriter writer(out, capacity);
+
+    // Member header: magic, deflate, no flags, no mtime, no extra flags, unknown OS.
+    const uint8_t header[10] = {0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF};
+    for (uint8_t byte : header)
+    {
+        writer.PutByte(byte);
+    }
+
+    // One final block with fixed codes: BFINAL = 1, BTYPE = 01.
+    writer.PutBits(1, 1);
+    writer.PutBits(1, 2);
+
+    auto insert = [&](size_t position)
+    {
+        if (position + MIN_MATCH <= length)
+        {
+            uint32_t hash = HashTriple<HASH_BITS>(bytes + position);
+            previous[position % WINDOW_BYTES] = head[hash];
+            head[hash] = static_cast<uint16_t>(position);
+        }
+    };
+
+    // Greedy matching with one step of lazy evaluation: a match is put off by a byte when the
+    // next position matches longer, which picks up a value's digits after a repeated key.
+    size_t position = 0;
+    size_t matchDistance = 0;
+    size_t matchLength = LongestMatch(bytes, length, position, matchDistance);
+    while (position < length)
+    {
+        if (matchLength >= MIN_MATCH)
+        {
+            insert(position);
+            size_t nextDistance = 0;
+            size_t nextLength =
+                (matchLength < LAZY_MATCH_LIMIT) ? LongestMatch(bytes, length, position + 1, nextDistance) : 0;
+            if (nextLength > matchLength)
+            {
+                PutLiteralOrLengthSymbol(writer, bytes[position]);
+                position++;
+                matchLength = nextLength;
+                matchDistance = nextDistance;
+                continue;
+            }
+
+            PutMatch(writer, matchLength, matchDistance);
+            for (size_t i = 1; i < matchLength; i++)
+            {
+                insert(position + i);
+            }
+            position += matchLength;
+        }
+        else
+        {
+            PutLiteralOrLengthSymbol(writer, bytes[position]);
+            insert(position);
+            position++;
+        }
+
+        if (writer.Overflowed())
+        {
+            return 0;
+        }
+        matchLength = LongestMatch(bytes, length, position, matchDistance);
+    }
+
+    PutLiteralOrLengthSymbol(writer, 256);
+    writer.AlignToByte();
+    writer.PutUint32(GzipCrc32(0, bytes, length));
+    writer.PutUint32(static_cast<uint32_t>(length));
+
+    return writer.Overflowed() ? 0 : writer.GetLength();
+}
@@ -0,0 +1,53 @@
+#ifndef TELEMETRY_GZIP_H
+#define TELEMETRY_GZIP_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Largest input one Compress call accepts; positions in the match tables are 16-bit.
+constexpr size_t GZIP_MAX_INPUT_BYTES = 8192;
+
+// Longest gzip member Compress writes for inputBytes: the 10-byte header and 8-byte trailer around
+// one fixed Huffman block. No input byte costs more than 9 bits (a literal at most 9, the worst
+// match 22 bits for 3 bytes), plus the 3-bit block header and 7-bit end of block.
+constexpr size_t GzipMaxOutputBytes(size_t inputBytes)
+{
+    return 10 + (3 + 9 * inputBytes + 7 + 7) / 8 + 8;
+}
+
+// gzip (RFC 1952) writer for telemetry uploads, sized for the transmit buffer and allocating
+// nothing: all state is the fixed match tables below, so one static instance is ~12 KB of .bss.
+//
+// The body is a single deflate block with the fixed Huffman codes (RFC 1951 3.2.6), which needs
+// no code tables in the output and no second pass over the input. Line protocol is almost all
+// repeated keys, tags and timestamp digits, so the LZ77 matches carry nearly all of the gain; a
+// dynamic Huffman block would only save a few percent more.
+class GzipCompressor
+{
+  public:
+    // Compress input into out. Returns the gzip length, or 0 if input is empty, longer than
+    // GZIP_MAX_INPUT_BYTES or does not fit in capacity. A body sent as Content-Encoding: gzip
+    // cannot fall back to raw bytes, so a 0 fails the upload; GzipMaxOutputBytes(length) of
+    // capacity always fits.
+    size_t Compress(const void *input, size_t length, uint8_t *out, size_t capacity);
+
+  private:
+    // Longest earlier match for the bytes at position, with its distance; 0 if none reaches
+    // three bytes.
+    size_t LongestMatch(const uint8_t *bytes, size_t length, size_t position, size_t &distance) const;
+
+    static constexpr size_t WINDOW_BYTES = 4096;
+    static constexpr size_t HASH_BITS = 11;
+    static constexpr size_t HASH_SIZE = size_t(1) << HASH_BITS;
+    static constexpr uint16_t NO_POSITION = 0xFFFF;
+
+    // Most recent position of each 3-byte hash, and for each position within the window the
+    // previous one with the same hash.
+    uint16_t head[HASH_SIZE];
+    uint16_t previous[WINDOW_BYTES];
+};
+
+// CRC-32 as used by gzip and zlib's crc32(), continuing from crc (0 to start).
+uint32_t GzipCrc32(uint32_t crc, const void *data, size_t length);
+
+#endif // TELEMETRY_GZIP_H
@@ -0,0 +1,82 @@
+#include "TelemetryLine.h"
+
+#include <cstring>
+
+#include "LineProtocolWriter.h"
+
+const TelemetryFieldName TELEMETRY_FIELD_NAMES[] = {
+    {"tipPos_X_m", "tx"},
+    {"tipPos_Y_m", "ty"},
+    {"targetPos_X_m", "gx"},
+    {"targetPos_Y_m", "gy"},
+    {"S0_Speed_degps", "s0v"},
+    {"S0_TargetSpeed_degps", "s0vt"},
+    {"S1_Speed_degps", "s1v"},
+    {"S1_TargetSpeed_degps", "s1vt"},
+    {"Pump_Speed_degps", "pv"},
+    {"Pump_TargetSpeed_degps", "pvt"},
+
+    {"targetPos_S0_deg", "s0g"},
+    {"targetPos_S1_deg", "s1g"},
+    {"plannedTarget_S0_deg", "s0p"},
+    {"plannedTarget_S1_deg", "s1p"},
+    {"plannedDelta_S0_deg", "s0d"},
+    {"plannedDelta_S1_deg", "s1d"},
+    {"S0_Pos_deg", "s0"},
+    {"S1_Pos_deg", "s1"},
+    {"loopWindowJitter_us", "lj"},
+    {"loopWindowLatency_us", "ll"},
+    {"loopWorstLatency_us", "lw"},
+    {"loopOverrunCount", "lo"},
+
+    {"espTemp_C", "tc"},
+    {"limitBlocked_S0", "lb0"},
+    {"limitBlocked_S1", "lb1"},
+    {"S0_LimitSwitch", "ls0"},
+    {"S1_LimitSwitch", "ls1"},
+    {"cartesianBoundaryCorner0_X_m", "c0x"},
+    {"cartesianBoundaryCorner0_Y_m", "c0y"},
+    {"cartesianBoundaryCorner1_X_m", "c1x"},
+    {"cartesianBoundaryCorner1_Y_m", "c1y"},
+    {"cartesianBoundaryCorner2_X_m", "c2x"},
+    {"cartesianBoundaryCorner2_Y_m", "c2y"},
+    {"cartesianBoundaryCorner3_X_m", "c3x"},
+    {"cartesianBoundaryCorner3_Y_m", "c3y"},
+};
+
+const size_t TELEMETRY_FIELD_NAME_COUNT = sizeof(TELEMETRY_FIELD_NAMES) / sizeof(TELEMETRY_FIELD_NAMES[0]);
+
+const char *GetTelemetryFieldKey(const char *name)
+{
+    for (size_t i = 0; i < TELEMETRY_FIELD_NAME_COUNT; i++)
+    {
+        if (strcmp(TELEMETRY_FIELD_NAMES[i].name, name) == 0)
+        {
+            return TELEMETRY_FIELD_NAMES[i].key;
+        }
+    }
+    return name;
+}
+
+size_t FormatTelemetryLine(char *out, size_t capacity, const char *prefix, const TelemetryField *fields,
+                           size_t count, int64_t timestamp_ms)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    LineProtocolWriter writer(out, capacity);
+    writer.Append(prefix);
+    for (size_t i = 0; i < count; i++)
+    {
+        writer.Append((i == 0) ? ' ' : ',');
+        writer.Append(fields[i].key);
+        writer.Append('=');
+        writer.AppendFixed5(fields[i].value);
+    }
+    writer.Append(' ');
+    writer.AppendInt64(timestamp_ms);
+    writer.Append('\n');
+    return writer.Ok() ? writer.Length() : 0;
+}
@@ -0,0 +1,41 @@
+#ifndef TELEMETRY_LINE_H
+#define TELEMETRY_LINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Telemetry goes to InfluxDB as one line-protocol line per aggregation cycle, carrying every
+// point due that cycle as a field of a single measurement:
+//
+//   tlm,location=us-midwest tx=0.1234,ty=0.2,s0v=-12.5 1767225662000
+//
+// instead of one line per point, each repeating the measurement, tag set and timestamp. Points
+// are written under the short keys in TELEMETRY_FIELD_NAMES (listed in telemetrybudget.md);
+// dashboards select r._measurement == "tlm" and r._field == <key>.
+constexpr const char *TELEMETRY_LINE_PREFIX = "tlm,location=us-midwest";
+
+struct TelemetryFieldName
+{
+    const char *name;
+    const char *key;
+};
+
+extern const TelemetryFieldName TELEMETRY_FIELD_NAMES[];
+extern const size_t TELEMETRY_FIELD_NAME_COUNT;
+
+// Short key for a registered point name, or the name itself if it has none.
+const char *GetTelemetryFieldKey(const char *name);
+
+struct TelemetryField
+{
+    const char *key;
+    float value;
+};
+
+// Write "<prefix> k=v,k=v,... <timestamp_ms>\n" to out. Values keep the five decimals the
+// per-point lines had, less trailing zeros (FormatFixed5). Returns the bytes written, or 0 if
+// there are no fields or the line does not fit in capacity (out then holds part of it).
+size_t FormatTelemetryLine(char *out, size_t capacity, const char *prefix, const TelemetryField *fields,
+                           size_t count, int64_t timestamp_ms);
+
+#endif // TELEMETRY_LINE_H
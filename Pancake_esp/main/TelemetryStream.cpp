@@ -0,0 +1,61 @@
+#include "TelemetryStream.h"
+
+namespace
+{
+// "<length in hex>\r\n"; returns its length.
+size_t FormatChunkHeader(char *out, size_t length)
+{
+    char digits[2 * sizeof(size_t)];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = "0123456789abcdef"[length & 0xF];
+        length >>= 4;
+    } while (length != 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = digits[count - 1 - i];
+    }
+    out[count] = '\r';
+    out[count + 1] = '\n';
+    return count + 2;
+}
+} // namespace
+
+bool StreamTelemetryChunks(const TelemetryChunk *chunks, size_t count, GzipCompressor *compressor,
+                           uint8_t *scratch, size_t scratchCapacity, TelemetryStreamWrite write, void *context,
+                           size_t &bodyBytes)
+{
+    bodyBytes = 0;
+    auto send = [&](const char *data, size_t length)
+    {
+        bodyBytes += length;
+        return write(context, data, length);
+    };
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const char *data = chunks[i].data;
+        size_t length = chunks[i].length;
+        if (length == 0)
+        {
+            continue; // a zero-length chunk would end the body
+        }
+        if (compressor != nullptr)
+        {
+            length = compressor->Compress(data, length, scratch, scratchCapacity);
+            if (length == 0)
+            {
+                return false;
+            }
+            data = reinterpret_cast<const char *>(scratch);
+        }
+
+        char header[2 * sizeof(size_t) + 2];
+        if (!send(header, FormatChunkHeader(header, length)) || !send(data, length) || !send("\r\n", 2))
+        {
+            return false;
+        }
+    }
+    return send("0\r\n\r\n", 5);
+}
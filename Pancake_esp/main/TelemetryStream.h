@@ -0,0 +1,40 @@
+#ifndef TELEMETRY_STREAM_H
+#define TELEMETRY_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "TelemetryGzip.h"
+
+// One piece of an upload, sent from wherever it already is (a pool buffer).
+struct TelemetryChunk
+{
+    const char *data;
+    size_t length;
+};
+
+// Sends body bytes on the open request (esp_http_client_write on the target). Returns false if
+// the connection failed.
+typedef bool (*TelemetryStreamWrite)(void *context, const char *data, size_t length);
+
+// Scratch needed to gzip a chunk of inputBytes: 9 bits per byte at worst with fixed Huffman codes,
+// plus the gzip header and trailer.
+constexpr size_t TelemetryGzipScratchBytes(size_t inputBytes)
+{
+    return inputBytes + inputBytes / 8 + 32;
+}
+static_assert(TelemetryGzipScratchBytes(1) >= GzipMaxOutputBytes(1) &&
+                  TelemetryGzipScratchBytes(GZIP_MAX_INPUT_BYTES) >= GzipMaxOutputBytes(GZIP_MAX_INPUT_BYTES),
+              "gzip scratch must hold a fixed Huffman member of any chunk Compress accepts");
+
+// Write chunks as an HTTP/1.1 chunked request body (Transfer-Encoding: chunked), one HTTP chunk
+// each, empty ones skipped, then the terminating chunk. With a compressor, each chunk goes out
+// as its own gzip member in scratch, which needs TelemetryGzipScratchBytes of the largest chunk;
+// members back to back are one valid gzip body (RFC 1952 2.2), so the request carries
+// Content-Encoding: gzip. Without one the chunks are written in place. Returns false if a write
+// failed or a chunk could not be compressed; bodyBytes is the body written, framing included.
+bool StreamTelemetryChunks(const TelemetryChunk *chunks, size_t count, GzipCompressor *compressor,
+                           uint8_t *scratch, size_t scratchCapacity, TelemetryStreamWrite write, void *context,
+                           size_t &bodyBytes);
+
+#endif // TELEMETRY_STREAM_H
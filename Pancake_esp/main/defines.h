@@ -9,6 +9,11 @@
 #define SAFETY_PERIOD_MS 10
 #define BUFFER_ADD_PERIOD_MS 1000
 
+// 1: all motors step from one BresenhamStepGenerator ISR. 0: one GptimerStepBackend per motor.
+#ifndef SHARED_STEP_TIMER
+#define SHARED_STEP_TIMER 1
+#endif
+
 
 #define CUSTOM_ERROR_CHECK(err)                                                                    \
     do                                                                                             \
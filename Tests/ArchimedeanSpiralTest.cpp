@@ -54,12 +54,74 @@ void TestInvalidConfigCompletesAtCurrentPosition()
     ExpectNearlyEqual(commanded_m.x, current_m.x, 0.0f, "invalid spiral x");
     ExpectNearlyEqual(commanded_m.y, current_m.y, 0.0f, "invalid spiral y");
 }
+
+void TestSetpointVelocityMatchesPathDerivative()
+{
+    ArchimedeanSpiral spiral;
+    SpiralConfig config = MakeValidConfig();
+    config.SpiralConstant_mprad = 0.005f;
+    spiral.ApplyConfig(config);
+
+    Vector2D current_m(config.CenterX_m, config.CenterY_m);
+    GuidanceSetpoint previous;
+    GuidanceSetpoint setpoint;
+    bool cmdViaAngle = true;
+    float s0Speed_degps = 0.0f;
+    float s1Speed_degps = 0.0f;
+
+    // Step well into the spiral, then compare the reported velocity with a central difference.
+    for (int i = 0; i < 300; i++)
+    {
+        previous = setpoint;
+        spiral.GetTargetSetpoint(10, current_m, setpoint, cmdViaAngle, s0Speed_degps,
+                                 s1Speed_degps);
+    }
+    GuidanceSetpoint next;
+    EXPECT_FALSE(spiral.GetTargetSetpoint(10, current_m, next, cmdViaAngle, s0Speed_degps,
+                                          s1Speed_degps));
+
+    EXPECT_TRUE(setpoint.hasVelocity);
+    EXPECT_FALSE(setpoint.hasAcceleration);
+    ExpectNearlyEqual(setpoint.velocity_mps.x,
+                      (next.position_m.x - previous.position_m.x) / 0.02f, 2.0e-4f,
+                      "spiral velocity x");
+    ExpectNearlyEqual(setpoint.velocity_mps.y,
+                      (next.position_m.y - previous.position_m.y) / 0.02f, 2.0e-4f,
+                      "spiral velocity y");
+}
+
+void TestPathPointsAheadAreSpacedByArcLength()
+{
+    ArchimedeanSpiral spiral;
+    SpiralConfig config = MakeValidConfig();
+    spiral.ApplyConfig(config);
+
+    // Walking the path in 0.1 mm steps should cover the distance asked for, even near the centre
+    // where the spiral turns much faster than its tangent suggests.
+    Vector2D previous_m;
+    EXPECT_TRUE(spiral.GetPathPointAhead(Vector2D(0.0f, 0.0f), 0.0f, previous_m));
+    float walked_m = 0.0f;
+    for (int i = 1; i <= 400; i++)
+    {
+        Vector2D point_m;
+        EXPECT_TRUE(spiral.GetPathPointAhead(Vector2D(0.0f, 0.0f), 0.0001f * i, point_m));
+        walked_m += (point_m - previous_m).magnitude();
+        previous_m = point_m;
+    }
+    ExpectNearlyEqual(walked_m, 0.04f, 2.0e-4f, "spiral walked length");
+
+    // Nothing lies beyond the outer radius.
+    Vector2D beyond_m;
+    EXPECT_FALSE(spiral.GetPathPointAhead(Vector2D(0.0f, 0.0f), 10.0f, beyond_m));
+}
 } // namespace
 
 int main()
 {
     TestZeroLinearSpeedDoesNotProduceNonFiniteTarget();
     TestInvalidConfigCompletesAtCurrentPosition();
+    TestSetpointVelocityMatchesPathDerivative();
+    TestPathPointsAheadAreSpacedByArcLength();
 
     PrintTestPassed("ArchimedeanSpiral unit test");
     return EXIT_SUCCESS;
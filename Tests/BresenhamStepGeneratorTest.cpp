@@ -0,0 +1,185 @@
+#include <cstdlib>
+#include <vector>
+
+#include "BresenhamStepGenerator.h"
+#include "HostHardware.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr uint32_t kResolution_hz = 1000000;
+constexpr gpio_num_t kStepA = GPIO_NUM_1;
+constexpr gpio_num_t kDirA = GPIO_NUM_2;
+constexpr gpio_num_t kStepB = GPIO_NUM_3;
+constexpr gpio_num_t kDirB = GPIO_NUM_4;
+
+struct PinLog
+{
+    std::vector<int64_t> risesA_us;
+    std::vector<int64_t> risesB_us;
+    int highPins = 0;
+};
+
+void OnGpioChange(gpio_num_t pin, uint32_t level, int64_t time_us, void *context)
+{
+    PinLog *log = static_cast<PinLog *>(context);
+    if (pin != kStepA && pin != kStepB)
+    {
+        return;
+    }
+    log->highPins += level ? 1 : -1;
+    if (level)
+    {
+        (pin == kStepA ? log->risesA_us : log->risesB_us).push_back(time_us);
+    }
+}
+
+// Counts steps and optionally hands back a new toggle interval, as StepperMotor::onStep does.
+struct FakeMotor
+{
+    int steps = 0;
+    uint64_t nextInterval_ticks = 0;
+
+    static uint64_t OnStep(void *context)
+    {
+        FakeMotor *motor = static_cast<FakeMotor *>(context);
+        motor->steps++;
+        return motor->nextInterval_ticks;
+    }
+};
+
+bool Contains(const std::vector<int64_t> &times_us, int64_t time_us)
+{
+    for (int64_t t : times_us)
+    {
+        if (t == time_us)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TestSlowAxisStepsOnFastAxisEdges()
+{
+    HostHardware::Reset();
+    PinLog log;
+    HostHardware::SetGpioListener(OnGpioChange, &log);
+
+    BresenhamStepGenerator generator("TEST");
+    BresenhamStepGenerator::Channel a(generator, kStepA, kDirA, "A");
+    BresenhamStepGenerator::Channel b(generator, kStepB, kDirB, "B");
+    FakeMotor motorA;
+    FakeMotor motorB;
+    EXPECT_EQ(a.Init(kResolution_hz, FakeMotor::OnStep, &motorA), ESP_OK);
+    EXPECT_EQ(b.Init(kResolution_hz, FakeMotor::OnStep, &motorB), ESP_OK);
+
+    // 10 kHz and 4 kHz steps: toggle intervals of 50 and 125 ticks.
+    EXPECT_EQ(a.SetToggleInterval(50), ESP_OK);
+    EXPECT_EQ(b.SetToggleInterval(125), ESP_OK);
+    EXPECT_EQ(a.Start(), ESP_OK);
+    EXPECT_EQ(b.Start(), ESP_OK);
+    EXPECT_EQ(a.Start(), ESP_ERR_INVALID_STATE);
+    HostHardware::AdvanceTo(100000);
+
+    // Both rates are kept on average...
+    EXPECT_EQ(motorA.steps, 1000);
+    ExpectNearlyEqual(static_cast<float>(motorB.steps), 400.0f, 1.0f, "slow axis steps");
+    EXPECT_EQ(static_cast<size_t>(motorA.steps), log.risesA_us.size());
+
+    // ...one interrupt per fast-axis step drives both, and every slow step shares a fast edge.
+    EXPECT_EQ(HostHardware::GetAlarmCount(), static_cast<uint64_t>(motorA.steps));
+    for (int64_t rise_us : log.risesB_us)
+    {
+        EXPECT_TRUE(Contains(log.risesA_us, rise_us));
+    }
+
+    // Each interrupt leaves every step pin low again.
+    EXPECT_EQ(log.highPins, 0);
+
+    EXPECT_EQ(a.Stop(), ESP_OK);
+    EXPECT_EQ(b.Stop(), ESP_OK);
+    EXPECT_EQ(b.Stop(), ESP_ERR_INVALID_STATE);
+    HostHardware::Reset();
+}
+
+void TestMasterHandsOverWhenFastAxisStops()
+{
+    HostHardware::Reset();
+    PinLog log;
+    HostHardware::SetGpioListener(OnGpioChange, &log);
+
+    BresenhamStepGenerator generator("TEST");
+    BresenhamStepGenerator::Channel a(generator, kStepA, kDirA, "A");
+    BresenhamStepGenerator::Channel b(generator, kStepB, kDirB, "B");
+    FakeMotor motorA;
+    FakeMotor motorB;
+    a.Init(kResolution_hz, FakeMotor::OnStep, &motorA);
+    b.Init(kResolution_hz, FakeMotor::OnStep, &motorB);
+    a.SetToggleInterval(50);
+    b.SetToggleInterval(500);
+    a.Start();
+    b.Start();
+    HostHardware::AdvanceTo(10000);
+    a.Stop();
+    const size_t slowStepsBefore = log.risesB_us.size();
+    const uint64_t alarmsBefore = HostHardware::GetAlarmCount();
+    HostHardware::AdvanceTo(20000);
+
+    // The slow axis carries on at 1 kHz on its own alarms.
+    EXPECT_EQ(log.risesB_us.size() - slowStepsBefore, 10U);
+    EXPECT_EQ(HostHardware::GetAlarmCount() - alarmsBefore, 10U);
+    for (size_t i = slowStepsBefore + 1; i < log.risesB_us.size(); i++)
+    {
+        EXPECT_EQ(log.risesB_us[i] - log.risesB_us[i - 1], 1000);
+    }
+
+    // With everything stopped no more interrupts fire.
+    b.Stop();
+    const uint64_t alarmsStopped = HostHardware::GetAlarmCount();
+    HostHardware::AdvanceTo(30000);
+    EXPECT_EQ(HostHardware::GetAlarmCount(), alarmsStopped);
+    HostHardware::Reset();
+}
+
+void TestHandlerIntervalAppliesFromNextStep()
+{
+    HostHardware::Reset();
+    PinLog log;
+    HostHardware::SetGpioListener(OnGpioChange, &log);
+
+    BresenhamStepGenerator generator("TEST");
+    BresenhamStepGenerator::Channel a(generator, kStepA, kDirA, "A");
+    FakeMotor motorA;
+    a.Init(kResolution_hz, FakeMotor::OnStep, &motorA);
+    a.SetToggleInterval(500);
+    a.Start();
+
+    // First step half a period after the start, as with a toggling timer; then the handler's
+    // interval takes over.
+    motorA.nextInterval_ticks = 100;
+    HostHardware::AdvanceTo(2000);
+    EXPECT_TRUE(log.risesA_us.size() >= 3);
+    EXPECT_EQ(log.risesA_us[0], 500);
+    EXPECT_EQ(log.risesA_us[1], 700);
+    EXPECT_EQ(log.risesA_us[2], 900);
+
+    // A faster interval set from task context re-aims the pending alarm at once.
+    a.SetToggleInterval(25);
+    const size_t before = log.risesA_us.size();
+    HostHardware::AdvanceTo(2100);
+    EXPECT_TRUE(log.risesA_us.size() - before >= 1);
+    a.Stop();
+    HostHardware::Reset();
+}
+} // namespace
+
+int main()
+{
+    TestSlowAxisStepsOnFastAxisEdges();
+    TestMasterHandsOverWhenFastAxisStops();
+    TestHandlerIntervalAppliesFromNextStep();
+
+    PrintTestPassed("BresenhamStepGenerator unit test");
+    return EXIT_SUCCESS;
+}
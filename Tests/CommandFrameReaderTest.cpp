@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CNCOpCodes.h"
+#include "CommandFrameReader.h"
+#include "ProgramPacket.h"
+#include "TestHarness.h"
+
+namespace
+{
+std::vector<uint8_t> MakeProgram(const std::vector<uint8_t> &body, uint16_t count)
+{
+    uint32_t crc = ProgramCrc32(body.data(), body.size());
+    uint16_t bodyLength = static_cast<uint16_t>(body.size());
+    std::vector<uint8_t> packet = {CNC_PROGRAM_OPCODE, static_cast<uint8_t>(PROGRAM_HEADER_LEN), 7, 0};
+    packet.push_back(static_cast<uint8_t>(count));
+    packet.push_back(static_cast<uint8_t>(count >> 8));
+    packet.push_back(static_cast<uint8_t>(bodyLength));
+    packet.push_back(static_cast<uint8_t>(bodyLength >> 8));
+    for (int i = 0; i < 4; i++)
+    {
+        packet.push_back(static_cast<uint8_t>(crc >> (8 * i)));
+    }
+    packet.insert(packet.end(), body.begin(), body.end());
+    return packet;
+}
+
+// A stop, a jog, an empty-payload command and a program, back to back.
+std::vector<std::vector<uint8_t>> MakeFrames()
+{
+    std::vector<std::vector<uint8_t>> frames;
+    frames.push_back({0x03, 0});
+    frames.push_back({CNC_JOG_OPCODE, 4, 1, 2, 3, 4});
+    frames.push_back({0x04, 0});
+    frames.push_back(MakeProgram({CNC_WAIT_OPCODE, 2, 0x10, 0x00, CNC_HOME_OPCODE, 0}, 2));
+    return frames;
+}
+
+std::vector<std::vector<uint8_t>> ReadAll(const std::vector<uint8_t> &stream, size_t chunk)
+{
+    CommandFrameReader reader;
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t start = 0; start < stream.size(); start += chunk)
+    {
+        size_t end = (start + chunk < stream.size()) ? start + chunk : stream.size();
+        size_t offset = start;
+        while (offset < end)
+        {
+            offset += reader.Consume(stream.data() + offset, end - offset);
+            EXPECT_FALSE(reader.IsBroken());
+            if (reader.HasFrame())
+            {
+                size_t length = 0;
+                const uint8_t *frame = reader.GetFrame(length);
+                frames.emplace_back(frame, frame + length);
+                reader.TakeFrame();
+            }
+        }
+    }
+    return frames;
+}
+
+void TestFramesSurviveAnySplit()
+{
+    std::vector<std::vector<uint8_t>> expected = MakeFrames();
+    std::vector<uint8_t> stream;
+    for (const auto &frame : expected)
+    {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    for (size_t chunk = 1; chunk <= stream.size(); chunk++)
+    {
+        std::vector<std::vector<uint8_t>> frames = ReadAll(stream, chunk);
+        EXPECT_EQ(frames.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            EXPECT_TRUE(frames[i] == expected[i]);
+        }
+    }
+}
+
+void TestFrameIsHeldUntilTaken()
+{
+    CommandFrameReader reader;
+    const uint8_t stream[] = {0x03, 0, 0x04, 0};
+    EXPECT_EQ(reader.Consume(stream, sizeof(stream)), static_cast<size_t>(2));
+    EXPECT_TRUE(reader.HasFrame());
+    EXPECT_EQ(reader.Consume(stream + 2, 2), static_cast<size_t>(0));
+    reader.TakeFrame();
+    EXPECT_EQ(reader.Consume(stream + 2, 2), static_cast<size_t>(2));
+    size_t length = 0;
+    EXPECT_EQ(reader.GetFrame(length)[0], 0x04);
+    EXPECT_EQ(length, static_cast<size_t>(2));
+}
+
+void TestStreamThatCannotBeFramedBreaksTheReader()
+{
+    // Base64 text is not a binary command.
+    CommandFrameReader reader;
+    const uint8_t text[] = {'E', 'g', 'E', '='};
+    reader.Consume(text, sizeof(text));
+    EXPECT_TRUE(reader.IsBroken());
+    EXPECT_FALSE(reader.HasFrame());
+    EXPECT_EQ(reader.Consume(text, sizeof(text)), static_cast<size_t>(0));
+
+    reader.Reset();
+    const uint8_t tooLong[] = {CNC_JOG_OPCODE, 255};
+    reader.Consume(tooLong, sizeof(tooLong));
+    EXPECT_TRUE(reader.IsBroken());
+
+    reader.Reset();
+    const uint8_t badProgram[] = {CNC_PROGRAM_OPCODE, 4, 0, 0, 0, 0};
+    reader.Consume(badProgram, sizeof(badProgram));
+    EXPECT_TRUE(reader.IsBroken());
+
+    reader.Reset();
+    std::vector<uint8_t> program = MakeProgram(std::vector<uint8_t>(CMD_PROGRAM_MAX_LEN, 0), 1);
+    reader.Consume(program.data(), program.size());
+    EXPECT_TRUE(reader.IsBroken());
+
+    reader.Reset();
+    const uint8_t stop[] = {0x03, 0};
+    EXPECT_EQ(reader.Consume(stop, sizeof(stop)), sizeof(stop));
+    EXPECT_TRUE(reader.HasFrame());
+}
+} // namespace
+
+int main()
+{
+    TestFramesSurviveAnySplit();
+    TestFrameIsHeldUntilTaken();
+    TestStreamThatCannotBeFramedBreaksTheReader();
+
+    PrintTestPassed("CommandFrameReader unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "CNCOpCodes.h"
+#include "CommandSlab.h"
+#include "TestHarness.h"
+
+namespace
+{
+cmd_handle_t StoreCommand(CommandSlab &slab, uint8_t opcode, size_t payloadLength)
+{
+    uint8_t *instructions = nullptr;
+    cmd_handle_t handle = slab.Allocate(1000 + opcode, 2 + payloadLength, instructions);
+    if (handle != CMD_HANDLE_INVALID)
+    {
+        instructions[0] = opcode;
+        instructions[1] = static_cast<uint8_t>(payloadLength);
+        std::memset(instructions + 2, opcode, payloadLength);
+    }
+    return handle;
+}
+
+void TestCommandsAreReadInPlace()
+{
+    CommandSlab slab;
+    cmd_handle_t jog = StoreCommand(slab, 0x11, 16);
+    cmd_handle_t arc = StoreCommand(slab, 0x17, 24);
+    EXPECT_TRUE(jog != CMD_HANDLE_INVALID);
+    EXPECT_TRUE(arc != CMD_HANDLE_INVALID);
+    EXPECT_EQ(slab.GetLiveCount(), 2U);
+
+    DecodedCommand command;
+    EXPECT_TRUE(slab.GetDecoded(arc, command));
+    EXPECT_EQ(command.handle, arc);
+    EXPECT_EQ(command.opcode, 0x17);
+    EXPECT_EQ(command.instruction_length, 24);
+    EXPECT_EQ(command.timestamp_ms, 1000 + 0x17);
+    EXPECT_EQ(command.instructions[2 + 23], 0x17);
+
+    // The view points into the slab, so an edit by the owner is what the next reader sees.
+    command.instructions[2] = 0xAB;
+    DecodedCommand again;
+    EXPECT_TRUE(slab.GetDecoded(arc, again));
+    EXPECT_EQ(again.instructions[2], 0xAB);
+
+    slab.Release(jog);
+    slab.Release(arc);
+    EXPECT_EQ(slab.GetLiveCount(), 0U);
+    EXPECT_EQ(slab.GetFreeBytes(), COMMAND_SLAB_BYTES);
+    EXPECT_FALSE(slab.GetDecoded(arc, command));
+}
+
+void TestMalformedRecordIsNotDecoded()
+{
+    CommandSlab slab;
+    uint8_t *data = nullptr;
+    cmd_handle_t shortRecord = slab.Allocate(0, 1, data);
+    data[0] = 0x11;
+    cmd_handle_t badLength = slab.Allocate(0, 4, data);
+    data[0] = 0x11;
+    data[1] = 3;
+
+    DecodedCommand command;
+    EXPECT_FALSE(slab.GetDecoded(shortRecord, command));
+    EXPECT_FALSE(slab.GetDecoded(badLength, command));
+    EXPECT_FALSE(slab.GetDecoded(CMD_HANDLE_INVALID, command));
+}
+
+void TestHoldsFarMoreJogsThanTheOldQueue()
+{
+    CommandSlab slab;
+    size_t stored = 0;
+    while (StoreCommand(slab, 0x11, 16) != CMD_HANDLE_INVALID)
+    {
+        stored++;
+    }
+    EXPECT_TRUE(stored > 4 * 32);
+    EXPECT_EQ(slab.GetLiveCount(), stored);
+
+    uint8_t *data = nullptr;
+    EXPECT_EQ(slab.Allocate(0, COMMAND_SLAB_BYTES, data), CMD_HANDLE_INVALID);
+    EXPECT_TRUE(data == nullptr);
+}
+
+void TestSpaceIsReclaimedFromTheOldestRecord()
+{
+    CommandSlab slab;
+    cmd_handle_t handles[400];
+    size_t count = 0;
+    while ((handles[count] = StoreCommand(slab, 0x11, 16)) != CMD_HANDLE_INVALID)
+    {
+        count++;
+    }
+
+    // A record released out of order frees nothing while an older one is still held...
+    slab.Release(handles[1]);
+    EXPECT_EQ(StoreCommand(slab, 0x11, 16), CMD_HANDLE_INVALID);
+
+    // ...and both come back once the oldest goes.
+    slab.Release(handles[0]);
+    cmd_handle_t reused = StoreCommand(slab, 0x11, 16);
+    EXPECT_TRUE(reused != CMD_HANDLE_INVALID);
+    EXPECT_TRUE(StoreCommand(slab, 0x11, 16) != CMD_HANDLE_INVALID);
+    EXPECT_EQ(StoreCommand(slab, 0x11, 16), CMD_HANDLE_INVALID);
+}
+
+// Pass one base64 command row through the slab as InfluxDB polling and CommandHandler do: the
+// text is written, decoded into a record of its own and released. Returns the decoded record,
+// or CMD_HANDLE_INVALID if either did not fit.
+cmd_handle_t PostRow(CommandSlab &slab, const char *text, size_t decodedLength)
+{
+    const size_t textLength = std::strlen(text);
+    const uint8_t opcode = PeekRawCommandOpcode(reinterpret_cast<const uint8_t *>(text), textLength);
+    const bool immediate = IsImmediateOpcode(opcode);
+    uint8_t *raw = nullptr;
+    cmd_handle_t rawHandle = slab.Allocate(0, textLength + 1, raw, immediate);
+    if (rawHandle == CMD_HANDLE_INVALID)
+    {
+        return CMD_HANDLE_INVALID;
+    }
+    std::memcpy(raw, text, textLength + 1);
+
+    uint8_t *instructions = nullptr;
+    cmd_handle_t decoded = slab.Allocate(0, decodedLength, instructions, immediate);
+    if (decoded != CMD_HANDLE_INVALID)
+    {
+        instructions[0] = opcode;
+        instructions[1] = static_cast<uint8_t>(decodedLength - 2);
+    }
+    slab.Release(rawHandle);
+    return decoded;
+}
+
+void TestStopFitsBehindAFullBacklogOfJogs()
+{
+    // A jog with a 16-byte payload, then stop and pause, as the ground station encodes them.
+    const char *jog = "EhAAAQIDBAUGBwgJCgsMDQ4P";
+    const char *stop = "AwA=";
+    const char *pause = "AQA=";
+    EXPECT_EQ(PeekRawCommandOpcode(reinterpret_cast<const uint8_t *>(jog), 2), CNC_JOG_OPCODE);
+    EXPECT_EQ(PeekRawCommandOpcode(reinterpret_cast<const uint8_t *>(stop), 4), 0x03);
+    const uint8_t binaryStop[] = {0x03, 0};
+    EXPECT_EQ(PeekRawCommandOpcode(binaryStop, sizeof(binaryStop)), 0x03);
+
+    // Queue jogs until the slab refuses one; the decoded records stay held, as in the CNC queue,
+    // and keep the released text records behind them from being reclaimed.
+    CommandSlab slab;
+    size_t jogs = 0;
+    while (PostRow(slab, jog, 18) != CMD_HANDLE_INVALID)
+    {
+        jogs++;
+    }
+    EXPECT_TRUE(jogs > 60);
+    EXPECT_TRUE(slab.GetFreeBytes() >= COMMAND_SLAB_RESERVE_BYTES);
+
+    // Stops and pauses still get through, one after another, while the backlog stays...
+    for (int i = 0; i < 8; i++)
+    {
+        cmd_handle_t command = PostRow(slab, (i % 2 == 0) ? stop : pause, 2);
+        EXPECT_TRUE(command != CMD_HANDLE_INVALID);
+        DecodedCommand decoded;
+        EXPECT_TRUE(slab.GetDecoded(command, decoded));
+        EXPECT_EQ(decoded.opcode, (i % 2 == 0) ? 0x03 : 0x01);
+        slab.Release(command);
+    }
+    // ...and motion is still refused.
+    EXPECT_EQ(PostRow(slab, jog, 18), CMD_HANDLE_INVALID);
+    EXPECT_EQ(StoreCommand(slab, 0x11, 16), CMD_HANDLE_INVALID);
+}
+
+void TestRecordsWrapAroundTheRing()
+{
+    // Stream commands of mixed sizes through a slab that only ever holds a few, as the motor loop
+    // does, and check every record comes back intact after the ring has wrapped many times.
+    CommandSlab slab;
+    cmd_handle_t fifo[8];
+    size_t lengths[8];
+    size_t head = 0;
+    size_t count = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        if (count == 8)
+        {
+            DecodedCommand oldest;
+            EXPECT_TRUE(slab.GetDecoded(fifo[head], oldest));
+            EXPECT_EQ(oldest.instruction_length, lengths[head]);
+            for (size_t j = 0; j < oldest.instruction_length; j++)
+            {
+                EXPECT_EQ(oldest.instructions[2 + j], oldest.opcode);
+            }
+            slab.Release(fifo[head]);
+            head = (head + 1) % 8;
+            count--;
+        }
+
+        size_t tail = (head + count) % 8;
+        lengths[tail] = static_cast<size_t>((i * 37) % 200);
+        fifo[tail] = StoreCommand(slab, static_cast<uint8_t>(0x10 + i % 8), lengths[tail]);
+        EXPECT_TRUE(fifo[tail] != CMD_HANDLE_INVALID);
+        count++;
+    }
+    for (; count > 0; count--, head = (head + 1) % 8)
+    {
+        slab.Release(fifo[head]);
+    }
+    EXPECT_EQ(slab.GetFreeBytes(), COMMAND_SLAB_BYTES);
+}
+} // namespace
+
+int main()
+{
+    TestCommandsAreReadInPlace();
+    TestMalformedRecordIsNotDecoded();
+    TestHoldsFarMoreJogsThanTheOldQueue();
+    TestSpaceIsReclaimedFromTheOldestRecord();
+    TestStopFitsBehindAFullBacklogOfJogs();
+    TestRecordsWrapAroundTheRing();
+
+    PrintTestPassed("CommandSlab unit test");
+    return EXIT_SUCCESS;
+}
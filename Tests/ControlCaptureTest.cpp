@@ -0,0 +1,198 @@
+#include <cstdlib>
+#include <string>
+
+#include "ControlCapture.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr int64_t kCyclePeriod_us = 10000;
+
+// Static: the ring is too big for a test's stack frame.
+ControlCapture capture;
+
+// One cycle's telemetry with its index in the S0 position so samples can be told apart.
+control_tlm_t CycleTelemetry(int64_t cycle, uint32_t queueClearCount = 0, int64_t start_us = 1000000)
+{
+    control_tlm_t tlm{};
+    tlm.sampleTime_us = start_us + cycle * kCyclePeriod_us;
+    tlm.S0MotorTlm.Position_deg = static_cast<float>(cycle);
+    tlm.S0MotorTlm.TargetSpeed_degps = 20.0f;
+    tlm.S1MotorTlm.Speed_degps = -5.0f;
+    tlm.plannedTarget_S1_deg = -90.0f;
+    tlm.cncQueueClearCount = queueClearCount;
+    return tlm;
+}
+
+control_tlm_t WithLimitSwitches(control_tlm_t tlm, bool s0LimitSwitch, bool s1LimitSwitch)
+{
+    tlm.limitSwitch_S0 = s0LimitSwitch;
+    tlm.limitSwitch_S1 = s1LimitSwitch;
+    return tlm;
+}
+
+void ResetCapture()
+{
+    if (capture.GetState() == ControlCaptureState::Captured)
+    {
+        capture.Release();
+    }
+    // Run out any capture in progress with a command trigger and throw it away.
+    for (int i = 0; capture.GetState() != ControlCaptureState::Idle && i < 2; i++)
+    {
+        capture.RequestTrigger();
+        for (size_t cycle = 0; cycle < CONTROL_CAPTURE_SAMPLES && capture.GetState() != ControlCaptureState::Captured;
+             cycle++)
+        {
+            capture.Record(CycleTelemetry(0));
+        }
+        capture.Release();
+    }
+}
+
+void TestCommandTriggerKeepsRunUpAndFollowUp()
+{
+    ResetCapture();
+    capture.Record(CycleTelemetry(-1));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Idle);
+
+    capture.RequestArm(100, 0);
+    int64_t cycle = 0;
+    for (; cycle < 700; cycle++)
+    {
+        capture.Record(CycleTelemetry(cycle));
+    }
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Armed);
+
+    capture.RequestTrigger();
+    const int64_t triggerCycle = cycle;
+    for (; cycle < triggerCycle + 100; cycle++)
+    {
+        capture.Record(CycleTelemetry(cycle));
+        EXPECT_TRUE(capture.GetState() == ControlCaptureState::Triggered);
+    }
+    capture.Record(CycleTelemetry(cycle));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Captured);
+
+    // Frozen: later cycles do not touch it.
+    capture.Record(CycleTelemetry(cycle + 1));
+
+    EXPECT_EQ(capture.GetSampleCount(), CONTROL_CAPTURE_SAMPLES);
+    EXPECT_EQ(capture.GetTriggerIndex(), CONTROL_CAPTURE_SAMPLES - 1 - 100);
+    EXPECT_EQ(static_cast<int>(capture.GetTriggerSource()), static_cast<int>(CAPTURE_TRIGGER_COMMAND));
+
+    const ControlCaptureSample &trigger = capture.GetSample(capture.GetTriggerIndex());
+    ExpectNearlyEqual(trigger.s0Pos_deg, static_cast<float>(triggerCycle), 0.0f, "trigger cycle");
+    EXPECT_TRUE((trigger.flags & CAPTURE_FLAG_TRIGGER) != 0);
+    for (size_t i = 0; i < capture.GetSampleCount(); i++)
+    {
+        const ControlCaptureSample &sample = capture.GetSample(i);
+        int64_t expectedCycle = triggerCycle + 100 - static_cast<int64_t>(CONTROL_CAPTURE_SAMPLES - 1 - i);
+        ExpectNearlyEqual(sample.s0Pos_deg, static_cast<float>(expectedCycle), 0.0f, "sample order");
+        EXPECT_EQ(capture.GetSampleTime_us(i), 1000000 + expectedCycle * kCyclePeriod_us);
+        EXPECT_EQ((sample.flags & CAPTURE_FLAG_TRIGGER) != 0, i == capture.GetTriggerIndex());
+    }
+    ExpectNearlyEqual(trigger.s0CmdSpeed_degps, 20.0f, 0.0f, "commanded speed");
+    ExpectNearlyEqual(trigger.s1Speed_degps, -5.0f, 0.0f, "speed");
+    ExpectNearlyEqual(trigger.s1Target_deg, -90.0f, 0.0f, "planned target");
+
+    // An arm sent while the capture waits for upload holds until it is released.
+    capture.RequestArm(10, CAPTURE_TRIGGER_ALL);
+    capture.Record(CycleTelemetry(cycle + 2));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Captured);
+    capture.Release();
+    capture.Record(CycleTelemetry(cycle + 3));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Armed);
+    EXPECT_EQ(capture.GetSampleCount(), static_cast<size_t>(1));
+}
+
+void TestEventTriggersFollowTheArmMask()
+{
+    ResetCapture();
+    capture.Record(CycleTelemetry(-1, 7));
+    capture.RequestArm(3, CAPTURE_TRIGGER_STOP);
+    capture.Record(WithLimitSwitches(CycleTelemetry(0, 7), true, false));
+    capture.Record(CycleTelemetry(1, 7));
+    // A switch closing is not in the mask.
+    capture.Record(WithLimitSwitches(CycleTelemetry(2, 7), true, false));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Armed);
+
+    // A stop or limit stop shows up as the queue clear count moving.
+    capture.Record(WithLimitSwitches(CycleTelemetry(3, 8), true, false));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Triggered);
+    for (int64_t cycle = 4; cycle < 7; cycle++)
+    {
+        capture.Record(WithLimitSwitches(CycleTelemetry(cycle, 8), true, false));
+    }
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Captured);
+    EXPECT_EQ(capture.GetSampleCount(), static_cast<size_t>(7));
+    EXPECT_EQ(capture.GetTriggerIndex(), static_cast<size_t>(3));
+    EXPECT_EQ(static_cast<int>(capture.GetTriggerSource()), static_cast<int>(CAPTURE_TRIGGER_STOP));
+    EXPECT_TRUE((capture.GetSample(3).flags & CAPTURE_FLAG_QUEUE_CLEARED) != 0);
+    EXPECT_TRUE((capture.GetSample(3).flags & CAPTURE_FLAG_S0_LIMIT_SWITCH) != 0);
+    EXPECT_TRUE((capture.GetSample(1).flags & CAPTURE_FLAG_S0_LIMIT_SWITCH) == 0);
+
+    // A switch already closed when the capture is armed only triggers when it closes again.
+    capture.Release();
+    capture.Record(WithLimitSwitches(CycleTelemetry(7, 8), false, true));
+    capture.RequestArm(0, CAPTURE_TRIGGER_LIMIT_SWITCH);
+    capture.Record(WithLimitSwitches(CycleTelemetry(8, 8), false, true));
+    capture.Record(WithLimitSwitches(CycleTelemetry(9, 8), false, true));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Armed);
+    capture.Record(CycleTelemetry(10, 8));
+    capture.Record(WithLimitSwitches(CycleTelemetry(11, 8), false, true));
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Captured);
+    EXPECT_EQ(capture.GetTriggerIndex(), capture.GetSampleCount() - 1);
+}
+
+void TestSampleTimesSurviveTimerWordWrap()
+{
+    ResetCapture();
+    const int64_t start_us = (int64_t(1) << 32) - 5 * kCyclePeriod_us;
+    capture.RequestArm(5, 0);
+    for (int64_t cycle = 0; cycle < 5; cycle++)
+    {
+        capture.Record(CycleTelemetry(cycle, 0, start_us));
+    }
+    capture.RequestTrigger();
+    for (int64_t cycle = 5; cycle < 11; cycle++)
+    {
+        capture.Record(CycleTelemetry(cycle, 0, start_us));
+    }
+    EXPECT_TRUE(capture.GetState() == ControlCaptureState::Captured);
+    for (size_t i = 0; i < capture.GetSampleCount(); i++)
+    {
+        EXPECT_EQ(capture.GetSampleTime_us(i), start_us + static_cast<int64_t>(i) * kCyclePeriod_us);
+    }
+}
+
+void TestSampleFormatsAsCaptureLine()
+{
+    ControlCaptureSample sample{};
+    sample.s0Pos_deg = 12.5f;
+    sample.s1Pos_deg = -3.0f;
+    sample.s0CmdSpeed_degps = 40.0f;
+    sample.flags = CAPTURE_FLAG_TRIGGER | CAPTURE_FLAG_S1_LIMIT_SWITCH;
+
+    TelemetryField fields[CONTROL_CAPTURE_FIELD_COUNT];
+    size_t count = GetControlCaptureFields(sample, fields);
+    EXPECT_EQ(count, CONTROL_CAPTURE_FIELD_COUNT);
+
+    char line[256];
+    size_t length = FormatTelemetryLine(line, sizeof(line), CONTROL_CAPTURE_LINE_PREFIX, fields, count, 1767225662010);
+    EXPECT_EQ(std::string(line, length),
+              std::string("cap,location=us-midwest s0=12.5,s1=-3,s0p=0,s1p=0,s0vt=40,s1vt=0,s0v=0,s1v=0,pv=0,f=34 "
+                          "1767225662010\n"));
+}
+} // namespace
+
+int main()
+{
+    TestCommandTriggerKeepsRunUpAndFollowUp();
+    TestEventTriggersFollowTheArmMask();
+    TestSampleTimesSurviveTimerWordWrap();
+    TestSampleFormatsAsCaptureLine();
+
+    PrintTestPassed("ControlCapture unit test");
+    return EXIT_SUCCESS;
+}
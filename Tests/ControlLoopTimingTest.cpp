@@ -0,0 +1,215 @@
+#include <cstdlib>
+
+#include "ControlLoopTiming.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr uint32_t kPeriod_us = 10000;
+constexpr uint32_t kMaxGuidanceStep_us = 50000;
+constexpr uint32_t kWindowCycles = 4;
+
+// Simulated monotonic clock driven by the test instead of esp_timer.
+struct SimulatedClock
+{
+    int64_t now_us = 1000000;
+
+    void Advance(int64_t delta_us) { now_us += delta_us; }
+};
+
+// Runs one cycle: wake `wakeLate_us` after the scheduled deadline, then spend `work_us`.
+unsigned int RunCycle(ControlLoopTiming &timing, SimulatedClock &clock, int64_t wakeLate_us,
+                      int64_t work_us, bool &overran)
+{
+    clock.now_us = timing.GetNextDeadline_us() + wakeLate_us;
+    unsigned int elapsed_ms = timing.BeginCycle(clock.now_us);
+    clock.Advance(work_us);
+    overran = timing.EndCycle(clock.now_us);
+    return elapsed_ms;
+}
+
+void TestOnTimeCyclesReportNominalPeriod()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    timing.Start(clock.now_us);
+
+    bool overran = true;
+    for (int i = 0; i < 10; i++)
+    {
+        // The first cycle runs at Start, so no time has passed yet.
+        EXPECT_EQ(RunCycle(timing, clock, 0, 2000, overran), (i == 0) ? 0U : 10U);
+        EXPECT_FALSE(overran);
+    }
+
+    const ControlLoopTimingStats &stats = timing.GetStats();
+    EXPECT_EQ(stats.cycleCount, 10U);
+    EXPECT_EQ(stats.overrunCount, 0U);
+    EXPECT_EQ(stats.lastJitter_us, 0);
+    EXPECT_EQ(stats.worstLatency_us, 2000U);
+}
+
+void TestDeadlinesDoNotAccumulateWorkTime()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    int64_t start_us = clock.now_us;
+    timing.Start(start_us);
+
+    // A relative delay would drift by the work time every cycle; absolute deadlines do not.
+    bool overran = false;
+    for (int i = 0; i < 100; i++)
+    {
+        RunCycle(timing, clock, 0, 7000, overran);
+    }
+
+    EXPECT_EQ(timing.GetNextDeadline_us(), start_us + 100 * static_cast<int64_t>(kPeriod_us));
+}
+
+void TestGuidanceTimeTracksWallTimeUnderJitter()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    int64_t start_us = clock.now_us;
+    timing.Start(start_us);
+
+    const int64_t lateness_us[] = {0, 1300, 250, 4700, 0, 900, 3100, 0};
+    unsigned int guidanceTotal_ms = 0;
+    bool overran = false;
+    for (int i = 0; i < 800; i++)
+    {
+        guidanceTotal_ms += RunCycle(timing, clock, lateness_us[i % 8], 1000, overran);
+    }
+
+    // The carried sub-millisecond remainder keeps integrated guidance time within 1 ms of wall time.
+    int64_t lastStartOffset_us = clock.now_us - 1000 - start_us;
+    EXPECT_TRUE(static_cast<int64_t>(guidanceTotal_ms) * 1000 <= lastStartOffset_us);
+    EXPECT_TRUE(static_cast<int64_t>(guidanceTotal_ms) * 1000 > lastStartOffset_us - 1000);
+}
+
+void TestLateWakeReportsJitterAndLatency()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    timing.Start(clock.now_us);
+
+    bool overran = false;
+    RunCycle(timing, clock, 0, 1000, overran);
+    EXPECT_EQ(RunCycle(timing, clock, 3500, 1000, overran), 13U);
+    EXPECT_FALSE(overran);
+
+    const ControlLoopTimingStats &stats = timing.GetStats();
+    EXPECT_EQ(stats.lastJitter_us, 3500);
+    EXPECT_EQ(stats.lastLatency_us, 4500U);
+    EXPECT_EQ(stats.worstLatency_us, 4500U);
+
+    // Next wake is on time, so the cycle is shortened to absorb the late one.
+    EXPECT_EQ(RunCycle(timing, clock, 0, 1000, overran), 7U);
+}
+
+void TestOverrunSkipsMissedDeadlines()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    timing.Start(clock.now_us);
+
+    bool overran = false;
+    int64_t deadline_us = timing.GetNextDeadline_us();
+    RunCycle(timing, clock, 0, 25000, overran);
+    EXPECT_TRUE(overran);
+
+    const ControlLoopTimingStats &stats = timing.GetStats();
+    EXPECT_EQ(stats.overrunCount, 1U);
+    EXPECT_EQ(stats.skippedDeadlineCount, 2U);
+    EXPECT_EQ(timing.GetNextDeadline_us(), deadline_us + 3 * static_cast<int64_t>(kPeriod_us));
+    EXPECT_TRUE(timing.GetNextDeadline_us() > clock.now_us);
+}
+
+void TestFirmwareCallOrderWakesOnDeadline()
+{
+    // MotorControlTask calls Start and runs its first cycle at once, then sleeps until each
+    // period after the previous wake.
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    const int64_t start_us = clock.now_us;
+    timing.Start(start_us);
+
+    bool overran = true;
+    EXPECT_EQ(timing.BeginCycle(clock.now_us), 0U);
+    clock.Advance(2000);
+    EXPECT_FALSE(timing.EndCycle(clock.now_us));
+    EXPECT_EQ(timing.GetStats().lastJitter_us, 0);
+    EXPECT_EQ(timing.GetStats().lastLatency_us, 2000U);
+
+    for (int k = 1; k <= 5; k++)
+    {
+        clock.now_us = start_us + k * static_cast<int64_t>(kPeriod_us);
+        EXPECT_EQ(timing.BeginCycle(clock.now_us), 10U);
+        clock.Advance(2000);
+        overran = timing.EndCycle(clock.now_us);
+        EXPECT_FALSE(overran);
+        EXPECT_EQ(timing.GetStats().lastJitter_us, 0);
+        EXPECT_EQ(timing.GetStats().lastLatency_us, 2000U);
+    }
+    EXPECT_EQ(timing.GetStats().overrunCount, 0U);
+
+    // Work just over one period runs past the next wake and counts as an overrun.
+    clock.now_us = start_us + 6 * static_cast<int64_t>(kPeriod_us);
+    timing.BeginCycle(clock.now_us);
+    clock.Advance(kPeriod_us + 100);
+    EXPECT_TRUE(timing.EndCycle(clock.now_us));
+    EXPECT_EQ(timing.GetStats().overrunCount, 1U);
+    EXPECT_EQ(timing.GetStats().lastLatency_us, kPeriod_us + 100);
+}
+
+void TestLongStallIsClampedForGuidance()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    timing.Start(clock.now_us);
+
+    bool overran = false;
+    EXPECT_EQ(RunCycle(timing, clock, 500000, 1000, overran), 50U);
+    EXPECT_EQ(timing.GetStats().lastElapsed_us, 500000U);
+}
+
+void TestWindowReportsWorstValuesThenResets()
+{
+    SimulatedClock clock;
+    ControlLoopTiming timing(kPeriod_us, kMaxGuidanceStep_us, kWindowCycles);
+    timing.Start(clock.now_us);
+
+    bool overran = false;
+    RunCycle(timing, clock, 200, 1000, overran);
+    RunCycle(timing, clock, 2400, 1000, overran);
+    RunCycle(timing, clock, 100, 3000, overran);
+    EXPECT_EQ(timing.GetStats().windowWorstJitter_us, 0U);
+
+    RunCycle(timing, clock, 0, 1000, overran);
+    EXPECT_EQ(timing.GetStats().windowWorstJitter_us, 2400U);
+    EXPECT_EQ(timing.GetStats().windowWorstLatency_us, 3400U);
+
+    for (int i = 0; i < 4; i++)
+    {
+        RunCycle(timing, clock, 0, 500, overran);
+    }
+    EXPECT_EQ(timing.GetStats().windowWorstJitter_us, 0U);
+    EXPECT_EQ(timing.GetStats().windowWorstLatency_us, 500U);
+    EXPECT_EQ(timing.GetStats().worstLatency_us, 3400U);
+}
+} // namespace
+
+int main()
+{
+    TestOnTimeCyclesReportNominalPeriod();
+    TestDeadlinesDoNotAccumulateWorkTime();
+    TestGuidanceTimeTracksWallTimeUnderJitter();
+    TestLateWakeReportsJitterAndLatency();
+    TestOverrunSkipsMissedDeadlines();
+    TestFirmwareCallOrderWakesOnDeadline();
+    TestLongStallIsClampedForGuidance();
+    TestWindowReportsWorstValuesThenResets();
+
+    PrintTestPassed("ControlLoopTiming unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "ElbowSelector.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr AngleMotion::AngleMoveLimitsDeg S0Limits{true, {210.0f, 300.0f}, false, {0.0f, 0.0f}};
+constexpr AngleMotion::AngleMoveLimitsDeg S1Limits{false, {0.0f, 0.0f}, true, {-270.0f, 270.0f}};
+
+void TestBothBranchesReachTheSameTip()
+{
+    for (int ix = -6; ix <= 6; ix++)
+    {
+        for (int iy = -6; iy <= 6; iy++)
+        {
+            Vector2D target_m(0.05f * ix, 0.05f * iy);
+            float s0_deg[2];
+            float s1_deg[2];
+            if (CartToAngBothBranches(s0_deg, s1_deg, target_m) != E_OK)
+            {
+                continue;
+            }
+
+            float legacyS0_deg = 0.0f;
+            float legacyS1_deg = 0.0f;
+            EXPECT_EQ(CartToAng(legacyS0_deg, legacyS1_deg, target_m), E_OK);
+            EXPECT_EQ(s0_deg[0], legacyS0_deg);
+            EXPECT_EQ(s1_deg[0], legacyS1_deg);
+            EXPECT_TRUE(s1_deg[0] <= 0.0f);
+            EXPECT_EQ(s1_deg[1], -s1_deg[0]);
+
+            for (int b = 0; b < 2; b++)
+            {
+                Vector2D tip_m;
+                AngToCart(s0_deg[b], s1_deg[b], tip_m);
+                ExpectNearlyEqual(tip_m.x, target_m.x, 1.0e-5f, "branch tip x");
+                ExpectNearlyEqual(tip_m.y, target_m.y, 1.0e-5f, "branch tip y");
+            }
+        }
+    }
+
+    float s0_deg[2] = {1.0f, 2.0f};
+    float s1_deg[2] = {3.0f, 4.0f};
+    EXPECT_EQ(CartToAngBothBranches(s0_deg, s1_deg, Vector2D(0.5f, 0.0f)), E_UNREACHABLE_TOO_FAR);
+    EXPECT_EQ(s0_deg[0], 1.0f);
+    EXPECT_EQ(s1_deg[1], 4.0f);
+}
+
+void TestElbowBranchOfJointPose()
+{
+    EXPECT_TRUE(GetElbowBranch(-115.0f) == ElbowBranch::Negative);
+    EXPECT_TRUE(GetElbowBranch(60.0f) == ElbowBranch::Positive);
+    EXPECT_TRUE(GetElbowBranch(-250.0f) == ElbowBranch::Positive);
+    EXPECT_TRUE(GetElbowBranch(250.0f) == ElbowBranch::Negative);
+}
+
+void TestPathStartKeepsTheArmsBranch()
+{
+    // An arm left in the positive branch used to be driven through a full elbow flip by the first
+    // Cartesian setpoint; now it carries on in the branch it is in.
+    ElbowSelector selector(S0Limits, S1Limits);
+    Vector2D start_m;
+    Vector2D end_m;
+    AngToCart(120.0f, 60.0f, start_m);
+    AngToCart(110.0f, 70.0f, end_m);
+
+    EXPECT_TRUE(selector.BeginPath(start_m, end_m, 120.0f, 60.0f) == ElbowBranch::Positive);
+    EXPECT_TRUE(selector.IsHolding());
+
+    float s0_deg = 0.0f;
+    float s1_deg = 0.0f;
+    EXPECT_EQ(selector.Solve(start_m, 120.0f, 60.0f, s0_deg, s1_deg), E_OK);
+    ExpectNearlyEqual(s0_deg, 120.0f, 1.0e-3f, "held branch S0");
+    ExpectNearlyEqual(s1_deg, 60.0f, 1.0e-3f, "held branch S1");
+}
+
+void TestPathStartFlipsWhenOnlyTheOtherBranchClearsTheLimits()
+{
+    // From (180, -60) the negative branch would end the path with S0 at 235 deg, inside the
+    // keep-out zone; the positive branch ends it at 202 deg.
+    ElbowSelector selector(S0Limits, S1Limits);
+    Vector2D start_m;
+    AngToCart(180.0f, -60.0f, start_m);
+    Vector2D end_m(-0.20f, -0.25f);
+
+    EXPECT_TRUE(selector.BeginPath(start_m, end_m, 180.0f, -60.0f) == ElbowBranch::Positive);
+
+    float s0_deg = 0.0f;
+    float s1_deg = 0.0f;
+    EXPECT_EQ(selector.Solve(end_m, 180.0f, -60.0f, s0_deg, s1_deg), E_OK);
+    bool blocked = true;
+    AngleMotion::SelectDeltaWithinLimitsDeg(180.0f, s0_deg, S0Limits, blocked);
+    EXPECT_FALSE(blocked);
+    EXPECT_TRUE(s1_deg > 0.0f);
+}
+
+void TestHeldBranchNeverFlipsMidPath()
+{
+    ElbowSelector selector(S0Limits, S1Limits);
+    Vector2D start_m;
+    AngToCart(150.0f, -90.0f, start_m);
+    EXPECT_TRUE(selector.BeginPath(start_m, start_m, 150.0f, -90.0f) == ElbowBranch::Negative);
+
+    // Even with the measured pose in the other branch, the path stays in the one it started in.
+    float s0_deg = 0.0f;
+    float s1_deg = 0.0f;
+    EXPECT_EQ(selector.Solve(start_m, 60.0f, 90.0f, s0_deg, s1_deg), E_OK);
+    ExpectNearlyEqual(s1_deg, -90.0f, 1.0e-3f, "held negative S1");
+    EXPECT_TRUE(selector.GetBranch() == ElbowBranch::Negative);
+
+    // Once the path ends the next Solve picks again from the pose.
+    selector.EndPath();
+    EXPECT_FALSE(selector.IsHolding());
+    Vector2D mirrored_m;
+    AngToCart(60.0f, 90.0f, mirrored_m);
+    EXPECT_EQ(selector.Solve(mirrored_m, 60.0f, 90.0f, s0_deg, s1_deg), E_OK);
+    EXPECT_TRUE(selector.GetBranch() == ElbowBranch::Positive);
+    ExpectNearlyEqual(s1_deg, 90.0f, 1.0e-3f, "new path positive S1");
+}
+
+void TestBranchSwitchesOncePerPath()
+{
+    ElbowSelector selector(S0Limits, S1Limits);
+    EXPECT_FALSE(selector.SwitchBranch());
+
+    Vector2D start_m;
+    AngToCart(150.0f, -90.0f, start_m);
+    EXPECT_TRUE(selector.BeginPath(start_m, start_m, 150.0f, -90.0f) == ElbowBranch::Negative);
+    EXPECT_TRUE(selector.SwitchBranch());
+    EXPECT_TRUE(selector.GetBranch() == ElbowBranch::Positive);
+    EXPECT_FALSE(selector.SwitchBranch());
+    EXPECT_TRUE(selector.GetBranch() == ElbowBranch::Positive);
+
+    // A new path may switch again.
+    selector.BeginPath(start_m, start_m, 150.0f, -90.0f);
+    EXPECT_TRUE(selector.SwitchBranch());
+}
+
+void TestUnreachablePathKeepsTheArmsBranch()
+{
+    ElbowSelector selector(S0Limits, S1Limits);
+    EXPECT_TRUE(selector.BeginPath(Vector2D(0.0f, 0.2f), Vector2D(0.0f, 0.5f), 90.0f, 45.0f) ==
+                ElbowBranch::Positive);
+
+    float s0_deg = 1.0f;
+    float s1_deg = 2.0f;
+    EXPECT_EQ(selector.Solve(Vector2D(0.0f, 0.5f), 90.0f, 45.0f, s0_deg, s1_deg), E_UNREACHABLE_TOO_FAR);
+    EXPECT_EQ(s0_deg, 1.0f);
+    EXPECT_EQ(s1_deg, 2.0f);
+}
+} // namespace
+
+int main()
+{
+    TestBothBranchesReachTheSameTip();
+    TestElbowBranchOfJointPose();
+    TestPathStartKeepsTheArmsBranch();
+    TestPathStartFlipsWhenOnlyTheOtherBranchClearsTheLimits();
+    TestHeldBranchNeverFlipsMidPath();
+    TestBranchSwitchesOncePerPath();
+    TestUnreachablePathKeepsTheArmsBranch();
+
+    PrintTestPassed("ElbowSelector unit test");
+    return EXIT_SUCCESS;
+}
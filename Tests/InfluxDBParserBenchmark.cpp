@@ -0,0 +1,133 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "InfluxDBParser.h"
+#include "InfluxDBStreamParser.h"
+
+// Time and heap allocations per response for the buffered parser the command poll used to run
+// against the streaming parser, on a full-width and a projected response of 32 commands. The
+// streaming parser is fed in 512-byte chunks, the size esp_http_client hands over by default.
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+constexpr int kRows = 32;
+constexpr int kRepeats = 20000;
+constexpr size_t kChunkBytes = 512;
+
+volatile int64_t sink;
+
+std::string MakeResponse(bool projected)
+{
+    std::string body = projected ? ",result,table,_time,_value\r\n"
+                                 : ",result,table,_start,_stop,_time,_value,_field,_measurement\r\n";
+    char row[160];
+    for (int i = 0; i < kRows; i++)
+    {
+        // A typical jog command, base64 encoded.
+        const char *payload = "EQwAAIA/AAAAQAAAQEA=";
+        if (projected)
+        {
+            snprintf(row, sizeof(row), ",_result,0,2026-01-01T00:01:%02d.%03dZ,%s\r\n", i, i * 7, payload);
+        }
+        else
+        {
+            snprintf(row, sizeof(row),
+                     ",_result,0,2026-01-01T00:00:00Z,2026-01-01T00:10:00Z,2026-01-01T00:01:%02d.%03dZ,%s,"
+                     "data,cmd\r\n",
+                     i, i * 7, payload);
+        }
+        body += row;
+    }
+    body += "\r\n";
+    return body;
+}
+
+bool Consume(const InfluxDBCommandRow &row, void *context)
+{
+    *static_cast<int64_t *>(context) += row.timestamp_ms + static_cast<int64_t>(row.payload.size());
+    return true;
+}
+
+template <typename Fn> double SecondsPerResponse(Fn fn, size_t &allocations)
+{
+    size_t before = allocationCount;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeats; r++)
+    {
+        fn();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    allocations = (allocationCount - before) / kRepeats;
+    return std::chrono::duration<double>(stop - start).count() / kRepeats;
+}
+
+void Compare(const char *name, const std::string &body)
+{
+    // The firmware buffered the body as a C string and passed it to the parser.
+    const char *buffered = body.c_str();
+    size_t bufferedAllocations = 0;
+    double buffered_s = SecondsPerResponse(
+        [&]()
+        {
+            std::vector<InfluxDBCommand> cmds;
+            parse_influxdb_command_list(buffered, cmds);
+            sink = cmds.back().timestamp_ms;
+        },
+        bufferedAllocations);
+
+    int64_t checksum = 0;
+    InfluxDBStreamParser parser(Consume, &checksum);
+    size_t streamingAllocations = 0;
+    double streaming_s = SecondsPerResponse(
+        [&]()
+        {
+            parser.Reset();
+            for (size_t offset = 0; offset < body.size(); offset += kChunkBytes)
+            {
+                size_t length = body.size() - offset < kChunkBytes ? body.size() - offset : kChunkBytes;
+                parser.Feed(body.data() + offset, length);
+            }
+            parser.Finish();
+            sink = checksum;
+        },
+        streamingAllocations);
+
+    std::printf("%-9s %5zu bytes  buffered %7.2f us %4zu allocs  streaming %6.2f us %zu allocs  "
+                "speedup %5.1fx\n",
+                name, body.size(), buffered_s * 1.0e6, bufferedAllocations, streaming_s * 1.0e6,
+                streamingAllocations, buffered_s / streaming_s);
+}
+} // namespace
+
+int main()
+{
+    Compare("full", MakeResponse(false));
+    Compare("projected", MakeResponse(true));
+    return EXIT_SUCCESS;
+}
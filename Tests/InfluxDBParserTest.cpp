@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -54,6 +55,55 @@ void TestMalformedResponsesAreRejected()
               static_cast<size_t>(0));
     EXPECT_TRUE(commands.empty());
 }
+
+void TestProjectedResponseFindsColumnsFromHeader()
+{
+    // keep(columns:["_time","_value"]) leaves only these two after result and table, and the
+    // server ends its lines with CRLF.
+    const char *projected =
+        ",result,table,_time,_value\r\n"
+        ",_result,0,2026-01-01T00:01:02.001Z,EgE=\r\n"
+        ",_result,0,2026-01-01T00:01:02.002Z,EgM=\r\n"
+        "\r\n";
+    std::vector<InfluxDBCommand> commands;
+    EXPECT_EQ(parse_influxdb_command_list(projected, commands), static_cast<size_t>(2));
+    EXPECT_EQ(commands[0].timestamp_ms, static_cast<int64_t>(1767225662001));
+    EXPECT_EQ(commands[0].payload, std::string("EgE="));
+    EXPECT_EQ(commands[1].timestamp_ms, static_cast<int64_t>(1767225662002));
+    EXPECT_EQ(commands[1].payload, std::string("EgM="));
+}
+
+void TestRowCutShortIsLeftForNextPoll()
+{
+    const char *truncated =
+        ",result,table,_time,_value\r\n"
+        ",_result,0,2026-01-01T00:01:02.001Z,EgE=\r\n"
+        ",_result,0,2026-01-01T00:01:02.002Z,Eg";
+    std::vector<InfluxDBCommand> commands;
+    EXPECT_EQ(parse_influxdb_command_list(truncated, commands), static_cast<size_t>(1));
+    EXPECT_EQ(commands[0].payload, std::string("EgE="));
+}
+
+void TestCommandQueryStartsAfterLastCommand()
+{
+    char query[384];
+    EXPECT_TRUE(build_influxdb_command_query(query, sizeof(query), "cmds", 1767225784123, 10, 32));
+    const std::string text(query);
+    EXPECT_TRUE(text.find("from(bucket:\"cmds\")") == 0);
+    EXPECT_TRUE(text.find("range(start:2026-01-01T00:03:04.124Z)") != std::string::npos);
+    EXPECT_TRUE(text.find("keep(columns:[\"_time\",\"_value\"])") != std::string::npos);
+    EXPECT_TRUE(text.find("sort(columns:[\"_time\"]) |> limit(n:32)") != std::string::npos);
+
+    // Carrying into the next second.
+    EXPECT_TRUE(build_influxdb_command_query(query, sizeof(query), "cmds", 1767225784999, 10, 32));
+    EXPECT_TRUE(strstr(query, "range(start:2026-01-01T00:03:05.000Z)") != nullptr);
+
+    // No command yet: a relative window instead.
+    EXPECT_TRUE(build_influxdb_command_query(query, sizeof(query), "cmds", 0, 10, 32));
+    EXPECT_TRUE(strstr(query, "range(start:-10s)") != nullptr);
+
+    EXPECT_FALSE(build_influxdb_command_query(query, 64, "cmds", 0, 10, 32));
+}
 } // namespace
 
 int main()
@@ -62,6 +112,9 @@ int main()
     TestParseLatestCommand();
     TestParseCommandListPreservesOrder();
     TestMalformedResponsesAreRejected();
+    TestProjectedResponseFindsColumnsFromHeader();
+    TestRowCutShortIsLeftForNextPoll();
+    TestCommandQueryStartsAfterLastCommand();
 
     PrintTestPassed("InfluxDBParser unit test");
     return EXIT_SUCCESS;
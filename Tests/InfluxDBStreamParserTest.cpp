@@ -0,0 +1,202 @@
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "InfluxDBParser.h"
+#include "InfluxDBStreamParser.h"
+#include "TestHarness.h"
+
+// Count heap allocations so the tests can check that feeding the parser never allocates.
+static size_t allocationCount = 0;
+
+void *operator new(size_t size)
+{
+    allocationCount++;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+const char *kFullResponse =
+    "#group,false,false,true,true,false,false,true,true,true,true\r\n"
+    "#datatype,string,long,dateTime:RFC3339,dateTime:RFC3339,dateTime:RFC3339,string,string,string,string\r\n"
+    "#default,_result,,,,,,,,\r\n"
+    ",result,table,_start,_stop,_time,_value,_field,_measurement,device\r\n"
+    ",_result,0,2026-01-01T00:00:00Z,2026-01-01T00:10:00Z,2026-01-01T00:01:02Z,EgE=,payload,commands,pancake\r\n"
+    ",_result,0,2026-01-01T00:00:00Z,2026-01-01T00:10:00Z,2026-01-01T00:03:04.012Z,EgM=,payload,commands,pancake\r\n"
+    "\r\n"
+    ",_result,0,2026-01-01T00:00:00Z,2026-01-01T00:10:00Z,2026-01-01T00:03:04.123456789Z,EgI=,payload,commands,pancake\r\n"
+    "\r\n";
+
+const char *kProjectedResponse =
+    ",result,table,_time,_value\r\n"
+    ",_result,0,2026-01-01T00:01:02.001Z,EgE=\r\n"
+    ",_result,0,2026-01-01T00:01:02.002Z,EgM=\r\n"
+    "\r\n";
+
+struct Collector
+{
+    // Preallocated so collecting rows does not count against the parser.
+    InfluxDBCommand rows[8];
+    size_t count = 0;
+    size_t acceptLimit = 8;
+};
+
+bool Collect(const InfluxDBCommandRow &row, void *context)
+{
+    Collector &collector = *static_cast<Collector *>(context);
+    if (collector.count >= collector.acceptLimit)
+    {
+        return false;
+    }
+    InfluxDBCommand &out = collector.rows[collector.count++];
+    out.timestamp_ms = row.payloadTooLong ? -row.timestamp_ms : row.timestamp_ms;
+    out.payload.assign(row.payload.data(), row.payload.size() < 8 ? row.payload.size() : 8);
+    return true;
+}
+
+void FeedInChunks(InfluxDBStreamParser &parser, const char *body, size_t chunk)
+{
+    size_t length = strlen(body);
+    for (size_t offset = 0; offset < length; offset += chunk)
+    {
+        parser.Feed(body + offset, (length - offset < chunk) ? length - offset : chunk);
+    }
+    parser.Finish();
+}
+
+void TestIso8601FastPathMatchesCalendar()
+{
+    int64_t ms = 0;
+    EXPECT_TRUE(ParseIso8601Ms("2026-01-01T00:01:02Z", ms));
+    EXPECT_EQ(ms, static_cast<int64_t>(1767225662000));
+    EXPECT_TRUE(ParseIso8601Ms("2024-02-29T23:59:59.5Z", ms));
+    EXPECT_EQ(ms, static_cast<int64_t>(1709251199500));
+    EXPECT_TRUE(ParseIso8601Ms("1970-01-01T00:00:00.000999999Z", ms));
+    EXPECT_EQ(ms, static_cast<int64_t>(0));
+
+    EXPECT_FALSE(ParseIso8601Ms("not-a-timestamp", ms));
+    EXPECT_FALSE(ParseIso8601Ms("2026-13-01T00:00:00Z", ms));
+    EXPECT_FALSE(ParseIso8601Ms("2026-01-01T00:00:00.Z", ms));
+    EXPECT_FALSE(ParseIso8601Ms("2026-01-01T00:00:00Zjunk", ms));
+}
+
+void TestEveryChunkSizeMatchesTheBufferedParser()
+{
+    for (const char *body : {kFullResponse, kProjectedResponse})
+    {
+        std::vector<InfluxDBCommand> expected;
+        parse_influxdb_command_list(body, expected);
+
+        for (size_t chunk = 1; chunk <= strlen(body); chunk++)
+        {
+            Collector collector;
+            InfluxDBStreamParser parser(Collect, &collector);
+            FeedInChunks(parser, body, chunk);
+            EXPECT_EQ(collector.count, expected.size());
+            EXPECT_EQ(parser.GetRejectedRowCount(), static_cast<size_t>(0));
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                EXPECT_EQ(collector.rows[i].timestamp_ms, expected[i].timestamp_ms);
+                EXPECT_EQ(collector.rows[i].payload, expected[i].payload);
+            }
+        }
+    }
+}
+
+void TestFeedingDoesNotAllocate()
+{
+    Collector collector;
+    InfluxDBStreamParser parser(Collect, &collector);
+    size_t before = allocationCount;
+    parser.Feed(kProjectedResponse, 30);
+    parser.Feed(kProjectedResponse + 30, strlen(kProjectedResponse) - 30);
+    parser.Finish();
+    EXPECT_EQ(allocationCount, before);
+    EXPECT_EQ(parser.GetRowCount(), static_cast<size_t>(2));
+}
+
+void TestRefusedRowStopsTheResponse()
+{
+    Collector collector;
+    collector.acceptLimit = 1;
+    InfluxDBStreamParser parser(Collect, &collector);
+    EXPECT_FALSE(parser.Feed(kProjectedResponse, strlen(kProjectedResponse)));
+    EXPECT_TRUE(parser.IsStopped());
+    EXPECT_EQ(collector.count, static_cast<size_t>(1));
+
+    // The next response starts clean.
+    collector.acceptLimit = 8;
+    parser.Reset();
+    EXPECT_TRUE(parser.Feed(kProjectedResponse, strlen(kProjectedResponse)));
+    EXPECT_EQ(collector.count, static_cast<size_t>(3));
+}
+
+void TestRowCutShortIsDropped()
+{
+    Collector collector;
+    InfluxDBStreamParser parser(Collect, &collector);
+    const char *cut = ",result,table,_time,_value\r\n,_result,0,2026-01-01T00:01:02.001Z,Eg";
+    parser.Feed(cut, strlen(cut));
+    parser.Finish();
+    EXPECT_EQ(collector.count, static_cast<size_t>(0));
+    EXPECT_EQ(parser.GetRejectedRowCount(), static_cast<size_t>(0));
+}
+
+void TestOverlongRowKeepsItsTimestamp()
+{
+    std::string body = ",result,table,_time,_value\r\n,_result,0,2026-01-01T00:01:02.001Z,";
+    body.append(INFLUXDB_STREAM_LINE_BYTES, 'A');
+    body += "\r\n,_result,0,2026-01-01T00:01:02.002Z,EgM=\r\n";
+
+    Collector collector;
+    InfluxDBStreamParser parser(Collect, &collector);
+    FeedInChunks(parser, body.c_str(), 100);
+    EXPECT_EQ(collector.count, static_cast<size_t>(2));
+    EXPECT_EQ(collector.rows[0].timestamp_ms, static_cast<int64_t>(-1767225662001));
+    EXPECT_EQ(collector.rows[1].timestamp_ms, static_cast<int64_t>(1767225662002));
+    EXPECT_EQ(collector.rows[1].payload, std::string("EgM="));
+}
+
+void TestMalformedRowsAreCounted()
+{
+    Collector collector;
+    InfluxDBStreamParser parser(Collect, &collector);
+    const char *body = ",_result,0,start,stop,not-a-timestamp,payload\n{\"code\":\"invalid\"}\n";
+    parser.Feed(body, strlen(body));
+    parser.Finish();
+    EXPECT_EQ(collector.count, static_cast<size_t>(0));
+    EXPECT_EQ(parser.GetRejectedRowCount(), static_cast<size_t>(1));
+}
+} // namespace
+
+int main()
+{
+    TestIso8601FastPathMatchesCalendar();
+    TestEveryChunkSizeMatchesTheBufferedParser();
+    TestFeedingDoesNotAllocate();
+    TestRefusedRowStopsTheResponse();
+    TestRowCutShortIsDropped();
+    TestOverlongRowKeepsItsTimestamp();
+    TestMalformedRowsAreCounted();
+
+    PrintTestPassed("InfluxDBStreamParser unit test");
+    return EXIT_SUCCESS;
+}
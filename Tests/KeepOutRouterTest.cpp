@@ -0,0 +1,68 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "KeepOutRouter.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr AngleMotion::AngleMoveLimitsDeg S0Limits{true, {210.0f, 300.0f}, false, {0.0f, 0.0f}};
+constexpr AngleMotion::AngleMoveLimitsDeg S1Limits{false, {0.0f, 0.0f}, true, {-270.0f, 270.0f}};
+
+bool InsideKeepOut(float s0_deg)
+{
+    float normalized_deg = AngleMotion::NormalizeAngleDeg(s0_deg);
+    return normalized_deg > 210.0f && normalized_deg < 300.0f;
+}
+
+void TestClearGoalIsRoutedDirectly()
+{
+    KeepOutRouter router(S0Limits, S1Limits);
+    JointRoute route = router.Route(120.0f, -115.0f, 170.0f, -60.0f);
+    EXPECT_TRUE(route.kind == JointRouteKind::Direct);
+    EXPECT_EQ(route.s0Target_deg, 170.0f);
+    EXPECT_EQ(route.s1Target_deg, -60.0f);
+}
+
+void TestGoalInsideKeepOutUsesMirroredElbow()
+{
+    // S0 at 250 deg is inside the keep-out zone, but the other elbow reaches the same tip with
+    // S0 well clear of it.
+    KeepOutRouter router(S0Limits, S1Limits);
+    JointRoute route = router.Route(120.0f, -115.0f, 250.0f, -90.0f);
+    EXPECT_TRUE(route.kind == JointRouteKind::MirroredElbow);
+    EXPECT_FALSE(InsideKeepOut(route.s0Target_deg));
+    ExpectNearlyEqual(route.s1Target_deg, 90.0f, 1.0e-3f, "mirrored S1");
+
+    Vector2D goal_m;
+    Vector2D routed_m;
+    AngToCart(250.0f, -90.0f, goal_m);
+    AngToCart(route.s0Target_deg, route.s1Target_deg, routed_m);
+    ExpectNearlyEqual(routed_m.x, goal_m.x, 1.0e-5f, "mirrored tip x");
+    ExpectNearlyEqual(routed_m.y, goal_m.y, 1.0e-5f, "mirrored tip y");
+}
+
+void TestGoalBlockedInBothBranches()
+{
+    // With the elbow nearly straight the mirrored pose lands inside the zone too.
+    KeepOutRouter router(S0Limits, S1Limits);
+    JointRoute route = router.Route(120.0f, -115.0f, 255.0f, -10.0f);
+    EXPECT_TRUE(route.kind == JointRouteKind::Blocked);
+    EXPECT_EQ(route.s0Target_deg, 255.0f);
+    EXPECT_EQ(route.s1Target_deg, -10.0f);
+
+    // A straight arm has no other elbow to fall back on.
+    route = router.Route(120.0f, -115.0f, 250.0f, 0.0f);
+    EXPECT_TRUE(route.kind == JointRouteKind::Blocked);
+}
+} // namespace
+
+int main()
+{
+    TestClearGoalIsRoutedDirectly();
+    TestGoalInsideKeepOutUsesMirroredElbow();
+    TestGoalBlockedInBothBranches();
+
+    PrintTestPassed("KeepOutRouter unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "LineProtocolWriter.h"
+#include "TelemetryLine.h"
+
+// Lines per second for the snprintf formatting the aggregator and log path used to run against
+// FormatTelemetryLine and LineProtocolWriter, on a 1 Hz telemetry line (10 fields), the aligned
+// 20 s line (all 35 fields) and a log line that needs escaping.
+namespace
+{
+constexpr int kRepeats = 200000;
+constexpr int64_t kTimestamp_ms = 1767225662000;
+constexpr const char *kLogMessage = "W (CNCControl) Stop: cleared 2 queued commands at \"S0\" 12.50 deg\n";
+
+volatile size_t sink;
+
+// The same running-arm values TelemetryLineBenchmark uses.
+float SampleValue(size_t i)
+{
+    if (i % 5 == 4)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(std::sin(1.7 * static_cast<double>(i)) * std::pow(10.0, static_cast<double>(i % 3)));
+}
+
+// FormatTelemetryLine as it was: one snprintf per field, then trailing zeros trimmed.
+size_t SnprintfTelemetryLine(char *out, size_t capacity, const char *prefix, const TelemetryField *fields, size_t count,
+                             int64_t timestamp_ms)
+{
+    size_t used = 0;
+    auto append = [&](int written)
+    {
+        if (written < 0 || static_cast<size_t>(written) >= capacity - used)
+        {
+            return false;
+        }
+        used += static_cast<size_t>(written);
+        return true;
+    };
+
+    if (!append(snprintf(out, capacity, "%s ", prefix)))
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!append(snprintf(out + used, capacity - used, "%s%s=%.5f", (i == 0) ? "" : ",", fields[i].key,
+                             fields[i].value)))
+        {
+            return 0;
+        }
+        while (out[used - 1] == '0')
+        {
+            used--;
+        }
+        if (out[used - 1] == '.')
+        {
+            used--;
+        }
+    }
+    if (!append(snprintf(out + used, capacity - used, " %lld\n", static_cast<long long>(timestamp_ms))))
+    {
+        return 0;
+    }
+    return used;
+}
+
+// AddLogToBuffer as it was: escape into a scratch copy, then snprintf the line.
+size_t SnprintfLogLine(char *out, size_t capacity, const char *message, int64_t timestamp_ms)
+{
+    char escapedMessage[512];
+    size_t escapedIdx = 0;
+    for (size_t i = 0; message[i] != '\0' && escapedIdx < sizeof(escapedMessage) - 1; ++i)
+    {
+        char c = message[i];
+        if (c == '\r' || c == '\n')
+        {
+            c = ' ';
+        }
+        if ((c == '"' || c == '\\') && escapedIdx < sizeof(escapedMessage) - 2)
+        {
+            escapedMessage[escapedIdx++] = '\\';
+        }
+        escapedMessage[escapedIdx++] = c;
+    }
+    escapedMessage[escapedIdx] = '\0';
+    int written = snprintf(out, capacity, "logs,level=info,source=myApp message=\"%s\" %lld\n", escapedMessage,
+                           static_cast<long long>(timestamp_ms));
+    return (written > 0 && static_cast<size_t>(written) < capacity) ? static_cast<size_t>(written) : 0;
+}
+
+size_t WriterLogLine(char *out, size_t capacity, const char *message, int64_t timestamp_ms)
+{
+    LineProtocolWriter writer(out, capacity);
+    writer.Append("logs,level=info,source=myApp message=\"");
+    writer.AppendEscaped(message);
+    writer.Append("\" ");
+    writer.AppendInt64(timestamp_ms);
+    writer.Append('\n');
+    return writer.Ok() ? writer.Length() : 0;
+}
+
+template <typename Fn> double LinesPerSecond(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t total = 0;
+    for (int i = 0; i < kRepeats; i++)
+    {
+        total += fn(i);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    sink = total;
+    return kRepeats / elapsed.count();
+}
+
+void Report(const char *name, double before, double after)
+{
+    std::printf("%-16s snprintf %9.0f lines/s (%6.2f us)  writer %9.0f lines/s (%6.2f us)  %4.1fx\n", name, before,
+                1e6 / before, after, 1e6 / after, after / before);
+}
+} // namespace
+
+int main()
+{
+    TelemetryField fields[64];
+    for (size_t i = 0; i < TELEMETRY_FIELD_NAME_COUNT; i++)
+    {
+        fields[i] = {TELEMETRY_FIELD_NAMES[i].key, SampleValue(i)};
+    }
+    char line[2048];
+    char check[2048];
+
+    for (size_t count : {size_t(10), TELEMETRY_FIELD_NAME_COUNT})
+    {
+        size_t length = FormatTelemetryLine(line, sizeof(line), TELEMETRY_LINE_PREFIX, fields, count, kTimestamp_ms);
+        size_t reference =
+            SnprintfTelemetryLine(check, sizeof(check), TELEMETRY_LINE_PREFIX, fields, count, kTimestamp_ms);
+        if (length != reference || std::memcmp(line, check, length) != 0)
+        {
+            std::printf("telemetry line differs from the snprintf output\n");
+            return EXIT_FAILURE;
+        }
+
+        double before = LinesPerSecond(
+            [&](int i)
+            {
+                return SnprintfTelemetryLine(check, sizeof(check), TELEMETRY_LINE_PREFIX, fields, count,
+                                             kTimestamp_ms + i);
+            });
+        double after = LinesPerSecond(
+            [&](int i)
+            {
+                return FormatTelemetryLine(line, sizeof(line), TELEMETRY_LINE_PREFIX, fields, count,
+                                           kTimestamp_ms + i);
+            });
+        char name[32];
+        snprintf(name, sizeof(name), "tlm, %zu fields", count);
+        Report(name, before, after);
+    }
+
+    if (WriterLogLine(line, sizeof(line), kLogMessage, kTimestamp_ms) !=
+            SnprintfLogLine(check, sizeof(check), kLogMessage, kTimestamp_ms) ||
+        std::strcmp(line, check) != 0)
+    {
+        std::printf("log line differs from the snprintf output\n");
+        return EXIT_FAILURE;
+    }
+    double before =
+        LinesPerSecond([&](int i) { return SnprintfLogLine(check, sizeof(check), kLogMessage, kTimestamp_ms + i); });
+    double after =
+        LinesPerSecond([&](int i) { return WriterLogLine(line, sizeof(line), kLogMessage, kTimestamp_ms + i); });
+    Report("log line", before, after);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "LineProtocolWriter.h"
+#include "TestHarness.h"
+
+namespace
+{
+// What the telemetry lines printed before FormatFixed5: "%.5f" less trailing zeros and point.
+std::string Snprintf5(float value)
+{
+    char text[64];
+    std::string result(text, static_cast<size_t>(snprintf(text, sizeof(text), "%.5f", value)));
+    if (result.find('.') != std::string::npos)
+    {
+        result.erase(result.find_last_not_of('0') + 1);
+        if (result.back() == '.')
+        {
+            result.pop_back();
+        }
+    }
+    return result;
+}
+
+void ExpectFixed5(float value)
+{
+    char text[FORMAT_FIXED5_MAX_CHARS];
+    std::string actual(text, FormatFixed5(text, value));
+    std::string expected = Snprintf5(value);
+    if (actual != expected)
+    {
+        std::fprintf(stderr, "FormatFixed5(%.9g) gave %s, snprintf %s\n", static_cast<double>(value), actual.c_str(),
+                     expected.c_str());
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void TestFixed5MatchesSnprintf()
+{
+    const float values[] = {0.0f,      -0.0f,     0.5f,        -0.5f,       3.0f,       0.12345f,    -12.5f,
+                            0.000004f, 0.000005f, -0.000004f,  0.000006f,   99999.99f,  123456.789f, 1e-30f,
+                            1e12f,     9.99e12f,  1e13f,       -3.4e38f,    360.0f,     -179.99998f, 1.0f / 3.0f,
+                            std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+                            std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::denorm_min()};
+    for (float value : values)
+    {
+        ExpectFixed5(value);
+    }
+
+    // Exact ties at the fifth decimal round to even, as printf does: 1/64 = 0.015625 -> 0.01562.
+    for (int i = -4096; i <= 4096; i++)
+    {
+        ExpectFixed5(static_cast<float>(i) / 64.0f);
+        ExpectFixed5(static_cast<float>(i) / 4096.0f);
+    }
+
+    // Every exponent the fast path takes, and the fallback above it.
+    std::mt19937 generator(12345);
+    std::uniform_int_distribution<uint32_t> bits;
+    for (int i = 0; i < 200000; i++)
+    {
+        uint32_t word = bits(generator);
+        float value;
+        std::memcpy(&value, &word, sizeof(value));
+        ExpectFixed5(value);
+        ExpectFixed5(std::ldexp(value, -std::ilogb(value) + static_cast<int>(i % 60) - 20));
+    }
+}
+
+void TestInt64MatchesSnprintf()
+{
+    std::mt19937_64 generator(6789);
+    const int64_t values[] = {0,
+                              7,
+                              -7,
+                              4294967295,
+                              4294967296,
+                              99999,
+                              100000,
+                              429496729599999,
+                              429496729600000,
+                              1767225662000,
+                              -1767225662000,
+                              999999999999999999,
+                              std::numeric_limits<int64_t>::max(),
+                              std::numeric_limits<int64_t>::min()};
+    char text[FORMAT_INT64_MAX_CHARS];
+    char expected[32];
+    const int valueCount = static_cast<int>(sizeof(values) / sizeof(values[0]));
+    for (int i = 0; i < 10000 + valueCount; i++)
+    {
+        int64_t value = (i < valueCount) ? values[i] : static_cast<int64_t>(generator() >> (i % 64));
+        size_t length = FormatInt64(text, value);
+        int expectedLength = snprintf(expected, sizeof(expected), "%" PRId64, value);
+        EXPECT_EQ(std::string(text, length), std::string(expected, static_cast<size_t>(expectedLength)));
+    }
+}
+
+void TestWriterKeepsLineWholeOrFails()
+{
+    char line[64];
+    auto write = [&](size_t capacity)
+    {
+        std::memset(line, '#', sizeof(line));
+        LineProtocolWriter writer(line, capacity);
+        writer.Append("m,t=a");
+        writer.Append(' ');
+        writer.Append("v=");
+        writer.AppendFixed5(-1.25f);
+        writer.Append(' ');
+        writer.AppendInt64(1767225662000);
+        writer.Append('\n');
+        return writer;
+    };
+
+    const std::string expected = "m,t=a v=-1.25 1767225662000\n";
+    LineProtocolWriter whole = write(sizeof(line));
+    EXPECT_TRUE(whole.Ok());
+    EXPECT_EQ(whole.Length(), expected.size());
+    EXPECT_EQ(std::string(line), expected);
+
+    // The terminator needs one more byte than the line, as with snprintf.
+    EXPECT_TRUE(write(expected.size() + 1).Ok());
+    for (size_t capacity = 0; capacity <= expected.size(); capacity++)
+    {
+        LineProtocolWriter cut = write(capacity);
+        EXPECT_FALSE(cut.Ok());
+        EXPECT_TRUE(cut.Length() < capacity || capacity == 0);
+        // Nothing is written past capacity.
+        EXPECT_EQ(line[capacity], '#');
+        if (capacity > 0)
+        {
+            EXPECT_EQ(line[cut.Length()], '\0');
+        }
+    }
+}
+
+void TestEscapedStringField()
+{
+    char line[64];
+    LineProtocolWriter writer(line, sizeof(line));
+    writer.Append("message=\"");
+    writer.AppendEscaped("say \"hi\"\r\nC:\\tmp");
+    writer.Append('"');
+    EXPECT_TRUE(writer.Ok());
+    EXPECT_EQ(std::string(line), std::string("message=\"say \\\"hi\\\"  C:\\\\tmp\""));
+
+    // An escape that does not fit fails the line rather than leaving a lone backslash.
+    LineProtocolWriter tight(line, 3);
+    tight.AppendEscaped("a\"");
+    EXPECT_FALSE(tight.Ok());
+}
+} // namespace
+
+int main()
+{
+    TestFixed5MatchesSnprintf();
+    TestInt64MatchesSnprintf();
+    TestWriterKeepsLineWholeOrFails();
+    TestEscapedStringField();
+
+    PrintTestPassed("LineProtocolWriter unit test");
+    return EXIT_SUCCESS;
+}
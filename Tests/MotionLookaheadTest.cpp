@@ -0,0 +1,203 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "ArcGuidance.h"
+#include "JogGuidance.h"
+#include "MotionLookahead.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr float kCruise_mps = 0.05f;
+
+LookaheadLimits MakeLimits()
+{
+    LookaheadLimits limits;
+    limits.s0Accel_degps2 = 800.0f;
+    limits.s1Accel_degps2 = 800.0f;
+    limits.accelScale = 0.05f;
+    limits.junctionDeviation_m = 0.0005f;
+    return limits;
+}
+
+LookaheadSegment MakeJog(Vector2D start_m, Vector2D end_m, bool pumpOn = true)
+{
+    JogConfig config{end_m.x, end_m.y, kCruise_mps, pumpOn ? 1U : 0U};
+    uint8_t payload[sizeof(JogConfig)];
+    memcpy(payload, &config, sizeof(config));
+
+    LookaheadSegment segment;
+    EXPECT_TRUE(DescribeLookaheadSegment(CNC_JOG_OPCODE, payload, sizeof(payload), start_m,
+                                         Vector2D(0.0f, 0.0f), segment));
+    return segment;
+}
+
+void TestOnlyJogAndArcAreBlendable()
+{
+    EXPECT_TRUE(IsLookaheadOpcode(CNC_JOG_OPCODE));
+    EXPECT_TRUE(IsLookaheadOpcode(CNC_ARC_OPCODE));
+    EXPECT_FALSE(IsLookaheadOpcode(CNC_SPIRAL_OPCODE));
+    EXPECT_FALSE(IsLookaheadOpcode(CNC_WAIT_OPCODE));
+    EXPECT_FALSE(IsLookaheadOpcode(CNC_CONFIG_ACCEL_SCALE_OPCODE));
+}
+
+void TestDescribeArcAppliesLocalOrigin()
+{
+    ArcConfig config{0.0f, 1.5707963f, 0.02f, kCruise_mps, 0.0f, 0.2f};
+    uint8_t payload[sizeof(ArcConfig)];
+    memcpy(payload, &config, sizeof(config));
+
+    LookaheadSegment segment;
+    EXPECT_TRUE(DescribeLookaheadSegment(CNC_ARC_OPCODE, payload, sizeof(payload),
+                                         Vector2D(0.0f, 0.0f), Vector2D(0.01f, 0.0f), segment));
+    ExpectNearlyEqual(segment.start_m.x, 0.01f, 1.0e-6f, "arc start x");
+    ExpectNearlyEqual(segment.start_m.y, 0.22f, 1.0e-6f, "arc start y");
+    ExpectNearlyEqual(segment.end_m.x, 0.03f, 1.0e-6f, "arc end x");
+    ExpectNearlyEqual(segment.end_m.y, 0.2f, 1.0e-6f, "arc end y");
+    ExpectNearlyEqual(segment.startDirection.x, 1.0f, 1.0e-6f, "arc start tangent x");
+    ExpectNearlyEqual(segment.endDirection.y, -1.0f, 1.0e-6f, "arc end tangent y");
+    ExpectNearlyEqual(segment.length_m, 0.02f * 1.5707963f, 1.0e-6f, "arc length");
+    EXPECT_TRUE(segment.pumpOn);
+
+    EXPECT_FALSE(DescribeLookaheadSegment(CNC_ARC_OPCODE, payload, sizeof(payload) - 1,
+                                          Vector2D(0.0f, 0.0f), Vector2D(0.0f, 0.0f), segment));
+}
+
+void TestCollinearJogsKeepCruiseSpeed()
+{
+    LookaheadSegment segments[3] = {
+        MakeJog(Vector2D(-0.05f, 0.25f), Vector2D(-0.01f, 0.25f)),
+        MakeJog(Vector2D(-0.01f, 0.25f), Vector2D(0.03f, 0.25f)),
+        MakeJog(Vector2D(0.03f, 0.25f), Vector2D(0.07f, 0.25f)),
+    };
+    PlanLookaheadSpeeds(segments, 3, 0.0f, MakeLimits());
+
+    ExpectNearlyEqual(segments[0].entrySpeed_mps, 0.0f, 0.0f, "collinear first entry");
+    ExpectNearlyEqual(segments[0].exitSpeed_mps, kCruise_mps, 1.0e-6f, "collinear first exit");
+    ExpectNearlyEqual(segments[1].exitSpeed_mps, kCruise_mps, 1.0e-6f, "collinear second exit");
+    ExpectNearlyEqual(segments[2].exitSpeed_mps, 0.0f, 0.0f, "window end stops");
+    EXPECT_TRUE(segments[0].accel_mps2 > 0.0f);
+}
+
+void TestCornerSlowsWithoutStopping()
+{
+    LookaheadSegment segments[3] = {
+        MakeJog(Vector2D(-0.04f, 0.22f), Vector2D(0.0f, 0.22f)),
+        MakeJog(Vector2D(0.0f, 0.22f), Vector2D(0.0f, 0.26f)),
+        MakeJog(Vector2D(0.0f, 0.26f), Vector2D(0.0f, 0.22f)),
+    };
+    PlanLookaheadSpeeds(segments, 3, 0.0f, MakeLimits());
+
+    EXPECT_TRUE(segments[0].exitSpeed_mps > 0.001f);
+    EXPECT_TRUE(segments[0].exitSpeed_mps < kCruise_mps);
+    EXPECT_EQ(segments[1].entrySpeed_mps, segments[0].exitSpeed_mps);
+
+    // A full reversal has no corner to round.
+    ExpectNearlyEqual(segments[1].exitSpeed_mps, 0.0f, 0.0f, "reversal stops");
+
+    // A looser corner tolerance allows a faster corner.
+    LookaheadLimits looser = MakeLimits();
+    looser.junctionDeviation_m = 0.002f;
+    EXPECT_TRUE(ComputeJunctionSpeed_mps(segments[0], segments[1], looser) >
+                ComputeJunctionSpeed_mps(segments[0], segments[1], MakeLimits()));
+}
+
+void TestPumpChangeAndGapForceStop()
+{
+    LookaheadSegment drawing = MakeJog(Vector2D(-0.04f, 0.25f), Vector2D(0.0f, 0.25f), true);
+    LookaheadSegment travel = MakeJog(Vector2D(0.0f, 0.25f), Vector2D(0.04f, 0.25f), false);
+    ExpectNearlyEqual(ComputeJunctionSpeed_mps(drawing, travel, MakeLimits()), 0.0f, 0.0f,
+                      "pump change junction");
+
+    LookaheadSegment detached = MakeJog(Vector2D(0.005f, 0.25f), Vector2D(0.04f, 0.25f), true);
+    ExpectNearlyEqual(ComputeJunctionSpeed_mps(drawing, detached, MakeLimits()), 0.0f, 0.0f,
+                      "gap junction");
+}
+
+void TestBackwardPassLeavesRoomToBrake()
+{
+    LookaheadSegment segments[2] = {
+        MakeJog(Vector2D(-0.05f, 0.25f), Vector2D(0.0f, 0.25f)),
+        MakeJog(Vector2D(0.0f, 0.25f), Vector2D(0.0005f, 0.25f)),
+    };
+    PlanLookaheadSpeeds(segments, 2, 0.0f, MakeLimits());
+
+    float brakeLimited_mps = sqrtf(2.0f * segments[1].accel_mps2 * segments[1].length_m);
+    EXPECT_TRUE(brakeLimited_mps < kCruise_mps);
+    ExpectNearlyEqual(segments[0].exitSpeed_mps, brakeLimited_mps, 1.0e-6f, "brake-limited exit");
+}
+
+void TestForwardPassLimitsByReachableSpeed()
+{
+    LookaheadSegment segments[2] = {
+        MakeJog(Vector2D(-0.0005f, 0.25f), Vector2D(0.0f, 0.25f)),
+        MakeJog(Vector2D(0.0f, 0.25f), Vector2D(0.05f, 0.25f)),
+    };
+    PlanLookaheadSpeeds(segments, 2, 0.0f, MakeLimits());
+    float reachable_mps = sqrtf(2.0f * segments[0].accel_mps2 * segments[0].length_m);
+    ExpectNearlyEqual(segments[0].exitSpeed_mps, reachable_mps, 1.0e-6f, "accel-limited exit");
+
+    PlanLookaheadSpeeds(segments, 2, kCruise_mps, MakeLimits());
+    ExpectNearlyEqual(segments[0].entrySpeed_mps, kCruise_mps, 0.0f, "carried entry speed");
+    ExpectNearlyEqual(segments[0].exitSpeed_mps, kCruise_mps, 1.0e-6f, "carried exit speed");
+}
+
+void TestJogProfileArrivesAtExitSpeed()
+{
+    JogGuidance jog;
+    jog.ApplyConfig(JogConfig{0.02f, 0.25f, kCruise_mps, 1U});
+    jog.Profile.accel_mps2 = 0.5f;
+    jog.Profile.exitSpeed_mps = 0.02f;
+
+    Vector2D carrot_m(0.0f, 0.25f);
+    bool viaAngle = true;
+    float s0Speed_degps = 0.0f;
+    float s1Speed_degps = 0.0f;
+    float peakSpeed_mps = 0.0f;
+    int steps = 0;
+    while (!jog.GetTargetPosition(10, carrot_m, carrot_m, viaAngle, s0Speed_degps, s1Speed_degps))
+    {
+        peakSpeed_mps = fmaxf(peakSpeed_mps, jog.Profile.currentSpeed_mps);
+        EXPECT_TRUE(steps++ < 200);
+    }
+
+    EXPECT_FALSE(viaAngle);
+    ExpectNearlyEqual(carrot_m.x, 0.02f, 0.0f, "jog end x");
+    ExpectNearlyEqual(peakSpeed_mps, kCruise_mps, 1.0e-6f, "jog peak speed");
+    // Jogs finish within 1 mm of the target, so allow the speed still left over that distance.
+    float arrivalBound_mps = sqrtf(0.02f * 0.02f + 2.0f * 0.5f * 1.0e-3f);
+    EXPECT_TRUE(jog.Profile.currentSpeed_mps >= 0.02f);
+    EXPECT_TRUE(jog.Profile.currentSpeed_mps <= arrivalBound_mps);
+    ExpectNearlyEqual(jog.GetRemainingPathLength_m(), 0.0f, 0.0f, "jog remaining");
+}
+
+void TestUnplannedJogKeepsLegacyStep()
+{
+    JogGuidance jog;
+    jog.ApplyConfig(JogConfig{0.02f, 0.25f, kCruise_mps, 1U});
+
+    Vector2D carrot_m(0.0f, 0.25f);
+    bool viaAngle = true;
+    float s0Speed_degps = 0.0f;
+    float s1Speed_degps = 0.0f;
+    EXPECT_FALSE(
+        jog.GetTargetPosition(10, carrot_m, carrot_m, viaAngle, s0Speed_degps, s1Speed_degps));
+    ExpectNearlyEqual(carrot_m.x, kCruise_mps * 0.01f, 1.0e-7f, "legacy first step");
+}
+} // namespace
+
+int main()
+{
+    TestOnlyJogAndArcAreBlendable();
+    TestDescribeArcAppliesLocalOrigin();
+    TestCollinearJogsKeepCruiseSpeed();
+    TestCornerSlowsWithoutStopping();
+    TestPumpChangeAndGapForceStop();
+    TestBackwardPassLeavesRoomToBrake();
+    TestForwardPassLimitsByReachableSpeed();
+    TestJogProfileArrivesAtExitSpeed();
+    TestUnplannedJogKeepsLegacyStep();
+
+    PrintTestPassed("MotionLookahead unit test");
+    return EXIT_SUCCESS;
+}
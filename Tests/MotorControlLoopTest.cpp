@@ -0,0 +1,353 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ArcGuidance.h"
+#include "CNCOpCodes.h"
+#include "GoToAngleGuidance.h"
+#include "HostSimulation.h"
+#include "JogGuidance.h"
+#include "PanMath.h"
+#include "ProgramPacket.h"
+#include "TestHarness.h"
+
+namespace
+{
+template <typename Config>
+void AppendPacket(std::vector<uint8_t> &stream, uint8_t opcode, const Config &config)
+{
+    uint8_t bytes[sizeof(Config)];
+    std::memcpy(bytes, &config, sizeof(Config));
+    stream.push_back(opcode);
+    stream.push_back(static_cast<uint8_t>(sizeof(Config)));
+    stream.insert(stream.end(), bytes, bytes + sizeof(Config));
+}
+
+void AppendImmediate(std::vector<uint8_t> &stream, uint8_t opcode)
+{
+    stream.push_back(opcode);
+    stream.push_back(0);
+}
+
+Vector2D PhysicalTip_m(const HostSimulation &simulation)
+{
+    Vector2D tip_m;
+    AngToCart(static_cast<float>(simulation.GetPhysicalS0_deg()),
+              static_cast<float>(simulation.GetPhysicalS1_deg()), tip_m);
+    return tip_m;
+}
+
+// Where the tip was on each cycle the controller had the pump on, i.e. what got drawn.
+void RecordPumpOnTip(const HostSimulation &simulation, void *context)
+{
+    if (simulation.GetControllerState().pumpSpeed_degps > 0.0f)
+    {
+        static_cast<std::vector<Vector2D> *>(context)->push_back(PhysicalTip_m(simulation));
+    }
+}
+
+// Largest step between consecutive pump-on samples.
+float LargestPumpOnGap_m(const std::vector<Vector2D> &drawn_m)
+{
+    float gap_m = 0.0f;
+    for (size_t i = 1; i < drawn_m.size(); i++)
+    {
+        gap_m = std::fmax(gap_m, (drawn_m[i] - drawn_m[i - 1]).magnitude());
+    }
+    return gap_m;
+}
+
+void TestJogStreamDrivesPhysicalArmToTarget()
+{
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.10f, 0.22f, 0.03f, 0});
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.14f, 0.20f, 0.03f, 0});
+
+    HostSimulation simulation;
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+
+    EXPECT_TRUE(metrics.completed);
+    EXPECT_EQ(metrics.packetCount, 2U);
+    EXPECT_TRUE(metrics.stepTimerEventCount > 0);
+    EXPECT_TRUE(metrics.trackingSampleCount > 0);
+    EXPECT_TRUE(metrics.maxTrackingError_m < 0.03);
+    EXPECT_TRUE(std::fabs(metrics.pumpTravel_deg) < 1e-9);
+
+    // The controller settles where the arm is when the carrot arrives, so the tip stops within
+    // the tracking lag of the target, and step counting agrees with the physical joints.
+    Vector2D tip_m = PhysicalTip_m(simulation);
+    EXPECT_TRUE((tip_m - Vector2D(0.14f, 0.20f)).magnitude() < 0.01f);
+    EXPECT_TRUE((tip_m - simulation.GetControllerState().currentPosition_m).magnitude() < 1e-4f);
+
+    // The run covers the move, not a fixed timeout.
+    EXPECT_TRUE(metrics.jobDuration_s > 1.0 && metrics.jobDuration_s < 20.0);
+
+    // Every command record went back to the slab once it had run.
+    EXPECT_EQ(simulation.GetCommandSlab().GetLiveCount(), 0U);
+}
+
+void TestPumpOnJogReportsPumpTravel()
+{
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.10f, 0.22f, 0.03f, 0});
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.10f, 0.18f, 0.02f, 1});
+
+    HostSimulation simulation;
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+
+    EXPECT_TRUE(metrics.completed);
+    EXPECT_TRUE(std::fabs(metrics.pumpTravel_deg) > 1.0);
+}
+
+void TestStopDrainsQueuedMotion()
+{
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.10f, 0.22f, 0.03f, 0});
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.14f, 0.20f, 0.03f, 0});
+    AppendImmediate(stream, 0x03);
+
+    HostSimulation simulation;
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+
+    EXPECT_TRUE(metrics.completed);
+    EXPECT_TRUE(metrics.jobDuration_s < 1.0);
+    EXPECT_TRUE((PhysicalTip_m(simulation) - Vector2D(0.14f, 0.20f)).magnitude() > 0.01f);
+    EXPECT_EQ(simulation.GetCommandSlab().GetFreeBytes(), COMMAND_SLAB_BYTES);
+}
+
+Vector2D RunAngleMoveIntoKeepOutThenJog(bool keepOutRouting)
+{
+    // S0 at 220 deg lies in the keep-out zone; the jog queued behind it is the rest of the job.
+    HostSimulationOptions options;
+    options.controlConfig.keepOutRouting = keepOutRouting;
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_GO_TO_ANGLE_OPCODE, GoToAngleConfig{220.0f, -60.0f, 0.5f});
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{-0.12f, -0.25f, 0.03f, 0});
+
+    HostSimulation simulation(options);
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+    EXPECT_TRUE(metrics.completed);
+    return PhysicalTip_m(simulation);
+}
+
+void TestKeepOutRoutingFinishesTheJob()
+{
+    const Vector2D jogTarget_m(-0.12f, -0.25f);
+    EXPECT_TRUE((RunAngleMoveIntoKeepOutThenJog(false) - jogTarget_m).magnitude() > 0.05f);
+    EXPECT_TRUE((RunAngleMoveIntoKeepOutThenJog(true) - jogTarget_m).magnitude() < 0.01f);
+}
+
+void TestPathStartIsDrawnAfterTheElbowFlips()
+{
+    // From (180, -60) deg the jog only clears the keep-out zone in the positive elbow branch, so
+    // the arm flips its elbow before the first point is drawn.
+    HostSimulationOptions options;
+    options.initialS0_deg = 180.0f;
+    options.initialS1_deg = -60.0f;
+    options.controlConfig.posTol_m = 0.002f;
+    Vector2D start_m;
+    AngToCart(options.initialS0_deg, options.initialS1_deg, start_m);
+    const Vector2D end_m(-0.10f, -0.25f);
+
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{end_m.x, end_m.y, 0.02f, 1});
+    HostSimulation simulation(options);
+    std::vector<Vector2D> drawn_m;
+    simulation.SetCycleObserver(RecordPumpOnTip, &drawn_m);
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+
+    EXPECT_TRUE(metrics.completed);
+    EXPECT_TRUE(simulation.GetPhysicalS1_deg() > 0.0);
+    EXPECT_TRUE(drawn_m.size() > 10);
+    EXPECT_TRUE((drawn_m.front() - start_m).magnitude() < 0.001f);
+    EXPECT_TRUE((drawn_m.back() - end_m).magnitude() < 0.002f);
+    EXPECT_TRUE(LargestPumpOnGap_m(drawn_m) < 0.002f);
+}
+
+void TestMidPathElbowFlipLeavesNoGap()
+{
+    // The jog starts clear of the keep-out zone in the negative branch, but part way along it S0
+    // would swing past 210 deg. The arm finishes it in the positive branch, drawing on from the
+    // point where it left the path.
+    HostSimulationOptions options;
+    options.initialS0_deg = -170.0f;
+    options.initialS1_deg = -30.0f;
+    options.controlConfig.posTol_m = 0.002f;
+    Vector2D start_m;
+    AngToCart(options.initialS0_deg, options.initialS1_deg, start_m);
+    const Vector2D end_m(-0.02f, -0.10f);
+
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{end_m.x, end_m.y, 0.02f, 1});
+    HostSimulation simulation(options);
+    std::vector<Vector2D> drawn_m;
+    simulation.SetCycleObserver(RecordPumpOnTip, &drawn_m);
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+
+    EXPECT_TRUE(metrics.completed);
+    EXPECT_TRUE(simulation.GetPhysicalS1_deg() > 0.0);
+    EXPECT_TRUE(drawn_m.size() > 10);
+    EXPECT_TRUE((drawn_m.front() - start_m).magnitude() < 0.001f);
+    EXPECT_TRUE((drawn_m.back() - end_m).magnitude() < 0.002f);
+    EXPECT_TRUE(LargestPumpOnGap_m(drawn_m) < options.controlConfig.posTol_m);
+}
+
+HostSimulationMetrics RunArcFromRest(float feedforwardGain, bool sharedStepTimer = true)
+{
+    // Half circle of radius 3 cm, starting under the tip so no approach move is needed.
+    const ArcConfig arc{0.0f, 3.14159265f, 0.03f, 0.02f, 0.10f, 0.17f};
+    HostSimulationOptions options;
+    options.controlConfig.feedforwardGain = feedforwardGain;
+    options.sharedStepTimer = sharedStepTimer;
+    EXPECT_EQ(CartToAng(options.initialS0_deg, options.initialS1_deg,
+                        Vector2D(arc.CenterX_m, arc.CenterY_m + arc.Radius_m)),
+              E_OK);
+
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_ARC_OPCODE, arc);
+    HostSimulation simulation(options);
+    EXPECT_TRUE(simulation.AppendPacketStream(stream.data(), stream.size()));
+    HostSimulationMetrics metrics = simulation.Run();
+    EXPECT_TRUE(metrics.completed);
+    return metrics;
+}
+
+void TestVelocityFeedforwardReducesArcTrackingError()
+{
+    HostSimulationMetrics feedback = RunArcFromRest(0.0f);
+    HostSimulationMetrics feedforward = RunArcFromRest(1.0f);
+
+    // Pure feedback lags the carrot by millimetres; with the joint rates fed forward only the
+    // residual is left to correct.
+    EXPECT_TRUE(feedback.maxTrackingError_m > 0.005);
+    EXPECT_TRUE(feedforward.maxTrackingError_m < 0.001);
+    EXPECT_TRUE(feedforward.rmsTrackingError_m < 0.1 * feedback.rmsTrackingError_m);
+}
+
+void TestSharedStepTimerCutsIsrLoadPerMillimetre()
+{
+    HostSimulationMetrics perMotor = RunArcFromRest(1.0f, false);
+    HostSimulationMetrics shared = RunArcFromRest(1.0f, true);
+
+    // Same path either way...
+    ExpectNearlyEqual(static_cast<float>(shared.pathLength_m),
+                      static_cast<float>(perMotor.pathLength_m), 0.001f, "path length");
+    EXPECT_TRUE(shared.maxTrackingError_m < 0.001);
+
+    // ...for one interrupt per master step instead of two per step on every axis.
+    const double perMotorIsrs_per_mm =
+        perMotor.stepTimerEventCount / (perMotor.pathLength_m * 1000.0);
+    const double sharedIsrs_per_mm = shared.stepTimerEventCount / (shared.pathLength_m * 1000.0);
+    EXPECT_TRUE(sharedIsrs_per_mm < 0.5 * perMotorIsrs_per_mm);
+}
+
+void TestTruncatedStreamIsRejected()
+{
+    const uint8_t stream[] = {CNC_JOG_OPCODE, 16, 0x00, 0x00};
+    HostSimulation simulation;
+    EXPECT_FALSE(simulation.AppendPacketStream(stream, sizeof(stream)));
+}
+
+void TestProgramPacketRunsLikeItsInstructions()
+{
+    std::vector<uint8_t> body;
+    AppendPacket(body, CNC_JOG_OPCODE, JogConfig{0.10f, 0.22f, 0.03f, 0});
+    AppendPacket(body, CNC_JOG_OPCODE, JogConfig{0.14f, 0.20f, 0.03f, 0});
+
+    const uint32_t crc = ProgramCrc32(body.data(), body.size());
+    std::vector<uint8_t> program = {CNC_PROGRAM_OPCODE, static_cast<uint8_t>(PROGRAM_HEADER_LEN), 1, 0, 2, 0,
+                                    static_cast<uint8_t>(body.size()), 0};
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        program.push_back(static_cast<uint8_t>(crc >> shift));
+    }
+    program.insert(program.end(), body.begin(), body.end());
+
+    HostSimulationMetrics plainMetrics;
+    HostSimulationMetrics programMetrics;
+    {
+        HostSimulation simulation;
+        EXPECT_TRUE(simulation.AppendPacketStream(body.data(), body.size()));
+        plainMetrics = simulation.Run();
+    }
+    {
+        HostSimulation simulation;
+        EXPECT_TRUE(simulation.AppendPacketStream(program.data(), program.size()));
+        programMetrics = simulation.Run();
+        EXPECT_EQ(simulation.GetCommandSlab().GetLiveCount(), 0U);
+    }
+    EXPECT_TRUE(programMetrics.completed);
+    EXPECT_EQ(programMetrics.packetCount, 2U);
+    EXPECT_EQ(programMetrics.cycleCount, plainMetrics.cycleCount);
+
+    // Running the same file again sends the same packet, sequence and CRC included, since each
+    // terminal session numbers its programs from 0. It is a new run, not a duplicate.
+    {
+        HostSimulation simulation;
+        EXPECT_TRUE(simulation.AppendPacketStream(program.data(), program.size()));
+        EXPECT_TRUE(simulation.AppendPacketStream(program.data(), program.size()));
+        HostSimulationMetrics rerunMetrics = simulation.Run();
+        EXPECT_TRUE(rerunMetrics.completed);
+        EXPECT_EQ(rerunMetrics.packetCount, 4U);
+        EXPECT_TRUE(rerunMetrics.cycleCount > programMetrics.cycleCount);
+        Vector2D tip_m = PhysicalTip_m(simulation);
+        ExpectNearlyEqual(tip_m.x, 0.14f, 0.002f, "re-run end x");
+        ExpectNearlyEqual(tip_m.y, 0.20f, 0.002f, "re-run end y");
+    }
+
+    // One flipped bit and none of the program is taken.
+    program.back() ^= 0x01;
+    HostSimulation simulation;
+    EXPECT_FALSE(simulation.AppendPacketStream(program.data(), program.size()));
+    EXPECT_EQ(simulation.Run().packetCount, 0U);
+}
+
+void TestRunsAreDeterministic()
+{
+    std::vector<uint8_t> stream;
+    AppendPacket(stream, CNC_JOG_OPCODE, JogConfig{0.10f, 0.22f, 0.05f, 1});
+
+    HostSimulationMetrics first;
+    HostSimulationMetrics second;
+    {
+        HostSimulation simulation;
+        simulation.AppendPacketStream(stream.data(), stream.size());
+        first = simulation.Run();
+    }
+    {
+        HostSimulation simulation;
+        simulation.AppendPacketStream(stream.data(), stream.size());
+        second = simulation.Run();
+    }
+
+    EXPECT_EQ(first.cycleCount, second.cycleCount);
+    EXPECT_EQ(first.stepTimerEventCount, second.stepTimerEventCount);
+    EXPECT_TRUE(first.maxTrackingError_m == second.maxTrackingError_m);
+    EXPECT_TRUE(first.pumpTravel_deg == second.pumpTravel_deg);
+}
+} // namespace
+
+int main()
+{
+    TestJogStreamDrivesPhysicalArmToTarget();
+    TestPumpOnJogReportsPumpTravel();
+    TestStopDrainsQueuedMotion();
+    TestKeepOutRoutingFinishesTheJob();
+    TestPathStartIsDrawnAfterTheElbowFlips();
+    TestMidPathElbowFlipLeavesNoGap();
+    TestVelocityFeedforwardReducesArcTrackingError();
+    TestSharedStepTimerCutsIsrLoadPerMillimetre();
+    TestTruncatedStreamIsRejected();
+    TestProgramPacketRunsLikeItsInstructions();
+    TestRunsAreDeterministic();
+
+    PrintTestPassed("MotorControlLoop host simulation test");
+    return EXIT_SUCCESS;
+}
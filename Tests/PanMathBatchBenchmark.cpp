@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "PanMath.h"
+
+// Samples per second of the batch kinematics against a scalar call per sample, and the time to
+// preflight a 10,000-sample spiral (inverse kinematics, then forward kinematics to check the
+// round trip).
+namespace
+{
+constexpr int kSamples = 10000;
+constexpr int kRepeats = 200;
+
+volatile float sink;
+
+template <typename Fn> double SecondsPerPass(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeats; r++)
+    {
+        fn();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count() / kRepeats;
+}
+
+void Report(const char *name, double scalar_s, double batch_s)
+{
+    std::printf("%-10s scalar %7.2f Msamples/s  batch %7.2f Msamples/s  speedup %5.2fx\n", name,
+                kSamples / scalar_s * 1.0e-6, kSamples / batch_s * 1.0e-6, scalar_s / batch_s);
+}
+} // namespace
+
+int main()
+{
+    // Spiral about a point inside the reachable annulus, stepping out past max reach so the
+    // tail exercises the error path too.
+    std::vector<float> x_m(kSamples), y_m(kSamples);
+    for (int i = 0; i < kSamples; i++)
+    {
+        float theta_rad = 0.01f * i;
+        float r_m = 0.002f + 0.0025f * theta_rad;
+        x_m[i] = r_m * std::cos(theta_rad);
+        y_m[i] = 0.22f + r_m * std::sin(theta_rad);
+    }
+
+    std::vector<float> s0_deg(kSamples), s1_deg(kSamples);
+    std::vector<float> rx_m(kSamples), ry_m(kSamples);
+    std::vector<MathErrorCodes> errors(kSamples);
+
+    double scalarInverse_s = SecondsPerPass(
+        [&]()
+        {
+            for (int i = 0; i < kSamples; i++)
+            {
+                errors[i] = CartToAng(s0_deg[i], s1_deg[i], Vector2D(x_m[i], y_m[i]));
+            }
+            sink = s0_deg[kSamples / 2];
+        });
+    double batchInverse_s = SecondsPerPass(
+        [&]()
+        {
+            CartToAngBatch(x_m.data(), y_m.data(), s0_deg.data(), s1_deg.data(), errors.data(),
+                           kSamples);
+            sink = s0_deg[kSamples / 2];
+        });
+    Report("CartToAng", scalarInverse_s, batchInverse_s);
+
+    double scalarForward_s = SecondsPerPass(
+        [&]()
+        {
+            for (int i = 0; i < kSamples; i++)
+            {
+                Vector2D p_m;
+                AngToCart(s0_deg[i], s1_deg[i], p_m);
+                rx_m[i] = p_m.x;
+                ry_m[i] = p_m.y;
+            }
+            sink = rx_m[kSamples / 2];
+        });
+    double batchForward_s = SecondsPerPass(
+        [&]()
+        {
+            AngToCartBatch(s0_deg.data(), s1_deg.data(), rx_m.data(), ry_m.data(), kSamples);
+            sink = rx_m[kSamples / 2];
+        });
+    Report("AngToCart", scalarForward_s, batchForward_s);
+
+    size_t unreachable = 0;
+    float worstRoundTrip_m = 0.0f;
+    double preflight_s = SecondsPerPass(
+        [&]()
+        {
+            unreachable = CartToAngBatch(x_m.data(), y_m.data(), s0_deg.data(), s1_deg.data(),
+                                         errors.data(), kSamples);
+            AngToCartBatch(s0_deg.data(), s1_deg.data(), rx_m.data(), ry_m.data(), kSamples);
+            worstRoundTrip_m = 0.0f;
+            for (int i = 0; i < kSamples; i++)
+            {
+                float error_m = (errors[i] == E_OK)
+                                    ? std::fabs(rx_m[i] - x_m[i]) + std::fabs(ry_m[i] - y_m[i])
+                                    : 0.0f;
+                worstRoundTrip_m = (error_m > worstRoundTrip_m) ? error_m : worstRoundTrip_m;
+            }
+        });
+    std::printf("preflight  %d-sample spiral: %.3f ms, %zu unreachable, worst round trip %.2g m\n",
+                kSamples, preflight_s * 1.0e3, unreachable, worstRoundTrip_m);
+    return EXIT_SUCCESS;
+}
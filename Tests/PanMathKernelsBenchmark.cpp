@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "PanMath.h"
+#include "PanMathKernels.h"
+
+// Host throughput and worst-case error of the PanMath kernels against libm. Host numbers only
+// rank the two and say nothing about the ESP32-S3, whose libm calls run from flash.
+namespace
+{
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kSamples = 1 << 16;
+constexpr int kRepeats = 64;
+
+volatile float sink;
+
+template <typename Fn> double NsPerCall(const std::vector<float> &a, const std::vector<float> &b, Fn fn)
+{
+    float acc = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeats; r++)
+    {
+        for (int i = 0; i < kSamples; i++)
+        {
+            acc += fn(a[i], b[i]);
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    sink = acc;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (kRepeats * kSamples);
+}
+
+void Report(const char *name, double libm_ns, double fast_ns, double worstError)
+{
+    std::printf("%-12s libm %6.2f ns  fast %6.2f ns  speedup %5.2fx  worst error %.3g\n", name,
+                libm_ns, fast_ns, libm_ns / fast_ns, worstError);
+}
+} // namespace
+
+int main()
+{
+    std::vector<float> angles_rad(kSamples);
+    std::vector<float> unit(kSamples);
+    std::vector<float> xs(kSamples);
+    std::vector<float> ys(kSamples);
+    for (int i = 0; i < kSamples; i++)
+    {
+        double t = static_cast<double>(i) / kSamples;
+        angles_rad[i] = static_cast<float>(-4.0 * kPi + 8.0 * kPi * t);
+        unit[i] = static_cast<float>(-1.0 + 2.0 * t);
+        xs[i] = static_cast<float>(0.3 * std::cos(37.0 * t * kPi));
+        ys[i] = static_cast<float>(0.3 * std::sin(37.0 * t * kPi) + 0.05);
+    }
+
+    double worstSinCos = 0.0;
+    double worstAtan2 = 0.0;
+    double worstAcos = 0.0;
+    for (int i = 0; i < kSamples; i++)
+    {
+        float s = 0.0f;
+        float c = 0.0f;
+        FastSinCos(angles_rad[i], s, c);
+        worstSinCos = std::fmax(worstSinCos, std::fabs(s - std::sin(static_cast<double>(angles_rad[i]))));
+        worstSinCos = std::fmax(worstSinCos, std::fabs(c - std::cos(static_cast<double>(angles_rad[i]))));
+        worstAtan2 = std::fmax(worstAtan2, std::fabs(FastAtan2(ys[i], xs[i]) -
+                                                     std::atan2(static_cast<double>(ys[i]),
+                                                                static_cast<double>(xs[i]))));
+        worstAcos = std::fmax(worstAcos,
+                              std::fabs(FastAcos(unit[i]) - std::acos(static_cast<double>(unit[i]))));
+    }
+
+    Report("sincos",
+           NsPerCall(angles_rad, angles_rad, [](float x, float) { return sinf(x) + cosf(x); }),
+           NsPerCall(angles_rad, angles_rad,
+                     [](float x, float)
+                     {
+                         float s, c;
+                         FastSinCos(x, s, c);
+                         return s + c;
+                     }),
+           worstSinCos);
+    Report("atan2", NsPerCall(ys, xs, [](float y, float x) { return atan2f(y, x); }),
+           NsPerCall(ys, xs, [](float y, float x) { return FastAtan2(y, x); }), worstAtan2);
+    Report("acos", NsPerCall(unit, unit, [](float x, float) { return acosf(x); }),
+           NsPerCall(unit, unit, [](float x, float) { return FastAcos(x); }), worstAcos);
+
+    // Whole kinematics on the kernels, for scale against the 10 ms control period.
+    double angToCart_ns = NsPerCall(angles_rad, unit,
+                                    [](float s0, float s1)
+                                    {
+                                        Vector2D p;
+                                        AngToCart(s0 * 57.3f, s1 * 180.0f, p);
+                                        return p.x + p.y;
+                                    });
+    double cartToAng_ns = NsPerCall(xs, ys,
+                                    [](float x, float y)
+                                    {
+                                        float s0 = 0.0f;
+                                        float s1 = 0.0f;
+                                        CartToAng(s0, s1, Vector2D(x, y));
+                                        return s0 + s1;
+                                    });
+    std::printf("AngToCart    %6.2f ns\nCartToAng    %6.2f ns\n", angToCart_ns, cartToAng_ns);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "PanMath.h"
+#include "PanMathKernels.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr double kPi = 3.14159265358979323846;
+constexpr float kKernelTolerance = 1.0e-6f;
+// One S0 microstep; kinematics built on the kernels must stay well inside it.
+constexpr float kS0Microstep_deg = 0.9f / 16.0f * 16.0f / 108.0f;
+
+void TestSinCosAcrossSeveralTurns()
+{
+    double worst = 0.0;
+    constexpr int kSamples = 400000;
+    for (int i = 0; i <= kSamples; i++)
+    {
+        float x = static_cast<float>(-8.0 * kPi + 16.0 * kPi * i / kSamples);
+        float s = 0.0f;
+        float c = 0.0f;
+        FastSinCos(x, s, c);
+        worst = std::fmax(worst, std::fabs(s - std::sin(static_cast<double>(x))));
+        worst = std::fmax(worst, std::fabs(c - std::cos(static_cast<double>(x))));
+    }
+    EXPECT_TRUE(worst < kKernelTolerance);
+
+    // Quadrant boundaries land exactly.
+    float s = 1.0f;
+    float c = 0.0f;
+    FastSinCos(0.0f, s, c);
+    EXPECT_EQ(s, 0.0f);
+    EXPECT_EQ(c, 1.0f);
+}
+
+void TestSinCosOfNonFiniteIsNan()
+{
+    for (float x : {NAN, INFINITY, -INFINITY})
+    {
+        float s = 0.0f;
+        float c = 0.0f;
+        FastSinCos(x, s, c);
+        EXPECT_TRUE(std::isnan(s));
+        EXPECT_TRUE(std::isnan(c));
+    }
+
+    // Far outside the accurate range the result is meaningless; this only has to be defined
+    // (the quarter-turn count would overflow int32_t without the clamp).
+    float s = 0.0f;
+    float c = 0.0f;
+    FastSinCos(3.0e38f, s, c);
+    FastSinCos(-1.0e12f, s, c);
+}
+
+void TestAtan2AllQuadrants()
+{
+    double worst = 0.0;
+    constexpr int kSamples = 200000;
+    for (int i = 0; i < kSamples; i++)
+    {
+        double a = -kPi + 2.0 * kPi * (i + 0.5) / kSamples;
+        for (float radius : {1.0e-3f, 0.2f, 35.0f})
+        {
+            float y = static_cast<float>(radius * std::sin(a));
+            float x = static_cast<float>(radius * std::cos(a));
+            worst = std::fmax(worst, std::fabs(FastAtan2(y, x) - std::atan2(static_cast<double>(y),
+                                                                              static_cast<double>(x))));
+        }
+    }
+    EXPECT_TRUE(worst < kKernelTolerance);
+
+    ExpectNearlyEqual(FastAtan2(0.0f, 1.0f), 0.0f, 0.0f, "atan2 +x axis");
+    ExpectNearlyEqual(FastAtan2(1.0f, 0.0f), 0.5f * static_cast<float>(kPi), 1.0e-7f, "atan2 +y axis");
+    ExpectNearlyEqual(FastAtan2(0.0f, -1.0f), static_cast<float>(kPi), 1.0e-7f, "atan2 -x axis");
+    ExpectNearlyEqual(FastAtan2(-1.0f, 0.0f), -0.5f * static_cast<float>(kPi), 1.0e-7f, "atan2 -y axis");
+    EXPECT_EQ(FastAtan2(0.0f, 0.0f), 0.0f);
+}
+
+void TestAcosWholeDomain()
+{
+    double worst = 0.0;
+    constexpr int kSamples = 400000;
+    for (int i = 0; i <= kSamples; i++)
+    {
+        float x = static_cast<float>(-1.0 + 2.0 * i / kSamples);
+        worst = std::fmax(worst, std::fabs(FastAcos(x) - std::acos(static_cast<double>(x))));
+    }
+    EXPECT_TRUE(worst < kKernelTolerance);
+
+    EXPECT_EQ(FastAcos(1.5f), 0.0f);
+    ExpectNearlyEqual(FastAcos(-1.5f), static_cast<float>(kPi), 1.0e-7f, "acos clamps below -1");
+}
+
+// Double-precision inverse kinematics, the same solution branch as CartToAng.
+void ReferenceCartToAng(double x, double y, double &s0_deg, double &s1_deg)
+{
+    const double l0 = 0.22;
+    const double l1 = 0.126;
+    double r2 = x * x + y * y;
+    double r = std::sqrt(r2);
+    double s0Arg = std::fmin(1.0, std::fmax(-1.0, (l0 * l0 - l1 * l1 + r2) / (2.0 * l0 * r)));
+    double s1Arg = std::fmin(1.0, std::fmax(-1.0, (l0 * l0 + l1 * l1 - r2) / (2.0 * l0 * l1)));
+    s0_deg = (std::atan2(x, y) + std::acos(s0Arg)) * 180.0 / kPi;
+    s1_deg = (std::acos(s1Arg) - kPi) * 180.0 / kPi;
+}
+
+void TestKinematicsStayWithinAFractionOfAMicrostep()
+{
+    double worstAngle_deg = 0.0;
+    double worstPosition_m = 0.0;
+    for (int ix = -60; ix <= 60; ix++)
+    {
+        for (int iy = -60; iy <= 60; iy++)
+        {
+            Vector2D target_m(0.35f * ix / 60.0f, 0.35f * iy / 60.0f);
+            float s0_deg = 0.0f;
+            float s1_deg = 0.0f;
+            if (CartToAng(s0_deg, s1_deg, target_m) != E_OK)
+            {
+                continue;
+            }
+
+            double ref0_deg = 0.0;
+            double ref1_deg = 0.0;
+            ReferenceCartToAng(target_m.x, target_m.y, ref0_deg, ref1_deg);
+            worstAngle_deg = std::fmax(worstAngle_deg, std::fabs(s0_deg - ref0_deg));
+            worstAngle_deg = std::fmax(worstAngle_deg, std::fabs(s1_deg - ref1_deg));
+
+            // Forward kinematics against the same reference angles.
+            Vector2D position_m;
+            AngToCart(static_cast<float>(ref0_deg), static_cast<float>(ref1_deg), position_m);
+            double theta = ref0_deg * kPi / 180.0;
+            double phi = (ref0_deg + ref1_deg) * kPi / 180.0;
+            worstPosition_m = std::fmax(
+                worstPosition_m, std::fabs(position_m.x - (0.22 * std::sin(theta) + 0.126 * std::sin(phi))));
+            worstPosition_m = std::fmax(
+                worstPosition_m, std::fabs(position_m.y - (0.22 * std::cos(theta) + 0.126 * std::cos(phi))));
+        }
+    }
+
+    EXPECT_TRUE(worstAngle_deg < 0.05 * kS0Microstep_deg);
+    EXPECT_TRUE(worstPosition_m < 1.0e-6);
+}
+} // namespace
+
+int main()
+{
+    TestSinCosAcrossSeveralTurns();
+    TestSinCosOfNonFiniteIsNan();
+    TestAtan2AllQuadrants();
+    TestAcosWholeDomain();
+    TestKinematicsStayWithinAFractionOfAMicrostep();
+
+    PrintTestPassed("PanMathKernels unit test");
+    return EXIT_SUCCESS;
+}
@@ -57,6 +57,57 @@ void TestVelocityKinematicsMatchFiniteDifference()
                       "cartesian velocity y");
 }
 
+void TestCartRateToAngRateInvertsVelocityKinematics()
+{
+    constexpr float s0_angle_deg = 35.0f;
+    constexpr float s1_angle_deg = -70.0f;
+    constexpr float s0_rate_degps = 12.5f;
+    constexpr float s1_rate_degps = -8.0f;
+
+    Vector2D position_m;
+    Vector2D velocity_mps;
+    AngToCart(s0_angle_deg, s1_angle_deg, s0_rate_degps, s1_rate_degps, position_m, velocity_mps);
+
+    float actual_s0_rate_degps = 0.0f;
+    float actual_s1_rate_degps = 0.0f;
+    EXPECT_TRUE(CartRateToAngRate(s0_angle_deg, s1_angle_deg, velocity_mps, actual_s0_rate_degps,
+                                  actual_s1_rate_degps));
+    ExpectNearlyEqual(actual_s0_rate_degps, s0_rate_degps, 1.0e-3f, "inverse jacobian s0 rate");
+    ExpectNearlyEqual(actual_s1_rate_degps, s1_rate_degps, 1.0e-3f, "inverse jacobian s1 rate");
+
+    // Fully extended arm cannot produce radial velocity.
+    EXPECT_FALSE(CartRateToAngRate(0.0f, 0.0f, Vector2D(0.0f, 1.0f), actual_s0_rate_degps,
+                                   actual_s1_rate_degps));
+}
+
+void TestFeedforwardLeadsVelocityByAcceleration()
+{
+    constexpr float s0_angle_deg = 35.0f;
+    constexpr float s1_angle_deg = -70.0f;
+    const Vector2D velocity_mps(0.02f, -0.01f);
+    const Vector2D accel_mps2(0.4f, 0.2f);
+
+    float expected_s0_rate_degps = 0.0f;
+    float expected_s1_rate_degps = 0.0f;
+    EXPECT_TRUE(CartRateToAngRate(s0_angle_deg, s1_angle_deg, velocity_mps + accel_mps2 * 0.005f,
+                                  expected_s0_rate_degps, expected_s1_rate_degps));
+
+    float s0_rate_degps = 0.0f;
+    float s1_rate_degps = 0.0f;
+    EXPECT_TRUE(CartVelToAngRateFeedforward(s0_angle_deg, s1_angle_deg, velocity_mps, accel_mps2,
+                                            0.005f, s0_rate_degps, s1_rate_degps));
+    ExpectNearlyEqual(s0_rate_degps, expected_s0_rate_degps, 1.0e-4f, "feedforward s0 rate");
+    ExpectNearlyEqual(s1_rate_degps, expected_s1_rate_degps, 1.0e-4f, "feedforward s1 rate");
+
+    // At the singularity the feedforward drops out rather than commanding unbounded rates.
+    s0_rate_degps = 1.0f;
+    s1_rate_degps = 1.0f;
+    EXPECT_FALSE(CartVelToAngRateFeedforward(0.0f, 0.0f, Vector2D(0.0f, 1.0f), accel_mps2, 0.005f,
+                                             s0_rate_degps, s1_rate_degps));
+    ExpectNearlyEqual(s0_rate_degps, 0.0f, 0.0f, "singular feedforward s0 rate");
+    ExpectNearlyEqual(s1_rate_degps, 0.0f, 0.0f, "singular feedforward s1 rate");
+}
+
 void TestInverseKinematicsRoundTrips()
 {
     ExpectRoundTrip(35.0f, -70.0f);
@@ -139,17 +190,60 @@ void TestReachabilityBoundaryEdges()
                         Vector2D(0.0f, GetMinReach_m() - 1.0e-4f)),
               E_UNREACHABLE_TOO_CLOSE);
 }
+
+void TestBatchKinematicsMatchScalarCalls()
+{
+    const float xs_m[] = {0.05f, -0.12f, 0.0f, 0.0f, 0.0f, NAN, 0.2f, 0.0f};
+    const float ys_m[] = {0.2f, 0.25f, GetMaxReach_m() + 0.01f, GetMinReach_m() - 0.01f, 0.0f,
+                          0.2f, INFINITY, GetMaxReach_m()};
+    constexpr size_t kCount = sizeof(xs_m) / sizeof(xs_m[0]);
+
+    float s0_deg[kCount];
+    float s1_deg[kCount];
+    MathErrorCodes errors[kCount];
+    EXPECT_EQ(CartToAngBatch(xs_m, ys_m, s0_deg, s1_deg, errors, kCount), 5U);
+
+    for (size_t i = 0; i < kCount; i++)
+    {
+        float expected_s0_deg = 0.0f;
+        float expected_s1_deg = 0.0f;
+        EXPECT_EQ(errors[i], CartToAng(expected_s0_deg, expected_s1_deg, Vector2D(xs_m[i], ys_m[i])));
+        ExpectNearlyEqual(s0_deg[i], expected_s0_deg, 0.0f, "batch s0 angle");
+        ExpectNearlyEqual(s1_deg[i], expected_s1_deg, 0.0f, "batch s1 angle");
+    }
+    EXPECT_EQ(errors[0], E_OK);
+    EXPECT_EQ(errors[2], E_UNREACHABLE_TOO_FAR);
+    EXPECT_EQ(errors[3], E_UNREACHABLE_TOO_CLOSE);
+    EXPECT_EQ(errors[4], E_UNREACHABLE_TOO_CLOSE);
+    EXPECT_EQ(errors[5], E_UNREACHABLE_TOO_FAR);
+    EXPECT_EQ(errors[6], E_UNREACHABLE_TOO_FAR);
+    EXPECT_EQ(errors[7], E_OK);
+
+    float xs_out_m[kCount];
+    float ys_out_m[kCount];
+    AngToCartBatch(s0_deg, s1_deg, xs_out_m, ys_out_m, kCount);
+    for (size_t i = 0; i < kCount; i++)
+    {
+        Vector2D expected_m;
+        AngToCart(s0_deg[i], s1_deg[i], expected_m);
+        ExpectNearlyEqual(xs_out_m[i], expected_m.x, 0.0f, "batch x");
+        ExpectNearlyEqual(ys_out_m[i], expected_m.y, 0.0f, "batch y");
+    }
+}
 } // namespace
 
 int main()
 {
     TestForwardKinematicsCardinalAngles();
     TestVelocityKinematicsMatchFiniteDifference();
+    TestCartRateToAngRateInvertsVelocityKinematics();
+    TestFeedforwardLeadsVelocityByAcceleration();
     TestInverseKinematicsRoundTrips();
     TestReachabilityErrors();
     TestNonFiniteTargetIsRejected();
     TestReachableRectangleCorners();
     TestReachabilityBoundaryEdges();
+    TestBatchKinematicsMatchScalarCalls();
 
     PrintTestPassed("PanMath unit test");
     return EXIT_SUCCESS;
@@ -0,0 +1,166 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "PathSpeedPlanner.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr float kSpacing_m = 0.001f;
+
+PathJointLimits MakeLimits()
+{
+    PathJointLimits limits;
+    limits.s0Speed_degps = 50.0f;
+    limits.s1Speed_degps = 50.0f;
+    limits.s0Accel_degps2 = 50.0f;
+    limits.s1Accel_degps2 = 100.0f;
+    return limits;
+}
+
+size_t SampleLine(Vector2D start_m, Vector2D direction, Vector2D *points)
+{
+    for (size_t i = 0; i < PATH_SPEED_MAX_POINTS; i++)
+    {
+        points[i] = start_m + direction * (kSpacing_m * static_cast<float>(i));
+    }
+    return PATH_SPEED_MAX_POINTS;
+}
+
+size_t SampleCircle(Vector2D center_m, float radius_m, Vector2D *points)
+{
+    for (size_t i = 0; i < PATH_SPEED_MAX_POINTS; i++)
+    {
+        float theta = kSpacing_m * static_cast<float>(i) / radius_m;
+        points[i] = center_m + Vector2D(sinf(theta), cosf(theta)) * radius_m;
+    }
+    return PATH_SPEED_MAX_POINTS;
+}
+
+// Joint speed and acceleration implied by the plan, checked interval by interval with the same
+// finite differences the planner uses, against the limits plus a small rounding allowance.
+void ExpectPlanWithinJointLimits(const PathSpeedPlan &plan, const Vector2D *points, size_t count,
+                                 const PathJointLimits &limits)
+{
+    float q[PATH_SPEED_MAX_POINTS][2];
+    for (size_t i = 0; i < count; i++)
+    {
+        EXPECT_EQ(CartToAng(q[i][0], q[i][1], points[i]), E_OK);
+    }
+
+    const float speedLimit_degps[2] = {limits.s0Speed_degps, limits.s1Speed_degps};
+    const float accelLimit_degps2[2] = {limits.s0Accel_degps2, limits.s1Accel_degps2};
+    for (size_t i = 1; i + 1 < count; i++)
+    {
+        float v = plan.GetSpeed_mps(kSpacing_m * static_cast<float>(i));
+        float vNext = plan.GetSpeed_mps(kSpacing_m * static_cast<float>(i + 1));
+        float pathAccel_mps2 = (vNext * vNext - v * v) / (2.0f * kSpacing_m);
+        for (int j = 0; j < 2; j++)
+        {
+            float first_degpm = (q[i + 1][j] - q[i - 1][j]) / (2.0f * kSpacing_m);
+            float second_degpm2 = (q[i + 1][j] - 2.0f * q[i][j] + q[i - 1][j]) / (kSpacing_m * kSpacing_m);
+            EXPECT_TRUE(fabsf(first_degpm * v) <= speedLimit_degps[j] * 1.01f);
+            EXPECT_TRUE(fabsf(first_degpm * pathAccel_mps2 + second_degpm2 * v * v) <=
+                        accelLimit_degps2[j] * 1.05f + 0.5f);
+        }
+    }
+}
+
+void TestStartsFromEntrySpeedAndStopsAtHorizon()
+{
+    Vector2D points[PATH_SPEED_MAX_POINTS];
+    size_t count = SampleLine(Vector2D(-0.05f, 0.25f), Vector2D(1.0f, 0.0f), points);
+    PathJointLimits limits = MakeLimits();
+
+    PathSpeedPlan plan;
+    EXPECT_TRUE(plan.Plan(points, count, kSpacing_m, 0.0f, 0.0f, limits));
+    EXPECT_TRUE(plan.IsValid());
+    EXPECT_EQ(plan.GetSpeed_mps(0.0f), 0.0f);
+    EXPECT_EQ(plan.GetSpeed_mps(kSpacing_m * (count - 1)), 0.0f);
+    EXPECT_TRUE(plan.GetSpeed_mps(kSpacing_m * (count / 2)) > 0.01f);
+    ExpectPlanWithinJointLimits(plan, points, count, limits);
+
+    // From rest the next step still moves, and no faster than the plan allows where it lands.
+    const float dt_s = 0.01f;
+    float step_mps = plan.GetStepSpeed_mps(dt_s);
+    EXPECT_TRUE(step_mps > 0.0f);
+    EXPECT_TRUE(step_mps <= plan.GetSpeed_mps(step_mps * dt_s) * 1.0001f);
+}
+
+void TestFreeExitKeepsSpeedAtHorizon()
+{
+    Vector2D points[PATH_SPEED_MAX_POINTS];
+    size_t count = SampleLine(Vector2D(-0.05f, 0.25f), Vector2D(1.0f, 0.0f), points);
+
+    PathSpeedPlan plan;
+    EXPECT_TRUE(plan.Plan(points, count, kSpacing_m, 0.05f, -1.0f, MakeLimits()));
+    ExpectNearlyEqual(plan.GetSpeed_mps(0.0f), 0.05f, 1.0e-6f, "entry speed");
+    EXPECT_TRUE(plan.GetSpeed_mps(kSpacing_m * (count - 1)) >= 0.05f);
+}
+
+void TestTightCurveIsSlowerThanStraightLine()
+{
+    PathJointLimits limits = MakeLimits();
+    Vector2D line[PATH_SPEED_MAX_POINTS];
+    Vector2D curve[PATH_SPEED_MAX_POINTS];
+    size_t count = SampleLine(Vector2D(0.0f, 0.22f), Vector2D(1.0f, 0.0f), line);
+    SampleCircle(Vector2D(0.0f, 0.21f), 0.01f, curve);
+
+    PathSpeedPlan linePlan;
+    PathSpeedPlan curvePlan;
+    EXPECT_TRUE(linePlan.Plan(line, count, kSpacing_m, 1.0f, -1.0f, limits));
+    EXPECT_TRUE(curvePlan.Plan(curve, count, kSpacing_m, 1.0f, -1.0f, limits));
+
+    // A 1 cm radius at 1 m/s needs 100 m/s^2 of centripetal acceleration the joints cannot give.
+    float lineSpeed_mps = linePlan.GetSpeed_mps(0.02f);
+    float curveSpeed_mps = curvePlan.GetSpeed_mps(0.02f);
+    EXPECT_TRUE(curveSpeed_mps < 0.5f * lineSpeed_mps);
+    ExpectPlanWithinJointLimits(curvePlan, curve, count, limits);
+}
+
+void TestJointSpeedLimitCapsNearMinimumReach()
+{
+    // The same tip speed needs far more S0 rate close to the base than out at mid reach.
+    PathJointLimits limits = MakeLimits();
+    limits.s0Accel_degps2 = 1.0e5f;
+    limits.s1Accel_degps2 = 1.0e5f;
+    Vector2D nearBase[PATH_SPEED_MAX_POINTS];
+    Vector2D midReach[PATH_SPEED_MAX_POINTS];
+    size_t count = SampleCircle(Vector2D(0.0f, 0.0f), 0.1f, nearBase);
+    SampleCircle(Vector2D(0.0f, 0.0f), 0.3f, midReach);
+
+    PathSpeedPlan nearPlan;
+    PathSpeedPlan midPlan;
+    EXPECT_TRUE(nearPlan.Plan(nearBase, count, kSpacing_m, 10.0f, -1.0f, limits));
+    EXPECT_TRUE(midPlan.Plan(midReach, count, kSpacing_m, 10.0f, -1.0f, limits));
+
+    // Around the base only S0 turns: 50 deg/s at r gives r * 50 deg/s of tip speed.
+    ExpectNearlyEqual(nearPlan.GetSpeed_mps(0.02f), 0.1f * 50.0f * C_DEGToRAD, 1.0e-3f, "near base speed");
+    ExpectNearlyEqual(midPlan.GetSpeed_mps(0.02f), 0.3f * 50.0f * C_DEGToRAD, 3.0e-3f, "mid reach speed");
+}
+
+void TestUnreachablePathPlacesNoLimit()
+{
+    Vector2D points[PATH_SPEED_MAX_POINTS];
+    size_t count = SampleLine(Vector2D(0.0f, 0.33f), Vector2D(0.0f, 1.0f), points);
+
+    PathSpeedPlan plan;
+    EXPECT_FALSE(plan.Plan(points, count, kSpacing_m, 0.0f, 0.0f, MakeLimits()));
+    EXPECT_FALSE(plan.IsValid());
+    EXPECT_TRUE(std::isinf(plan.GetSpeed_mps(0.0f)));
+    EXPECT_TRUE(std::isinf(plan.GetStepSpeed_mps(0.01f)));
+    EXPECT_FALSE(plan.Plan(points, 1, kSpacing_m, 0.0f, 0.0f, MakeLimits()));
+}
+} // namespace
+
+int main()
+{
+    TestStartsFromEntrySpeedAndStopsAtHorizon();
+    TestFreeExitKeepsSpeedAtHorizon();
+    TestTightCurveIsSlowerThanStraightLine();
+    TestJointSpeedLimitCapsNearMinimumReach();
+    TestUnreachablePathPlacesNoLimit();
+
+    PrintTestPassed("PathSpeedPlanner unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CNCOpCodes.h"
+#include "ProgramPacket.h"
+#include "TestHarness.h"
+
+namespace
+{
+void AppendU16(std::vector<uint8_t> &out, uint16_t value)
+{
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void AppendU32(std::vector<uint8_t> &out, uint32_t value)
+{
+    AppendU16(out, static_cast<uint16_t>(value));
+    AppendU16(out, static_cast<uint16_t>(value >> 16));
+}
+
+std::vector<uint8_t> Instruction(uint8_t opcode, uint8_t payloadLength)
+{
+    std::vector<uint8_t> instruction = {opcode, payloadLength};
+    for (uint8_t i = 0; i < payloadLength; i++)
+    {
+        instruction.push_back(static_cast<uint8_t>(opcode + i));
+    }
+    return instruction;
+}
+
+// Same layout as CommandTerminal.py's _build_program_packet.
+std::vector<uint8_t> BuildProgram(uint16_t sequence, const std::vector<std::vector<uint8_t>> &instructions)
+{
+    std::vector<uint8_t> body;
+    for (const auto &instruction : instructions)
+    {
+        body.insert(body.end(), instruction.begin(), instruction.end());
+    }
+
+    std::vector<uint8_t> packet = {CNC_PROGRAM_OPCODE, static_cast<uint8_t>(PROGRAM_HEADER_LEN)};
+    AppendU16(packet, sequence);
+    AppendU16(packet, static_cast<uint16_t>(instructions.size()));
+    AppendU16(packet, static_cast<uint16_t>(body.size()));
+    AppendU32(packet, ProgramCrc32(body.data(), body.size()));
+    packet.insert(packet.end(), body.begin(), body.end());
+    return packet;
+}
+
+void TestCrcMatchesZlib()
+{
+    const char *check = "123456789";
+    EXPECT_EQ(ProgramCrc32(reinterpret_cast<const uint8_t *>(check), std::strlen(check)), 0xCBF43926u);
+    EXPECT_EQ(ProgramCrc32(nullptr, 0), 0u);
+}
+
+void TestInstructionsComeOutInOrder()
+{
+    std::vector<std::vector<uint8_t>> instructions = {
+        Instruction(CNC_JOG_OPCODE, 16),
+        Instruction(CNC_HOME_OPCODE, 0),
+        Instruction(CNC_ARC_OPCODE, 24),
+    };
+    std::vector<uint8_t> packet = BuildProgram(7, instructions);
+    EXPECT_EQ(GetProgramPacketLength(packet.data(), packet.size()), packet.size());
+
+    ProgramPacket program;
+    EXPECT_TRUE(ParseProgramPacket(packet.data(), packet.size(), program) == ProgramPacketStatus::Ok);
+    EXPECT_EQ(program.sequence, 7);
+    EXPECT_EQ(program.instruction_count, 3);
+    EXPECT_EQ(program.body_length, 18 + 2 + 26);
+
+    size_t offset = 0;
+    const uint8_t *instruction = nullptr;
+    size_t instructionLength = 0;
+    for (const auto &expected : instructions)
+    {
+        EXPECT_TRUE(NextProgramInstruction(program, offset, instruction, instructionLength));
+        EXPECT_EQ(instructionLength, expected.size());
+        EXPECT_EQ(std::memcmp(instruction, expected.data(), expected.size()), 0);
+    }
+    EXPECT_FALSE(NextProgramInstruction(program, offset, instruction, instructionLength));
+}
+
+void TestCorruptProgramIsRefusedWhole()
+{
+    std::vector<uint8_t> packet =
+        BuildProgram(1, {Instruction(CNC_JOG_OPCODE, 16), Instruction(CNC_JOG_OPCODE, 16)});
+    ProgramPacket program;
+    program.sequence = 99;
+
+    std::vector<uint8_t> flipped = packet;
+    flipped.back() ^= 0x01;
+    EXPECT_TRUE(ParseProgramPacket(flipped.data(), flipped.size(), program) == ProgramPacketStatus::BadCrc);
+    EXPECT_EQ(program.sequence, 99);
+
+    EXPECT_TRUE(ParseProgramPacket(packet.data(), packet.size() - 1, program) == ProgramPacketStatus::Truncated);
+    EXPECT_TRUE(ParseProgramPacket(packet.data(), 5, program) == ProgramPacketStatus::Truncated);
+
+    // A count that disagrees with the body is as bad as a broken body.
+    std::vector<uint8_t> miscounted = packet;
+    miscounted[4] = 3;
+    EXPECT_TRUE(ParseProgramPacket(miscounted.data(), miscounted.size(), program) ==
+                ProgramPacketStatus::BadInstruction);
+
+    std::vector<uint8_t> empty = BuildProgram(2, {});
+    EXPECT_TRUE(ParseProgramPacket(empty.data(), empty.size(), program) == ProgramPacketStatus::BadHeader);
+    EXPECT_EQ(program.sequence, 99);
+}
+
+void TestBodyMustSplitIntoInstructions()
+{
+    ProgramPacket program;
+
+    // The last instruction's length byte runs past the end of the body.
+    std::vector<uint8_t> overrun = BuildProgram(3, {Instruction(CNC_JOG_OPCODE, 16), {CNC_WAIT_OPCODE, 4, 0}});
+    EXPECT_TRUE(ParseProgramPacket(overrun.data(), overrun.size(), program) ==
+                ProgramPacketStatus::BadInstruction);
+
+    // Programs do not nest.
+    std::vector<uint8_t> inner = BuildProgram(4, {Instruction(CNC_HOME_OPCODE, 0)});
+    std::vector<uint8_t> nested = BuildProgram(5, {inner});
+    EXPECT_TRUE(ParseProgramPacket(nested.data(), nested.size(), program) == ProgramPacketStatus::BadInstruction);
+
+    // Anything but a program header is not a program.
+    std::vector<uint8_t> plain = Instruction(CNC_JOG_OPCODE, 16);
+    EXPECT_EQ(GetProgramPacketLength(plain.data(), plain.size()), 0u);
+    EXPECT_TRUE(ParseProgramPacket(plain.data(), plain.size(), program) == ProgramPacketStatus::BadHeader);
+}
+} // namespace
+
+int main()
+{
+    TestCrcMatchesZlib();
+    TestInstructionsComeOutInOrder();
+    TestCorruptProgramIsRefusedWhole();
+    TestBodyMustSplitIntoInstructions();
+
+    PrintTestPassed("ProgramPacket unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CNCOpCodes.h"
+#include "CommandSlab.h"
+#include "FileProgramStorage.h"
+#include "ProgramFeeder.h"
+#include "ProgramStore.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr size_t kStorageBytes = 4 * PROGRAM_SLOT_BYTES;
+
+std::string FreshPath(const char *name)
+{
+    std::string path = std::string("/tmp/pancake_program_store_") + name + ".bin";
+    std::remove(path.c_str());
+    return path;
+}
+
+// `count` jog-sized instructions, each payload filled with its index so order shows.
+std::vector<uint8_t> MakeProgram(size_t count, uint8_t opcode = CNC_JOG_OPCODE)
+{
+    std::vector<uint8_t> program;
+    for (size_t i = 0; i < count; i++)
+    {
+        program.push_back(opcode);
+        program.push_back(16);
+        program.insert(program.end(), 16, static_cast<uint8_t>(i));
+    }
+    return program;
+}
+
+uint32_t HashOf(const std::vector<uint8_t> &program)
+{
+    return ProgramHash(program.data(), program.size());
+}
+
+ProgramUploadStatus Upload(ProgramStore &store, const std::vector<uint8_t> &program, size_t chunkBytes = 200)
+{
+    ProgramUploadStatus status = store.BeginUpload(HashOf(program), static_cast<uint32_t>(program.size()));
+    if (status != ProgramUploadStatus::Ok && status != ProgramUploadStatus::AlreadyStored)
+    {
+        return status;
+    }
+    for (size_t offset = 0; offset < program.size(); offset += chunkBytes)
+    {
+        size_t length = std::min(chunkBytes, program.size() - offset);
+        ProgramUploadStatus chunk = store.WriteChunk(static_cast<uint32_t>(offset), program.data() + offset, length);
+        if (chunk != status)
+        {
+            return chunk;
+        }
+    }
+    return store.CommitUpload(HashOf(program));
+}
+
+void TestHashIsFnv1a()
+{
+    const char *text = "foobar";
+    EXPECT_EQ(ProgramHash(reinterpret_cast<const uint8_t *>(text), std::strlen(text)), 0xBF9CF968u);
+    EXPECT_EQ(ProgramHash(nullptr, 0), 2166136261u);
+}
+
+void TestUploadedProgramSurvivesReboot()
+{
+    const std::string path = FreshPath("reboot");
+    std::vector<uint8_t> program = MakeProgram(200);
+    {
+        FileProgramStorage storage(path, kStorageBytes);
+        ProgramStore store(storage);
+        EXPECT_EQ(store.GetSlotCount(), 4U);
+        EXPECT_TRUE(Upload(store, program) == ProgramUploadStatus::Ok);
+    }
+
+    FileProgramStorage storage(path, kStorageBytes);
+    ProgramStore store(storage);
+    StoredProgram stored;
+    EXPECT_TRUE(store.Find(HashOf(program), static_cast<uint32_t>(program.size()), stored));
+    std::vector<uint8_t> readBack(program.size());
+    EXPECT_EQ(store.Read(stored, 0, readBack.data(), readBack.size()), ESP_OK);
+    EXPECT_TRUE(readBack == program);
+    EXPECT_EQ(store.Read(stored, 1, readBack.data(), readBack.size()), ESP_ERR_INVALID_ARG);
+}
+
+void TestRepeatUploadIsSkipped()
+{
+    FileProgramStorage storage(FreshPath("repeat"), kStorageBytes);
+    ProgramStore store(storage);
+    std::vector<uint8_t> program = MakeProgram(40);
+    EXPECT_TRUE(Upload(store, program) == ProgramUploadStatus::Ok);
+    size_t erases = storage.GetEraseCount();
+
+    EXPECT_TRUE(Upload(store, program) == ProgramUploadStatus::AlreadyStored);
+    EXPECT_EQ(storage.GetEraseCount(), erases);
+}
+
+void TestIncompleteOrCorruptUploadIsNeverFound()
+{
+    FileProgramStorage storage(FreshPath("corrupt"), kStorageBytes);
+    ProgramStore store(storage);
+    std::vector<uint8_t> program = MakeProgram(20);
+    const uint32_t hash = HashOf(program);
+    const uint32_t length = static_cast<uint32_t>(program.size());
+    StoredProgram stored;
+
+    // Cut off before the commit.
+    EXPECT_TRUE(store.BeginUpload(hash, length) == ProgramUploadStatus::Ok);
+    EXPECT_TRUE(store.WriteChunk(0, program.data(), 100) == ProgramUploadStatus::Ok);
+    EXPECT_FALSE(store.Find(hash, length, stored));
+
+    // A chunk that skips ahead ends the upload.
+    EXPECT_TRUE(store.WriteChunk(120, program.data() + 120, 40) == ProgramUploadStatus::OutOfOrder);
+    EXPECT_FALSE(store.IsUploading());
+    EXPECT_TRUE(store.CommitUpload(hash) == ProgramUploadStatus::NotUploading);
+
+    // Bytes that do not hash to the announced name.
+    std::vector<uint8_t> damaged = program;
+    damaged[50] ^= 0x01;
+    EXPECT_TRUE(store.BeginUpload(hash, length) == ProgramUploadStatus::Ok);
+    EXPECT_TRUE(store.WriteChunk(0, damaged.data(), damaged.size()) == ProgramUploadStatus::Ok);
+    EXPECT_TRUE(store.CommitUpload(hash) == ProgramUploadStatus::BadHash);
+    EXPECT_FALSE(store.Find(hash, length, stored));
+
+    // A program must split into whole instructions.
+    std::vector<uint8_t> truncated(program.begin(), program.end() - 1);
+    EXPECT_TRUE(Upload(store, truncated) == ProgramUploadStatus::Malformed);
+
+    std::vector<uint8_t> tooLarge(store.GetMaxProgramLength() + 1, 0);
+    EXPECT_TRUE(store.BeginUpload(HashOf(tooLarge), static_cast<uint32_t>(tooLarge.size())) ==
+                ProgramUploadStatus::TooLarge);
+}
+
+void TestOldestProgramMakesRoom()
+{
+    FileProgramStorage storage(FreshPath("oldest"), kStorageBytes);
+    ProgramStore store(storage);
+    std::vector<std::vector<uint8_t>> programs;
+    for (size_t i = 0; i < 5; i++)
+    {
+        programs.push_back(MakeProgram(10 + i));
+        EXPECT_TRUE(Upload(store, programs.back()) == ProgramUploadStatus::Ok);
+    }
+
+    StoredProgram stored;
+    EXPECT_FALSE(store.Find(HashOf(programs[0]), static_cast<uint32_t>(programs[0].size()), stored));
+    for (size_t i = 1; i < 5; i++)
+    {
+        EXPECT_TRUE(store.Find(HashOf(programs[i]), static_cast<uint32_t>(programs[i].size()), stored));
+    }
+    EXPECT_EQ(stored.slot, 0U);
+}
+
+struct FeederFixture
+{
+    explicit FeederFixture(const char *name) : storage(FreshPath(name), kStorageBytes), store(storage)
+    {
+        cncQueue = xQueueCreate(256, sizeof(cmd_handle_t));
+    }
+    ~FeederFixture() { vQueueDelete(cncQueue); }
+
+    StoredProgram Store(const std::vector<uint8_t> &program)
+    {
+        StoredProgram stored;
+        EXPECT_TRUE(Upload(store, program) == ProgramUploadStatus::Ok);
+        EXPECT_TRUE(store.Find(HashOf(program), static_cast<uint32_t>(program.size()), stored));
+        return stored;
+    }
+
+    // Take one queued instruction the way the controller does, returning its first payload byte.
+    int Consume()
+    {
+        cmd_handle_t handle;
+        if (xQueueReceive(cncQueue, &handle, 0) != pdTRUE)
+        {
+            return -1;
+        }
+        DecodedCommand command;
+        EXPECT_TRUE(slab.GetDecoded(handle, command));
+        int index = command.instructions[2];
+        slab.Release(handle);
+        return index;
+    }
+
+    FileProgramStorage storage;
+    ProgramStore store;
+    CommandSlab slab;
+    QueueHandle_t cncQueue = nullptr;
+};
+
+void TestFeederKeepsTheQueueToppedUp()
+{
+    FeederFixture fixture("feed");
+    ProgramFeeder feeder(fixture.store, fixture.slab, fixture.cncQueue);
+    EXPECT_TRUE(feeder.Start(fixture.Store(MakeProgram(100))));
+    EXPECT_FALSE(feeder.Start(fixture.Store(MakeProgram(3))));
+
+    // Only a short run is queued ahead; the rest waits in flash until the controller takes some.
+    EXPECT_EQ(feeder.Feed(0), PROGRAM_FEED_QUEUE_AHEAD);
+    EXPECT_EQ(feeder.Feed(0), 0U);
+
+    int expected = 0;
+    while (feeder.IsRunning() || uxQueueMessagesWaiting(fixture.cncQueue) > 0)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            int index = fixture.Consume();
+            if (index >= 0)
+            {
+                EXPECT_EQ(index, expected++);
+            }
+        }
+        feeder.Feed(0);
+        EXPECT_TRUE(uxQueueMessagesWaiting(fixture.cncQueue) <= PROGRAM_FEED_QUEUE_AHEAD);
+    }
+    EXPECT_EQ(expected, 100);
+    EXPECT_EQ(fixture.slab.GetLiveCount(), 0U);
+}
+
+void TestFeederLeavesSlabRoomForNetworkCommands()
+{
+    FeederFixture fixture("reserve");
+    uint8_t *data = nullptr;
+    cmd_handle_t hog = fixture.slab.Allocate(0, COMMAND_SLAB_BYTES - PROGRAM_FEED_SLAB_RESERVE_BYTES - 16, data);
+    EXPECT_TRUE(hog != CMD_HANDLE_INVALID);
+
+    ProgramFeeder feeder(fixture.store, fixture.slab, fixture.cncQueue);
+    EXPECT_TRUE(feeder.Start(fixture.Store(MakeProgram(10))));
+    EXPECT_EQ(feeder.Feed(0), 0U);
+    EXPECT_TRUE(feeder.IsRunning());
+
+    fixture.slab.Release(hog);
+    EXPECT_EQ(feeder.Feed(0), 10U);
+    EXPECT_FALSE(feeder.IsRunning());
+}
+
+void TestFeederStopsWhenTheControllerClearsTheQueue()
+{
+    FeederFixture fixture("clear");
+    ProgramFeeder feeder(fixture.store, fixture.slab, fixture.cncQueue);
+    EXPECT_TRUE(feeder.Start(fixture.Store(MakeProgram(50))));
+    EXPECT_TRUE(feeder.Feed(7) > 0);
+
+    // A limit stop drained the queue; the rest of the program must not follow.
+    while (fixture.Consume() >= 0)
+    {
+    }
+    EXPECT_EQ(feeder.Feed(8), 0U);
+    EXPECT_FALSE(feeder.IsRunning());
+
+    EXPECT_TRUE(feeder.Start(fixture.Store(MakeProgram(5))));
+    feeder.Cancel();
+    EXPECT_EQ(feeder.Feed(8), 0U);
+}
+
+void TestCancelAndRestartBeforeTheNextFeed()
+{
+    FeederFixture fixture("restart");
+    ProgramFeeder feeder(fixture.store, fixture.slab, fixture.cncQueue);
+    EXPECT_TRUE(feeder.Start(fixture.Store(MakeProgram(40))));
+    EXPECT_TRUE(feeder.IsRunning());
+    EXPECT_EQ(feeder.Feed(3), PROGRAM_FEED_QUEUE_AHEAD);
+
+    // A stop cancels the run and another is started before the feeder's next turn. The stop's
+    // queue clear comes first; the new program is counted from there and starts at its beginning.
+    feeder.Cancel();
+    EXPECT_FALSE(feeder.IsRunning());
+    EXPECT_TRUE(feeder.Start(fixture.Store(MakeProgram(5))));
+    EXPECT_FALSE(feeder.Start(fixture.Store(MakeProgram(6))));
+    while (fixture.Consume() >= 0)
+    {
+    }
+    EXPECT_EQ(feeder.Feed(4), 5U);
+    for (int expected = 0; expected < 5; expected++)
+    {
+        EXPECT_EQ(fixture.Consume(), expected);
+    }
+    EXPECT_FALSE(feeder.IsRunning());
+}
+
+void TestFeederSkipsNonCncInstructions()
+{
+    FeederFixture fixture("noncnc");
+    std::vector<uint8_t> program = MakeProgram(2);
+    std::vector<uint8_t> echo = MakeProgram(1, 0x69);
+    program.insert(program.begin() + 18, echo.begin(), echo.end());
+
+    ProgramFeeder feeder(fixture.store, fixture.slab, fixture.cncQueue);
+    EXPECT_TRUE(feeder.Start(fixture.Store(program)));
+    EXPECT_EQ(feeder.Feed(0), 2U);
+    EXPECT_EQ(fixture.slab.GetLiveCount(), 2U);
+}
+} // namespace
+
+int main()
+{
+    TestHashIsFnv1a();
+    TestUploadedProgramSurvivesReboot();
+    TestRepeatUploadIsSkipped();
+    TestIncompleteOrCorruptUploadIsNeverFound();
+    TestOldestProgramMakesRoom();
+    TestFeederKeepsTheQueueToppedUp();
+    TestFeederLeavesSlabRoomForNetworkCommands();
+    TestFeederStopsWhenTheControllerClearsTheQueue();
+    TestCancelAndRestartBeforeTheNextFeed();
+    TestFeederSkipsNonCncInstructions();
+
+    PrintTestPassed("ProgramStore unit test");
+    return EXIT_SUCCESS;
+}
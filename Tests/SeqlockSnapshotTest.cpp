@@ -0,0 +1,144 @@
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "SeqlockSnapshot.h"
+#include "TestHarness.h"
+#include "Telemetry.h"
+
+namespace
+{
+// Every field of a publish is derived from one counter, so a reader can tell a torn copy from a
+// whole one by checking them against each other.
+control_tlm_t MakeTlm(uint32_t n)
+{
+    control_tlm_t tlm{};
+    tlm.sampleTime_us = static_cast<int64_t>(n) * 10000;
+    tlm.S0MotorTlm = {static_cast<float>(n), static_cast<float>(n) + 1.0f, static_cast<float>(n) + 2.0f};
+    tlm.S1MotorTlm = {static_cast<float>(n) + 3.0f, static_cast<float>(n) + 4.0f, static_cast<float>(n) + 5.0f};
+    tlm.PumpMotorTlm = {-static_cast<float>(n), 0.0f, static_cast<float>(n)};
+    tlm.tipPos_X_m = static_cast<float>(n);
+    tlm.tipPos_Y_m = -static_cast<float>(n);
+    tlm.plannedTarget_S0_deg = static_cast<float>(n);
+    tlm.plannedTarget_S1_deg = static_cast<float>(n);
+    tlm.limitBlocked_S0 = (n & 1u) != 0;
+    tlm.limitBlocked_S1 = (n & 1u) == 0;
+    tlm.loopOverrunCount = n;
+    tlm.loopWorstLatency_us = ~n;
+    return tlm;
+}
+
+bool IsWhole(const control_tlm_t &tlm)
+{
+    // Counters stay below 2^24, so the float copies are exact.
+    const uint32_t n = tlm.loopOverrunCount;
+    const float f = static_cast<float>(n);
+    return tlm.sampleTime_us == static_cast<int64_t>(n) * 10000 && tlm.S0MotorTlm.Speed_degps == f &&
+           tlm.S0MotorTlm.TargetSpeed_degps == f + 1.0f && tlm.S0MotorTlm.Position_deg == f + 2.0f &&
+           tlm.S1MotorTlm.Speed_degps == f + 3.0f && tlm.S1MotorTlm.TargetSpeed_degps == f + 4.0f &&
+           tlm.S1MotorTlm.Position_deg == f + 5.0f && tlm.PumpMotorTlm.Speed_degps == -f &&
+           tlm.PumpMotorTlm.Position_deg == f && tlm.tipPos_X_m == f && tlm.tipPos_Y_m == -f &&
+           tlm.plannedTarget_S0_deg == f && tlm.plannedTarget_S1_deg == f &&
+           tlm.limitBlocked_S0 == ((n & 1u) != 0) && tlm.limitBlocked_S1 == ((n & 1u) == 0) &&
+           tlm.loopWorstLatency_us == ~n;
+}
+
+void TestReadReturnsLatestPublish()
+{
+    SeqlockSnapshot<control_tlm_t> snapshot;
+    control_tlm_t tlm = MakeTlm(7);
+    EXPECT_EQ(snapshot.GetSequence(), 0U);
+    EXPECT_TRUE(snapshot.TryRead(tlm));
+    EXPECT_EQ(tlm.loopOverrunCount, 0U);
+
+    snapshot.Publish(MakeTlm(1));
+    snapshot.Publish(MakeTlm(2));
+    EXPECT_EQ(snapshot.GetSequence(), 4U);
+    snapshot.Read(tlm);
+    EXPECT_TRUE(IsWhole(tlm));
+    EXPECT_EQ(tlm.loopOverrunCount, 2U);
+}
+
+void TestConcurrentReadersNeverSeeTornSnapshot()
+{
+    constexpr uint32_t kPublishes = 1000000;
+    constexpr int kReaders = 3;
+
+    SeqlockSnapshot<control_tlm_t> snapshot;
+    snapshot.Publish(MakeTlm(0));
+    std::atomic<int> readersStarted(0);
+    std::atomic<bool> writerDone(false);
+    std::atomic<uint32_t> tornReads(0);
+    std::atomic<uint32_t> backwardReads(0);
+    std::vector<uint64_t> wholeReads(kReaders, 0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; r++)
+    {
+        readers.emplace_back(
+            [&, r]()
+            {
+                uint32_t last = 0;
+                control_tlm_t tlm{};
+                while (!writerDone.load(std::memory_order_acquire))
+                {
+                    if (!snapshot.TryRead(tlm))
+                    {
+                        continue;
+                    }
+                    if (!IsWhole(tlm))
+                    {
+                        tornReads++;
+                    }
+                    if (tlm.loopOverrunCount < last)
+                    {
+                        backwardReads++;
+                    }
+                    last = tlm.loopOverrunCount;
+                    if (wholeReads[r]++ == 0)
+                    {
+                        readersStarted++;
+                    }
+                }
+            });
+    }
+
+    // Once every reader has a first copy the writer publishes flat out, never waiting on them.
+    while (readersStarted.load() < kReaders)
+    {
+        std::this_thread::yield();
+    }
+    for (uint32_t n = 1; n <= kPublishes; n++)
+    {
+        snapshot.Publish(MakeTlm(n));
+    }
+    writerDone.store(true, std::memory_order_release);
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(tornReads.load(), 0U);
+    EXPECT_EQ(backwardReads.load(), 0U);
+    EXPECT_EQ(snapshot.GetSequence(), 2 * (kPublishes + 1));
+    for (int r = 0; r < kReaders; r++)
+    {
+        EXPECT_TRUE(wholeReads[r] > 0);
+    }
+
+    control_tlm_t last{};
+    snapshot.Read(last);
+    EXPECT_EQ(last.loopOverrunCount, kPublishes);
+    EXPECT_TRUE(IsWhole(last));
+}
+} // namespace
+
+int main()
+{
+    TestReadReturnsLatestPublish();
+    TestConcurrentReadersNeverSeeTornSnapshot();
+
+    PrintTestPassed("SeqlockSnapshot unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "StepRamp.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr uint32_t kTickRate_hz = 1000000;
+constexpr float kAccel_stepsps2 = 20000.0f;
+
+// Take steps until the ramp stops changing the period; returns the elapsed time in seconds.
+double RunUntilSettled(StepRamp &ramp, int &steps)
+{
+    double elapsed_s = 0.0;
+    steps = 0;
+    while (ramp.IsRamping() && steps < 100000)
+    {
+        elapsed_s += static_cast<double>(ramp.GetPeriod_ticks()) / kTickRate_hz;
+        ramp.Step();
+        steps++;
+    }
+    return elapsed_s;
+}
+
+void TestRampFromRestFollowsConstantAcceleration()
+{
+    StepRamp ramp;
+    ramp.Configure(kTickRate_hz, kAccel_stepsps2);
+    EXPECT_TRUE(ramp.IsStopped());
+
+    ramp.Retarget(4000.0f);
+    EXPECT_TRUE(ramp.IsRamping());
+    EXPECT_EQ(ramp.GetPeriod_ticks(), ramp.GetFirstStepPeriod_ticks());
+
+    // Every step is shorter than the one before until the target rate is reached.
+    uint32_t lastPeriod_ticks = ramp.GetPeriod_ticks();
+    double elapsed_s = 0.0;
+    int steps = 0;
+    while (ramp.IsRamping())
+    {
+        elapsed_s += static_cast<double>(ramp.GetPeriod_ticks()) / kTickRate_hz;
+        uint32_t period_ticks = ramp.Step();
+        EXPECT_TRUE(period_ticks <= lastPeriod_ticks);
+        lastPeriod_ticks = period_ticks;
+        steps++;
+    }
+    EXPECT_EQ(lastPeriod_ticks, 250U);
+    ExpectNearlyEqual(ramp.GetRate_stepsps(), 4000.0f, 1.0f, "cruise rate");
+
+    // v = a t and n = v^2 / 2a, within the first-step approximation.
+    ExpectNearlyEqual(static_cast<float>(elapsed_s), 4000.0f / kAccel_stepsps2, 0.01f,
+                      "time to cruise");
+    ExpectNearlyEqual(static_cast<float>(steps), 4000.0f * 4000.0f / (2.0f * kAccel_stepsps2), 8.0f,
+                      "steps to cruise");
+
+    // Cruising holds the period.
+    EXPECT_EQ(ramp.Step(), 250U);
+    EXPECT_EQ(ramp.Step(), 250U);
+}
+
+void TestRampDownToRestHoldsSlowestRate()
+{
+    StepRamp ramp;
+    ramp.Configure(kTickRate_hz, kAccel_stepsps2);
+    ramp.Jump(3000.0f);
+    EXPECT_FALSE(ramp.IsRamping());
+
+    ramp.Retarget(0.0f);
+    int steps = 0;
+    double elapsed_s = RunUntilSettled(ramp, steps);
+    EXPECT_TRUE(ramp.AtSlowestRate());
+    EXPECT_FALSE(ramp.IsStopped());
+    EXPECT_EQ(ramp.GetPeriod_ticks(), ramp.GetFirstStepPeriod_ticks());
+
+    // Constant deceleration until one step from rest, where v = sqrt(2a).
+    const float slowest_stepsps = sqrtf(2.0f * kAccel_stepsps2);
+    ExpectNearlyEqual(static_cast<float>(elapsed_s), (3000.0f - slowest_stepsps) / kAccel_stepsps2,
+                      0.005f, "time to slow down");
+    ExpectNearlyEqual(static_cast<float>(steps),
+                      (3000.0f * 3000.0f - slowest_stepsps * slowest_stepsps) /
+                          (2.0f * kAccel_stepsps2),
+                      8.0f, "steps to slow down");
+
+    ramp.Stop();
+    EXPECT_TRUE(ramp.IsStopped());
+    EXPECT_EQ(ramp.Step(), 0U);
+}
+
+void TestRetargetMidRampReversesTheRamp()
+{
+    StepRamp ramp;
+    ramp.Configure(kTickRate_hz, kAccel_stepsps2);
+    ramp.Retarget(5000.0f);
+    for (int i = 0; i < 200; i++)
+    {
+        ramp.Step();
+    }
+    EXPECT_TRUE(ramp.IsRamping());
+    const float midRate_stepsps = ramp.GetRate_stepsps();
+    ExpectNearlyEqual(midRate_stepsps, sqrtf(2.0f * kAccel_stepsps2 * 200.0f), 60.0f,
+                      "rate after 200 steps");
+
+    // Slowing to a lower target lengthens every step until it is reached.
+    ramp.Retarget(1000.0f);
+    uint32_t lastPeriod_ticks = ramp.GetPeriod_ticks();
+    while (ramp.IsRamping())
+    {
+        uint32_t period_ticks = ramp.Step();
+        EXPECT_TRUE(period_ticks >= lastPeriod_ticks);
+        lastPeriod_ticks = period_ticks;
+    }
+    EXPECT_EQ(lastPeriod_ticks, 1000U);
+}
+
+void TestSlowTargetsAndZeroAccelSkipTheRamp()
+{
+    StepRamp ramp;
+    ramp.Configure(kTickRate_hz, kAccel_stepsps2);
+
+    // Slower than the first ramp step: run at the target straight away.
+    ramp.Retarget(10.0f);
+    EXPECT_FALSE(ramp.IsRamping());
+    EXPECT_EQ(ramp.GetPeriod_ticks(), 100000U);
+
+    ramp.Stop();
+    ramp.Configure(kTickRate_hz, 0.0f);
+    ramp.Retarget(2000.0f);
+    EXPECT_FALSE(ramp.IsRamping());
+    EXPECT_EQ(ramp.GetPeriod_ticks(), 500U);
+}
+} // namespace
+
+int main()
+{
+    TestRampFromRestFollowsConstantAcceleration();
+    TestRampDownToRestHoldsSlowestRate();
+    TestRetargetMidRampReversesTheRamp();
+    TestSlowTargetsAndZeroAccelSkipTheRamp();
+
+    PrintTestPassed("StepRamp unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "RecordingStepBackend.h"
+#include "StepperMotor.h"
+#include "TestHarness.h"
+
+namespace
+{
+// One degree per step keeps step rates and speeds numerically equal.
+constexpr float kStepSize_deg = 1.0f;
+constexpr float kAccel_degps2 = 1000.0f;
+constexpr float kSpeedLimit_degps = 200.0f;
+constexpr uint32_t kPeriod_ms = 10;
+
+// Run `cycles` control periods: update the speed, then let the backend emit the period's edges.
+void RunCycles(StepperMotor &motor, RecordingStepBackend &output, int cycles)
+{
+    for (int i = 0; i < cycles; i++)
+    {
+        motor.UpdateSpeed(false);
+        output.AdvanceTo(output.Now_us() + kPeriod_ms * 1000);
+    }
+}
+
+// Net steps implied by the recorded edges, using the direction level at each rising step edge.
+long SignedStepsFromEdges(const RecordingStepBackend &output, bool initialDirectionLevel,
+                          bool wiredBackward)
+{
+    long steps = 0;
+    bool directionLevel = initialDirectionLevel;
+    for (const RecordingStepBackend::Edge &edge : output.GetEdges())
+    {
+        if (edge.output == RecordingStepBackend::Output::Direction)
+        {
+            directionLevel = edge.level;
+        }
+        else if (edge.level)
+        {
+            steps += (directionLevel != wiredBackward) ? 1 : -1;
+        }
+    }
+    return steps;
+}
+
+float Position_deg(StepperMotor &motor)
+{
+    motor_tlm_t tlm{};
+    motor.GetTlm(&tlm);
+    return tlm.Position_deg;
+}
+
+void TestConstantSpeedProducesEvenlySpacedSteps()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, kAccel_degps2, kSpeedLimit_degps, kStepSize_deg, "TEST", false);
+    motor.InitializeTimers(kPeriod_ms);
+
+    motor.setTargetSpeed(100.0f);
+    motor.UpdateSpeed(true);
+    output.ClearEdges();
+    RunCycles(motor, output, 100);
+
+    // 100 steps/s toggles every 5 ms.
+    const std::vector<RecordingStepBackend::Edge> &edges = output.GetEdges();
+    EXPECT_TRUE(edges.size() >= 199);
+    for (size_t i = 1; i < edges.size(); i++)
+    {
+        EXPECT_EQ(edges[i].time_us - edges[i - 1].time_us, 5000);
+    }
+    EXPECT_EQ(output.CountSteps(), 100U);
+    ExpectNearlyEqual(Position_deg(motor), 100.0f, 1e-4f, "position after one second");
+}
+
+void TestRampShortensStepIntervalEachCycle()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, kAccel_degps2, kSpeedLimit_degps, kStepSize_deg, "TEST", false);
+    motor.InitializeTimers(kPeriod_ms);
+
+    motor.setTargetSpeed(kSpeedLimit_degps);
+    RunCycles(motor, output, 30);
+
+    motor_tlm_t tlm{};
+    motor.GetTlm(&tlm);
+    ExpectNearlyEqual(tlm.Speed_degps, 200.0f, 1e-4f, "speed after ramp");
+
+    int64_t lastRise_us = -1;
+    int64_t lastInterval_us = INT64_MAX;
+    for (const RecordingStepBackend::Edge &edge : output.GetEdges())
+    {
+        if (edge.output != RecordingStepBackend::Output::Step || !edge.level)
+        {
+            continue;
+        }
+        if (lastRise_us >= 0)
+        {
+            int64_t interval_us = edge.time_us - lastRise_us;
+            EXPECT_TRUE(interval_us <= lastInterval_us);
+            lastInterval_us = interval_us;
+        }
+        lastRise_us = edge.time_us;
+    }
+    EXPECT_EQ(lastInterval_us, 5000);
+}
+
+void TestRampRunsBetweenControlTicks()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, 50000.0f, 2000.0f, kStepSize_deg, "TEST", false);
+    motor.InitializeTimers(kPeriod_ms);
+    motor.setTargetSpeed(500.0f);
+    motor.UpdateSpeed(true);
+    output.AdvanceTo(output.Now_us() + kPeriod_ms * 1000);
+    output.ClearEdges();
+
+    // 500 -> 1500 steps/s at 50000 steps/s^2 takes 20 ms, i.e. two control ticks.
+    motor.setTargetSpeed(1500.0f);
+    RunCycles(motor, output, 1);
+
+    // Within the first tick every step is shorter than the last, not one fixed interval.
+    std::vector<int64_t> intervals_us;
+    int64_t lastRise_us = -1;
+    for (const RecordingStepBackend::Edge &edge : output.GetEdges())
+    {
+        if (edge.output != RecordingStepBackend::Output::Step || !edge.level)
+        {
+            continue;
+        }
+        if (lastRise_us >= 0)
+        {
+            intervals_us.push_back(edge.time_us - lastRise_us);
+        }
+        lastRise_us = edge.time_us;
+    }
+    EXPECT_TRUE(intervals_us.size() >= 5);
+    for (size_t i = 1; i < intervals_us.size(); i++)
+    {
+        EXPECT_TRUE(intervals_us[i] < intervals_us[i - 1]);
+    }
+
+    RunCycles(motor, output, 3);
+    motor_tlm_t tlm{};
+    motor.GetTlm(&tlm);
+    ExpectNearlyEqual(tlm.Speed_degps, 1500.0f, 1e-2f, "speed after ramp");
+}
+
+// Speed at the start of each control tick while running `cycles` ticks.
+std::vector<float> SpeedTrace(StepperMotor &motor, RecordingStepBackend &output, int cycles)
+{
+    std::vector<float> trace;
+    for (int i = 0; i < cycles; i++)
+    {
+        motor.UpdateSpeed(false);
+        motor_tlm_t tlm{};
+        motor.GetTlm(&tlm);
+        trace.push_back(tlm.Speed_degps);
+        output.AdvanceTo(output.Now_us() + kPeriod_ms * 1000);
+    }
+    return trace;
+}
+
+// Largest change in acceleration between consecutive ticks of a speed trace.
+float MaxAccelChange_degps2(const std::vector<float> &trace)
+{
+    const float period_s = kPeriod_ms / 1000.0f;
+    float lastAccel_degps2 = 0.0f;
+    float maxChange_degps2 = 0.0f;
+    float previous_degps = 0.0f;
+    for (float speed_degps : trace)
+    {
+        float accel_degps2 = (speed_degps - previous_degps) / period_s;
+        maxChange_degps2 = std::max(maxChange_degps2, std::fabs(accel_degps2 - lastAccel_degps2));
+        lastAccel_degps2 = accel_degps2;
+        previous_degps = speed_degps;
+    }
+    return maxChange_degps2;
+}
+
+void TestJerkLimitShapesSpeedTraceIntoSCurve()
+{
+    constexpr float kFastAccel_degps2 = 20000.0f;
+    constexpr float kJerk_degps3 = 400000.0f;
+    constexpr float kCruise_degps = 3000.0f;
+
+    RecordingStepBackend trapezoidOutput;
+    StepperMotor trapezoid(trapezoidOutput, kFastAccel_degps2, 4000.0f, kStepSize_deg, "TEST",
+                           false);
+    trapezoid.InitializeTimers(kPeriod_ms);
+    trapezoid.setTargetSpeed(kCruise_degps);
+    const std::vector<float> trapezoidTrace = SpeedTrace(trapezoid, trapezoidOutput, 40);
+
+    RecordingStepBackend sCurveOutput;
+    StepperMotor sCurve(sCurveOutput, kFastAccel_degps2, 4000.0f, kStepSize_deg, "TEST", false);
+    sCurve.InitializeTimers(kPeriod_ms);
+    sCurve.SetJerkLimit(kJerk_degps3);
+    EXPECT_EQ(sCurve.GetJerkLimit(), kJerk_degps3);
+    sCurve.setTargetSpeed(kCruise_degps);
+    const std::vector<float> sCurveTrace = SpeedTrace(sCurve, sCurveOutput, 40);
+
+    // The trapezoid jumps straight to full acceleration; the S-curve builds up to it over
+    // accel / jerk = 50 ms, changing acceleration by at most jerk * period each tick.
+    const float jerkStep_degps2 = kJerk_degps3 * kPeriod_ms / 1000.0f;
+    EXPECT_TRUE(MaxAccelChange_degps2(trapezoidTrace) > 3.0f * jerkStep_degps2);
+    EXPECT_TRUE(MaxAccelChange_degps2(sCurveTrace) < 1.01f * jerkStep_degps2);
+
+    // No overshoot, and cruise is reached after v / a + a / j = 200 ms.
+    size_t sCurveArrival = 0;
+    for (size_t i = 0; i < sCurveTrace.size(); i++)
+    {
+        EXPECT_TRUE(sCurveTrace[i] <= kCruise_degps);
+        EXPECT_TRUE(i == 0 || sCurveTrace[i] >= sCurveTrace[i - 1]);
+        if (sCurveArrival == 0 && sCurveTrace[i] >= kCruise_degps)
+        {
+            sCurveArrival = i + 1;
+        }
+    }
+    ExpectNearlyEqual(static_cast<float>(sCurveArrival), 20.0f, 1.5f, "ticks to cruise");
+
+    // The step output follows the profile: never faster than cruise, and settled on it.
+    int64_t lastRise_us = -1;
+    int64_t minInterval_us = INT64_MAX;
+    int64_t lastInterval_us = 0;
+    for (const RecordingStepBackend::Edge &edge : sCurveOutput.GetEdges())
+    {
+        if (edge.output != RecordingStepBackend::Output::Step || !edge.level)
+        {
+            continue;
+        }
+        if (lastRise_us >= 0)
+        {
+            lastInterval_us = edge.time_us - lastRise_us;
+            minInterval_us = std::min(minInterval_us, lastInterval_us);
+        }
+        lastRise_us = edge.time_us;
+    }
+    EXPECT_TRUE(minInterval_us >= 333);
+    EXPECT_TRUE(lastInterval_us <= 334);
+
+    // Slowing back down is shaped the same way and ends at rest.
+    sCurve.setTargetSpeed(0.0f);
+    const std::vector<float> stopTrace = SpeedTrace(sCurve, sCurveOutput, 40);
+    std::vector<float> fromCruise{kCruise_degps};
+    fromCruise.insert(fromCruise.end(), stopTrace.begin(), stopTrace.end());
+    float maxChange_degps2 = 0.0f;
+    for (size_t i = 2; i < fromCruise.size(); i++)
+    {
+        float before_degps2 = (fromCruise[i - 1] - fromCruise[i - 2]) * 1000.0f / kPeriod_ms;
+        float after_degps2 = (fromCruise[i] - fromCruise[i - 1]) * 1000.0f / kPeriod_ms;
+        maxChange_degps2 = std::max(maxChange_degps2, std::fabs(after_degps2 - before_degps2));
+    }
+    EXPECT_TRUE(maxChange_degps2 < 1.01f * jerkStep_degps2);
+    EXPECT_EQ(stopTrace.back(), 0.0f);
+    EXPECT_FALSE(sCurveOutput.IsRunning());
+}
+
+void TestJerkLimitedReversalKeepsStepCount()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, 20000.0f, 4000.0f, kStepSize_deg, "TEST", false);
+    motor.InitializeTimers(kPeriod_ms);
+    motor.SetJerkLimit(400000.0f);
+
+    motor.setTargetSpeed(1000.0f);
+    RunCycles(motor, output, 20);
+    const float peak_deg = Position_deg(motor);
+    const bool initialDirectionLevel = output.GetDirectionLevel();
+    output.ClearEdges();
+
+    motor.setTargetSpeed(-1000.0f);
+    const std::vector<float> trace = SpeedTrace(motor, output, 40);
+    ExpectNearlyEqual(trace.back(), -1000.0f, 1.0f, "reversed cruise speed");
+
+    size_t directionEdges = 0;
+    for (const RecordingStepBackend::Edge &edge : output.GetEdges())
+    {
+        directionEdges += (edge.output == RecordingStepBackend::Output::Direction) ? 1 : 0;
+    }
+    EXPECT_EQ(directionEdges, 1U);
+
+    const long recordedSteps = SignedStepsFromEdges(output, initialDirectionLevel, false);
+    ExpectNearlyEqual(Position_deg(motor) - peak_deg, static_cast<float>(recordedSteps), 1e-4f,
+                      "S-curve position change matches recorded steps");
+
+    // Turning the jerk limit off goes back to the trapezoid.
+    motor.SetJerkLimit(0.0f);
+    motor.setTargetSpeed(0.0f);
+    RunCycles(motor, output, 10);
+    EXPECT_FALSE(output.IsRunning());
+}
+
+void TestReversalDeceleratesThroughZeroBeforeFlippingDirection()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, kAccel_degps2, kSpeedLimit_degps, kStepSize_deg, "TEST", false);
+    motor.InitializeTimers(kPeriod_ms);
+
+    motor.setTargetSpeed(50.0f);
+    motor.UpdateSpeed(true);
+    RunCycles(motor, output, 20);
+    const float peak_deg = Position_deg(motor);
+    const bool initialDirectionLevel = output.GetDirectionLevel();
+    output.ClearEdges();
+
+    motor.setTargetSpeed(-50.0f);
+    RunCycles(motor, output, 40);
+
+    // Exactly one direction change, and no step pulses in the cycle the motor stood still.
+    size_t directionEdges = 0;
+    int64_t directionEdge_us = 0;
+    for (const RecordingStepBackend::Edge &edge : output.GetEdges())
+    {
+        if (edge.output == RecordingStepBackend::Output::Direction)
+        {
+            directionEdges++;
+            directionEdge_us = edge.time_us;
+        }
+    }
+    EXPECT_EQ(directionEdges, 1U);
+    EXPECT_FALSE(output.GetDirectionLevel());
+
+    int64_t lastStepBefore_us = 0;
+    int64_t firstStepAfter_us = INT64_MAX;
+    for (const RecordingStepBackend::Edge &edge : output.GetEdges())
+    {
+        if (edge.output != RecordingStepBackend::Output::Step)
+        {
+            continue;
+        }
+        if (edge.time_us <= directionEdge_us)
+        {
+            lastStepBefore_us = edge.time_us;
+        }
+        else if (edge.time_us < firstStepAfter_us)
+        {
+            firstStepAfter_us = edge.time_us;
+        }
+    }
+    EXPECT_TRUE(directionEdge_us - lastStepBefore_us >= static_cast<int64_t>(kPeriod_ms) * 1000);
+    EXPECT_TRUE(firstStepAfter_us > directionEdge_us);
+
+    // Step counting follows the direction output exactly.
+    const long recordedSteps = SignedStepsFromEdges(output, initialDirectionLevel, false);
+    ExpectNearlyEqual(Position_deg(motor) - peak_deg, static_cast<float>(recordedSteps), 1e-4f,
+                      "position change matches recorded steps");
+    EXPECT_TRUE(Position_deg(motor) < peak_deg);
+}
+
+void TestWiredBackwardInvertsDirectionOutputOnly()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, kAccel_degps2, kSpeedLimit_degps, kStepSize_deg, "TEST", true);
+    motor.InitializeTimers(kPeriod_ms);
+
+    motor.setTargetSpeed(40.0f);
+    motor.UpdateSpeed(true);
+    RunCycles(motor, output, 50);
+
+    EXPECT_FALSE(output.GetDirectionLevel());
+    EXPECT_TRUE(Position_deg(motor) > 0.0f);
+    const long recordedSteps = SignedStepsFromEdges(output, false, true);
+    ExpectNearlyEqual(Position_deg(motor), static_cast<float>(recordedSteps), 1e-4f,
+                      "wired-backward position matches recorded steps");
+}
+
+void TestDirectionalInhibitStopsStepOutput()
+{
+    RecordingStepBackend output;
+    StepperMotor motor(output, kAccel_degps2, kSpeedLimit_degps, kStepSize_deg, "TEST", false);
+    motor.InitializeTimers(kPeriod_ms);
+
+    motor.SetDirectionalInhibit(StepperMotor::E_INHIBIT_FORWARD);
+    motor.setTargetSpeed(50.0f);
+    RunCycles(motor, output, 10);
+
+    EXPECT_FALSE(output.IsRunning());
+    EXPECT_EQ(output.CountSteps(), 0U);
+
+    motor.setTargetSpeed(-50.0f);
+    RunCycles(motor, output, 10);
+    EXPECT_TRUE(output.IsRunning());
+    EXPECT_TRUE(Position_deg(motor) < 0.0f);
+}
+} // namespace
+
+int main()
+{
+    TestConstantSpeedProducesEvenlySpacedSteps();
+    TestRampShortensStepIntervalEachCycle();
+    TestRampRunsBetweenControlTicks();
+    TestJerkLimitShapesSpeedTraceIntoSCurve();
+    TestJerkLimitedReversalKeepsStepCount();
+    TestReversalDeceleratesThroughZeroBeforeFlippingDirection();
+    TestWiredBackwardInvertsDirectionOutputOnly();
+    TestDirectionalInhibitStopsStepOutput();
+
+    PrintTestPassed("StepperMotor unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "TelemetryBufferPool.h"
+#include "TestHarness.h"
+
+namespace
+{
+using Pool = TelemetryBufferPool<32, 3>;
+
+// Append text as one line, dropped whole if it does not fit.
+bool AppendLine(Pool &pool, const char *text)
+{
+    return pool.Append(
+        [&](char *out, size_t capacity)
+        {
+            size_t length = strlen(text);
+            if (length >= capacity)
+            {
+                return size_t(0);
+            }
+            memcpy(out, text, length + 1);
+            return length;
+        });
+}
+
+std::string Contents(const Pool::Buffer *buffer)
+{
+    return std::string(buffer->data, buffer->length);
+}
+
+void TestLinesRollIntoTheNextBufferAndComeOutInOrder()
+{
+    Pool pool;
+    // 13 bytes each: two lines fill a 32-byte buffer (the writer needs room for a terminator).
+    EXPECT_TRUE(AppendLine(pool, "line-0001 01\n"));
+    EXPECT_TRUE(AppendLine(pool, "line-0002 02\n"));
+    EXPECT_TRUE(AppendLine(pool, "line-0003 03\n"));
+
+    Pool::Buffer *taken[3];
+    EXPECT_EQ(pool.Take(taken, 3), static_cast<size_t>(2));
+    EXPECT_EQ(Contents(taken[0]), std::string("line-0001 01\nline-0002 02\n"));
+    EXPECT_EQ(Contents(taken[1]), std::string("line-0003 03\n"));
+
+    // Producers carry on in the free buffer while the taken ones are out.
+    EXPECT_TRUE(AppendLine(pool, "line-0004 04\n"));
+    pool.Give(taken, 2);
+    EXPECT_EQ(pool.Take(taken, 3), static_cast<size_t>(1));
+    EXPECT_EQ(Contents(taken[0]), std::string("line-0004 04\n"));
+    pool.Give(taken, 1);
+
+    // Nothing new: nothing to take.
+    EXPECT_EQ(pool.Take(taken, 3), static_cast<size_t>(0));
+    EXPECT_EQ(pool.GetDroppedCount(), static_cast<size_t>(0));
+}
+
+void TestTakeLimitLeavesTheRestQueued()
+{
+    Pool pool;
+    for (int i = 0; i < 5; i++)
+    {
+        char line[16];
+        snprintf(line, sizeof(line), "line-%04d %02d\n", i, i);
+        EXPECT_TRUE(AppendLine(pool, line));
+    }
+
+    Pool::Buffer *taken[3];
+    EXPECT_EQ(pool.Take(taken, 2), static_cast<size_t>(2));
+    EXPECT_EQ(Contents(taken[1]), std::string("line-0002 02\nline-0003 03\n"));
+    Pool::Buffer *rest[3];
+    EXPECT_EQ(pool.Take(rest, 2), static_cast<size_t>(1));
+    EXPECT_EQ(Contents(rest[0]), std::string("line-0004 04\n"));
+    pool.Give(rest, 1);
+    pool.Give(taken, 2);
+}
+
+void TestLinesAreDroppedWhenEveryBufferIsFull()
+{
+    Pool pool;
+    for (int i = 0; i < 6; i++)
+    {
+        EXPECT_TRUE(AppendLine(pool, "line-full 00\n"));
+    }
+    EXPECT_FALSE(AppendLine(pool, "line-lost 01\n"));
+    EXPECT_FALSE(AppendLine(pool, "line-lost 02\n"));
+    EXPECT_EQ(pool.GetDroppedCount(), static_cast<size_t>(2));
+    EXPECT_TRUE(pool.TakeFree() == nullptr);
+
+    // A line longer than a buffer is dropped, and what was buffered before it is kept.
+    Pool fresh;
+    EXPECT_TRUE(AppendLine(fresh, "short\n"));
+    EXPECT_FALSE(AppendLine(fresh, "a line much longer than thirty-two bytes\n"));
+    EXPECT_TRUE(AppendLine(fresh, "after\n"));
+    Pool::Buffer *taken[3];
+    EXPECT_EQ(fresh.Take(taken, 3), static_cast<size_t>(2));
+    EXPECT_EQ(Contents(taken[0]), std::string("short\n"));
+    EXPECT_EQ(Contents(taken[1]), std::string("after\n"));
+}
+
+void TestFreeBufferForOtherUploads()
+{
+    Pool pool;
+    Pool::Buffer *own = pool.TakeFree();
+    EXPECT_TRUE(own != nullptr);
+    EXPECT_EQ(own->length, static_cast<size_t>(0));
+
+    // The producers still have the other two.
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(AppendLine(pool, "line-0000 00\n"));
+    }
+    EXPECT_FALSE(AppendLine(pool, "line-0000 00\n"));
+
+    own->length = 5;
+    pool.Give(&own, 1);
+    EXPECT_TRUE(AppendLine(pool, "line-0000 00\n"));
+    Pool::Buffer *taken[3];
+    EXPECT_EQ(pool.Take(taken, 3), static_cast<size_t>(3));
+    EXPECT_EQ(Contents(taken[2]), std::string("line-0000 00\n"));
+}
+} // namespace
+
+int main()
+{
+    TestLinesRollIntoTheNextBufferAndComeOutInOrder();
+    TestTakeLimitLeavesTheRestQueued();
+    TestLinesAreDroppedWhenEveryBufferIsFull();
+    TestFreeBufferForOtherUploads();
+
+    PrintTestPassed("TelemetryBufferPool unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "HttpStandIn.h"
+#include "TelemetryGzip.h"
+#include "TelemetryLine.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr size_t kTransmitBufferBytes = 6000;
+
+// Static like the firmware's instance; the match tables are too big for a test's stack frame.
+GzipCompressor compressor;
+uint8_t compressed[GzipMaxOutputBytes(GZIP_MAX_INPUT_BYTES)];
+
+// A full transmit buffer as the aggregator fills it: the 1 Hz group every cycle, the 0.25 Hz
+// group every fourth and the 0.05 Hz group every twentieth. Motion values drift from cycle to
+// cycle; the slow group (temperature, limit flags, boundary corners) barely changes.
+std::string FullTelemetryBuffer()
+{
+    std::string buffer;
+    for (int cycle = 0;; cycle++)
+    {
+        size_t count = 10 + ((cycle % 4 == 0) ? 12 : 0);
+        TelemetryField fields[35];
+        size_t used = 0;
+        for (size_t i = 0; i < TELEMETRY_FIELD_NAME_COUNT && used < 35; i++)
+        {
+            bool due = i < count || (i >= 22 && cycle % 20 == 0);
+            if (due)
+            {
+                double phase = ((i < 22) ? 0.1 * cycle : 0.0) + 1.3 * static_cast<double>(i);
+                float value = static_cast<float>(std::sin(phase) * std::pow(10.0, static_cast<double>(i % 3)));
+                fields[used++] = {TELEMETRY_FIELD_NAMES[i].key, (i % 5 == 4) ? 0.0f : value};
+            }
+        }
+        char line[1024];
+        size_t length = FormatTelemetryLine(line, sizeof(line), TELEMETRY_LINE_PREFIX, fields, used,
+                                            1767225662000 + 1000 * static_cast<int64_t>(cycle));
+        if (buffer.size() + length > kTransmitBufferBytes)
+        {
+            return buffer;
+        }
+        buffer.append(line, length);
+    }
+}
+
+// Compress data, post it to the stand-in as the transmit task would and return what arrived.
+HttpStandInRequest PostCompressed(const std::string &data, size_t &compressedLength, int &status)
+{
+    compressedLength = compressor.Compress(data.data(), data.size(), compressed, sizeof(compressed));
+    EXPECT_TRUE(compressedLength > 0);
+
+    HttpStandIn standIn;
+    HttpStandInRequest request;
+    std::thread server([&]() { EXPECT_TRUE(standIn.ServeOne(request)); });
+    status = PostToHttpStandIn(standIn.GetPort(), "gzip", compressed, compressedLength);
+    server.join();
+    return request;
+}
+
+void TestTelemetryBufferRoundTripsThroughStandIn()
+{
+    std::string buffer = FullTelemetryBuffer();
+    EXPECT_TRUE(buffer.size() > kTransmitBufferBytes - 500);
+
+    size_t compressedLength = 0;
+    int status = 0;
+    HttpStandInRequest request = PostCompressed(buffer, compressedLength, status);
+    EXPECT_EQ(status, 204);
+    EXPECT_TRUE(request.decoded);
+    EXPECT_EQ(request.contentEncoding, std::string("gzip"));
+    EXPECT_EQ(request.wireBytes, compressedLength);
+    EXPECT_TRUE(request.body == buffer);
+
+    // Line protocol is mostly repeated keys and timestamp digits; anything under 2x would mean
+    // the matcher is not finding the previous lines.
+    double ratio = static_cast<double>(buffer.size()) / static_cast<double>(compressedLength);
+    EXPECT_TRUE(ratio > 2.0);
+    std::printf("Full telemetry buffer: %zu B -> %zu B gzip, %.2fx\n", buffer.size(), compressedLength, ratio);
+}
+
+void TestAwkwardInputsRoundTrip()
+{
+    // Every byte value, including the 9-bit literal codes (144..255).
+    std::string allBytes;
+    for (int i = 0; i < 512; i++)
+    {
+        allBytes.push_back(static_cast<char>((i * 7) & 0xFF));
+    }
+    // One long run: overlapping distance-1 matches and the 258-byte maximum length.
+    std::string run(GZIP_MAX_INPUT_BYTES, 'x');
+    // Too short to match at all.
+    std::string tiny = "t";
+
+    for (const std::string *input : {&allBytes, &run, &tiny})
+    {
+        size_t compressedLength = 0;
+        int status = 0;
+        HttpStandInRequest request = PostCompressed(*input, compressedLength, status);
+        EXPECT_EQ(status, 204);
+        EXPECT_TRUE(request.decoded);
+        EXPECT_TRUE(request.body == *input);
+    }
+}
+
+void TestRefusesWhatItCannotCompress()
+{
+    std::string buffer = FullTelemetryBuffer();
+    EXPECT_EQ(compressor.Compress(buffer.data(), 0, compressed, sizeof(compressed)), static_cast<size_t>(0));
+
+    std::string tooLong(GZIP_MAX_INPUT_BYTES + 1, 'x');
+    EXPECT_EQ(compressor.Compress(tooLong.data(), tooLong.size(), compressed, sizeof(compressed)),
+              static_cast<size_t>(0));
+
+    size_t whole = compressor.Compress(buffer.data(), buffer.size(), compressed, sizeof(compressed));
+    EXPECT_TRUE(whole > 0);
+    EXPECT_EQ(compressor.Compress(buffer.data(), buffer.size(), compressed, whole - 1), static_cast<size_t>(0));
+    EXPECT_EQ(compressor.Compress(buffer.data(), buffer.size(), compressed, whole), whole);
+}
+
+void TestWorstCaseFitsTheOutputBound()
+{
+    // Pseudo-random bytes from the 9-bit literal range leave almost nothing to match, so the
+    // output is as long as a fixed Huffman block gets.
+    std::string noise(GZIP_MAX_INPUT_BYTES, '\0');
+    uint32_t state = 12345;
+    for (char &byte : noise)
+    {
+        state = state * 1103515245u + 12345u;
+        byte = static_cast<char>(144 + (state >> 16) % 112);
+    }
+    size_t bound = GzipMaxOutputBytes(noise.size());
+    size_t length = compressor.Compress(noise.data(), noise.size(), compressed, bound);
+    EXPECT_TRUE(length > 0);
+    EXPECT_TRUE(length > noise.size());
+    EXPECT_TRUE(length <= bound);
+}
+
+void TestCrc32MatchesGzip()
+{
+    EXPECT_EQ(GzipCrc32(0, "123456789", 9), 0xCBF43926u);
+    EXPECT_EQ(GzipCrc32(GzipCrc32(0, "1234", 4), "56789", 5), 0xCBF43926u);
+}
+} // namespace
+
+int main()
+{
+    TestTelemetryBufferRoundTripsThroughStandIn();
+    TestAwkwardInputsRoundTrip();
+    TestRefusesWhatItCannotCompress();
+    TestWorstCaseFitsTheOutputBound();
+    TestCrc32MatchesGzip();
+
+    PrintTestPassed("TelemetryGzip unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "TelemetryLine.h"
+
+// Bytes of line protocol per cadence group for the old one-line-per-point format against the
+// multi-field line, using the registered points as listed in TELEMETRY_FIELD_NAMES: the first
+// 10 publish at 1 Hz, the next 12 every 4 s and the last 13 every 20 s (telemetrybudget.md).
+namespace
+{
+constexpr int64_t kTimestamp_ms = 1767225662000;
+
+struct CadenceGroup
+{
+    const char *name;
+    size_t first;
+    size_t count;
+    double period_s;
+};
+
+constexpr CadenceGroup kGroups[] = {
+    {"1 Hz", 0, 10, 1.0},
+    {"0.25 Hz", 10, 12, 4.0},
+    {"0.05 Hz", 22, 13, 20.0},
+};
+
+// Something like a running arm: mixed signs, a few integer digits, some exact zeros.
+float SampleValue(size_t i)
+{
+    if (i % 5 == 4)
+    {
+        return 0.0f;
+    }
+    return static_cast<float>(std::sin(1.7 * static_cast<double>(i)) * std::pow(10.0, static_cast<double>(i % 3)));
+}
+
+size_t PerPointBytes(const CadenceGroup &group)
+{
+    char line[128];
+    size_t total = 0;
+    for (size_t i = group.first; i < group.first + group.count; i++)
+    {
+        total += static_cast<size_t>(snprintf(line, sizeof(line), "%s,location=us-midwest %s=%.5f %lld\n",
+                                              TELEMETRY_FIELD_NAMES[i].name, "data", SampleValue(i),
+                                              static_cast<long long>(kTimestamp_ms)));
+    }
+    return total;
+}
+
+size_t MultiFieldBytes(const CadenceGroup &group)
+{
+    TelemetryField fields[64];
+    for (size_t i = 0; i < group.count; i++)
+    {
+        fields[i] = {TELEMETRY_FIELD_NAMES[group.first + i].key, SampleValue(group.first + i)};
+    }
+    char line[1024];
+    return FormatTelemetryLine(line, sizeof(line), TELEMETRY_LINE_PREFIX, fields, group.count, kTimestamp_ms);
+}
+} // namespace
+
+int main()
+{
+    double perPointRate = 0.0;
+    double multiFieldRate = 0.0;
+    for (const CadenceGroup &group : kGroups)
+    {
+        size_t perPoint = PerPointBytes(group);
+        size_t multiField = MultiFieldBytes(group);
+        perPointRate += perPoint / group.period_s;
+        multiFieldRate += multiField / group.period_s;
+        std::printf("%-8s %2zu points  per-point %4zu B  multi-field %4zu B  %4.1fx smaller\n", group.name,
+                    group.count, perPoint, multiField, static_cast<double>(perPoint) / multiField);
+    }
+    std::printf("average  per-point %6.1f B/s  multi-field %6.1f B/s  %4.1fx smaller\n", perPointRate,
+                multiFieldRate, perPointRate / multiFieldRate);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "TelemetryLine.h"
+#include "TestHarness.h"
+
+namespace
+{
+void TestLineCarriesEveryFieldOnce()
+{
+    const TelemetryField fields[] = {{"tx", 0.12345f}, {"ty", -0.5f}, {"lo", 3.0f}, {"lb0", 0.0f}};
+    char line[128];
+    size_t length = FormatTelemetryLine(line, sizeof(line), TELEMETRY_LINE_PREFIX, fields, 4, 1767225662000);
+    EXPECT_EQ(std::string(line, length),
+              std::string("tlm,location=us-midwest tx=0.12345,ty=-0.5,lo=3,lb0=0 1767225662000\n"));
+    EXPECT_EQ(strlen(line), length);
+}
+
+void TestLineThatDoesNotFitIsNotWritten()
+{
+    const TelemetryField fields[] = {{"tx", 0.1f}, {"ty", 0.2f}};
+    char line[128];
+    size_t whole = FormatTelemetryLine(line, sizeof(line), "tlm", fields, 2, 1767225662000);
+    EXPECT_TRUE(whole > 0);
+
+    // The terminator needs one more byte than the line itself.
+    EXPECT_EQ(FormatTelemetryLine(line, whole, "tlm", fields, 2, 1767225662000), static_cast<size_t>(0));
+    EXPECT_EQ(FormatTelemetryLine(line, whole + 1, "tlm", fields, 2, 1767225662000), whole);
+    EXPECT_EQ(FormatTelemetryLine(line, 10, "tlm", fields, 2, 1767225662000), static_cast<size_t>(0));
+    EXPECT_EQ(FormatTelemetryLine(line, sizeof(line), "tlm", fields, 0, 1767225662000), static_cast<size_t>(0));
+}
+
+void TestFieldKeysAreShortAndUnique()
+{
+    std::set<std::string> keys;
+    std::set<std::string> names;
+    for (size_t i = 0; i < TELEMETRY_FIELD_NAME_COUNT; i++)
+    {
+        const TelemetryFieldName &entry = TELEMETRY_FIELD_NAMES[i];
+        EXPECT_TRUE(strlen(entry.key) <= 4);
+        EXPECT_TRUE(keys.insert(entry.key).second);
+        EXPECT_TRUE(names.insert(entry.name).second);
+        EXPECT_EQ(std::string(GetTelemetryFieldKey(entry.name)), std::string(entry.key));
+    }
+    EXPECT_EQ(std::string(GetTelemetryFieldKey("unlistedPoint")), std::string("unlistedPoint"));
+}
+} // namespace
+
+int main()
+{
+    TestLineCarriesEveryFieldOnce();
+    TestLineThatDoesNotFitIsNotWritten();
+    TestFieldKeysAreShortAndUnique();
+
+    PrintTestPassed("TelemetryLine unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "HttpStandIn.h"
+#include "TelemetryBufferPool.h"
+#include "TelemetryLine.h"
+#include "TelemetryStream.h"
+#include "TestHarness.h"
+
+namespace
+{
+constexpr size_t kBufferBytes = 6000;
+constexpr size_t kBufferCount = 3;
+using Pool = TelemetryBufferPool<kBufferBytes, kBufferCount>;
+
+// Static like the firmware's instances; too big for a test's stack frame.
+Pool pool;
+GzipCompressor compressor;
+uint8_t scratch[TelemetryGzipScratchBytes(kBufferBytes)];
+
+struct Wire
+{
+    std::string bytes;
+    size_t writes = 0;
+    size_t failAfterWrites = SIZE_MAX;
+};
+
+bool WriteToWire(void *context, const char *data, size_t length)
+{
+    Wire &wire = *static_cast<Wire *>(context);
+    if (wire.writes++ >= wire.failAfterWrites)
+    {
+        return false;
+    }
+    wire.bytes.append(data, length);
+    return true;
+}
+
+// Fill the pool with telemetry lines the way the aggregator does until it has filled `buffers`.
+std::string FillPool(size_t buffers)
+{
+    std::string expected;
+    for (int cycle = 0;; cycle++)
+    {
+        TelemetryField fields[10];
+        for (size_t i = 0; i < 10; i++)
+        {
+            fields[i] = {TELEMETRY_FIELD_NAMES[i].key, 0.01f * static_cast<float>(cycle * 10 + static_cast<int>(i))};
+        }
+        const int64_t timestamp_ms = 1767225662000 + 1000 * static_cast<int64_t>(cycle);
+        std::string text;
+        bool appended = pool.Append(
+            [&](char *out, size_t capacity)
+            {
+                size_t length = FormatTelemetryLine(out, capacity, TELEMETRY_LINE_PREFIX, fields, 10, timestamp_ms);
+                text.assign(out, length);
+                return length;
+            });
+        EXPECT_TRUE(appended);
+        expected += text;
+        if (expected.size() > kBufferBytes * (buffers - 1) + kBufferBytes / 2)
+        {
+            return expected;
+        }
+    }
+}
+
+// Stream the buffers taken from the pool and post the result to the stand-in.
+HttpStandInRequest StreamAndPost(Pool::Buffer *const *buffers, size_t count, GzipCompressor *gzip, Wire &wire,
+                                 int &status)
+{
+    TelemetryChunk chunks[kBufferCount];
+    for (size_t i = 0; i < count; i++)
+    {
+        chunks[i] = {buffers[i]->data, buffers[i]->length};
+    }
+    size_t bodyBytes = 0;
+    EXPECT_TRUE(StreamTelemetryChunks(chunks, count, gzip, scratch, sizeof(scratch), WriteToWire, &wire, bodyBytes));
+    EXPECT_EQ(bodyBytes, wire.bytes.size());
+
+    HttpStandIn standIn;
+    HttpStandInRequest request;
+    std::thread server([&]() { EXPECT_TRUE(standIn.ServeOne(request)); });
+    status = PostChunkedToHttpStandIn(standIn.GetPort(), gzip ? "gzip" : nullptr, wire.bytes.data(), wire.bytes.size());
+    server.join();
+    return request;
+}
+
+void TestPoolBuffersStreamAsGzipMembers()
+{
+    std::string expected = FillPool(2);
+    Pool::Buffer *taken[kBufferCount];
+    size_t count = pool.Take(taken, kBufferCount - 1);
+    EXPECT_EQ(count, static_cast<size_t>(2));
+
+    Wire wire;
+    int status = 0;
+    HttpStandInRequest request = StreamAndPost(taken, count, &compressor, wire, status);
+    EXPECT_EQ(status, 204);
+    EXPECT_TRUE(request.decoded);
+    EXPECT_EQ(request.chunkCount, count);
+    EXPECT_TRUE(request.body == expected);
+    std::printf("Two pool buffers: %zu B -> %zu B chunked gzip body in %zu writes\n", expected.size(),
+                wire.bytes.size(), wire.writes);
+    pool.Give(taken, count);
+}
+
+void TestPlainChunksAreWrittenInPlace()
+{
+    std::string expected = FillPool(1);
+    Pool::Buffer *taken[kBufferCount];
+    size_t count = pool.Take(taken, kBufferCount - 1);
+    EXPECT_EQ(count, static_cast<size_t>(1));
+
+    Wire wire;
+    int status = 0;
+    HttpStandInRequest request = StreamAndPost(taken, count, nullptr, wire, status);
+    EXPECT_EQ(status, 204);
+    EXPECT_TRUE(request.body == expected);
+    // Header, the buffer itself, its CRLF and the terminating chunk.
+    EXPECT_EQ(wire.writes, static_cast<size_t>(4));
+    pool.Give(taken, count);
+}
+
+void TestIncompressibleAndEmptyChunks()
+{
+    // Random bytes do not compress; the scratch bound still holds them.
+    std::string noise(kBufferBytes, '\0');
+    std::mt19937 generator(99);
+    for (char &c : noise)
+    {
+        c = static_cast<char>(generator());
+    }
+    TelemetryChunk chunks[] = {{"", 0}, {noise.data(), noise.size()}, {"tail\n", 5}};
+    Wire wire;
+    size_t bodyBytes = 0;
+    EXPECT_TRUE(StreamTelemetryChunks(chunks, 3, &compressor, scratch, sizeof(scratch), WriteToWire, &wire, bodyBytes));
+
+    HttpStandIn standIn;
+    HttpStandInRequest request;
+    std::thread server([&]() { EXPECT_TRUE(standIn.ServeOne(request)); });
+    int status = PostChunkedToHttpStandIn(standIn.GetPort(), "gzip", wire.bytes.data(), wire.bytes.size());
+    server.join();
+    EXPECT_EQ(status, 204);
+    EXPECT_EQ(request.chunkCount, static_cast<size_t>(2));
+    EXPECT_TRUE(request.body == noise + "tail\n");
+}
+
+void TestWriteFailureStopsTheStream()
+{
+    TelemetryChunk chunks[] = {{"a=1\n", 4}, {"b=2\n", 4}};
+    Wire wire;
+    wire.failAfterWrites = 2;
+    size_t bodyBytes = 0;
+    EXPECT_FALSE(StreamTelemetryChunks(chunks, 2, nullptr, scratch, sizeof(scratch), WriteToWire, &wire, bodyBytes));
+    EXPECT_EQ(wire.writes, static_cast<size_t>(3));
+
+    // Not enough scratch to compress into.
+    Wire other;
+    EXPECT_FALSE(StreamTelemetryChunks(chunks, 2, &compressor, scratch, 8, WriteToWire, &other, bodyBytes));
+}
+} // namespace
+
+int main()
+{
+    TestPoolBuffersStreamAsGzipMembers();
+    TestPlainChunksAreWrittenInPlace();
+    TestIncompressibleAndEmptyChunks();
+    TestWriteFailureStopsTheStream();
+
+    PrintTestPassed("TelemetryStream unit test");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "FileProgramStorage.h"
+
+#include <fstream>
+#include <vector>
+
+FileProgramStorage::FileProgramStorage(const std::string &path, size_t size, size_t eraseSize)
+    : path(path), size(size), eraseSize(eraseSize)
+{
+    std::ifstream existing(path, std::ios::binary | std::ios::ate);
+    if (existing && static_cast<size_t>(existing.tellg()) == size)
+    {
+        return;
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::vector<char> erased(size, static_cast<char>(0xFF));
+    file.write(erased.data(), static_cast<std::streamsize>(erased.size()));
+}
+
+esp_err_t FileProgramStorage::Read(size_t offset, void *data, size_t length)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!InRange(offset, length) || !file)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(static_cast<char *>(data), static_cast<std::streamsize>(length));
+    return file ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t FileProgramStorage::Write(size_t offset, const void *data, size_t length)
+{
+    std::vector<char> bytes(length);
+    if (Read(offset, bytes.data(), length) != ESP_OK)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *in = static_cast<const char *>(data);
+    for (size_t i = 0; i < length; i++)
+    {
+        bytes[i] = static_cast<char>(bytes[i] & in[i]);
+    }
+
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(bytes.data(), static_cast<std::streamsize>(length));
+    return file ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t FileProgramStorage::Erase(size_t offset, size_t length)
+{
+    if (!InRange(offset, length) || offset % eraseSize != 0 || length % eraseSize != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    std::vector<char> erased(length, static_cast<char>(0xFF));
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(erased.data(), static_cast<std::streamsize>(length));
+    eraseCount++;
+    return file ? ESP_OK : ESP_FAIL;
+}
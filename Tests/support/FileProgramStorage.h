@@ -0,0 +1,34 @@
+#ifndef TEST_SUPPORT_FILE_PROGRAM_STORAGE_H
+#define TEST_SUPPORT_FILE_PROGRAM_STORAGE_H
+
+#include <cstddef>
+#include <string>
+
+#include "ProgramStorage.h"
+
+// Program storage in a host file, with flash rules: a new file reads as erased (0xFF), writes
+// AND into what is there, and erases must cover whole blocks. The file outlives the object, so a
+// second instance on the same path sees what the first stored, as after a reboot.
+class FileProgramStorage : public ProgramStorage
+{
+  public:
+    FileProgramStorage(const std::string &path, size_t size, size_t eraseSize = 4096);
+
+    size_t GetSize() const override { return size; }
+    size_t GetEraseSize() const override { return eraseSize; }
+    esp_err_t Read(size_t offset, void *data, size_t length) override;
+    esp_err_t Write(size_t offset, const void *data, size_t length) override;
+    esp_err_t Erase(size_t offset, size_t length) override;
+
+    size_t GetEraseCount() const { return eraseCount; }
+
+  private:
+    bool InRange(size_t offset, size_t length) const { return offset <= size && length <= size - offset; }
+
+    std::string path;
+    size_t size;
+    size_t eraseSize;
+    size_t eraseCount = 0;
+};
+
+#endif // TEST_SUPPORT_FILE_PROGRAM_STORAGE_H
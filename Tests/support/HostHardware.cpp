@@ -0,0 +1,328 @@
+#include "HostHardware.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "driver/gptimer.h"
+#include "esp_timer.h"
+
+struct HostGptimer
+{
+    uint32_t resolution_hz = 1000000;
+    gptimer_alarm_cb_t onAlarm = nullptr;
+    void *userContext = nullptr;
+    bool enabled = false;
+    bool running = false;
+    bool alarmArmed = false;
+    bool autoReload = false;
+    uint64_t alarmCount = 0;
+    uint64_t reloadCount = 0;
+
+    // Count = countAtStart + ticks elapsed since startTime_us while running.
+    uint64_t countAtStart = 0;
+    int64_t startTime_us = 0;
+};
+
+namespace
+{
+constexpr int GPIO_PIN_COUNT = GPIO_NUM_MAX;
+
+struct HostHardwareState
+{
+    int64_t now_us = 0;
+    uint64_t alarmCount = 0;
+    std::vector<HostGptimer *> timers;
+    uint32_t gpioLevels[GPIO_PIN_COUNT] = {};
+    HostHardware::GpioListener gpioListener = nullptr;
+    void *gpioListenerContext = nullptr;
+    bool limitSwitchHardStop = true;
+    bool pumpMotorInUse = false;
+};
+
+HostHardwareState &State()
+{
+    static HostHardwareState state;
+    return state;
+}
+
+uint64_t TicksToMicroseconds(const HostGptimer &timer, uint64_t ticks)
+{
+    // Round up so an alarm never fires before its count is reached.
+    return (ticks * 1000000ULL + timer.resolution_hz - 1) / timer.resolution_hz;
+}
+
+uint64_t CurrentCount(const HostGptimer &timer, int64_t now_us)
+{
+    if (!timer.running)
+    {
+        return timer.countAtStart;
+    }
+    uint64_t elapsed_us = static_cast<uint64_t>(now_us - timer.startTime_us);
+    return timer.countAtStart + elapsed_us * timer.resolution_hz / 1000000ULL;
+}
+
+// Time of the next alarm. An alarm set below the current count fires immediately, as on the
+// target.
+int64_t NextAlarmTime_us(const HostGptimer &timer)
+{
+    if (timer.countAtStart >= timer.alarmCount)
+    {
+        return timer.startTime_us;
+    }
+    return timer.startTime_us +
+           static_cast<int64_t>(TicksToMicroseconds(timer, timer.alarmCount - timer.countAtStart));
+}
+
+bool IsValidPin(gpio_num_t pin) { return pin >= 0 && pin < GPIO_PIN_COUNT; }
+} // namespace
+
+namespace HostHardware
+{
+void Reset()
+{
+    HostHardwareState &state = State();
+    for (HostGptimer *timer : state.timers)
+    {
+        delete timer;
+    }
+    state = HostHardwareState{};
+}
+
+int64_t Now_us() { return State().now_us; }
+
+void AdvanceTo(int64_t time_us)
+{
+    HostHardwareState &state = State();
+    for (;;)
+    {
+        HostGptimer *next = nullptr;
+        int64_t nextTime_us = time_us;
+        for (HostGptimer *timer : state.timers)
+        {
+            if (!timer->running || !timer->alarmArmed || timer->onAlarm == nullptr)
+            {
+                continue;
+            }
+            int64_t alarmTime_us = NextAlarmTime_us(*timer);
+            if (alarmTime_us < state.now_us)
+            {
+                alarmTime_us = state.now_us;
+            }
+            if (alarmTime_us <= time_us && (next == nullptr || alarmTime_us < nextTime_us))
+            {
+                next = timer;
+                nextTime_us = alarmTime_us;
+            }
+        }
+
+        if (next == nullptr)
+        {
+            break;
+        }
+
+        state.now_us = nextTime_us;
+        gptimer_alarm_event_data_t event{next->alarmCount, next->alarmCount};
+        if (next->autoReload)
+        {
+            next->countAtStart = next->reloadCount;
+            next->startTime_us = state.now_us;
+        }
+        else
+        {
+            next->countAtStart = CurrentCount(*next, state.now_us);
+            next->startTime_us = state.now_us;
+            next->alarmArmed = false;
+        }
+        state.alarmCount++;
+        next->onAlarm(next, &event, next->userContext);
+    }
+
+    if (time_us > state.now_us)
+    {
+        state.now_us = time_us;
+    }
+}
+
+void SetGpioListener(GpioListener listener, void *context)
+{
+    State().gpioListener = listener;
+    State().gpioListenerContext = context;
+}
+
+uint32_t GetGpioLevel(gpio_num_t pin) { return IsValidPin(pin) ? State().gpioLevels[pin] : 0; }
+
+uint64_t GetAlarmCount() { return State().alarmCount; }
+
+bool GetLimitSwitchHardStop() { return State().limitSwitchHardStop; }
+
+bool GetPumpMotorInUse() { return State().pumpMotorInUse; }
+} // namespace HostHardware
+
+int64_t esp_timer_get_time(void) { return State().now_us; }
+
+esp_err_t gpio_config(const gpio_config_t *config) { return config != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG; }
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    return gpio_set_level(gpio_num, 0);
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    (void)mode;
+    return IsValidPin(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!IsValidPin(gpio_num))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    HostHardwareState &state = State();
+    uint32_t normalized = level ? 1U : 0U;
+    if (state.gpioLevels[gpio_num] == normalized)
+    {
+        return ESP_OK;
+    }
+    state.gpioLevels[gpio_num] = normalized;
+    if (state.gpioListener != nullptr)
+    {
+        state.gpioListener(gpio_num, normalized, state.now_us, state.gpioListenerContext);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) { return static_cast<int>(HostHardware::GetGpioLevel(gpio_num)); }
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer)
+{
+    if (config == nullptr || ret_timer == nullptr || config->resolution_hz == 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    HostGptimer *timer = new HostGptimer();
+    timer->resolution_hz = config->resolution_hz;
+    State().timers.push_back(timer);
+    *ret_timer = timer;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_del_timer(gptimer_handle_t timer)
+{
+    std::vector<HostGptimer *> &timers = State().timers;
+    for (size_t i = 0; i < timers.size(); i++)
+    {
+        if (timers[i] == timer)
+        {
+            timers.erase(timers.begin() + static_cast<long>(i));
+            delete timer;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer,
+                                           const gptimer_event_callbacks_t *cbs, void *user_data)
+{
+    if (timer == nullptr || cbs == nullptr)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->onAlarm = cbs->on_alarm;
+    timer->userContext = user_data;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer)
+{
+    if (timer == nullptr || timer->enabled)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer)
+{
+    if (timer == nullptr || !timer->enabled || timer->running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer)
+{
+    if (timer == nullptr || !timer->enabled || timer->running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->running = true;
+    timer->startTime_us = State().now_us;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer)
+{
+    if (timer == nullptr || !timer->running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->countAtStart = CurrentCount(*timer, State().now_us);
+    timer->startTime_us = State().now_us;
+    timer->running = false;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t *config)
+{
+    if (timer == nullptr)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Re-base on the current count so a new alarm is measured from the same origin as the
+    // hardware counter.
+    timer->countAtStart = CurrentCount(*timer, State().now_us);
+    timer->startTime_us = State().now_us;
+    if (config == nullptr)
+    {
+        timer->alarmArmed = false;
+        return ESP_OK;
+    }
+    timer->alarmArmed = true;
+    timer->alarmCount = config->alarm_count;
+    timer->reloadCount = config->reload_count;
+    timer->autoReload = config->flags.auto_reload_on_alarm;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value)
+{
+    if (timer == nullptr || value == nullptr)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = CurrentCount(*timer, State().now_us);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_raw_count(gptimer_handle_t timer, uint64_t value)
+{
+    if (timer == nullptr)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->countAtStart = value;
+    timer->startTime_us = State().now_us;
+    return ESP_OK;
+}
+
+extern "C" void SetLimitSwitchPolicy(bool HardStopOnLimit) { State().limitSwitchHardStop = HardStopOnLimit; }
+
+extern "C" void SetPumpMotorInUse(bool InUse) { State().pumpMotorInUse = InUse; }
@@ -0,0 +1,33 @@
+#ifndef TEST_SUPPORT_HOST_HARDWARE_H
+#define TEST_SUPPORT_HOST_HARDWARE_H
+
+#include <cstdint>
+
+#include "driver/gpio.h"
+
+// Virtual clock and simulated peripherals behind the ESP-IDF shims in this directory. Nothing
+// advances on its own: callers move the clock with AdvanceTo, which fires gptimer alarms in time
+// order exactly as the step ISRs would run on the target.
+namespace HostHardware
+{
+using GpioListener = void (*)(gpio_num_t pin, uint32_t level, int64_t time_us, void *context);
+
+// Return to t = 0 with no timers, all pins low and no listener.
+void Reset();
+
+int64_t Now_us();
+void AdvanceTo(int64_t time_us);
+
+// Called for every gpio_set_level that changes a pin.
+void SetGpioListener(GpioListener listener, void *context);
+uint32_t GetGpioLevel(gpio_num_t pin);
+
+// Number of alarm callbacks fired since Reset, summed over all timers.
+uint64_t GetAlarmCount();
+
+// Last values passed through the Safety.h seam.
+bool GetLimitSwitchHardStop();
+bool GetPumpMotorInUse();
+} // namespace HostHardware
+
+#endif // TEST_SUPPORT_HOST_HARDWARE_H
@@ -0,0 +1,295 @@
+#include "HttpStandIn.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace
+{
+bool SendAll(int socketFd, const void *data, size_t length)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (length > 0)
+    {
+        ssize_t sent = send(socketFd, bytes, length, 0);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Read until the blank line ending the headers; anything after it is the start of the body.
+bool ReadHeaders(int socketFd, std::string &headers, std::string &bodyStart)
+{
+    std::string received;
+    char chunk[512];
+    for (;;)
+    {
+        size_t end = received.find("\r\n\r\n");
+        if (end != std::string::npos)
+        {
+            headers = received.substr(0, end + 2);
+            bodyStart = received.substr(end + 4);
+            return true;
+        }
+        ssize_t got = recv(socketFd, chunk, sizeof(chunk), 0);
+        if (got <= 0)
+        {
+            return false;
+        }
+        received.append(chunk, static_cast<size_t>(got));
+    }
+}
+
+std::string HeaderValue(const std::string &headers, const char *name)
+{
+    size_t nameLength = strlen(name);
+    size_t lineStart = headers.find("\r\n");
+    while (lineStart != std::string::npos && lineStart + 2 < headers.size())
+    {
+        lineStart += 2;
+        size_t lineEnd = headers.find("\r\n", lineStart);
+        std::string line = headers.substr(lineStart, lineEnd - lineStart);
+        if (line.size() > nameLength && line[nameLength] == ':' &&
+            strncasecmp(line.c_str(), name, nameLength) == 0)
+        {
+            size_t valueStart = line.find_first_not_of(' ', nameLength + 1);
+            return valueStart == std::string::npos ? std::string() : line.substr(valueStart);
+        }
+        lineStart = lineEnd;
+    }
+    return std::string();
+}
+
+bool Gunzip(const std::string &compressed, std::string &plain)
+{
+    z_stream stream = {};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+    {
+        return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+
+    int status = Z_OK;
+    char chunk[4096];
+    while (status == Z_OK)
+    {
+        stream.next_out = reinterpret_cast<Bytef *>(chunk);
+        stream.avail_out = sizeof(chunk);
+        status = inflate(&stream, Z_NO_FLUSH);
+        plain.append(chunk, sizeof(chunk) - stream.avail_out);
+        if (status == Z_STREAM_END && stream.avail_in > 0)
+        {
+            // Another member follows, as gzip readers accept.
+            status = inflateReset(&stream);
+        }
+        else if (status == Z_OK && stream.avail_in == 0 && stream.avail_out != 0)
+        {
+            break; // ran out of input before the end of the stream
+        }
+    }
+    // Z_STREAM_END also means the CRC-32 and length in the trailer matched.
+    bool complete = status == Z_STREAM_END && stream.avail_in == 0;
+    inflateEnd(&stream);
+    return complete;
+}
+
+// Read from the socket until data holds at least length bytes.
+bool ReadAtLeast(int socketFd, std::string &data, size_t length)
+{
+    char chunk[4096];
+    while (data.size() < length)
+    {
+        ssize_t got = recv(socketFd, chunk, sizeof(chunk), 0);
+        if (got <= 0)
+        {
+            return false;
+        }
+        data.append(chunk, static_cast<size_t>(got));
+    }
+    return true;
+}
+
+// Undo Transfer-Encoding: chunked, reading the rest of it from the socket. received holds what
+// followed the headers.
+bool ReadChunkedBody(int socketFd, std::string received, std::string &body, size_t &chunkCount)
+{
+    size_t position = 0;
+    for (;;)
+    {
+        size_t lineEnd;
+        while ((lineEnd = received.find("\r\n", position)) == std::string::npos)
+        {
+            if (!ReadAtLeast(socketFd, received, received.size() + 1))
+            {
+                return false;
+            }
+        }
+        size_t length = strtoul(received.c_str() + position, nullptr, 16);
+        position = lineEnd + 2;
+        if (!ReadAtLeast(socketFd, received, position + length + 2) ||
+            received.compare(position + length, 2, "\r\n") != 0)
+        {
+            return false;
+        }
+        if (length == 0)
+        {
+            return true;
+        }
+        body.append(received, position, length);
+        position += length + 2;
+        chunkCount++;
+    }
+}
+} // namespace
+
+HttpStandIn::HttpStandIn()
+{
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        std::perror("socket");
+        std::exit(EXIT_FAILURE);
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, 1) != 0 ||
+        getsockname(listener, reinterpret_cast<sockaddr *>(&address), &addressLength) != 0)
+    {
+        std::perror("HttpStandIn listen");
+        std::exit(EXIT_FAILURE);
+    }
+    port = ntohs(address.sin_port);
+}
+
+HttpStandIn::~HttpStandIn()
+{
+    if (listener >= 0)
+    {
+        close(listener);
+    }
+}
+
+bool HttpStandIn::ServeOne(HttpStandInRequest &request)
+{
+    int connection = accept(listener, nullptr, nullptr);
+    if (connection < 0)
+    {
+        return false;
+    }
+
+    std::string headers;
+    std::string body;
+    bool intact = ReadHeaders(connection, headers, body);
+    size_t chunkCount = 0;
+    if (intact && strcasecmp(HeaderValue(headers, "Transfer-Encoding").c_str(), "chunked") == 0)
+    {
+        std::string received;
+        received.swap(body);
+        intact = ReadChunkedBody(connection, received, body, chunkCount);
+    }
+    else if (intact)
+    {
+        intact = ReadAtLeast(connection, body, strtoul(HeaderValue(headers, "Content-Length").c_str(), nullptr, 10));
+    }
+
+    request = HttpStandInRequest();
+    if (intact)
+    {
+        request.contentEncoding = HeaderValue(headers, "Content-Encoding");
+        request.wireBytes = body.size();
+        request.chunkCount = chunkCount;
+        if (request.contentEncoding.empty() || request.contentEncoding == "identity")
+        {
+            request.body = body;
+            request.decoded = true;
+        }
+        else if (request.contentEncoding == "gzip")
+        {
+            request.decoded = Gunzip(body, request.body);
+        }
+    }
+
+    const char *response = request.decoded ? "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n"
+                                           : "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+    SendAll(connection, response, strlen(response));
+    close(connection);
+    return intact;
+}
+
+namespace
+{
+int Post(uint16_t port, const char *contentEncoding, const void *body, size_t length, bool chunked)
+{
+    int connection = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (connection < 0 || connect(connection, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        if (connection >= 0)
+        {
+            close(connection);
+        }
+        return -1;
+    }
+
+    char framing[64];
+    if (chunked)
+    {
+        snprintf(framing, sizeof(framing), "Transfer-Encoding: chunked\r\n");
+    }
+    else
+    {
+        snprintf(framing, sizeof(framing), "Content-Length: %zu\r\n", length);
+    }
+    char headers[256];
+    int headerLength = snprintf(headers, sizeof(headers),
+                                "POST /api/v2/write?bucket=tlm&precision=ms HTTP/1.1\r\n"
+                                "Host: 127.0.0.1\r\n"
+                                "Content-Type: text/plain\r\n"
+                                "%s%s%s"
+                                "%s\r\n",
+                                contentEncoding ? "Content-Encoding: " : "", contentEncoding ? contentEncoding : "",
+                                contentEncoding ? "\r\n" : "", framing);
+
+    int status = -1;
+    std::string response;
+    std::string unused;
+    if (SendAll(connection, headers, static_cast<size_t>(headerLength)) && SendAll(connection, body, length) &&
+        ReadHeaders(connection, response, unused))
+    {
+        sscanf(response.c_str(), "HTTP/1.1 %d", &status);
+    }
+    close(connection);
+    return status;
+}
+} // namespace
+
+int PostToHttpStandIn(uint16_t port, const char *contentEncoding, const void *body, size_t length)
+{
+    return Post(port, contentEncoding, body, length, false);
+}
+
+int PostChunkedToHttpStandIn(uint16_t port, const char *contentEncoding, const void *chunkedBody, size_t length)
+{
+    return Post(port, contentEncoding, chunkedBody, length, true);
+}
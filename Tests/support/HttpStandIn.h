@@ -0,0 +1,43 @@
+#ifndef TEST_SUPPORT_HTTP_STAND_IN_H
+#define TEST_SUPPORT_HTTP_STAND_IN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct HttpStandInRequest
+{
+    std::string contentEncoding;
+    size_t wireBytes = 0;   // body bytes as sent, after any Content-Encoding, without chunk framing
+    size_t chunkCount = 0;  // data chunks of a Transfer-Encoding: chunked body
+    std::string body;       // body after undoing Content-Encoding
+    bool decoded = false;   // false if the encoding was unknown or the body did not inflate
+};
+
+// Loopback stand-in for the InfluxDB write endpoint: reads one POST with a Content-Length or
+// chunked body, undoes a gzip Content-Encoding with zlib the way the server would (any number of
+// members), and answers 204, or 400 if the body could not be decoded.
+class HttpStandIn
+{
+  public:
+    HttpStandIn();
+    ~HttpStandIn();
+
+    uint16_t GetPort() const { return port; }
+
+    // Accept one connection and serve one request on it. Returns false if none arrived intact.
+    bool ServeOne(HttpStandInRequest &request);
+
+  private:
+    int listener = -1;
+    uint16_t port = 0;
+};
+
+// POST body to the stand-in as the telemetry client would; contentEncoding may be null. Returns
+// the response status, or -1 if the exchange failed.
+int PostToHttpStandIn(uint16_t port, const char *contentEncoding, const void *body, size_t length);
+
+// The same with Transfer-Encoding: chunked; chunkedBody already carries the chunk framing.
+int PostChunkedToHttpStandIn(uint16_t port, const char *contentEncoding, const void *chunkedBody, size_t length);
+
+#endif // TEST_SUPPORT_HTTP_STAND_IN_H
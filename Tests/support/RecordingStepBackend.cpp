@@ -0,0 +1,109 @@
+#include "RecordingStepBackend.h"
+
+esp_err_t RecordingStepBackend::Init(uint32_t resolution_hz, StepHandler onStep, void *context)
+{
+    if (resolution_hz == 0 || onStep == nullptr)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    this->resolution_hz = resolution_hz;
+    this->onStep = onStep;
+    this->context = context;
+    initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t RecordingStepBackend::SetToggleInterval(uint64_t ticks)
+{
+    if (!initialized)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    interval_ticks = ticks;
+    return ESP_OK;
+}
+
+esp_err_t RecordingStepBackend::Start()
+{
+    if (!initialized || running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    running = true;
+    lastToggle_us = now_us - stoppedElapsed_us;
+    return ESP_OK;
+}
+
+esp_err_t RecordingStepBackend::Stop()
+{
+    if (!running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    running = false;
+    stoppedElapsed_us = now_us - lastToggle_us;
+    return ESP_OK;
+}
+
+void RecordingStepBackend::SetDirectionLevel(bool level)
+{
+    if (level == directionLevel)
+    {
+        return;
+    }
+    directionLevel = level;
+    edges.push_back({now_us, Output::Direction, level});
+}
+
+void RecordingStepBackend::AdvanceTo(int64_t time_us)
+{
+    while (running && interval_ticks > 0)
+    {
+        int64_t due_us = lastToggle_us + TicksToMicroseconds(interval_ticks);
+        if (due_us < now_us)
+        {
+            // The interval was shortened below the time already counted: fire right away.
+            due_us = now_us;
+        }
+        if (due_us > time_us)
+        {
+            break;
+        }
+
+        now_us = due_us;
+        lastToggle_us = due_us;
+        stepLevel = !stepLevel;
+        edges.push_back({now_us, Output::Step, stepLevel});
+        if (stepLevel)
+        {
+            uint64_t nextInterval = onStep(context);
+            if (nextInterval != 0)
+            {
+                interval_ticks = nextInterval;
+            }
+        }
+    }
+
+    if (time_us > now_us)
+    {
+        now_us = time_us;
+    }
+}
+
+size_t RecordingStepBackend::CountSteps() const
+{
+    size_t steps = 0;
+    for (const Edge &edge : edges)
+    {
+        if (edge.output == Output::Step && edge.level)
+        {
+            steps++;
+        }
+    }
+    return steps;
+}
+
+int64_t RecordingStepBackend::TicksToMicroseconds(uint64_t ticks) const
+{
+    return static_cast<int64_t>((ticks * 1000000ULL + resolution_hz - 1) / resolution_hz);
+}
@@ -0,0 +1,68 @@
+#ifndef TEST_SUPPORT_RECORDING_STEP_BACKEND_H
+#define TEST_SUPPORT_RECORDING_STEP_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "StepOutputBackend.h"
+
+// Host step output that keeps its own virtual time and records every output edge. Nothing
+// happens until AdvanceTo is called, which replays the toggles the hardware timer would have
+// produced up to that time.
+class RecordingStepBackend : public StepOutputBackend
+{
+  public:
+    enum class Output
+    {
+        Step,
+        Direction,
+    };
+
+    struct Edge
+    {
+        int64_t time_us;
+        Output output;
+        bool level;
+    };
+
+    esp_err_t Init(uint32_t resolution_hz, StepHandler onStep, void *context) override;
+    esp_err_t SetToggleInterval(uint64_t ticks) override;
+    esp_err_t Start() override;
+    esp_err_t Stop() override;
+    void SetDirectionLevel(bool level) override;
+
+    void AdvanceTo(int64_t time_us);
+    int64_t Now_us() const { return now_us; }
+
+    bool IsRunning() const { return running; }
+    bool GetDirectionLevel() const { return directionLevel; }
+    const std::vector<Edge> &GetEdges() const { return edges; }
+    void ClearEdges() { edges.clear(); }
+
+    // Rising step edges recorded so far.
+    size_t CountSteps() const;
+
+  private:
+    int64_t TicksToMicroseconds(uint64_t ticks) const;
+
+    uint32_t resolution_hz = 0;
+    StepHandler onStep = nullptr;
+    void *context = nullptr;
+
+    int64_t now_us = 0;
+    bool initialized = false;
+    bool running = false;
+    bool stepLevel = false;
+    bool directionLevel = false;
+    uint64_t interval_ticks = 0;
+
+    // Toggles are due `interval_ticks` after this time. While stopped, the time already counted
+    // since the last toggle is parked in stoppedElapsed_us, as the hardware counter holds its value.
+    int64_t lastToggle_us = 0;
+    int64_t stoppedElapsed_us = 0;
+
+    std::vector<Edge> edges;
+};
+
+#endif // TEST_SUPPORT_RECORDING_STEP_BACKEND_H
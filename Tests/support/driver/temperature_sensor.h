@@ -0,0 +1,7 @@
+#ifndef TEST_SUPPORT_DRIVER_TEMPERATURE_SENSOR_H
+#define TEST_SUPPORT_DRIVER_TEMPERATURE_SENSOR_H
+
+// Safety.h includes the temperature sensor driver; the host build never reads it.
+typedef struct HostTemperatureSensor *temperature_sensor_handle_t;
+
+#endif // TEST_SUPPORT_DRIVER_TEMPERATURE_SENSOR_H
@@ -0,0 +1,7 @@
+#ifndef TEST_SUPPORT_ESP_ATTR_H
+#define TEST_SUPPORT_ESP_ATTR_H
+
+// Code placement attributes have no meaning on the host.
+#define IRAM_ATTR
+
+#endif // TEST_SUPPORT_ESP_ATTR_H
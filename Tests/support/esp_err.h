@@ -1,9 +1,33 @@
 #ifndef TEST_SUPPORT_ESP_ERR_H
 #define TEST_SUPPORT_ESP_ERR_H
 
-// Minimal host-test shim for Pancake_esp/main/PanMath.h. PanMath includes
-// esp_err.h for firmware builds, but the functions exercised by this test do
-// not use ESP-IDF types or APIs.
+// Minimal host shim for the ESP-IDF error codes used by the firmware sources that the host tests
+// and the host simulation compile.
 typedef int esp_err_t;
 
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+
+inline const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        default:
+            return "UNKNOWN_ERROR";
+    }
+}
+
 #endif // TEST_SUPPORT_ESP_ERR_H
@@ -0,0 +1,53 @@
+#ifndef TEST_SUPPORT_ESP_LOG_H
+#define TEST_SUPPORT_ESP_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+
+// Host shim for ESP-IDF logging. Messages go to stderr and are filtered by one global level,
+// which defaults to warnings so long simulations stay quiet. The writer is deliberately not
+// format-checked: firmware format strings assume the Xtensa integer widths.
+typedef enum
+{
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+inline esp_log_level_t &HostLogLevel()
+{
+    static esp_log_level_t level = ESP_LOG_WARN;
+    return level;
+}
+
+inline void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    HostLogLevel() = level;
+}
+
+inline void HostLogWrite(esp_log_level_t level, char letter, const char *tag, const char *format, ...)
+{
+    if (level > HostLogLevel())
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "%c (%s) ", letter, tag);
+    std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+}
+
+#define ESP_LOGE(tag, format, ...) HostLogWrite(ESP_LOG_ERROR, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HostLogWrite(ESP_LOG_WARN, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HostLogWrite(ESP_LOG_INFO, 'I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HostLogWrite(ESP_LOG_DEBUG, 'D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HostLogWrite(ESP_LOG_VERBOSE, 'V', tag, format, ##__VA_ARGS__)
+
+#endif // TEST_SUPPORT_ESP_LOG_H
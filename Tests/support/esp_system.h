@@ -0,0 +1,6 @@
+#ifndef TEST_SUPPORT_ESP_SYSTEM_H
+#define TEST_SUPPORT_ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+#endif // TEST_SUPPORT_ESP_SYSTEM_H
@@ -0,0 +1,9 @@
+#ifndef TEST_SUPPORT_ESP_TIMER_H
+#define TEST_SUPPORT_ESP_TIMER_H
+
+#include <cstdint>
+
+// Reads the virtual clock in HostHardware.cpp.
+int64_t esp_timer_get_time(void);
+
+#endif // TEST_SUPPORT_ESP_TIMER_H
@@ -0,0 +1,83 @@
+#ifndef TEST_SUPPORT_FREERTOS_QUEUE_H
+#define TEST_SUPPORT_FREERTOS_QUEUE_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+
+// Fixed-capacity FIFO of fixed-size items with the non-blocking FreeRTOS queue semantics.
+struct HostQueue
+{
+    size_t itemSize;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    std::vector<unsigned char> storage;
+};
+
+typedef HostQueue *QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    if (length == 0 || itemSize == 0)
+    {
+        return nullptr;
+    }
+    return new HostQueue{itemSize, length, 0, 0, std::vector<unsigned char>(length * itemSize)};
+}
+
+inline void vQueueDelete(QueueHandle_t queue) { delete queue; }
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    if (queue->count >= queue->capacity)
+    {
+        return pdFALSE;
+    }
+    size_t tail = (queue->head + queue->count) % queue->capacity;
+    std::memcpy(&queue->storage[tail * queue->itemSize], item, queue->itemSize);
+    queue->count++;
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueSendToBack(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+    return xQueueSend(queue, item, ticksToWait);
+}
+
+inline BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    if (queue->count == 0)
+    {
+        return pdFALSE;
+    }
+    std::memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait)
+{
+    if (xQueuePeek(queue, item, ticksToWait) != pdTRUE)
+    {
+        return pdFALSE;
+    }
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return static_cast<UBaseType_t>(queue->count);
+}
+
+inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    return static_cast<UBaseType_t>(queue->capacity - queue->count);
+}
+
+#endif // TEST_SUPPORT_FREERTOS_QUEUE_H
@@ -0,0 +1,9 @@
+#ifndef TEST_SUPPORT_FREERTOS_TASK_H
+#define TEST_SUPPORT_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+// Nothing on the host blocks: the simulation advances time explicitly.
+inline void vTaskDelay(TickType_t ticks) { (void)ticks; }
+
+#endif // TEST_SUPPORT_FREERTOS_TASK_H
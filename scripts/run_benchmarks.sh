@@ -0,0 +1,55 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Host micro-benchmarks, built optimised. Not part of run_unit_tests.sh: the numbers depend on
+# the machine and are for comparing implementations, not for pass/fail. The float flags let GCC
+# vectorise the batch kinematics without changing any result.
+repo_root="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+build_dir="$repo_root/build/benchmarks"
+mkdir -p "$build_dir"
+
+cxx="${CXX:-g++}"
+common_flags=(
+    -std=c++17
+    -O3
+    -fno-math-errno
+    -fno-trapping-math
+    -Wall
+    -Wextra
+    -Werror
+    -I"$repo_root/Tests"
+    -I"$repo_root/Tests/support"
+    -I"$repo_root/Pancake_esp/main"
+)
+
+build_and_run() {
+    local name="$1"
+    shift
+    "$cxx" "${common_flags[@]}" "$@" -o "$build_dir/$name"
+    "$build_dir/$name"
+}
+
+build_and_run panmath_kernels_benchmark \
+    "$repo_root/Tests/PanMathKernelsBenchmark.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
+build_and_run panmath_batch_benchmark \
+    "$repo_root/Tests/PanMathBatchBenchmark.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
+build_and_run influxdb_parser_benchmark \
+    "$repo_root/Tests/InfluxDBParserBenchmark.cpp" \
+    "$repo_root/Pancake_esp/main/InfluxDBParser.cpp" \
+    "$repo_root/Pancake_esp/main/InfluxDBStreamParser.cpp"
+
+build_and_run telemetry_line_benchmark \
+    "$repo_root/Tests/TelemetryLineBenchmark.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryLine.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp"
+
+build_and_run line_protocol_writer_benchmark \
+    "$repo_root/Tests/LineProtocolWriterBenchmark.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryLine.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp"
@@ -0,0 +1,41 @@
+#!/usr/bin/env bash
+# Build the host-native motor control simulation and run it on a compiled packet stream:
+#   python GroundStation/CommandTerminal.py compile SmileyFace.cake smiley.bin
+#   scripts/run_host_sim.sh smiley.bin [--repeat N] [--start S0_deg S1_deg] [--feedforward G]
+#       [--step-timer shared|per-motor] [--verbose]
+set -euo pipefail
+
+repo_root="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+build_dir="$repo_root/build/host-sim"
+mkdir -p "$build_dir"
+
+main_dir="$repo_root/Pancake_esp/main"
+cxx="${CXX:-g++}"
+"$cxx" -std=c++17 -O2 -Wall -Wextra -Werror \
+    -I"$repo_root/Tests/support" \
+    -I"$main_dir" \
+    -I"$repo_root/PancakeSim/HostSim" \
+    "$repo_root/PancakeSim/HostSim/HostSimMain.cpp" \
+    "$repo_root/PancakeSim/HostSim/HostSimulation.cpp" \
+    "$repo_root/Tests/support/HostHardware.cpp" \
+    "$main_dir/MotorControlLoop.cpp" \
+    "$main_dir/StepperMotor.cpp" \
+    "$main_dir/StepRamp.cpp" \
+    "$main_dir/GptimerStepBackend.cpp" \
+    "$main_dir/BresenhamStepGenerator.cpp" \
+    "$main_dir/Telemetry.c" \
+    "$main_dir/AngleMotion.cpp" \
+    "$main_dir/CommandSlab.cpp" \
+    "$main_dir/ElbowSelector.cpp" \
+    "$main_dir/KeepOutRouter.cpp" \
+    "$main_dir/ArchimedeanSpiral.cpp" \
+    "$main_dir/HomingController.cpp" \
+    "$main_dir/MotionLookahead.cpp" \
+    "$main_dir/MotionSafety.cpp" \
+    "$main_dir/PanMath.cpp" \
+    "$main_dir/PathSpeedPlanner.cpp" \
+    "$main_dir/ProgramPacket.cpp" \
+    "$main_dir/Vector2D.cpp" \
+    -o "$build_dir/host_sim"
+
+"$build_dir/host_sim" "$@"
@@ -28,6 +28,11 @@ build_and_run panmath_test \
     "$repo_root/Pancake_esp/main/PanMath.cpp" \
     "$repo_root/Pancake_esp/main/Vector2D.cpp"
 
+build_and_run panmath_kernels_test \
+    "$repo_root/Tests/PanMathKernelsTest.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
 build_and_run vector2d_test \
     "$repo_root/Tests/Vector2DTest.cpp" \
     "$repo_root/Pancake_esp/main/Vector2D.cpp"
@@ -46,6 +51,41 @@ build_and_run angle_motion_test \
     "$repo_root/Tests/AngleMotionTest.cpp" \
     "$repo_root/Pancake_esp/main/AngleMotion.cpp"
 
+build_and_run elbow_selector_test \
+    "$repo_root/Tests/ElbowSelectorTest.cpp" \
+    "$repo_root/Pancake_esp/main/ElbowSelector.cpp" \
+    "$repo_root/Pancake_esp/main/AngleMotion.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
+build_and_run keep_out_router_test \
+    "$repo_root/Tests/KeepOutRouterTest.cpp" \
+    "$repo_root/Pancake_esp/main/KeepOutRouter.cpp" \
+    "$repo_root/Pancake_esp/main/AngleMotion.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
+build_and_run path_speed_planner_test \
+    "$repo_root/Tests/PathSpeedPlannerTest.cpp" \
+    "$repo_root/Pancake_esp/main/PathSpeedPlanner.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
+build_and_run command_slab_test \
+    "$repo_root/Tests/CommandSlabTest.cpp" \
+    "$repo_root/Pancake_esp/main/CommandSlab.cpp"
+
+build_and_run program_packet_test \
+    "$repo_root/Tests/ProgramPacketTest.cpp" \
+    "$repo_root/Pancake_esp/main/ProgramPacket.cpp"
+
+build_and_run program_store_test \
+    "$repo_root/Tests/ProgramStoreTest.cpp" \
+    "$repo_root/Tests/support/FileProgramStorage.cpp" \
+    "$repo_root/Pancake_esp/main/ProgramStore.cpp" \
+    "$repo_root/Pancake_esp/main/ProgramFeeder.cpp" \
+    "$repo_root/Pancake_esp/main/CommandSlab.cpp"
+
 build_and_run homing_controller_test \
     "$repo_root/Tests/HomingControllerTest.cpp" \
     "$repo_root/Pancake_esp/main/HomingController.cpp"
@@ -67,3 +107,103 @@ build_and_run go_to_angle_guidance_test \
 build_and_run influxdb_parser_test \
     "$repo_root/Tests/InfluxDBParserTest.cpp" \
     "$repo_root/Pancake_esp/main/InfluxDBParser.cpp"
+
+build_and_run influxdb_stream_parser_test \
+    "$repo_root/Tests/InfluxDBStreamParserTest.cpp" \
+    "$repo_root/Pancake_esp/main/InfluxDBParser.cpp" \
+    "$repo_root/Pancake_esp/main/InfluxDBStreamParser.cpp"
+
+build_and_run command_frame_reader_test \
+    "$repo_root/Tests/CommandFrameReaderTest.cpp" \
+    "$repo_root/Pancake_esp/main/CommandFrameReader.cpp" \
+    "$repo_root/Pancake_esp/main/ProgramPacket.cpp"
+
+build_and_run line_protocol_writer_test \
+    "$repo_root/Tests/LineProtocolWriterTest.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp"
+
+build_and_run telemetry_line_test \
+    "$repo_root/Tests/TelemetryLineTest.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryLine.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp"
+
+build_and_run telemetry_gzip_test \
+    -pthread \
+    "$repo_root/Tests/TelemetryGzipTest.cpp" \
+    "$repo_root/Tests/support/HttpStandIn.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryGzip.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryLine.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp" \
+    -lz
+
+build_and_run telemetry_buffer_pool_test \
+    "$repo_root/Tests/TelemetryBufferPoolTest.cpp"
+
+build_and_run telemetry_stream_test \
+    -pthread \
+    "$repo_root/Tests/TelemetryStreamTest.cpp" \
+    "$repo_root/Tests/support/HttpStandIn.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryStream.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryGzip.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryLine.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp" \
+    -lz
+
+build_and_run control_capture_test \
+    "$repo_root/Tests/ControlCaptureTest.cpp" \
+    "$repo_root/Pancake_esp/main/ControlCapture.cpp" \
+    "$repo_root/Pancake_esp/main/TelemetryLine.cpp" \
+    "$repo_root/Pancake_esp/main/LineProtocolWriter.cpp"
+
+build_and_run control_loop_timing_test \
+    "$repo_root/Tests/ControlLoopTimingTest.cpp" \
+    "$repo_root/Pancake_esp/main/ControlLoopTiming.cpp"
+
+build_and_run motion_lookahead_test \
+    "$repo_root/Tests/MotionLookaheadTest.cpp" \
+    "$repo_root/Pancake_esp/main/MotionLookahead.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"
+
+build_and_run step_ramp_test \
+    "$repo_root/Tests/StepRampTest.cpp" \
+    "$repo_root/Pancake_esp/main/StepRamp.cpp"
+
+build_and_run seqlock_snapshot_test \
+    -pthread \
+    "$repo_root/Tests/SeqlockSnapshotTest.cpp"
+
+build_and_run stepper_motor_test \
+    "$repo_root/Tests/StepperMotorTest.cpp" \
+    "$repo_root/Tests/support/RecordingStepBackend.cpp" \
+    "$repo_root/Pancake_esp/main/StepperMotor.cpp" \
+    "$repo_root/Pancake_esp/main/StepRamp.cpp"
+
+build_and_run bresenham_step_generator_test \
+    "$repo_root/Tests/BresenhamStepGeneratorTest.cpp" \
+    "$repo_root/Tests/support/HostHardware.cpp" \
+    "$repo_root/Pancake_esp/main/BresenhamStepGenerator.cpp"
+
+build_and_run motor_control_loop_test \
+    -I"$repo_root/PancakeSim/HostSim" \
+    "$repo_root/Tests/MotorControlLoopTest.cpp" \
+    "$repo_root/PancakeSim/HostSim/HostSimulation.cpp" \
+    "$repo_root/Tests/support/HostHardware.cpp" \
+    "$repo_root/Pancake_esp/main/MotorControlLoop.cpp" \
+    "$repo_root/Pancake_esp/main/StepperMotor.cpp" \
+    "$repo_root/Pancake_esp/main/StepRamp.cpp" \
+    "$repo_root/Pancake_esp/main/GptimerStepBackend.cpp" \
+    "$repo_root/Pancake_esp/main/BresenhamStepGenerator.cpp" \
+    "$repo_root/Pancake_esp/main/Telemetry.c" \
+    "$repo_root/Pancake_esp/main/AngleMotion.cpp" \
+    "$repo_root/Pancake_esp/main/CommandSlab.cpp" \
+    "$repo_root/Pancake_esp/main/ElbowSelector.cpp" \
+    "$repo_root/Pancake_esp/main/KeepOutRouter.cpp" \
+    "$repo_root/Pancake_esp/main/ArchimedeanSpiral.cpp" \
+    "$repo_root/Pancake_esp/main/HomingController.cpp" \
+    "$repo_root/Pancake_esp/main/MotionLookahead.cpp" \
+    "$repo_root/Pancake_esp/main/MotionSafety.cpp" \
+    "$repo_root/Pancake_esp/main/PanMath.cpp" \
+    "$repo_root/Pancake_esp/main/PathSpeedPlanner.cpp" \
+    "$repo_root/Pancake_esp/main/ProgramPacket.cpp" \
+    "$repo_root/Pancake_esp/main/Vector2D.cpp"